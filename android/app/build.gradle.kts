@@ -27,9 +27,14 @@ android {
 
         externalNativeBuild {
             cmake {
+                // -Psecurevox.ggmlOpenmp=true builds ggml with OpenMP threads
+                // (compare with rtf_compare.sh)
+                val ggmlOpenmp =
+                    if (project.findProperty("securevox.ggmlOpenmp") == "true") "ON" else "OFF"
                 arguments += listOf(
                     "-DWHISPER_BUILD_TESTS=OFF",
-                    "-DWHISPER_BUILD_EXAMPLES=OFF"
+                    "-DWHISPER_BUILD_EXAMPLES=OFF",
+                    "-DSECUREVOX_GGML_OPENMP=$ggmlOpenmp"
                 )
                 cppFlags += listOf("-std=c++17", "-O3", "-fPIC")
             }
@@ -0,0 +1,173 @@
+#include <jni.h>
+#include <android/log.h>
+#include <string>
+#include <vector>
+#include "audio_buffer.h"
+
+#define TAG "NativeAudioJNI"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+static securevox::AudioBuffer* as_audio(jlong audioPtr) {
+    return reinterpret_cast<securevox::AudioBuffer*>(audioPtr);
+}
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+Java_com_securevox_app_whisper_NativeAudio_createAudio(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jint sampleRate) {
+
+    if (sampleRate <= 0) {
+        LOGE("Invalid sample rate: %d", sampleRate);
+        return 0;
+    }
+    return reinterpret_cast<jlong>(new securevox::AudioBuffer(sampleRate));
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_securevox_app_whisper_NativeAudio_loadAudio(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jstring path) {
+
+    const char* chars = env->GetStringUTFChars(path, nullptr);
+    const std::string filePath = chars;
+    env->ReleaseStringUTFChars(path, chars);
+
+    auto* audio = new securevox::AudioBuffer(0);
+    std::string error;
+    if (!audio->load_file(filePath, error)) {
+        LOGE("Failed to load audio: %s", error.c_str());
+        delete audio;
+        return 0;
+    }
+    return reinterpret_cast<jlong>(audio);
+}
+
+JNIEXPORT void JNICALL
+Java_com_securevox_app_whisper_NativeAudio_appendPcm16(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jlong audioPtr,
+    jshortArray samples,
+    jint offset,
+    jint length) {
+
+    auto* audio = as_audio(audioPtr);
+    if (audio == nullptr || length <= 0) return;
+
+    // Copy only the chunk, converting into the buffer's own storage
+    std::vector<jshort> chunk(static_cast<size_t>(length));
+    env->GetShortArrayRegion(samples, offset, length, chunk.data());
+    audio->append_pcm16(reinterpret_cast<const int16_t*>(chunk.data()), chunk.size());
+}
+
+JNIEXPORT void JNICALL
+Java_com_securevox_app_whisper_NativeAudio_appendFloat(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jlong audioPtr,
+    jfloatArray samples,
+    jint offset,
+    jint length) {
+
+    auto* audio = as_audio(audioPtr);
+    if (audio == nullptr || length <= 0) return;
+
+    env->GetFloatArrayRegion(samples, offset, length, audio->extend(static_cast<size_t>(length)));
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_securevox_app_whisper_NativeAudio_resampleAudio(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jlong audioPtr,
+    jint sampleRate) {
+
+    auto* audio = as_audio(audioPtr);
+    if (audio == nullptr) return JNI_FALSE;
+
+    std::string error;
+    if (!audio->resample(sampleRate, error)) {
+        LOGE("%s", error.c_str());
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_securevox_app_whisper_NativeAudio_suppressNoise(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jlong audioPtr) {
+
+    auto* audio = as_audio(audioPtr);
+    if (audio == nullptr) return JNI_FALSE;
+
+    std::string error;
+    if (!audio->suppress_noise(securevox::DenoiseOptions(), securevox::VadOptions(), error)) {
+        LOGE("%s", error.c_str());
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_securevox_app_whisper_NativeAudio_removeSilence(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jlong audioPtr) {
+
+    auto* audio = as_audio(audioPtr);
+    if (audio == nullptr) return JNI_FALSE;
+
+    std::string error;
+    if (!audio->remove_silence(securevox::VadOptions(), error)) {
+        LOGE("%s", error.c_str());
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_securevox_app_whisper_NativeAudio_sampleRate(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jlong audioPtr) {
+
+    auto* audio = as_audio(audioPtr);
+    return audio != nullptr ? audio->sample_rate() : 0;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_securevox_app_whisper_NativeAudio_sampleCount(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jlong audioPtr) {
+
+    auto* audio = as_audio(audioPtr);
+    return audio != nullptr ? static_cast<jint>(audio->size()) : 0;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_securevox_app_whisper_NativeAudio_durationMs(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jlong audioPtr) {
+
+    auto* audio = as_audio(audioPtr);
+    return audio != nullptr ? audio->duration_ms() : 0;
+}
+
+JNIEXPORT void JNICALL
+Java_com_securevox_app_whisper_NativeAudio_freeAudio(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jlong audioPtr) {
+
+    delete as_audio(audioPtr);
+}
+
+} // extern "C"
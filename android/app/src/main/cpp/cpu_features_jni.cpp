@@ -0,0 +1,17 @@
+#include <jni.h>
+#include "cpu_features.h"
+
+// Built into libsecurevox_cpu.so at the baseline ISA, so it can run before
+// we know which whisper_jni variant the CPU supports.
+
+extern "C" {
+
+JNIEXPORT jstring JNICALL
+Java_com_securevox_app_whisper_NativeLibrary_cpuVariant(
+    JNIEnv* env,
+    jclass /* clazz */) {
+
+    return env->NewStringUTF(securevox::best_cpu_variant());
+}
+
+} // extern "C"
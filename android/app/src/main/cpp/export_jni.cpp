@@ -0,0 +1,101 @@
+#include <jni.h>
+#include <android/log.h>
+#include <string>
+#include "exporter.h"
+
+#define TAG "ExportJNI"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+// Transcode a Java string to standard UTF-8 into a reused buffer.
+// GetStringUTFChars would emit modified UTF-8, which splits emoji and other
+// supplementary characters into invalid surrogate sequences.
+static void to_utf8(JNIEnv* env, jstring str, std::string& out) {
+    out.clear();
+    if (str == nullptr) return;
+
+    const jsize len = env->GetStringLength(str);
+    const jchar* chars = env->GetStringCritical(str, nullptr);
+    for (jsize i = 0; i < len; i++) {
+        uint32_t cp = chars[i];
+        if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < len && chars[i + 1] >= 0xDC00 && chars[i + 1] <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (chars[++i] - 0xDC00);
+        } else if (cp >= 0xD800 && cp <= 0xDFFF) {
+            cp = 0xFFFD;  // unpaired surrogate
+        }
+
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+    env->ReleaseStringCritical(str, chars);
+}
+
+extern "C" {
+
+JNIEXPORT jboolean JNICALL
+Java_com_securevox_app_whisper_NativeExporter_writeSegments(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray starts,
+    jlongArray ends,
+    jobjectArray texts,
+    jobjectArray speakers,
+    jint format,
+    jint maxLineChars,
+    jint fd) {
+
+    if (format < 0 || format > static_cast<jint>(securevox::ExportFormat::Json)) {
+        LOGE("Unknown export format: %d", format);
+        return JNI_FALSE;
+    }
+
+    securevox::ExportOptions options;
+    options.max_line_chars = maxLineChars;
+    securevox::TranscriptExporter exporter(fd, static_cast<securevox::ExportFormat>(format), options);
+
+    const jsize count = env->GetArrayLength(texts);
+    jlong* startPtr = env->GetLongArrayElements(starts, nullptr);
+    jlong* endPtr = env->GetLongArrayElements(ends, nullptr);
+
+    // Scratch buffers grow to the longest segment once and are reused
+    std::string text;
+    std::string speaker;
+    for (jsize i = 0; i < count; i++) {
+        auto jtext = static_cast<jstring>(env->GetObjectArrayElement(texts, i));
+        to_utf8(env, jtext, text);
+        env->DeleteLocalRef(jtext);
+
+        speaker.clear();
+        if (speakers != nullptr) {
+            auto jspeaker = static_cast<jstring>(env->GetObjectArrayElement(speakers, i));
+            to_utf8(env, jspeaker, speaker);
+            env->DeleteLocalRef(jspeaker);
+        }
+
+        exporter.add(startPtr[i], endPtr[i], text.data(), text.size(), speaker.data(), speaker.size());
+    }
+
+    env->ReleaseLongArrayElements(starts, startPtr, JNI_ABORT);
+    env->ReleaseLongArrayElements(ends, endPtr, JNI_ABORT);
+
+    std::string error;
+    if (!exporter.finish(error)) {
+        LOGE("%s", error.c_str());
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+} // extern "C"
@@ -0,0 +1,99 @@
+#include <jni.h>
+#include <android/log.h>
+#include <string>
+#include <vector>
+#include "audio_buffer.h"
+#include "fingerprint.h"
+
+#define TAG "FingerprintJNI"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+static std::string to_string(JNIEnv* env, jstring str) {
+    const char* chars = env->GetStringUTFChars(str, nullptr);
+    std::string result = chars;
+    env->ReleaseStringUTFChars(str, chars);
+    return result;
+}
+
+static void append_escaped(std::string& out, const std::string& text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+}
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+Java_com_securevox_app_whisper_AudioFingerprintIndex_openIndex(
+    JNIEnv* env,
+    jobject /* this */,
+    jstring path) {
+
+    auto* index = new securevox::FingerprintIndex();
+    std::string error;
+    if (!index->open(to_string(env, path), error)) {
+        LOGE("Failed to open fingerprint index: %s", error.c_str());
+        delete index;
+        return 0;
+    }
+
+    LOGI("Fingerprint index opened: %zu recordings", index->recording_count());
+    return reinterpret_cast<jlong>(index);
+}
+
+// Fingerprint the audio, look for an earlier recording it duplicates or
+// overlaps, then index it. Returns the match as JSON, or "" when there is none.
+JNIEXPORT jstring JNICALL
+Java_com_securevox_app_whisper_AudioFingerprintIndex_indexRecording(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong indexPtr,
+    jstring recordingId,
+    jlong audioPtr) {
+
+    auto* index = reinterpret_cast<securevox::FingerprintIndex*>(indexPtr);
+    auto* audio = reinterpret_cast<const securevox::AudioBuffer*>(audioPtr);
+    if (index == nullptr || audio == nullptr || audio->sample_rate() <= 0) {
+        return env->NewStringUTF("");
+    }
+
+    const std::string id = to_string(env, recordingId);
+    const std::vector<securevox::Landmark> landmarks =
+        securevox::compute_landmarks(audio->data(), audio->size(), audio->sample_rate());
+
+    securevox::FingerprintMatch match;
+    const bool found = index->find(landmarks, id, match);
+    if (!index->set_recording(id, landmarks, audio->duration_ms())) {
+        LOGE("Failed to write fingerprint index");
+    }
+    if (!found) return env->NewStringUTF("");
+
+    LOGI("Recording overlaps %s at %lld ms (%u landmarks)",
+         match.recording_id.c_str(), static_cast<long long>(match.offset_ms), match.matches);
+
+    std::string json = "{\"recording\":\"";
+    append_escaped(json, match.recording_id);
+    json += "\",\"offset\":" + std::to_string(match.offset_ms);
+    json += ",\"begin\":" + std::to_string(match.query_begin_ms);
+    json += ",\"end\":" + std::to_string(match.query_end_ms);
+    json += ",\"duration\":" + std::to_string(match.recording_duration_ms);
+    json += ",\"matches\":" + std::to_string(match.matches);
+    json += "}";
+    return env->NewStringUTF(json.c_str());
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_securevox_app_whisper_AudioFingerprintIndex_removeRecording(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong indexPtr,
+    jstring recordingId) {
+
+    auto* index = reinterpret_cast<securevox::FingerprintIndex*>(indexPtr);
+    if (index == nullptr) return JNI_FALSE;
+    return index->remove_recording(to_string(env, recordingId)) ? JNI_TRUE : JNI_FALSE;
+}
+
+} // extern "C"
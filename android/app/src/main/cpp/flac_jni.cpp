@@ -0,0 +1,111 @@
+#include <jni.h>
+#include <android/log.h>
+#include <string>
+#include <vector>
+#include "flac.h"
+
+#define TAG "FlacJNI"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+namespace {
+
+// Encoder plus a staging buffer reused for every capture chunk
+struct FlacWriter {
+    securevox::FlacEncoder encoder;
+    std::vector<jshort> chunk;
+};
+
+} // namespace
+
+static std::string to_string(JNIEnv* env, jstring str) {
+    const char* chars = env->GetStringUTFChars(str, nullptr);
+    std::string result = chars;
+    env->ReleaseStringUTFChars(str, chars);
+    return result;
+}
+
+static FlacWriter* as_writer(jlong writerPtr) {
+    return reinterpret_cast<FlacWriter*>(writerPtr);
+}
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+Java_com_securevox_app_whisper_NativeFlacWriter_openWriter(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jstring path,
+    jint sampleRate) {
+
+    auto* writer = new FlacWriter();
+    std::string error;
+    if (!writer->encoder.open(to_string(env, path), sampleRate, error)) {
+        LOGE("%s", error.c_str());
+        delete writer;
+        return 0;
+    }
+    return reinterpret_cast<jlong>(writer);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_securevox_app_whisper_NativeFlacWriter_writePcm16(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jlong writerPtr,
+    jshortArray samples,
+    jint offset,
+    jint length) {
+
+    auto* writer = as_writer(writerPtr);
+    if (writer == nullptr) return JNI_FALSE;
+    if (length <= 0) return JNI_TRUE;
+
+    // A region copy rather than a critical section: appending may hit the disk
+    if (writer->chunk.size() < static_cast<size_t>(length)) writer->chunk.resize(static_cast<size_t>(length));
+    env->GetShortArrayRegion(samples, offset, length, writer->chunk.data());
+    return writer->encoder.append(reinterpret_cast<const int16_t*>(writer->chunk.data()), static_cast<size_t>(length))
+        ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_securevox_app_whisper_NativeFlacWriter_samplesWritten(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jlong writerPtr) {
+
+    auto* writer = as_writer(writerPtr);
+    return writer != nullptr ? static_cast<jlong>(writer->encoder.samples_written()) : 0;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_securevox_app_whisper_NativeFlacWriter_finishWriter(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jlong writerPtr) {
+
+    auto* writer = as_writer(writerPtr);
+    if (writer == nullptr) return JNI_FALSE;
+
+    std::string error;
+    const bool ok = writer->encoder.finish(error);
+    if (!ok) LOGE("%s", error.c_str());
+    delete writer;
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_securevox_app_whisper_NativeFlacWriter_convertWavFile(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jstring wavPath,
+    jstring flacPath) {
+
+    std::string error;
+    if (!securevox::convert_wav_to_flac(to_string(env, wavPath), to_string(env, flacPath), error)) {
+        LOGE("Failed to convert to FLAC: %s", error.c_str());
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+} // extern "C"
@@ -0,0 +1,155 @@
+#include <jni.h>
+#include <android/log.h>
+#include <string>
+#include <vector>
+#include "transcript_index.h"
+
+#define TAG "TranscriptIndexJNI"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+static std::string to_string(JNIEnv* env, jstring str) {
+    const char* chars = env->GetStringUTFChars(str, nullptr);
+    std::string result = chars;
+    env->ReleaseStringUTFChars(str, chars);
+    return result;
+}
+
+// Segments from parallel arrays; false when their lengths differ
+static bool to_segments(JNIEnv* env, jlongArray starts, jlongArray ends, jobjectArray texts,
+                        std::vector<securevox::Segment>& segments) {
+    const jsize count = env->GetArrayLength(texts);
+    if (env->GetArrayLength(starts) != count || env->GetArrayLength(ends) != count) return false;
+
+    segments.resize(static_cast<size_t>(count));
+    jlong* startPtr = env->GetLongArrayElements(starts, nullptr);
+    jlong* endPtr = env->GetLongArrayElements(ends, nullptr);
+    for (size_t i = 0; i < segments.size(); i++) {
+        segments[i].start_ms = startPtr[i];
+        segments[i].end_ms = endPtr[i];
+
+        auto text = static_cast<jstring>(env->GetObjectArrayElement(texts, static_cast<jsize>(i)));
+        segments[i].text = to_string(env, text);
+        env->DeleteLocalRef(text);
+    }
+    env->ReleaseLongArrayElements(starts, startPtr, JNI_ABORT);
+    env->ReleaseLongArrayElements(ends, endPtr, JNI_ABORT);
+    return true;
+}
+
+static void append_escaped(std::string& out, const std::string& text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+}
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+Java_com_securevox_app_whisper_TranscriptIndex_openIndex(
+    JNIEnv* env,
+    jobject /* this */,
+    jstring path) {
+
+    auto* index = new securevox::TranscriptIndex();
+    std::string error;
+    if (!index->open(to_string(env, path), error)) {
+        LOGE("Failed to open transcript index: %s", error.c_str());
+        delete index;
+        return 0;
+    }
+
+    LOGI("Transcript index opened: %zu recordings", index->recording_count());
+    return reinterpret_cast<jlong>(index);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_securevox_app_whisper_TranscriptIndex_setRecordingSegments(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong indexPtr,
+    jstring recordingId,
+    jlongArray starts,
+    jlongArray ends,
+    jobjectArray texts) {
+
+    auto* index = reinterpret_cast<securevox::TranscriptIndex*>(indexPtr);
+    if (index == nullptr) return JNI_FALSE;
+
+    std::vector<securevox::Segment> segments;
+    if (!to_segments(env, starts, ends, texts, segments)) return JNI_FALSE;
+    return index->set_recording(to_string(env, recordingId), segments) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_securevox_app_whisper_TranscriptIndex_addRecordingSegments(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong indexPtr,
+    jstring recordingId,
+    jint firstIndex,
+    jlongArray starts,
+    jlongArray ends,
+    jobjectArray texts) {
+
+    auto* index = reinterpret_cast<securevox::TranscriptIndex*>(indexPtr);
+    if (index == nullptr || firstIndex < 0) return JNI_FALSE;
+
+    std::vector<securevox::Segment> segments;
+    if (!to_segments(env, starts, ends, texts, segments)) return JNI_FALSE;
+    return index->add_segments(to_string(env, recordingId), static_cast<uint32_t>(firstIndex), segments)
+        ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_securevox_app_whisper_TranscriptIndex_removeRecording(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong indexPtr,
+    jstring recordingId) {
+
+    auto* index = reinterpret_cast<securevox::TranscriptIndex*>(indexPtr);
+    if (index == nullptr) return JNI_FALSE;
+    return index->remove_recording(to_string(env, recordingId)) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_securevox_app_whisper_TranscriptIndex_searchIndex(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong indexPtr,
+    jstring query,
+    jint limit) {
+
+    auto* index = reinterpret_cast<securevox::TranscriptIndex*>(indexPtr);
+    if (index == nullptr) return env->NewStringUTF("[]");
+
+    const std::vector<securevox::SearchHit> hits =
+        index->search(to_string(env, query), static_cast<size_t>(limit > 0 ? limit : 0));
+
+    std::string json = "[";
+    for (size_t i = 0; i < hits.size(); i++) {
+        if (i > 0) json += ",";
+        json += "{\"recording\":\"";
+        append_escaped(json, hits[i].recording_id);
+        json += "\",\"segment\":" + std::to_string(hits[i].segment_index);
+        json += ",\"start\":" + std::to_string(hits[i].segment_start_ms);
+        json += ",\"time\":" + std::to_string(hits[i].time_ms);
+        json += "}";
+    }
+    json += "]";
+    return env->NewStringUTF(json.c_str());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_securevox_app_whisper_TranscriptIndex_indexedRecordingCount(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jlong indexPtr) {
+
+    auto* index = reinterpret_cast<securevox::TranscriptIndex*>(indexPtr);
+    return index != nullptr ? static_cast<jint>(index->recording_count()) : 0;
+}
+
+} // extern "C"
@@ -0,0 +1,95 @@
+#include <jni.h>
+#include <android/log.h>
+#include <string>
+#include <vector>
+#include "waveform.h"
+
+#define TAG "WaveformJNI"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+static_assert(sizeof(securevox::WaveformColumn) == 3 * sizeof(float), "columns are copied out as float triples");
+
+static std::string to_string(JNIEnv* env, jstring str) {
+    const char* chars = env->GetStringUTFChars(str, nullptr);
+    std::string result = chars;
+    env->ReleaseStringUTFChars(str, chars);
+    return result;
+}
+
+static securevox::WaveformPeaks* as_peaks(jlong peaksPtr) {
+    return reinterpret_cast<securevox::WaveformPeaks*>(peaksPtr);
+}
+
+extern "C" {
+
+JNIEXPORT jboolean JNICALL
+Java_com_securevox_app_whisper_WaveformPeaks_buildPeaks(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jstring audioPath,
+    jstring peaksPath) {
+
+    std::string error;
+    if (!securevox::build_waveform(to_string(env, audioPath), to_string(env, peaksPath), error)) {
+        LOGE("Failed to build waveform: %s", error.c_str());
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_securevox_app_whisper_WaveformPeaks_openPeaks(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jstring peaksPath) {
+
+    auto* peaks = new securevox::WaveformPeaks();
+    std::string error;
+    if (!peaks->open(to_string(env, peaksPath), error)) {
+        LOGE("%s", error.c_str());
+        delete peaks;
+        return 0;
+    }
+    return reinterpret_cast<jlong>(peaks);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_securevox_app_whisper_WaveformPeaks_peaksDurationMs(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jlong peaksPtr) {
+
+    auto* peaks = as_peaks(peaksPtr);
+    return peaks != nullptr ? peaks->duration_ms() : 0;
+}
+
+// Fills out with (min, max, rms) per column; its length must be a multiple of 3
+JNIEXPORT void JNICALL
+Java_com_securevox_app_whisper_WaveformPeaks_renderPeaks(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jlong peaksPtr,
+    jlong beginMs,
+    jlong endMs,
+    jfloatArray out) {
+
+    auto* peaks = as_peaks(peaksPtr);
+    const jsize length = env->GetArrayLength(out);
+    if (peaks == nullptr || length < 3) return;
+
+    std::vector<securevox::WaveformColumn> columns(static_cast<size_t>(length / 3));
+    peaks->render(beginMs, endMs, columns.size(), columns.data());
+    env->SetFloatArrayRegion(out, 0, static_cast<jsize>(columns.size() * 3),
+                             reinterpret_cast<const jfloat*>(columns.data()));
+}
+
+JNIEXPORT void JNICALL
+Java_com_securevox_app_whisper_WaveformPeaks_closePeaks(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jlong peaksPtr) {
+
+    delete as_peaks(peaksPtr);
+}
+
+} // extern "C"
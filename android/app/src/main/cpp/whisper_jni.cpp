@@ -1,9 +1,25 @@
 #include <jni.h>
 #include <android/log.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
 #include <string>
 #include <vector>
 #include <thread>
 #include "whisper.h"
+#include "thread_pool.h"
+#include "power_policy.h"
+#include "checkpoint.h"
+#include "incremental.h"
+#include "audio_buffer.h"
+#include "json_writer.h"
+#include "memory_budget.h"
+#include "encoder_cache.h"
+#include "result_cache.h"
+#include "decode_guard.h"
+#include "speculative.h"
+#include "short_clip.h"
 
 #define TAG "WhisperJNI"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
@@ -12,6 +28,416 @@
 // Global context holder
 static whisper_context* g_context = nullptr;
 
+// Tokens per large-model decoder pass in the last speculative job
+static std::atomic<double> g_speculative_tokens_per_pass{0.0};
+
+// Clips up to this long take the short-clip fast path; 0 while it is off
+static std::atomic<int64_t> g_short_clip_ms{0};
+
+// Characters of recovered transcript fed back as the prompt when resuming
+static constexpr size_t RESUME_PROMPT_CHARS = 200;
+
+// whisper_full skips input shorter than a second; a little more is safe from rounding
+static constexpr jsize MIN_WHISPER_SAMPLES = WHISPER_SAMPLE_RATE * 11 / 10;
+
+// Identifies model + language + decoder so a checkpoint is never resumed with
+// other settings: speculative and whisper_full windows are segmented differently
+static std::string job_key(whisper_context* ctx, const char* language, bool speculative) {
+    return std::to_string(whisper_model_n_vocab(ctx)) + "/" +
+           std::to_string(whisper_model_n_text_layer(ctx)) + "/" +
+           std::to_string(whisper_model_n_text_state(ctx)) + "/" +
+           std::to_string(whisper_model_ftype(ctx)) + "/" +
+           (language ? language : "") +
+           (speculative ? "/greedy" : "");
+}
+
+// Build result JSON with segments. Supplementary characters are escaped as
+// surrogate pairs because NewStringUTF only accepts modified UTF-8.
+static jstring segments_to_json(JNIEnv* env, const std::vector<securevox::Segment>& segments) {
+    size_t textBytes = 0;
+    for (const auto& segment : segments) textBytes += segment.text.size();
+
+    securevox::JsonWriter json(textBytes + segments.size() * 48 + 2, true);
+    json.put('[');
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (i > 0) json.put(',');
+        securevox::write_segment_json(json, segments[i].text.data(), segments[i].text.size(),
+                                      segments[i].start_ms, segments[i].end_ms);
+    }
+    json.put(']');
+
+    if (!json.ok()) {
+        LOGE("Out of memory building transcription result");
+        return env->NewStringUTF("");
+    }
+    return env->NewStringUTF(json.data());
+}
+
+// Progress callback target
+struct CallbackData {
+    JNIEnv* env;
+    jobject callback;
+    jmethodID method;
+    // Range of the overall progress covered by the current whisper_full call
+    int base = 0;
+    int span = 100;
+};
+
+static CallbackData make_callback_data(JNIEnv* env, jobject progressCallback) {
+    jmethodID onProgressMethod = nullptr;
+    if (progressCallback != nullptr) {
+        jclass callbackClass = env->GetObjectClass(progressCallback);
+        onProgressMethod = env->GetMethodID(callbackClass, "onProgress", "(I)V");
+    }
+    return { env, progressCallback, onProgressMethod };
+}
+
+// Configure whisper parameters
+static whisper_full_params make_params(const char* lang, int n_threads) {
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.print_realtime = false;
+    params.print_progress = false;
+    params.print_timestamps = true;
+    params.print_special = false;
+    params.translate = false;
+    params.language = lang;
+    params.n_threads = n_threads;
+    params.offset_ms = 0;
+    params.no_context = true;
+    params.single_segment = false;
+    return params;
+}
+
+// Progress reporting plus duty-cycle pauses between encoder windows
+static void attach_callbacks(whisper_full_params& params, CallbackData* cbData, securevox::DutyCycle* dutyCycle) {
+    params.progress_callback_user_data = cbData;
+    params.progress_callback = [](struct whisper_context* /*ctx*/,
+                                   struct whisper_state* /*state*/,
+                                   int progress,
+                                   void* user_data) {
+        auto* data = static_cast<CallbackData*>(user_data);
+        if (data->callback != nullptr && data->method != nullptr) {
+            data->env->CallVoidMethod(data->callback, data->method, data->base + progress * data->span / 100);
+        }
+    };
+
+    params.encoder_begin_callback_user_data = dutyCycle;
+    params.encoder_begin_callback = [](struct whisper_context* /*ctx*/,
+                                       struct whisper_state* /*state*/,
+                                       void* user_data) {
+        static_cast<securevox::DutyCycle*>(user_data)->on_window();
+        return true;
+    };
+}
+
+// How a job was admitted against the memory budget (see WhisperLib.planJob)
+struct JobOptions {
+    int64_t chunkMs = 0;  // audio per whisper_full call, 0 for all of it at once
+    int bestOf = 0;       // greedy decoders, 0 for whisper's default
+    bool speculative = false;  // greedy with draft, instead of whisper_full
+    whisper_context* draft = nullptr;  // small model proposing tokens, may be null
+};
+
+// Where segments decoded from a chunk are checkpointed, shifted to the full timeline
+struct SegmentSink {
+    securevox::Checkpoint* checkpoint;
+    const securevox::DecodeGuard* guard;
+    int64_t offsetMs;
+};
+
+// Short-clip fast path settings for a job of audioLen samples (see
+// short_clip.h). Only jobs decoded by one whisper_full call can take it.
+static securevox::ShortClipOptions short_clip_options(int64_t audioLen, const JobOptions& options) {
+    securevox::ShortClipOptions shortClip;
+    shortClip.max_ms = g_short_clip_ms.load();
+    const bool oneCall = options.chunkMs <= 0 || audioLen <= options.chunkMs * WHISPER_SAMPLE_RATE / 1000;
+    if (options.speculative || !oneCall) shortClip.max_ms = 0;
+    return shortClip;
+}
+
+// A short clip is cheaper to encode at its own length than to decode
+// speculatively, which always encodes the full window with both models
+static void prefer_short_clip(JobOptions& options, int64_t audioLen) {
+    JobOptions plain = options;
+    plain.speculative = false;
+    plain.draft = nullptr;
+    if (options.speculative &&
+        securevox::short_clip_audio_ctx(static_cast<size_t>(audioLen), short_clip_options(audioLen, plain)) > 0) {
+        options = plain;
+    }
+}
+
+// Decoding settings that change the transcript, for the result cache key
+static std::string result_settings(const char* language, const JobOptions& options, int64_t audioLen) {
+    const int audioCtx = securevox::short_clip_audio_ctx(static_cast<size_t>(audioLen),
+                                                         short_clip_options(audioLen, options));
+    return std::string(language ? language : "") + "/" +
+           std::to_string(options.chunkMs) + "/" +
+           std::to_string(options.bestOf) +
+           (options.speculative ? "/greedy" : "") +
+           (audioCtx > 0 ? "/ctx" + std::to_string(audioCtx) : "");
+}
+
+// Map segment times to the original audio (timeMap may be null) and build the result
+static jstring finish_segments(JNIEnv* env, std::vector<securevox::Segment>& segments,
+                               const securevox::TimeMap* timeMap) {
+    if (timeMap != nullptr && !timeMap->empty()) {
+        for (auto& segment : segments) {
+            segment.start_ms = timeMap->to_original_ms(segment.start_ms, WHISPER_SAMPLE_RATE);
+            segment.end_ms = timeMap->to_original_ms(segment.end_ms, WHISPER_SAMPLE_RATE);
+        }
+    }
+
+    LOGI("Transcription complete: %zu segments", segments.size());
+    return segments_to_json(env, segments);
+}
+
+// Transcribe samples the caller keeps alive for the duration of the call.
+// timeMap may be null; otherwise segment times are mapped to the original audio.
+static jstring transcribe_samples(
+    JNIEnv* env,
+    whisper_context* ctx,
+    const float* audioPtr,
+    int audioLen,
+    jstring language,
+    jstring checkpointPath,
+    jobject progressCallback,
+    const securevox::TimeMap* timeMap,
+    const JobOptions& options = JobOptions()) {
+
+    LOGI("Transcribing %d samples", audioLen);
+
+    // Get language
+    const char* lang = env->GetStringUTFChars(language, nullptr);
+
+    // The same audio, model and settings were transcribed before: no decoding at all
+    securevox::ResultCache& results = securevox::ResultCache::instance();
+    const uint64_t model = securevox::EncoderCache::instance().model_of(ctx);
+    const bool cacheResult = results.enabled() && model != 0;
+    securevox::ResultKey resultKey;
+    if (cacheResult) {
+        resultKey = securevox::make_result_key(audioPtr, static_cast<size_t>(audioLen), model,
+                                               result_settings(lang, options, audioLen));
+        std::vector<securevox::Segment> cached;
+        if (results.load(resultKey, cached)) {
+            LOGI("Result cache hit: %zu segments", cached.size());
+            env->ReleaseStringUTFChars(language, lang);
+            if (checkpointPath != nullptr) {
+                const char* path = env->GetStringUTFChars(checkpointPath, nullptr);
+                std::remove(path);
+                env->ReleaseStringUTFChars(checkpointPath, path);
+            }
+            return finish_segments(env, cached, timeMap);
+        }
+    }
+
+    // Background jobs follow the battery/thermal policy (full speed when it is disabled)
+    securevox::ThrottlePlan plan = securevox::PowerPolicy::instance().plan(4);
+    securevox::EfficiencyCoreScope coreScope(plan.efficiency_cores);
+    securevox::DutyCycle dutyCycle(4);
+
+    // ggml threads count against the shared pool so concurrent jobs don't oversubscribe
+    securevox::ThreadPool::Lease threads = securevox::ThreadPool::instance().lease(plan.max_threads);
+
+    // Configure whisper parameters
+    whisper_full_params params = make_params(lang, threads.count());
+    if (options.bestOf > 0) params.greedy.best_of = options.bestOf;
+
+    // A short clip is encoded at its own length and decoded as one segment
+    const securevox::ShortClipOptions shortClipOptions = short_clip_options(audioLen, options);
+    const bool shortClip = securevox::apply_short_clip(params, static_cast<size_t>(audioLen), shortClipOptions);
+    if (shortClip) LOGI("Short clip: audio_ctx %d", params.audio_ctx);
+
+    // Resume from the sidecar checkpoint left by a killed run, if any
+    securevox::Checkpoint checkpoint;
+    bool checkpointing = false;
+
+    if (checkpointPath != nullptr && shortClip) {
+        // One short whisper_full call leaves nothing worth resuming
+        const char* path = env->GetStringUTFChars(checkpointPath, nullptr);
+        std::remove(path);
+        env->ReleaseStringUTFChars(checkpointPath, path);
+    } else if (checkpointPath != nullptr) {
+        const char* path = env->GetStringUTFChars(checkpointPath, nullptr);
+        std::string error;
+        checkpointing = checkpoint.open(path, static_cast<uint64_t>(audioLen), job_key(ctx, lang, options.speculative), error);
+        env->ReleaseStringUTFChars(checkpointPath, path);
+
+        if (!checkpointing) {
+            LOGE("Checkpointing disabled: %s", error.c_str());
+        } else if (!checkpoint.segments().empty()) {
+            LOGI("Resuming at %lld ms with %zu segments",
+                 static_cast<long long>(checkpoint.resume_offset_ms()), checkpoint.segments().size());
+        }
+    }
+
+    securevox::DecodeGuard guard;
+    SegmentSink sink = { &checkpoint, &guard, 0 };
+    if (checkpointing) {
+        params.new_segment_callback_user_data = &sink;
+        params.new_segment_callback = [](struct whisper_context* ctx,
+                                         struct whisper_state* state,
+                                         int n_new,
+                                         void* user_data) {
+            auto* sink = static_cast<SegmentSink*>(user_data);
+            std::vector<securevox::Segment> window;
+            securevox::read_segments(ctx, state, whisper_full_n_segments_from_state(state) - n_new, window, sink->guard);
+            for (auto& segment : window) {
+                segment.start_ms += sink->offsetMs;
+                segment.end_ms += sink->offsetMs;
+            }
+            if (!sink->checkpoint->append(window)) {
+                LOGE("Failed to write checkpoint");
+            }
+        };
+    }
+
+    CallbackData cbData = make_callback_data(env, progressCallback);
+    attach_callbacks(params, &cbData, &dutyCycle);
+
+    // Runaway loops are cut short. Unless silence was already removed, segments
+    // decoded from what the VAD finds silent are dropped too.
+    guard.attach(params);
+    securevox::SpeechRegions speech;
+    const bool vad = !options.speculative && (timeMap == nullptr || timeMap->empty());
+    if (vad) speech = securevox::detect_speech(audioPtr, static_cast<size_t>(audioLen), WHISPER_SAMPLE_RATE);
+
+    // Recovered segments come first, then the ones decoded in this run
+    std::vector<securevox::Segment> segments = checkpoint.segments();
+
+    // With a draft model: greedy decoding of the large model, verified in
+    // batches of draft proposals (no prompt or guard; failed windows fall back
+    // to whisper_full)
+    std::unique_ptr<securevox::SpeculativeDecoder> speculative;
+    if (options.speculative) {
+        securevox::SpeculativeOptions speculativeOptions;
+        speculativeOptions.n_threads = threads.count();
+        speculativeOptions.temperature_inc = params.temperature_inc;
+        speculative.reset(new securevox::SpeculativeDecoder(ctx, options.draft, speculativeOptions));
+    }
+
+    // Decode from the resume point to the end, one chunk per whisper_full call when
+    // chunked so the padded copy and mel only ever cover a chunk
+    const int64_t chunkSamples = options.chunkMs > 0
+        ? options.chunkMs * WHISPER_SAMPLE_RATE / 1000
+        : static_cast<int64_t>(audioLen);
+    int64_t first = std::min<int64_t>(checkpoint.resume_offset_ms() * WHISPER_SAMPLE_RATE / 1000, audioLen);
+    int result = 0;
+    std::string prompt;
+
+    while (first < audioLen && result == 0) {
+        const int64_t last = std::min<int64_t>(first + chunkSamples, audioLen);
+        const int64_t offsetMs = first * 1000 / WHISPER_SAMPLE_RATE;
+
+        // Continue from the text so far so wording and casing stay consistent
+        prompt = securevox::tail_text(segments, RESUME_PROMPT_CHARS);
+        params.initial_prompt = prompt.empty() ? nullptr : prompt.c_str();
+        sink.offsetMs = offsetMs;
+        if (vad) guard.set_speech(&speech, static_cast<size_t>(first));
+        cbData.base = static_cast<int>(first * 100 / audioLen);
+        cbData.span = static_cast<int>(last * 100 / audioLen) - cbData.base;
+
+        std::vector<securevox::Segment> decoded;
+        {
+            // Windows this audio already went through the encoder for are reused
+            securevox::EncoderCacheScope encoderCache(ctx, audioPtr + first, static_cast<size_t>(last - first));
+            if (speculative) {
+                std::string error;
+                auto onWindow = [&](const std::vector<securevox::Segment>& window, size_t done) {
+                    if (checkpointing) {
+                        std::vector<securevox::Segment> shifted = window;
+                        for (auto& segment : shifted) {
+                            segment.start_ms += offsetMs;
+                            segment.end_ms += offsetMs;
+                        }
+                        if (!checkpoint.append(shifted)) LOGE("Failed to write checkpoint");
+                    }
+                    dutyCycle.on_window();
+                    if (cbData.callback != nullptr && cbData.method != nullptr) {
+                        env->CallVoidMethod(cbData.callback, cbData.method,
+                                            cbData.base + static_cast<int>(done * cbData.span / static_cast<size_t>(last - first)));
+                    }
+                };
+                if (!speculative->transcribe(audioPtr + first, static_cast<size_t>(last - first), lang,
+                                             decoded, error, onWindow)) {
+                    LOGE("Speculative decoding failed: %s", error.c_str());
+                    result = -1;
+                }
+            } else {
+                const int cutBefore = guard.cut_windows();
+                result = whisper_full(ctx, params, audioPtr + first, static_cast<int>(last - first));
+                if (result == 0 && shortClip &&
+                    !securevox::short_clip_accepted(ctx, &guard, cutBefore, shortClipOptions)) {
+                    LOGI("Short clip result rejected, decoding again with the full context");
+                    securevox::clear_short_clip(params);
+                    result = whisper_full(ctx, params, audioPtr + first, static_cast<int>(last - first));
+                }
+            }
+        }
+        if (result != 0) break;
+
+        if (!speculative) securevox::read_segments(ctx, nullptr, 0, decoded, &guard);
+        for (auto& segment : decoded) {
+            segment.start_ms += offsetMs;
+            segment.end_ms += offsetMs;
+        }
+
+        // A word cut by the chunk boundary is decoded again in the next chunk:
+        // continue from the end of the last segment if it is past half the chunk
+        int64_t next = last;
+        if (last < audioLen && !decoded.empty()) {
+            const int64_t endSample = decoded.back().end_ms * WHISPER_SAMPLE_RATE / 1000;
+            if (endSample > first + (last - first) / 2 && endSample < last) next = endSample;
+        }
+        segments.insert(segments.end(), decoded.begin(), decoded.end());
+        first = next;
+    }
+
+    if (dutyCycle.paused_ms() > 0 || coreScope.active()) {
+        LOGI("Throttled: %d threads, efficiency cores %d, paused %lld ms",
+             threads.count(), coreScope.active() ? 1 : 0, dutyCycle.paused_ms());
+    }
+
+    if (guard.cut_windows() > 0 || guard.dropped_segments() > 0) {
+        LOGI("Decode guard: %d decoder passes cut short, %d no-speech segments dropped",
+             guard.cut_windows(), guard.dropped_segments());
+    }
+
+    if (speculative) {
+        const securevox::SpeculativeStats& stats = speculative->stats();
+        g_speculative_tokens_per_pass.store(stats.tokens_per_pass());
+        LOGI("Speculative decoding: %d tokens in %d large-model passes (%.2f per pass), %d/%d drafts accepted, %lld ms",
+             stats.tokens, stats.target_passes, stats.tokens_per_pass(), stats.accepted, stats.drafted,
+             static_cast<long long>(stats.decode_ms));
+    }
+
+    if (securevox::EncoderCache::instance().enabled()) {
+        const securevox::EncoderCacheStats cacheStats = securevox::EncoderCache::instance().stats();
+        LOGI("Encoder cache: %llu hits, %llu from disk, %llu encoded",
+             static_cast<unsigned long long>(cacheStats.hits),
+             static_cast<unsigned long long>(cacheStats.disk_hits),
+             static_cast<unsigned long long>(cacheStats.misses));
+    }
+
+    env->ReleaseStringUTFChars(language, lang);
+
+    if (result != 0) {
+        LOGE("Transcription failed with code: %d", result);
+        return env->NewStringUTF("");
+    }
+
+    if (checkpointing) {
+        checkpoint.remove();
+    }
+
+    // Stored in the timeline of the hashed audio; the time map is applied on every return
+    if (cacheResult) {
+        results.store(resultKey, segments);
+    }
+
+    return finish_segments(env, segments, timeMap);
+}
+
 extern "C" {
 
 JNIEXPORT jlong JNICALL
@@ -27,6 +453,9 @@ Java_com_securevox_app_whisper_WhisperLib_initContext(
     cparams.use_gpu = false;  // CPU only for maximum compatibility
 
     whisper_context* ctx = whisper_init_from_file_with_params(path, cparams);
+    if (ctx != nullptr) {
+        securevox::EncoderCache::instance().register_model(ctx, path);
+    }
     env->ReleaseStringUTFChars(modelPath, path);
 
     if (ctx == nullptr) {
@@ -46,6 +475,7 @@ Java_com_securevox_app_whisper_WhisperLib_freeContext(
 
     auto* ctx = reinterpret_cast<whisper_context*>(contextPtr);
     if (ctx != nullptr) {
+        securevox::EncoderCache::instance().unregister_model(ctx);
         whisper_free(ctx);
         LOGI("Context freed");
     }
@@ -58,6 +488,7 @@ Java_com_securevox_app_whisper_WhisperLib_transcribeAudio(
     jlong contextPtr,
     jfloatArray audioData,
     jstring language,
+    jstring checkpointPath,
     jobject progressCallback) {
 
     auto* ctx = reinterpret_cast<whisper_context*>(contextPtr);
@@ -70,102 +501,388 @@ Java_com_securevox_app_whisper_WhisperLib_transcribeAudio(
     jsize audioLen = env->GetArrayLength(audioData);
     jfloat* audioPtr = env->GetFloatArrayElements(audioData, nullptr);
 
-    LOGI("Transcribing %d samples", audioLen);
+    jstring result = transcribe_samples(env, ctx, audioPtr, audioLen, language,
+                                        checkpointPath, progressCallback, nullptr);
 
-    // Get language
-    const char* lang = env->GetStringUTFChars(language, nullptr);
+    env->ReleaseFloatArrayElements(audioData, audioPtr, JNI_ABORT);
+    return result;
+}
 
-    // Configure whisper parameters
-    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-    params.print_realtime = false;
-    params.print_progress = false;
-    params.print_timestamps = true;
-    params.print_special = false;
-    params.translate = false;
-    params.language = lang;
-    params.n_threads = std::min(4, (int)std::thread::hardware_concurrency());
-    params.offset_ms = 0;
-    params.no_context = true;
-    params.single_segment = false;
+JNIEXPORT jstring JNICALL
+Java_com_securevox_app_whisper_WhisperLib_transcribeAudioBuffer(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong contextPtr,
+    jobject audioBuffer,
+    jint numSamples,
+    jstring language,
+    jstring checkpointPath,
+    jobject progressCallback) {
 
-    // Progress callback
-    jclass callbackClass = nullptr;
-    jmethodID onProgressMethod = nullptr;
+    auto* ctx = reinterpret_cast<whisper_context*>(contextPtr);
+    if (ctx == nullptr) {
+        LOGE("Context is null");
+        return env->NewStringUTF("");
+    }
 
-    if (progressCallback != nullptr) {
-        callbackClass = env->GetObjectClass(progressCallback);
-        onProgressMethod = env->GetMethodID(callbackClass, "onProgress", "(I)V");
+    // Direct buffers are read in place: no copy and no pinning of the Java heap
+    auto* audioPtr = static_cast<const float*>(env->GetDirectBufferAddress(audioBuffer));
+    const jlong capacity = env->GetDirectBufferCapacity(audioBuffer);
+    if (audioPtr == nullptr || numSamples < 0 ||
+        capacity < static_cast<jlong>(numSamples) * static_cast<jlong>(sizeof(float))) {
+        LOGE("Audio buffer is not direct or holds fewer than %d samples", numSamples);
+        return env->NewStringUTF("");
     }
 
-    struct CallbackData {
-        JNIEnv* env;
-        jobject callback;
-        jmethodID method;
-    };
+    return transcribe_samples(env, ctx, audioPtr, numSamples, language,
+                              checkpointPath, progressCallback, nullptr);
+}
 
-    CallbackData cbData = { env, progressCallback, onProgressMethod };
+JNIEXPORT jstring JNICALL
+Java_com_securevox_app_whisper_WhisperLib_transcribeNativeAudio(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong contextPtr,
+    jlong audioPtr,
+    jstring language,
+    jstring checkpointPath,
+    jlong chunkMs,
+    jint bestOf,
+    jlong draftPtr,
+    jobject progressCallback) {
 
-    params.progress_callback_user_data = &cbData;
-    params.progress_callback = [](struct whisper_context* /*ctx*/,
-                                   struct whisper_state* /*state*/,
-                                   int progress,
-                                   void* user_data) {
-        auto* data = static_cast<CallbackData*>(user_data);
-        if (data->callback != nullptr && data->method != nullptr) {
-            data->env->CallVoidMethod(data->callback, data->method, progress);
-        }
-    };
+    auto* ctx = reinterpret_cast<whisper_context*>(contextPtr);
+    auto* draft = reinterpret_cast<whisper_context*>(draftPtr);
+    auto* audio = reinterpret_cast<const securevox::AudioBuffer*>(audioPtr);
+    if (ctx == nullptr || audio == nullptr) {
+        LOGE("Context or audio is null");
+        return env->NewStringUTF("");
+    }
+    if (audio->sample_rate() != WHISPER_SAMPLE_RATE) {
+        LOGE("Audio is at %d Hz, expected %d", audio->sample_rate(), WHISPER_SAMPLE_RATE);
+        return env->NewStringUTF("");
+    }
+
+    JobOptions options;
+    options.chunkMs = chunkMs;
+    options.bestOf = bestOf;
+    g_speculative_tokens_per_pass.store(0.0);
+    std::string error;
+    if (draft != nullptr && !securevox::SpeculativeDecoder::compatible(ctx, draft, error)) {
+        LOGE("Not decoding speculatively: %s", error.c_str());
+    } else if (draft != nullptr) {
+        options.speculative = true;
+        options.draft = draft;
+    }
+    prefer_short_clip(options, static_cast<int64_t>(audio->size()));
+    return transcribe_samples(env, ctx, audio->data(), static_cast<int>(audio->size()), language,
+                              checkpointPath, progressCallback, &audio->time_map(), options);
+}
 
-    // Run transcription
-    int result = whisper_full(ctx, params, audioPtr, audioLen);
+// Stored transcript of native audio for a model file, without loading the
+// model; null on a miss or when the result cache is off
+JNIEXPORT jstring JNICALL
+Java_com_securevox_app_whisper_WhisperLib_lookupResult(
+    JNIEnv* env,
+    jobject /* this */,
+    jstring modelPath,
+    jlong audioPtr,
+    jstring language,
+    jlong chunkMs,
+    jint bestOf,
+    jboolean speculative) {
+
+    auto* audio = reinterpret_cast<const securevox::AudioBuffer*>(audioPtr);
+    securevox::ResultCache& results = securevox::ResultCache::instance();
+    if (audio == nullptr || audio->sample_rate() != WHISPER_SAMPLE_RATE || !results.enabled()) {
+        return nullptr;
+    }
 
-    env->ReleaseFloatArrayElements(audioData, audioPtr, JNI_ABORT);
+    const char* path = env->GetStringUTFChars(modelPath, nullptr);
+    const uint64_t model = securevox::model_fingerprint(path);
+    env->ReleaseStringUTFChars(modelPath, path);
+    if (model == 0) return nullptr;
+
+    JobOptions options;
+    options.chunkMs = chunkMs;
+    options.bestOf = bestOf;
+    options.speculative = speculative == JNI_TRUE;
+    prefer_short_clip(options, static_cast<int64_t>(audio->size()));
+    const char* lang = env->GetStringUTFChars(language, nullptr);
+    const securevox::ResultKey key = securevox::make_result_key(audio->data(), audio->size(), model,
+                                                                result_settings(lang, options, audio->size()));
     env->ReleaseStringUTFChars(language, lang);
 
-    if (result != 0) {
-        LOGE("Transcription failed with code: %d", result);
+    std::vector<securevox::Segment> segments;
+    if (!results.load(key, segments)) return nullptr;
+
+    LOGI("Result cache hit: %zu segments", segments.size());
+    return finish_segments(env, segments, &audio->time_map());
+}
+
+// Returns {admitted, modelIndex, chunkMs, threads, bestOf, estimatedBytes, downgrades},
+// or null if a model header cannot be read
+JNIEXPORT jlongArray JNICALL
+Java_com_securevox_app_whisper_WhisperLib_planJob(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jobjectArray modelPaths,
+    jlong numSamples,
+    jint threads,
+    jint bestOf,
+    jlong budgetBytes) {
+
+    std::vector<securevox::ModelDims> candidates(env->GetArrayLength(modelPaths));
+    for (size_t i = 0; i < candidates.size(); i++) {
+        auto path = static_cast<jstring>(env->GetObjectArrayElement(modelPaths, static_cast<jsize>(i)));
+        const char* chars = env->GetStringUTFChars(path, nullptr);
+        std::string error;
+        const bool ok = securevox::read_model_dims(chars, candidates[i], error);
+        env->ReleaseStringUTFChars(path, chars);
+        env->DeleteLocalRef(path);
+        if (!ok) {
+            LOGE("Cannot plan job: %s", error.c_str());
+            return nullptr;
+        }
+    }
+
+    securevox::JobShape wanted;
+    wanted.n_samples = static_cast<uint64_t>(std::max<jlong>(numSamples, 0));
+    wanted.threads = threads;
+    wanted.decoders = bestOf;
+    const securevox::AdmissionPlan plan =
+        securevox::plan_admission(candidates, wanted, static_cast<uint64_t>(std::max<jlong>(budgetBytes, 0)));
+
+    LOGI("Admission: %s model %zu, chunk %lld ms, best_of %d, estimate %llu of %llu bytes",
+         plan.admitted ? "admitted" : "over budget", plan.model_index,
+         static_cast<long long>(plan.job.chunk_ms), plan.job.decoders,
+         static_cast<unsigned long long>(plan.estimated_bytes), static_cast<unsigned long long>(plan.budget_bytes));
+
+    const jlong values[] = {
+        plan.admitted ? 1 : 0,
+        static_cast<jlong>(plan.model_index),
+        plan.job.chunk_ms,
+        plan.job.threads,
+        plan.job.decoders,
+        static_cast<jlong>(plan.estimated_bytes),
+        plan.downgrades,
+    };
+    jlongArray result = env->NewLongArray(7);
+    if (result != nullptr) env->SetLongArrayRegion(result, 0, 7, values);
+    return result;
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_securevox_app_whisper_WhisperLib_transcribeIncremental(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong contextPtr,
+    jfloatArray audioData,
+    jstring language,
+    jlongArray previousStarts,
+    jlongArray previousEnds,
+    jobjectArray previousTexts,
+    jint editStart,
+    jint removedSamples,
+    jint insertedSamples,
+    jobject progressCallback) {
+
+    auto* ctx = reinterpret_cast<whisper_context*>(contextPtr);
+    if (ctx == nullptr) {
+        LOGE("Context is null");
         return env->NewStringUTF("");
     }
 
-    // Build result JSON with segments
-    std::string jsonResult = "[";
-    int numSegments = whisper_full_n_segments(ctx);
+    // Previous transcript, in the old timeline
+    const jsize previousCount = env->GetArrayLength(previousTexts);
+    if (env->GetArrayLength(previousStarts) != previousCount || env->GetArrayLength(previousEnds) != previousCount) {
+        env->ThrowNew(env->FindClass("java/lang/IllegalArgumentException"),
+                      "previousStarts, previousEnds and previousTexts differ in length");
+        return nullptr;
+    }
+    std::vector<securevox::Segment> previous(static_cast<size_t>(previousCount));
+    {
+        jlong* starts = env->GetLongArrayElements(previousStarts, nullptr);
+        jlong* ends = env->GetLongArrayElements(previousEnds, nullptr);
+        for (size_t i = 0; i < previous.size(); i++) {
+            previous[i].start_ms = starts[i];
+            previous[i].end_ms = ends[i];
+
+            auto text = static_cast<jstring>(env->GetObjectArrayElement(previousTexts, static_cast<jsize>(i)));
+            const char* chars = env->GetStringUTFChars(text, nullptr);
+            previous[i].text = chars;
+            env->ReleaseStringUTFChars(text, chars);
+            env->DeleteLocalRef(text);
+        }
+        env->ReleaseLongArrayElements(previousStarts, starts, JNI_ABORT);
+        env->ReleaseLongArrayElements(previousEnds, ends, JNI_ABORT);
+    }
 
-    for (int i = 0; i < numSegments; i++) {
-        const char* text = whisper_full_get_segment_text(ctx, i);
-        int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-        int64_t t1 = whisper_full_get_segment_t1(ctx, i);
+    jsize audioLen = env->GetArrayLength(audioData);
 
-        // Convert to milliseconds
-        double startMs = t0 * 10.0;
-        double endMs = t1 * 10.0;
+    securevox::AudioEdit edit;
+    edit.start_sample = editStart;
+    edit.removed_samples = removedSamples;
+    edit.inserted_samples = insertedSamples;
+    securevox::IncrementalPlan plan = securevox::plan_incremental(previous, edit, audioLen);
+
+    LOGI("Incremental: keeping %zu + %zu segments, redoing %lld-%lld ms",
+         plan.before.size(), plan.after.size(),
+         static_cast<long long>(plan.redo_start_ms), static_cast<long long>(plan.redo_end_ms));
+
+    std::vector<securevox::Segment> redone;
+    if (plan.needs_inference()) {
+        const char* lang = env->GetStringUTFChars(language, nullptr);
+
+        securevox::ThrottlePlan throttle = securevox::PowerPolicy::instance().plan(4);
+        securevox::EfficiencyCoreScope coreScope(throttle.efficiency_cores);
+        securevox::DutyCycle dutyCycle(4);
+        securevox::ThreadPool::Lease threads = securevox::ThreadPool::instance().lease(throttle.max_threads);
+
+        // Continue from the kept text so wording and casing stay consistent
+        const std::string prompt = securevox::tail_text(plan.before, RESUME_PROMPT_CHARS);
+        whisper_full_params params = make_params(lang, threads.count());
+        if (!prompt.empty()) params.initial_prompt = prompt.c_str();
+
+        CallbackData cbData = make_callback_data(env, progressCallback);
+        attach_callbacks(params, &cbData, &dutyCycle);
+        securevox::DecodeGuard guard;
+        guard.attach(params);
+
+        // Only the changed range is handed to whisper, so mel and encoder work
+        // scale with the edit rather than the recording
+        const jsize first = static_cast<jsize>(plan.redo_start_ms * WHISPER_SAMPLE_RATE / 1000);
+        const jsize last = std::min(audioLen, static_cast<jsize>(plan.redo_end_ms * WHISPER_SAMPLE_RATE / 1000));
+
+        // whisper_full returns no segments for less than a second of audio, so a
+        // shorter slice is padded with silence up to that
+        jfloat* audioPtr = env->GetFloatArrayElements(audioData, nullptr);
+        int result;
+        if (last - first < MIN_WHISPER_SAMPLES) {
+            std::vector<float> padded(static_cast<size_t>(MIN_WHISPER_SAMPLES), 0.0f);
+            std::copy(audioPtr + first, audioPtr + last, padded.begin());
+            result = whisper_full(ctx, params, padded.data(), static_cast<int>(padded.size()));
+        } else {
+            result = whisper_full(ctx, params, audioPtr + first, last - first);
+        }
+        env->ReleaseFloatArrayElements(audioData, audioPtr, JNI_ABORT);
+        env->ReleaseStringUTFChars(language, lang);
 
-        if (i > 0) jsonResult += ",";
+        if (result != 0) {
+            LOGE("Incremental transcription failed with code: %d", result);
+            return env->NewStringUTF("");
+        }
 
-        // Escape text for JSON
-        std::string escapedText;
-        for (const char* p = text; *p; p++) {
-            switch (*p) {
-                case '"': escapedText += "\\\""; break;
-                case '\\': escapedText += "\\\\"; break;
-                case '\n': escapedText += "\\n"; break;
-                case '\r': escapedText += "\\r"; break;
-                case '\t': escapedText += "\\t"; break;
-                default: escapedText += *p;
-            }
+        securevox::read_segments(ctx, nullptr, 0, redone, &guard);
+        for (securevox::Segment& segment : redone) {
+            // Padding can stretch the last segment past the redone range
+            segment.start_ms = std::min(segment.start_ms + plan.redo_start_ms, plan.redo_end_ms);
+            segment.end_ms = std::min(segment.end_ms + plan.redo_start_ms, plan.redo_end_ms);
         }
+    }
+
+    std::vector<securevox::Segment> segments = securevox::splice_segments(plan, std::move(redone));
+    LOGI("Incremental transcription complete: %zu segments", segments.size());
+    return segments_to_json(env, segments);
+}
+
+JNIEXPORT void JNICALL
+Java_com_securevox_app_whisper_WhisperLib_setMaxThreads(
+    JNIEnv* env,
+    jobject /* this */,
+    jint maxThreads) {
+
+    securevox::ThreadPool::instance().set_max_threads(maxThreads);
+    LOGI("Thread cap set to %d", securevox::ThreadPool::instance().max_threads());
+}
+
+JNIEXPORT void JNICALL
+Java_com_securevox_app_whisper_WhisperLib_configureEncoderCache(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jlong memoryBytes,
+    jstring spillDir,
+    jlong spillBytes) {
+
+    auto& cache = securevox::EncoderCache::instance();
+    cache.set_memory_budget(static_cast<size_t>(std::max<jlong>(memoryBytes, 0)));
+
+    if (spillDir != nullptr && spillBytes > 0) {
+        const char* dir = env->GetStringUTFChars(spillDir, nullptr);
+        cache.set_spill(dir, static_cast<uint64_t>(spillBytes));
+        env->ReleaseStringUTFChars(spillDir, dir);
+    } else {
+        cache.set_spill("", 0);
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_securevox_app_whisper_WhisperLib_clearEncoderCache(
+    JNIEnv* env,
+    jclass /* clazz */) {
 
-        jsonResult += "{";
-        jsonResult += "\"text\":\"" + escapedText + "\",";
-        jsonResult += "\"start\":" + std::to_string(startMs) + ",";
-        jsonResult += "\"end\":" + std::to_string(endMs);
-        jsonResult += "}";
+    securevox::EncoderCache::instance().clear();
+}
+
+JNIEXPORT void JNICALL
+Java_com_securevox_app_whisper_WhisperLib_configureResultCache(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jstring dir,
+    jlong maxBytes) {
+
+    auto& cache = securevox::ResultCache::instance();
+    if (dir != nullptr && maxBytes > 0) {
+        const char* path = env->GetStringUTFChars(dir, nullptr);
+        cache.set_storage(path, static_cast<uint64_t>(maxBytes));
+        env->ReleaseStringUTFChars(dir, path);
+        LOGI("Result cache: %zu stored transcripts", cache.stats().entries);
+    } else {
+        cache.set_storage("", 0);
     }
+}
+
+JNIEXPORT void JNICALL
+Java_com_securevox_app_whisper_WhisperLib_clearResultCache(
+    JNIEnv* env,
+    jclass /* clazz */) {
 
-    jsonResult += "]";
+    securevox::ResultCache::instance().clear();
+}
+
+JNIEXPORT void JNICALL
+Java_com_securevox_app_whisper_WhisperLib_configureShortClips(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jlong maxMs) {
 
-    LOGI("Transcription complete: %d segments", numSegments);
-    return env->NewStringUTF(jsonResult.c_str());
+    g_short_clip_ms.store(std::max<int64_t>(maxMs, 0));
+}
+
+JNIEXPORT void JNICALL
+Java_com_securevox_app_whisper_WhisperLib_setEnergyAware(
+    JNIEnv* env,
+    jobject /* this */,
+    jboolean enabled) {
+
+    securevox::PowerPolicy::instance().set_enabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL
+Java_com_securevox_app_whisper_WhisperLib_updatePowerState(
+    JNIEnv* env,
+    jobject /* this */,
+    jint batteryPercent,
+    jboolean charging,
+    jint thermalStatus,
+    jboolean powerSave) {
+
+    securevox::PowerSignals signals;
+    signals.battery_percent = batteryPercent;
+    signals.charging = charging == JNI_TRUE;
+    signals.thermal_status = thermalStatus;
+    signals.power_save = powerSave == JNI_TRUE;
+    securevox::PowerPolicy::instance().update(signals);
 }
 
 JNIEXPORT jstring JNICALL
@@ -177,6 +894,16 @@ Java_com_securevox_app_whisper_WhisperLib_getSystemInfo(
     return env->NewStringUTF(sysInfo);
 }
 
+// Tokens per large-model decoder pass in the last speculative job (plain
+// greedy makes one pass per token), 0 if there was none
+JNIEXPORT jdouble JNICALL
+Java_com_securevox_app_whisper_WhisperLib_getSpeculativeTokensPerPass(
+    JNIEnv* /* env */,
+    jobject /* this */) {
+
+    return g_speculative_tokens_per_pass.load();
+}
+
 JNIEXPORT jboolean JNICALL
 Java_com_securevox_app_whisper_WhisperLib_isMultilingual(
     JNIEnv* env,
@@ -5,12 +5,19 @@ import com.securevox.app.data.local.TranscriptSegmentDao
 import com.securevox.app.data.model.Recording
 import com.securevox.app.data.model.TranscriptSegment
 import com.securevox.app.data.model.TranscriptionStatus
+import com.securevox.app.whisper.AudioFingerprintIndex
+import com.securevox.app.whisper.TranscriptHit
+import com.securevox.app.whisper.TranscriptIndex
+import com.securevox.app.whisper.WaveformPeaks
+import com.securevox.app.whisper.WhisperLib
 import kotlinx.coroutines.flow.Flow
 import java.io.File
 
 class RecordingRepository(
     private val recordingDao: RecordingDao,
-    private val segmentDao: TranscriptSegmentDao
+    private val segmentDao: TranscriptSegmentDao,
+    private val transcriptIndex: TranscriptIndex? = null,
+    private val fingerprintIndex: AudioFingerprintIndex? = null
 ) {
 
     // Recordings
@@ -20,6 +27,9 @@ class RecordingRepository(
 
     fun getRecordingByIdFlow(id: String): Flow<Recording?> = recordingDao.getRecordingByIdFlow(id)
 
+    suspend fun getRecordingsByStatus(status: TranscriptionStatus): List<Recording> =
+        recordingDao.getRecordingsByStatus(status)
+
     suspend fun saveRecording(recording: Recording) = recordingDao.insertRecording(recording)
 
     suspend fun updateRecording(recording: Recording) = recordingDao.updateRecording(recording)
@@ -30,8 +40,19 @@ class RecordingRepository(
         if (file.exists()) {
             file.delete()
         }
+        // Delete any leftover transcription checkpoint
+        File("${recording.audioFilePath}.ckpt").delete()
+        File(WaveformPeaks.sidecarPath(recording.audioFilePath)).delete()
+        // Cached encoder output is derived from the audio; it is not indexed by
+        // recording, so drop all of it (re-runs just encode again)
+        WhisperLib.clearEncoderOutputs()
+        // Stored transcripts are not indexed by recording either; the text must
+        // not outlive the recording
+        WhisperLib.clearResults()
         // Delete from database (segments cascade delete)
         recordingDao.deleteRecording(recording)
+        transcriptIndex?.remove(recording.id)
+        fingerprintIndex?.remove(recording.id)
     }
 
     suspend fun updateTranscriptionStatus(
@@ -54,15 +75,42 @@ class RecordingRepository(
     suspend fun getSegmentsForRecordingSync(recordingId: String): List<TranscriptSegment> =
         segmentDao.getSegmentsForRecordingSync(recordingId)
 
-    suspend fun saveSegments(segments: List<TranscriptSegment>) =
+    suspend fun saveSegments(segments: List<TranscriptSegment>) {
         segmentDao.insertSegments(segments)
+        // Only the new segments are indexed; the rest of the recording stays as it is
+        transcriptIndex?.let { index ->
+            segments.groupBy { it.recordingId }.forEach { (recordingId, recordingSegments) ->
+                index.addSegments(recordingId, recordingSegments)
+            }
+        }
+    }
 
-    suspend fun deleteSegmentsForRecording(recordingId: String) =
+    suspend fun deleteSegmentsForRecording(recordingId: String) {
         segmentDao.deleteSegmentsForRecording(recordingId)
+        transcriptIndex?.remove(recordingId)
+    }
 
     suspend fun getFullTranscriptText(recordingId: String): String? =
         segmentDao.getFullTranscriptText(recordingId)
 
+    // Transcript search
+    suspend fun searchTranscripts(query: String): List<TranscriptHit> =
+        transcriptIndex?.search(query) ?: emptyList()
+
+    /**
+     * Index transcripts saved before the search index existed.
+     */
+    suspend fun rebuildTranscriptIndexIfEmpty() {
+        val index = transcriptIndex ?: return
+        if (index.recordingCount() > 0) return
+        recordingDao.getRecordingsByStatus(TranscriptionStatus.COMPLETED).forEach { recording ->
+            val segments = segmentDao.getSegmentsForRecordingSync(recording.id)
+            if (segments.isNotEmpty()) {
+                index.setRecording(recording.id, segments)
+            }
+        }
+    }
+
     // Storage stats
     suspend fun getTotalStorageUsed(): Long = recordingDao.getTotalStorageUsed() ?: 0L
 
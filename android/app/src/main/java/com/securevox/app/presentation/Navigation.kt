@@ -18,8 +18,9 @@ import com.securevox.app.whisper.WhisperModel
 sealed class Screen(val route: String) {
     object Setup : Screen("setup")
     object Recordings : Screen("recordings")
-    object RecordingDetail : Screen("recording/{recordingId}") {
-        fun createRoute(recordingId: String) = "recording/$recordingId"
+    object RecordingDetail : Screen("recording/{recordingId}?startMs={startMs}") {
+        fun createRoute(recordingId: String, startMs: Long? = null) =
+            if (startMs != null) "recording/$recordingId?startMs=$startMs" else "recording/$recordingId"
     }
     object Settings : Screen("settings")
     object FAQ : Screen("faq")
@@ -55,8 +56,8 @@ fun SecureVoxNavHost() {
 
         composable(Screen.Recordings.route) {
             RecordingsScreen(
-                onRecordingClick = { recordingId ->
-                    navController.navigate(Screen.RecordingDetail.createRoute(recordingId))
+                onRecordingClick = { recordingId, startMs ->
+                    navController.navigate(Screen.RecordingDetail.createRoute(recordingId, startMs))
                 },
                 onSettingsClick = {
                     navController.navigate(Screen.Settings.route)
@@ -67,12 +68,18 @@ fun SecureVoxNavHost() {
         composable(
             route = Screen.RecordingDetail.route,
             arguments = listOf(
-                navArgument("recordingId") { type = NavType.StringType }
+                navArgument("recordingId") { type = NavType.StringType },
+                navArgument("startMs") {
+                    type = NavType.LongType
+                    defaultValue = -1L
+                }
             )
         ) { backStackEntry ->
             val recordingId = backStackEntry.arguments?.getString("recordingId") ?: return@composable
+            val startMs = backStackEntry.arguments?.getLong("startMs") ?: -1L
             RecordingDetailScreen(
                 recordingId = recordingId,
+                startPositionMs = startMs,
                 onNavigateBack = { navController.popBackStack() }
             )
         }
@@ -5,6 +5,7 @@ import android.content.ClipboardManager
 import android.content.Context
 import android.content.Intent
 import android.widget.Toast
+import androidx.compose.foundation.Canvas
 import androidx.compose.foundation.background
 import androidx.compose.foundation.clickable
 import androidx.compose.foundation.layout.*
@@ -20,6 +21,8 @@ import androidx.compose.runtime.*
 import androidx.compose.ui.Alignment
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.draw.clip
+import androidx.compose.ui.geometry.Offset
+import androidx.compose.ui.layout.onSizeChanged
 import androidx.compose.ui.platform.LocalContext
 import androidx.compose.ui.text.font.FontWeight
 import androidx.compose.ui.unit.dp
@@ -27,6 +30,7 @@ import com.securevox.app.data.model.TranscriptSegment
 import com.securevox.app.data.model.TranscriptionStatus
 import com.securevox.app.service.ExportFormat
 import com.securevox.app.service.PlaybackSpeed
+import com.securevox.app.whisper.WaveformPeaks
 import kotlinx.coroutines.launch
 import java.text.SimpleDateFormat
 import java.util.*
@@ -35,13 +39,14 @@ import java.util.*
 @Composable
 fun RecordingDetailScreen(
     recordingId: String,
+    startPositionMs: Long = -1L,
     onNavigateBack: () -> Unit
 ) {
     val context = LocalContext.current
 
     // Create ViewModel with factory
     val viewModel = remember {
-        RecordingDetailViewModelFactory(context.applicationContext as android.app.Application, recordingId)
+        RecordingDetailViewModelFactory(context.applicationContext as android.app.Application, recordingId, startPositionMs)
             .create(RecordingDetailViewModel::class.java)
     }
 
@@ -52,6 +57,7 @@ fun RecordingDetailScreen(
     val duration by viewModel.duration.collectAsState()
     val activeSegment by viewModel.activeSegment.collectAsState()
     val playbackSpeed by viewModel.playbackSpeed.collectAsState()
+    val waveform by viewModel.waveform.collectAsState()
 
     var showDeleteDialog by remember { mutableStateOf(false) }
     var showSpeedMenu by remember { mutableStateOf(false) }
@@ -193,6 +199,7 @@ fun RecordingDetailScreen(
                 currentPosition = currentPosition,
                 duration = duration,
                 playbackSpeed = playbackSpeed,
+                waveform = waveform,
                 onPlayPause = { viewModel.togglePlayPause() },
                 onSeek = { viewModel.seekTo(it) },
                 onSkipBack = { viewModel.skipBackward() },
@@ -268,6 +275,7 @@ private fun PlaybackControls(
     currentPosition: Long,
     duration: Long,
     playbackSpeed: PlaybackSpeed,
+    waveform: WaveformPeaks?,
     onPlayPause: () -> Unit,
     onSeek: (Long) -> Unit,
     onSkipBack: () -> Unit,
@@ -285,6 +293,16 @@ private fun PlaybackControls(
                 .fillMaxWidth()
                 .padding(16.dp)
         ) {
+            waveform?.let {
+                WaveformStrip(
+                    waveform = it,
+                    progress = if (duration > 0) currentPosition.toFloat() / duration else 0f,
+                    modifier = Modifier
+                        .fillMaxWidth()
+                        .height(48.dp)
+                )
+            }
+
             // Progress slider
             Slider(
                 value = if (duration > 0) currentPosition.toFloat() / duration else 0f,
@@ -393,6 +411,47 @@ private fun PlaybackControls(
     }
 }
 
+/**
+ * Whole-recording waveform, one bar per few pixels, played part highlighted.
+ * Peaks are rendered once per size from the mapped pyramid, not per frame.
+ */
+@Composable
+private fun WaveformStrip(
+    waveform: WaveformPeaks,
+    progress: Float,
+    modifier: Modifier = Modifier
+) {
+    val barWidthPx = 3
+    var columns by remember { mutableStateOf(0) }
+    val peaks = remember(waveform, columns) {
+        if (columns > 0) waveform.render(0, waveform.durationMs, columns) else FloatArray(0)
+    }
+    // Scale to the loudest peak so quiet recordings still fill the strip
+    val scale = remember(peaks) {
+        val loudest = peaks.indices.filter { it % 3 != 2 }.maxOfOrNull { kotlin.math.abs(peaks[it]) } ?: 0f
+        if (loudest > 0f) 1f / loudest else 1f
+    }
+    val played = MaterialTheme.colorScheme.primary
+    val unplayed = MaterialTheme.colorScheme.onSurfaceVariant.copy(alpha = 0.4f)
+
+    Canvas(modifier = modifier.onSizeChanged { columns = it.width / barWidthPx }) {
+        val count = peaks.size / 3
+        if (count == 0) return@Canvas
+        val step = size.width / count
+        val middle = size.height / 2
+        for (c in 0 until count) {
+            val x = (c + 0.5f) * step
+            val color = if (c < progress * count) played else unplayed
+            // Peaks faint, RMS solid on top of them
+            val top = middle - peaks[c * 3 + 1] * scale * middle
+            val bottom = middle - peaks[c * 3] * scale * middle
+            val rms = peaks[c * 3 + 2] * scale * middle
+            drawLine(color.copy(alpha = color.alpha * 0.5f), Offset(x, top), Offset(x, maxOf(bottom, top + 1f)), strokeWidth = step * 0.7f)
+            drawLine(color, Offset(x, middle - rms), Offset(x, middle + maxOf(rms, 0.5f)), strokeWidth = step * 0.7f)
+        }
+    }
+}
+
 @Composable
 private fun TranscriptionProgress() {
     Box(
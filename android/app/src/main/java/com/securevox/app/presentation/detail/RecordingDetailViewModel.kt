@@ -11,19 +11,26 @@ import com.securevox.app.service.AudioPlayerService
 import com.securevox.app.service.ExportFormat
 import com.securevox.app.service.ExportService
 import com.securevox.app.service.PlaybackSpeed
+import com.securevox.app.whisper.AudioFingerprintIndex
+import com.securevox.app.whisper.TranscriptIndex
+import com.securevox.app.whisper.WaveformPeaks
 import android.content.Intent
 import kotlinx.coroutines.flow.*
 import kotlinx.coroutines.launch
 
 class RecordingDetailViewModel(
     application: Application,
-    private val recordingId: String
+    private val recordingId: String,
+    // Where to start playback, e.g. a transcript search match; -1 for none
+    private val startPositionMs: Long = -1L
 ) : AndroidViewModel(application) {
 
     private val database = SecureVoxDatabase.getInstance(application)
     private val repository = RecordingRepository(
         database.recordingDao(),
-        database.transcriptSegmentDao()
+        database.transcriptSegmentDao(),
+        TranscriptIndex.getInstance(application),
+        AudioFingerprintIndex.getInstance(application)
     )
     private val audioPlayer = AudioPlayerService.getInstance(application)
     private val exportService = ExportService(application)
@@ -38,6 +45,7 @@ class RecordingDetailViewModel(
     val currentPosition: StateFlow<Long> = audioPlayer.currentPosition
     val duration: StateFlow<Long> = audioPlayer.duration
     val playbackSpeed: StateFlow<PlaybackSpeed> = audioPlayer.playbackSpeed
+    val waveform: StateFlow<WaveformPeaks?> = audioPlayer.waveform
 
     val activeSegment: StateFlow<TranscriptSegment?> = combine(
         segments,
@@ -50,6 +58,9 @@ class RecordingDetailViewModel(
         viewModelScope.launch {
             recording.filterNotNull().first().let { rec ->
                 audioPlayer.load(rec.audioFilePath)
+                if (startPositionMs >= 0) {
+                    audioPlayer.seekTo(startPositionMs)
+                }
             }
         }
     }
@@ -6,13 +6,14 @@ import androidx.lifecycle.ViewModelProvider
 
 class RecordingDetailViewModelFactory(
     private val application: Application,
-    private val recordingId: String
+    private val recordingId: String,
+    private val startPositionMs: Long = -1L
 ) : ViewModelProvider.Factory {
 
     @Suppress("UNCHECKED_CAST")
     override fun <T : ViewModel> create(modelClass: Class<T>): T {
         if (modelClass.isAssignableFrom(RecordingDetailViewModel::class.java)) {
-            return RecordingDetailViewModel(application, recordingId) as T
+            return RecordingDetailViewModel(application, recordingId, startPositionMs) as T
         }
         throw IllegalArgumentException("Unknown ViewModel class")
     }
@@ -26,13 +26,14 @@ import androidx.lifecycle.viewmodel.compose.viewModel
 import com.securevox.app.data.model.Recording
 import com.securevox.app.data.model.TranscriptionStatus
 import com.securevox.app.service.MediaImportService
+import com.securevox.app.whisper.TranscriptHit
 import java.text.SimpleDateFormat
 import java.util.*
 
 @OptIn(ExperimentalMaterial3Api::class)
 @Composable
 fun RecordingsScreen(
-    onRecordingClick: (String) -> Unit,
+    onRecordingClick: (recordingId: String, startMs: Long?) -> Unit,
     onSettingsClick: () -> Unit,
     viewModel: RecordingsViewModel = viewModel()
 ) {
@@ -41,6 +42,7 @@ fun RecordingsScreen(
     val audioLevel by viewModel.audioLevel.collectAsState()
     val recordingDuration by viewModel.recordingDuration.collectAsState()
     val searchQuery by viewModel.searchQuery.collectAsState()
+    val transcriptHits by viewModel.transcriptHits.collectAsState()
     val filter by viewModel.filter.collectAsState()
     val isImporting by viewModel.isImporting.collectAsState()
     val importError by viewModel.importError.collectAsState()
@@ -144,9 +146,11 @@ fun RecordingsScreen(
                     verticalArrangement = Arrangement.spacedBy(8.dp)
                 ) {
                     items(recordings, key = { it.id }) { recording ->
+                        val hit = if (searchQuery.isNotBlank()) transcriptHits[recording.id] else null
                         SwipeableRecordingItem(
                             recording = recording,
-                            onClick = { onRecordingClick(recording.id) },
+                            transcriptHit = hit,
+                            onClick = { onRecordingClick(recording.id, hit?.timeMs) },
                             onDelete = { viewModel.deleteRecording(recording) },
                             onToggleFavorite = { viewModel.toggleFavorite(recording) }
                         )
@@ -411,6 +415,7 @@ private fun FilterTabs(
 @Composable
 private fun SwipeableRecordingItem(
     recording: Recording,
+    transcriptHit: TranscriptHit?,
     onClick: () -> Unit,
     onDelete: () -> Unit,
     onToggleFavorite: () -> Unit
@@ -472,6 +477,14 @@ private fun SwipeableRecordingItem(
                         color = MaterialTheme.colorScheme.onSurfaceVariant
                     )
                 }
+                transcriptHit?.let { hit ->
+                    Spacer(modifier = Modifier.height(2.dp))
+                    Text(
+                        text = "Transcript match at ${formatDuration(hit.timeMs)}",
+                        style = MaterialTheme.typography.bodySmall,
+                        color = MaterialTheme.colorScheme.primary
+                    )
+                }
             }
 
             Row(
@@ -9,10 +9,15 @@ import com.securevox.app.data.local.SecureVoxDatabase
 import com.securevox.app.data.model.Recording
 import com.securevox.app.data.model.TranscriptionStatus
 import com.securevox.app.data.repository.RecordingRepository
+import com.securevox.app.service.AudioArchiveWorker
 import com.securevox.app.service.AudioRecorderService
 import com.securevox.app.service.ImportResult
 import com.securevox.app.service.MediaImportService
 import com.securevox.app.service.TranscriptionWorker
+import com.securevox.app.whisper.AudioFingerprintIndex
+import com.securevox.app.whisper.TranscriptHit
+import com.securevox.app.whisper.TranscriptIndex
+import kotlinx.coroutines.Job
 import kotlinx.coroutines.flow.*
 import kotlinx.coroutines.launch
 import java.io.File
@@ -32,7 +37,9 @@ class RecordingsViewModel(application: Application) : AndroidViewModel(applicati
     private val database = SecureVoxDatabase.getInstance(application)
     private val repository = RecordingRepository(
         database.recordingDao(),
-        database.transcriptSegmentDao()
+        database.transcriptSegmentDao(),
+        TranscriptIndex.getInstance(application),
+        AudioFingerprintIndex.getInstance(application)
     )
     private val audioRecorder = AudioRecorderService(application)
     private val mediaImportService = MediaImportService.getInstance(application)
@@ -55,11 +62,18 @@ class RecordingsViewModel(application: Application) : AndroidViewModel(applicati
     private val allRecordings: StateFlow<List<Recording>> = repository.getAllRecordings()
         .stateIn(viewModelScope, SharingStarted.Lazily, emptyList())
 
+    // First transcript match per recording for the current query
+    private val _transcriptHits = MutableStateFlow<Map<String, TranscriptHit>>(emptyMap())
+    val transcriptHits: StateFlow<Map<String, TranscriptHit>> = _transcriptHits.asStateFlow()
+
+    private var searchJob: Job? = null
+
     val recordings: StateFlow<List<Recording>> = combine(
         allRecordings,
         _searchQuery,
-        _filter
-    ) { recordings, query, filter ->
+        _filter,
+        _transcriptHits
+    ) { recordings, query, filter, hits ->
         var filtered = recordings
 
         // Apply favorites filter
@@ -67,10 +81,10 @@ class RecordingsViewModel(application: Application) : AndroidViewModel(applicati
             filtered = filtered.filter { it.isFavorite }
         }
 
-        // Apply search filter
+        // Apply search filter (title or transcript)
         if (query.isNotBlank()) {
             filtered = filtered.filter {
-                it.title.contains(query, ignoreCase = true)
+                it.title.contains(query, ignoreCase = true) || hits.containsKey(it.id)
             }
         }
 
@@ -87,9 +101,17 @@ class RecordingsViewModel(application: Application) : AndroidViewModel(applicati
         File(getApplication<Application>().filesDir, "recordings").also { it.mkdirs() }
     }
 
+    init {
+        viewModelScope.launch {
+            repository.rebuildTranscriptIndexIfEmpty()
+        }
+        // Shrink WAV recordings made before capture was encoded to FLAC
+        AudioArchiveWorker.enqueue(application)
+    }
+
     fun startRecording() {
         val timestamp = SimpleDateFormat("yyyyMMdd_HHmmss", Locale.US).format(Date())
-        val fileName = "recording_$timestamp.wav"
+        val fileName = "recording_$timestamp.flac"
         val filePath = File(recordingsDir, fileName).absolutePath
 
         if (audioRecorder.startRecording(filePath)) {
@@ -144,6 +166,14 @@ class RecordingsViewModel(application: Application) : AndroidViewModel(applicati
 
     fun setSearchQuery(query: String) {
         _searchQuery.value = query
+
+        // Only the latest query matters while typing
+        searchJob?.cancel()
+        searchJob = viewModelScope.launch {
+            _transcriptHits.value = repository.searchTranscripts(query)
+                .groupBy { it.recordingId }
+                .mapValues { (_, hits) -> hits.first() }
+        }
     }
 
     fun setFilter(filter: RecordingsFilter) {
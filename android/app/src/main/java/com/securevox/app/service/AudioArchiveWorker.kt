@@ -0,0 +1,93 @@
+package com.securevox.app.service
+
+import android.content.Context
+import android.util.Log
+import androidx.work.*
+import com.securevox.app.data.local.SecureVoxDatabase
+import com.securevox.app.data.model.TranscriptionStatus
+import com.securevox.app.data.repository.RecordingRepository
+import com.securevox.app.whisper.NativeFlacWriter
+import com.securevox.app.whisper.WaveformPeaks
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+import java.io.File
+
+/**
+ * Background re-encoding of WAV recordings to FLAC.
+ *
+ * Recordings made before capture was encoded natively are plain 16-bit WAV, about
+ * twice the size of the same audio as FLAC. Only transcribed recordings are
+ * converted, so no running transcription or resumable checkpoint refers to the
+ * old path. The conversion is lossless, so content-addressed caches still hit.
+ */
+class AudioArchiveWorker(
+    context: Context,
+    params: WorkerParameters
+) : CoroutineWorker(context, params) {
+
+    companion object {
+        private const val TAG = "AudioArchiveWorker"
+        private const val WORK_NAME = "audio_archive"
+
+        /** Output: number of recordings converted */
+        const val KEY_CONVERTED = "converted"
+
+        /**
+         * Queue a conversion pass unless one is already waiting.
+         */
+        fun enqueue(context: Context) {
+            val request = OneTimeWorkRequestBuilder<AudioArchiveWorker>()
+                .setConstraints(
+                    Constraints.Builder()
+                        .setRequiresBatteryNotLow(true)
+                        .build()
+                )
+                .build()
+            WorkManager.getInstance(context)
+                .enqueueUniqueWork(WORK_NAME, ExistingWorkPolicy.KEEP, request)
+        }
+    }
+
+    private val database = SecureVoxDatabase.getInstance(applicationContext)
+    private val repository = RecordingRepository(
+        database.recordingDao(),
+        database.transcriptSegmentDao()
+    )
+
+    override suspend fun doWork(): Result = withContext(Dispatchers.IO) {
+        val candidates = repository.getRecordingsByStatus(TranscriptionStatus.COMPLETED)
+            .filter { it.audioFilePath.endsWith(".wav", ignoreCase = true) }
+
+        var converted = 0
+        for (candidate in candidates) {
+            if (isStopped) break
+
+            val wav = File(candidate.audioFilePath)
+            if (!wav.exists()) continue
+            val flac = File(wav.parentFile, wav.nameWithoutExtension + ".flac")
+
+            // Refuses anything but 16-bit mono, e.g. imported stereo files
+            if (!NativeFlacWriter.convertWav(wav.absolutePath, flac.absolutePath)) {
+                Log.i(TAG, "Left as WAV: ${wav.name}")
+                continue
+            }
+
+            // Re-read: the recording may have been deleted or re-queued meanwhile
+            val recording = repository.getRecordingById(candidate.id)
+            if (recording == null || recording.audioFilePath != candidate.audioFilePath ||
+                recording.transcriptionStatus != TranscriptionStatus.COMPLETED) {
+                flac.delete()
+                continue
+            }
+
+            repository.updateRecording(recording.copy(audioFilePath = flac.absolutePath, fileSize = flac.length()))
+            wav.delete()
+            File("${wav.absolutePath}.ckpt").delete()
+            File(WaveformPeaks.sidecarPath(wav.absolutePath)).delete()
+            converted++
+            Log.i(TAG, "${wav.name}: ${candidate.fileSize} -> ${flac.length()} bytes")
+        }
+
+        Result.success(workDataOf(KEY_CONVERTED to converted))
+    }
+}
@@ -5,6 +5,7 @@ import android.media.MediaPlayer
 import android.media.PlaybackParams
 import android.os.Build
 import android.util.Log
+import com.securevox.app.whisper.WaveformPeaks
 import kotlinx.coroutines.*
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
@@ -71,6 +72,10 @@ class AudioPlayerService private constructor(private val context: Context) {
     private var _isLoaded = MutableStateFlow(false)
     val isLoaded: StateFlow<Boolean> = _isLoaded.asStateFlow()
 
+    // Peaks of the loaded file for drawing its waveform; null until mapped
+    private val _waveform = MutableStateFlow<WaveformPeaks?>(null)
+    val waveform: StateFlow<WaveformPeaks?> = _waveform.asStateFlow()
+
     /**
      * Load an audio file for playback.
      * If the same file is already loaded, this does nothing.
@@ -100,7 +105,7 @@ class AudioPlayerService private constructor(private val context: Context) {
         }
 
         if (file.length() < 44) {
-            Log.e(TAG, "File too small to be valid WAV: ${file.length()} bytes")
+            Log.e(TAG, "File too small to be valid audio: ${file.length()} bytes")
             return false
         }
 
@@ -131,6 +136,7 @@ class AudioPlayerService private constructor(private val context: Context) {
             _currentPosition.value = 0L
             _isLoaded.value = true
             Log.i(TAG, "Loaded successfully: $filePath, duration: ${_duration.value}ms")
+            loadWaveform(filePath)
             return true
 
         } catch (e: Exception) {
@@ -250,6 +256,33 @@ class AudioPlayerService private constructor(private val context: Context) {
         setPlaybackSpeed(speeds[nextIndex])
     }
 
+    /**
+     * Map the peak sidecar of a file, building it first if it is missing or
+     * older than the audio. Rendering and closing both happen on the main
+     * thread, so the peaks are never released while being drawn.
+     */
+    private fun loadWaveform(filePath: String) {
+        scope.launch {
+            val peaks = withContext(Dispatchers.IO) {
+                val audio = File(filePath)
+                val sidecar = File(WaveformPeaks.sidecarPath(filePath))
+                val stale = !sidecar.exists() || sidecar.lastModified() < audio.lastModified()
+                if (stale && !WaveformPeaks.build(filePath, sidecar.path)) {
+                    Log.w(TAG, "No waveform for $filePath")
+                    return@withContext null
+                }
+                WaveformPeaks.open(sidecar.path)
+            }
+            // The player may have moved on to another file meanwhile
+            if (filePath == currentFilePath) {
+                _waveform.value?.close()
+                _waveform.value = peaks
+            } else {
+                peaks?.close()
+            }
+        }
+    }
+
     private fun startPositionUpdates() {
         positionUpdateJob?.cancel()
         positionUpdateJob = scope.launch {
@@ -272,6 +305,8 @@ class AudioPlayerService private constructor(private val context: Context) {
      */
     fun release() {
         stopPositionUpdates()
+        _waveform.value?.close()
+        _waveform.value = null
         mediaPlayer?.release()
         mediaPlayer = null
         currentFilePath = null
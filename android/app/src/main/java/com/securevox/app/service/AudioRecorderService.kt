@@ -8,20 +8,18 @@ import android.media.AudioRecord
 import android.media.MediaRecorder
 import android.util.Log
 import androidx.core.content.ContextCompat
+import com.securevox.app.whisper.NativeFlacWriter
 import kotlinx.coroutines.*
 import kotlin.coroutines.coroutineContext
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
 import java.io.File
-import java.io.FileOutputStream
-import java.io.RandomAccessFile
-import java.nio.ByteBuffer
-import java.nio.ByteOrder
 
 /**
  * Service for recording audio using AudioRecord.
- * Records at 16kHz mono for optimal Whisper compatibility.
+ * Records at 16kHz mono for optimal Whisper compatibility, encoded losslessly
+ * to FLAC while capturing.
  */
 class AudioRecorderService(private val context: Context) {
 
@@ -49,7 +47,7 @@ class AudioRecorderService(private val context: Context) {
 
     /**
      * Start recording audio to a file.
-     * @param outputPath Path where the WAV file will be saved
+     * @param outputPath Path where the FLAC file will be saved
      * @return true if recording started successfully
      */
     fun startRecording(outputPath: String): Boolean {
@@ -111,7 +109,7 @@ class AudioRecorderService(private val context: Context) {
     }
 
     /**
-     * Stop recording and finalize the WAV file.
+     * Stop recording and finalize the FLAC file.
      * @return Path to the recorded file, or null if failed
      */
     fun stopRecording(): String? {
@@ -139,14 +137,16 @@ class AudioRecorderService(private val context: Context) {
     private suspend fun recordAudioToFile(bufferSize: Int) {
         val buffer = ShortArray(bufferSize)
         val startTime = System.currentTimeMillis()
+        val path = outputFile!!.absolutePath
 
-        FileOutputStream(outputFile).use { fos ->
-            // Write placeholder WAV header (will be updated at the end)
-            val header = ByteArray(44)
-            fos.write(header)
-
-            var totalBytesWritten = 0L
+        // Capture chunks are encoded natively as they arrive; no per-read allocation
+        val writer = NativeFlacWriter.open(path, SAMPLE_RATE)
+        if (writer == null) {
+            Log.e(TAG, "Cannot create $path")
+            return
+        }
 
+        try {
             while (_isRecording.value && coroutineContext.isActive) {
                 val readResult = audioRecord?.read(buffer, 0, buffer.size) ?: -1
 
@@ -154,14 +154,10 @@ class AudioRecorderService(private val context: Context) {
                     // Calculate audio level for visualization
                     updateAudioLevel(buffer, readResult)
 
-                    // Convert shorts to bytes and write
-                    val byteBuffer = ByteBuffer.allocate(readResult * 2)
-                    byteBuffer.order(ByteOrder.LITTLE_ENDIAN)
-                    for (i in 0 until readResult) {
-                        byteBuffer.putShort(buffer[i])
+                    if (!writer.write(buffer, 0, readResult)) {
+                        Log.e(TAG, "Write failed, stopping capture: $path")
+                        break
                     }
-                    fos.write(byteBuffer.array())
-                    totalBytesWritten += readResult * 2
 
                     // Update duration
                     _recordingDuration.value = System.currentTimeMillis() - startTime
@@ -169,10 +165,8 @@ class AudioRecorderService(private val context: Context) {
 
                 yield()
             }
-
-            // Update WAV header with actual size
-            fos.close()
-            updateWavHeader(outputFile!!, totalBytesWritten)
+        } finally {
+            if (!writer.finish()) Log.e(TAG, "Failed to finalize $path")
         }
     }
 
@@ -188,40 +182,6 @@ class AudioRecorderService(private val context: Context) {
         _audioLevel.value = normalized.toFloat()
     }
 
-    private fun updateWavHeader(file: File, dataSize: Long) {
-        RandomAccessFile(file, "rw").use { raf ->
-            val totalSize = dataSize + 36
-
-            // Write WAV header
-            raf.seek(0)
-            raf.writeBytes("RIFF")
-            raf.writeIntLE(totalSize.toInt())
-            raf.writeBytes("WAVE")
-            raf.writeBytes("fmt ")
-            raf.writeIntLE(16) // Subchunk1Size
-            raf.writeShortLE(1) // AudioFormat (PCM)
-            raf.writeShortLE(1) // NumChannels (mono)
-            raf.writeIntLE(SAMPLE_RATE) // SampleRate
-            raf.writeIntLE(SAMPLE_RATE * 2) // ByteRate
-            raf.writeShortLE(2) // BlockAlign
-            raf.writeShortLE(16) // BitsPerSample
-            raf.writeBytes("data")
-            raf.writeIntLE(dataSize.toInt())
-        }
-    }
-
-    private fun RandomAccessFile.writeIntLE(value: Int) {
-        write(value and 0xFF)
-        write((value shr 8) and 0xFF)
-        write((value shr 16) and 0xFF)
-        write((value shr 24) and 0xFF)
-    }
-
-    private fun RandomAccessFile.writeShortLE(value: Int) {
-        write(value and 0xFF)
-        write((value shr 8) and 0xFF)
-    }
-
     private fun hasPermission(): Boolean {
         return ContextCompat.checkSelfPermission(
             context,
@@ -2,18 +2,27 @@ package com.securevox.app.service
 
 import android.content.Context
 import android.content.Intent
+import android.os.ParcelFileDescriptor
 import android.util.Log
 import androidx.core.content.FileProvider
 import com.securevox.app.data.model.TranscriptSegment
+import com.securevox.app.whisper.NativeExporter
 import java.io.File
+import java.io.IOException
 
 /**
  * Export format options matching iOS
  */
-enum class ExportFormat(val extension: String, val mimeType: String, val displayName: String) {
-    TXT("txt", "text/plain", "Plain Text (.txt)"),
-    SRT("srt", "application/x-subrip", "SubRip Subtitle (.srt)"),
-    VTT("vtt", "text/vtt", "WebVTT (.vtt)")
+enum class ExportFormat(
+    val extension: String,
+    val mimeType: String,
+    val displayName: String,
+    val nativeFormat: Int
+) {
+    TXT("txt", "text/plain", "Plain Text (.txt)", NativeExporter.FORMAT_TXT),
+    SRT("srt", "application/x-subrip", "SubRip Subtitle (.srt)", NativeExporter.FORMAT_SRT),
+    VTT("vtt", "text/vtt", "WebVTT (.vtt)", NativeExporter.FORMAT_VTT),
+    JSON("json", "application/json", "JSON (.json)", NativeExporter.FORMAT_JSON)
 }
 
 /**
@@ -24,17 +33,9 @@ class ExportService(private val context: Context) {
 
     companion object {
         private const val TAG = "ExportService"
-    }
 
-    /**
-     * Generate transcript content in the specified format.
-     */
-    fun generateContent(segments: List<TranscriptSegment>, format: ExportFormat): String {
-        return when (format) {
-            ExportFormat.TXT -> generateTxt(segments)
-            ExportFormat.SRT -> generateSrt(segments)
-            ExportFormat.VTT -> generateVtt(segments)
-        }
+        // Subtitle line wrap width (common broadcast guideline)
+        private const val MAX_LINE_CHARS = 42
     }
 
     /**
@@ -46,11 +47,10 @@ class ExportService(private val context: Context) {
         fileName: String
     ): Intent? {
         try {
-            val content = generateContent(segments, format)
             val sanitizedFileName = sanitizeFileName(fileName)
             val file = createExportFile(sanitizedFileName, format.extension)
 
-            file.writeText(content)
+            writeSegments(segments, format, file)
             Log.i(TAG, "Exported to: ${file.absolutePath}")
 
             val uri = FileProvider.getUriForFile(
@@ -71,77 +71,25 @@ class ExportService(private val context: Context) {
     }
 
     /**
-     * Generate plain text format.
-     * Simple text without timestamps, segments joined with double line breaks.
+     * Stream segments to the file through the native exporter.
      */
-    private fun generateTxt(segments: List<TranscriptSegment>): String {
-        return segments.joinToString("\n\n") { it.text }
-    }
-
-    /**
-     * Generate SRT (SubRip) format.
-     * Industry-standard subtitle format with timestamps.
-     *
-     * Format:
-     * 1
-     * 00:00:00,000 --> 00:00:05,000
-     * First segment text
-     *
-     * 2
-     * 00:00:05,000 --> 00:00:10,000
-     * Second segment text
-     */
-    private fun generateSrt(segments: List<TranscriptSegment>): String {
-        return segments.mapIndexed { index, segment ->
-            val startTime = formatSrtTimestamp(segment.startTimeMs)
-            val endTime = formatSrtTimestamp(segment.endTimeMs)
-            "${index + 1}\n$startTime --> $endTime\n${segment.text}"
-        }.joinToString("\n\n")
-    }
-
-    /**
-     * Generate WebVTT format.
-     * Web-compatible subtitle format.
-     *
-     * Format:
-     * WEBVTT
-     *
-     * 00:00:00.000 --> 00:00:05.000
-     * First segment text
-     *
-     * 00:00:05.000 --> 00:00:10.000
-     * Second segment text
-     */
-    private fun generateVtt(segments: List<TranscriptSegment>): String {
-        val header = "WEBVTT\n\n"
-        val body = segments.joinToString("\n\n") { segment ->
-            val startTime = formatVttTimestamp(segment.startTimeMs)
-            val endTime = formatVttTimestamp(segment.endTimeMs)
-            "$startTime --> $endTime\n${segment.text}"
+    private fun writeSegments(segments: List<TranscriptSegment>, format: ExportFormat, file: File) {
+        val mode = ParcelFileDescriptor.MODE_WRITE_ONLY or
+            ParcelFileDescriptor.MODE_CREATE or
+            ParcelFileDescriptor.MODE_TRUNCATE
+
+        ParcelFileDescriptor.open(file, mode).use { pfd ->
+            val written = NativeExporter.write(
+                starts = LongArray(segments.size) { segments[it].startTimeMs },
+                ends = LongArray(segments.size) { segments[it].endTimeMs },
+                texts = Array(segments.size) { segments[it].text },
+                speakers = null,
+                format = format.nativeFormat,
+                maxLineChars = MAX_LINE_CHARS,
+                fd = pfd.fd
+            )
+            if (!written) throw IOException("Failed to write ${file.name}")
         }
-        return header + body
-    }
-
-    /**
-     * Format timestamp for SRT format: HH:MM:SS,mmm
-     */
-    private fun formatSrtTimestamp(millis: Long): String {
-        val hours = millis / (1000 * 60 * 60)
-        val minutes = (millis / (1000 * 60)) % 60
-        val seconds = (millis / 1000) % 60
-        val ms = millis % 1000
-        return String.format("%02d:%02d:%02d,%03d", hours, minutes, seconds, ms)
-    }
-
-    /**
-     * Format timestamp for VTT format: HH:MM:SS.mmm
-     */
-    private fun formatVttTimestamp(millis: Long): String {
-        val hours = millis / (1000 * 60 * 60)
-        val minutes = (millis / (1000 * 60)) % 60
-        val seconds = (millis / 1000) % 60
-        val ms = millis % 1000
-        return String.format("%02d:%02d:%02d.%03d", hours, minutes, seconds, ms)
     }
 
     /**
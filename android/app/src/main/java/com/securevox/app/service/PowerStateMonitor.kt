@@ -0,0 +1,101 @@
+package com.securevox.app.service
+
+import android.content.BroadcastReceiver
+import android.content.Context
+import android.content.Intent
+import android.content.IntentFilter
+import android.os.BatteryManager
+import android.os.Build
+import android.os.PowerManager
+import com.securevox.app.whisper.WhisperLib
+
+/**
+ * Feeds battery, charger and thermal changes to the native throttling policy
+ * while a background transcription is running.
+ */
+class PowerStateMonitor(
+    private val context: Context,
+    private val whisperLib: WhisperLib
+) {
+    private val powerManager = context.getSystemService(Context.POWER_SERVICE) as PowerManager
+
+    private var lastBatteryIntent: Intent? = null
+
+    private val batteryReceiver = object : BroadcastReceiver() {
+        override fun onReceive(context: Context, intent: Intent) {
+            if (intent.action == Intent.ACTION_BATTERY_CHANGED) {
+                lastBatteryIntent = intent
+            }
+            report()
+        }
+    }
+
+    private val thermalListener: Any? =
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) {
+            PowerManager.OnThermalStatusChangedListener { report() }
+        } else {
+            null
+        }
+
+    /**
+     * Enable the energy-aware mode and start reporting state changes.
+     */
+    fun start() {
+        whisperLib.setEnergyAwareMode(true)
+
+        val filter = IntentFilter().apply {
+            addAction(Intent.ACTION_BATTERY_CHANGED)
+            addAction(PowerManager.ACTION_POWER_SAVE_MODE_CHANGED)
+        }
+        // ACTION_BATTERY_CHANGED is sticky, so the current state is delivered immediately
+        lastBatteryIntent = context.registerReceiver(batteryReceiver, filter)
+
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) {
+            powerManager.addThermalStatusListener(
+                thermalListener as PowerManager.OnThermalStatusChangedListener
+            )
+        }
+
+        report()
+    }
+
+    /**
+     * Stop reporting and return the native layer to full speed.
+     */
+    fun stop() {
+        try {
+            context.unregisterReceiver(batteryReceiver)
+        } catch (e: IllegalArgumentException) {
+            // Not registered
+        }
+
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) {
+            powerManager.removeThermalStatusListener(
+                thermalListener as PowerManager.OnThermalStatusChangedListener
+            )
+        }
+
+        whisperLib.setEnergyAwareMode(false)
+    }
+
+    private fun report() {
+        val intent = lastBatteryIntent
+        val level = intent?.getIntExtra(BatteryManager.EXTRA_LEVEL, -1) ?: -1
+        val scale = intent?.getIntExtra(BatteryManager.EXTRA_SCALE, -1) ?: -1
+        val batteryPercent = if (level >= 0 && scale > 0) level * 100 / scale else -1
+        val plugged = (intent?.getIntExtra(BatteryManager.EXTRA_PLUGGED, 0) ?: 0) != 0
+
+        val thermalStatus = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) {
+            powerManager.currentThermalStatus
+        } else {
+            0 // PowerManager.THERMAL_STATUS_NONE
+        }
+
+        whisperLib.reportPowerState(
+            batteryPercent = batteryPercent,
+            charging = plugged,
+            thermalStatus = thermalStatus,
+            powerSave = powerManager.isPowerSaveMode
+        )
+    }
+}
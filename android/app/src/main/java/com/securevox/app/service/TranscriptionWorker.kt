@@ -1,5 +1,6 @@
 package com.securevox.app.service
 
+import android.app.ActivityManager
 import android.content.Context
 import android.util.Log
 import androidx.work.*
@@ -7,6 +8,9 @@ import com.securevox.app.data.local.SecureVoxDatabase
 import com.securevox.app.data.model.TranscriptSegment
 import com.securevox.app.data.model.TranscriptionStatus
 import com.securevox.app.data.repository.RecordingRepository
+import com.securevox.app.whisper.AudioFingerprintIndex
+import com.securevox.app.whisper.NativeAudio
+import com.securevox.app.whisper.TranscriptIndex
 import com.securevox.app.whisper.TranscriptionSegment as WhisperSegment
 import com.securevox.app.whisper.WhisperLib
 import com.securevox.app.whisper.WhisperModel
@@ -14,9 +18,6 @@ import com.securevox.app.SecureVoxApp
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.withContext
 import java.io.File
-import java.io.FileInputStream
-import java.nio.ByteBuffer
-import java.nio.ByteOrder
 
 /**
  * WorkManager Worker for background transcription.
@@ -32,16 +33,56 @@ class TranscriptionWorker(
         const val KEY_MODEL_NAME = "model_name"
         const val KEY_LANGUAGE = "language"
         const val KEY_PROGRESS = "progress"
+        /** Input: native memory budget in bytes; 0 or absent uses what the system reports available */
+        const val KEY_MEMORY_BUDGET = "memory_budget"
+        /** Input: suppress background noise before transcribing (noisy field recordings) */
+        const val KEY_SUPPRESS_NOISE = "suppress_noise"
+        /** Output: the model and downgrades chosen to fit the budget, or why the job did not fit */
+        const val KEY_ADMISSION = "admission"
+        /** Output: id of the recording whose transcript was reused instead of transcribing */
+        const val KEY_REUSED_FROM = "reused_from"
+        /** Input: let the tiny model draft tokens for a larger one when the budget allows */
+        const val KEY_SPECULATIVE = "speculative"
+        /** Output: tokens per large-model decoder pass when the tiny model drafted them */
+        const val KEY_SPECULATIVE_TOKENS_PER_PASS = "speculative_tokens_per_pass"
+
+        // A fingerprint match is reused when this recording lies inside the matched
+        // one (within the tolerance) and the shared audio covers this much of it
+        private const val DUPLICATE_TOLERANCE_MS = 2_000L
+        private const val DUPLICATE_MIN_COVERAGE = 0.5
+
+        // Encoder outputs kept for re-runs: a few windows in memory (3-8 MB each,
+        // depending on the model), the rest spilled under cacheDir
+        private const val ENCODER_CACHE_MEMORY_BYTES = 32L * 1024 * 1024
+        private const val ENCODER_CACHE_DISK_BYTES = 512L * 1024 * 1024
+        private const val ENCODER_CACHE_DIR = "encoder-cache"
+
+        // Finished transcripts by audio content; a few KB each, so this holds thousands
+        private const val RESULT_CACHE_BYTES = 64L * 1024 * 1024
+        private const val RESULT_CACHE_DIR = "transcript-cache"
+
+        // Most voice memos are shorter than this; they are encoded at their own length
+        private const val SHORT_CLIP_MAX_MS = 15_000L
+
+        // The tiny model drafts tokens for a larger one only with this many times
+        // its file size left in the budget (weights plus its own state)
+        private const val DRAFT_HEADROOM_FACTOR = 2
 
         fun createWorkRequest(
             recordingId: String,
             modelName: String = "ggml-tiny.bin",
-            language: String = "en"
+            language: String = "en",
+            memoryBudgetBytes: Long = 0L,
+            suppressNoise: Boolean = false,
+            speculative: Boolean = false
         ): OneTimeWorkRequest {
             val inputData = workDataOf(
                 KEY_RECORDING_ID to recordingId,
                 KEY_MODEL_NAME to modelName,
-                KEY_LANGUAGE to language
+                KEY_LANGUAGE to language,
+                KEY_MEMORY_BUDGET to memoryBudgetBytes,
+                KEY_SUPPRESS_NOISE to suppressNoise,
+                KEY_SPECULATIVE to speculative
             )
 
             return OneTimeWorkRequestBuilder<TranscriptionWorker>()
@@ -56,9 +97,12 @@ class TranscriptionWorker(
     }
 
     private val database = SecureVoxDatabase.getInstance(applicationContext)
+    private val fingerprintIndex = AudioFingerprintIndex.getInstance(applicationContext)
     private val repository = RecordingRepository(
         database.recordingDao(),
-        database.transcriptSegmentDao()
+        database.transcriptSegmentDao(),
+        TranscriptIndex.getInstance(applicationContext),
+        fingerprintIndex
     )
 
     override suspend fun doWork(): Result = withContext(Dispatchers.Default) {
@@ -77,8 +121,30 @@ class TranscriptionWorker(
             val recording = repository.getRecordingById(recordingId)
                 ?: return@withContext Result.failure()
 
-            // Initialize Whisper with downloaded model
-            val whisperLib = WhisperLib(applicationContext)
+            // Load audio file
+            val audioData = loadAudioFile(
+                recording.audioFilePath,
+                inputData.getBoolean(KEY_SUPPRESS_NOISE, false)
+            )
+            if (audioData == null) {
+                Log.e(TAG, "Failed to load audio file")
+                repository.updateTranscriptionStatus(recordingId, TranscriptionStatus.FAILED, 0)
+                return@withContext Result.failure()
+            }
+
+            // The same audio imported before (another bitrate, the track of a video)
+            // gets that transcript, shifted to this recording's timeline
+            val duplicate = duplicateTranscript(recordingId, audioData)
+            if (duplicate != null) {
+                audioData.close()
+                val (sourceId, reusedSegments) = duplicate
+                repository.deleteSegmentsForRecording(recordingId)
+                repository.saveSegments(reusedSegments)
+                repository.updateTranscriptionStatus(recordingId, TranscriptionStatus.COMPLETED, 100)
+                Log.i(TAG, "Reused ${reusedSegments.size} segments of recording $sourceId")
+                return@withContext Result.success(workDataOf(KEY_REUSED_FROM to sourceId))
+            }
+
             val modelManager = SecureVoxApp.instance.modelManager
 
             // Find the model by filename, default to TINY
@@ -88,40 +154,114 @@ class TranscriptionWorker(
             if (!modelManager.isModelDownloaded(whisperModel)) {
                 Log.e(TAG, "Model not downloaded: ${whisperModel.fileName}")
                 repository.updateTranscriptionStatus(recordingId, TranscriptionStatus.FAILED, 0)
+                audioData.close()
                 return@withContext Result.failure()
             }
 
-            // Get the model path from ModelManager
-            val modelPath = modelManager.getModelPath(whisperModel)
-            Log.i(TAG, "Initializing Whisper with model: $modelPath")
-
-            val initialized = whisperLib.initialize(modelPath)
-
-            if (!initialized) {
-                Log.e(TAG, "Failed to initialize Whisper model from: $modelPath")
+            // Fit the job into memory before loading anything: a job over budget is
+            // chunked, decoded with one decoder or moved to a smaller downloaded model
+            // instead of being OOM-killed part way through
+            val candidates = listOf(whisperModel) + WhisperModel.entries
+                .filter { it.sizeBytes < whisperModel.sizeBytes && modelManager.isModelDownloaded(it) }
+                .sortedByDescending { it.sizeBytes }
+            val budgetBytes = inputData.getLong(KEY_MEMORY_BUDGET, 0L).takeIf { it > 0 }
+                ?: availableMemoryBytes()
+            val plan = WhisperLib.planJob(
+                candidates.map { modelManager.getModelPath(it) },
+                audioData.sampleCount.toLong(),
+                budgetBytes
+            )
+            if (plan == null || !plan.admitted) {
+                val reason = if (plan == null) "Unreadable model file" else
+                    "Needs ~${plan.estimatedBytes / 1_000_000} MB, budget ${budgetBytes / 1_000_000} MB"
+                Log.e(TAG, "Not enough memory to transcribe: $reason")
                 repository.updateTranscriptionStatus(recordingId, TranscriptionStatus.FAILED, 0)
-                return@withContext Result.failure()
+                audioData.close()
+                return@withContext Result.failure(workDataOf(KEY_ADMISSION to reason))
             }
+            val chosenModel = candidates[plan.modelIndex]
+            val admission = "${chosenModel.fileName}, downgrades: ${plan.describeDowngrades()}, " +
+                "~${plan.estimatedBytes / 1_000_000} of ${budgetBytes / 1_000_000} MB"
+            Log.i(TAG, "Admitted: $admission")
 
-            // Load audio file
-            val audioData = loadAudioFile(recording.audioFilePath)
-            if (audioData == null) {
-                Log.e(TAG, "Failed to load audio file")
-                repository.updateTranscriptionStatus(recordingId, TranscriptionStatus.FAILED, 0)
-                whisperLib.release()
-                return@withContext Result.failure()
+            // Re-running a recording (other language or preset) reuses its encoder
+            // windows; most of them come back from the app-private cache directory
+            WhisperLib.setEncoderCache(
+                ENCODER_CACHE_MEMORY_BYTES,
+                File(applicationContext.cacheDir, ENCODER_CACHE_DIR),
+                ENCODER_CACHE_DISK_BYTES
+            )
+            // Identical audio (a re-imported file, a retry) gets its stored transcript.
+            // In files, not cache, so the OS does not evict it under storage pressure.
+            WhisperLib.setResultCache(
+                File(applicationContext.filesDir, RESULT_CACHE_DIR),
+                RESULT_CACHE_BYTES
+            )
+            // Set before the result lookup: short clips are stored under their own settings
+            WhisperLib.setShortClipMode(SHORT_CLIP_MAX_MS)
+
+            val whisperLib = WhisperLib(applicationContext)
+            val modelPath = modelManager.getModelPath(chosenModel)
+
+            // Opt-in: with memory to spare, the tiny model proposes tokens the chosen
+            // model verifies several at a time, the same greedy transcript in fewer
+            // passes. Off by default: that path is greedy, without the decode guard
+            // or a prompt, and only a failed window gets the temperature fallback.
+            val draftModel = WhisperModel.TINY.takeIf {
+                inputData.getBoolean(KEY_SPECULATIVE, false) &&
+                    chosenModel.sizeBytes > it.sizeBytes &&
+                    !plan.chunked && !plan.smallerModel &&
+                    budgetBytes - plan.estimatedBytes >= DRAFT_HEADROOM_FACTOR * it.sizeBytes &&
+                    modelManager.isModelDownloaded(it)
             }
 
-            // Transcribe
-            val segments = whisperLib.transcribe(
-                audioData = audioData,
-                language = language,
-                onProgress = { progress ->
-                    setProgressAsync(workDataOf(KEY_PROGRESS to progress))
-                    // Can't call suspend functions here, just log
-                    Log.d(TAG, "Transcription progress: $progress%")
+            // A hit skips loading the model too
+            val cached = whisperLib.cachedTranscript(modelPath, audioData, language, plan, draftModel != null)
+            val segments = if (cached != null) {
+                Log.i(TAG, "Stored transcript found, not transcribing again")
+                File(checkpointPathFor(recording.audioFilePath)).delete()
+                audioData.close()
+                cached
+            } else {
+                // Initialize Whisper with the admitted model
+                Log.i(TAG, "Initializing Whisper with model: $modelPath")
+
+                val initialized = whisperLib.initialize(modelPath)
+
+                if (!initialized) {
+                    Log.e(TAG, "Failed to initialize Whisper model from: $modelPath")
+                    repository.updateTranscriptionStatus(recordingId, TranscriptionStatus.FAILED, 0)
+                    audioData.close()
+                    return@withContext Result.failure()
                 }
-            )
+
+                if (draftModel != null && !whisperLib.setDraftModel(modelManager.getModelPath(draftModel))) {
+                    Log.e(TAG, "Failed to load draft model, decoding without it")
+                }
+
+                // Background jobs throttle on battery/thermal pressure
+                val powerMonitor = PowerStateMonitor(applicationContext, whisperLib)
+                powerMonitor.start()
+
+                // Transcribe
+                try {
+                    whisperLib.transcribe(
+                        audio = audioData,
+                        language = language,
+                        // Survives process death so a rerun resumes instead of starting over
+                        checkpointPath = checkpointPathFor(recording.audioFilePath),
+                        plan = plan,
+                        onProgress = { progress ->
+                            setProgressAsync(workDataOf(KEY_PROGRESS to progress))
+                            // Can't call suspend functions here, just log
+                            Log.d(TAG, "Transcription progress: $progress%")
+                        }
+                    )
+                } finally {
+                    powerMonitor.stop()
+                    audioData.close()
+                }
+            }
 
             // Save segments
             val transcriptSegments = segments.mapIndexed { index, segment ->
@@ -140,10 +280,18 @@ class TranscriptionWorker(
             // Update status to completed
             repository.updateTranscriptionStatus(recordingId, TranscriptionStatus.COMPLETED, 100)
 
+            val tokensPerPass = if (draftModel != null && cached == null) whisperLib.lastSpeculativeTokensPerPass else 0.0
             whisperLib.release()
             Log.i(TAG, "Transcription completed: ${segments.size} segments")
+            if (tokensPerPass > 0.0) {
+                Log.i(TAG, "Speculative decoding: %.2f tokens per large-model pass".format(tokensPerPass))
+            }
 
-            Result.success()
+            Result.success(workDataOf(
+                KEY_MODEL_NAME to chosenModel.fileName,
+                KEY_ADMISSION to admission,
+                KEY_SPECULATIVE_TOKENS_PER_PASS to tokensPerPass
+            ))
 
         } catch (e: Exception) {
             Log.e(TAG, "Transcription failed", e)
@@ -152,32 +300,70 @@ class TranscriptionWorker(
         }
     }
 
-    private fun loadAudioFile(filePath: String): FloatArray? {
-        val file = File(filePath)
-        if (!file.exists()) return null
+    private fun checkpointPathFor(audioFilePath: String): String = "$audioFilePath.ckpt"
 
-        return try {
-            FileInputStream(file).use { fis ->
-                // Skip WAV header (44 bytes)
-                fis.skip(44)
+    /**
+     * Fingerprint the recording and, if it is contained in an earlier transcribed
+     * recording, return that recording's id and its segments moved to this timeline.
+     * Partial overlaps are still transcribed in full.
+     */
+    private suspend fun duplicateTranscript(
+        recordingId: String,
+        audio: NativeAudio
+    ): Pair<String, List<TranscriptSegment>>? {
+        val match = fingerprintIndex.indexRecording(recordingId, audio) ?: return null
+        val durationMs = audio.durationMs
 
-                // Read remaining as 16-bit PCM
-                val bytes = fis.readBytes()
-                val shortBuffer = ByteBuffer.wrap(bytes)
-                    .order(ByteOrder.LITTLE_ENDIAN)
-                    .asShortBuffer()
+        val contained = match.offsetMs >= -DUPLICATE_TOLERANCE_MS &&
+            match.offsetMs + durationMs <= match.matchedDurationMs + DUPLICATE_TOLERANCE_MS
+        val coverage = (match.endMs - match.beginMs).toDouble() / durationMs.coerceAtLeast(1L)
+        if (!contained || coverage < DUPLICATE_MIN_COVERAGE) {
+            Log.i(TAG, "Overlaps recording ${match.recordingId} in part, transcribing")
+            return null
+        }
 
-                val samples = ShortArray(shortBuffer.remaining())
-                shortBuffer.get(samples)
+        val source = repository.getRecordingById(match.recordingId) ?: return null
+        if (source.transcriptionStatus != TranscriptionStatus.COMPLETED) return null
 
-                // Convert to float array normalized to [-1, 1]
-                FloatArray(samples.size) { i ->
-                    samples[i].toFloat() / Short.MAX_VALUE
-                }
+        val segments = repository.getSegmentsForRecordingSync(match.recordingId)
+            .sortedBy { it.segmentIndex }
+            .map { it.startTimeMs - match.offsetMs to it }
+            .filter { (start, segment) -> start < durationMs && segment.endTimeMs - match.offsetMs > 0 }
+            .mapIndexed { index, (start, segment) ->
+                TranscriptSegment(
+                    recordingId = recordingId,
+                    text = segment.text,
+                    startTimeMs = start.coerceAtLeast(0L),
+                    endTimeMs = (segment.endTimeMs - match.offsetMs).coerceAtMost(durationMs),
+                    segmentIndex = index
+                )
             }
-        } catch (e: Exception) {
-            Log.e(TAG, "Error loading audio file", e)
-            null
+        return if (segments.isEmpty()) null else match.recordingId to segments
+    }
+
+    /**
+     * Memory the job may use before the system reaches its low-memory threshold
+     * and starts killing processes.
+     */
+    private fun availableMemoryBytes(): Long {
+        val activityManager = applicationContext.getSystemService(Context.ACTIVITY_SERVICE) as ActivityManager
+        val info = ActivityManager.MemoryInfo()
+        activityManager.getMemoryInfo(info)
+        return (info.availMem - info.threshold).coerceAtLeast(0L)
+    }
+
+    /**
+     * Decode and resample the recording in native memory, optionally suppressing
+     * noise; only a handle is held on the Java heap.
+     */
+    private fun loadAudioFile(filePath: String, suppressNoise: Boolean): NativeAudio? {
+        if (!File(filePath).exists()) return null
+
+        val audio = NativeAudio.fromFile(filePath) ?: return null
+        if (!audio.resample(WhisperLib.SAMPLE_RATE) || (suppressNoise && !audio.suppressNoise())) {
+            audio.close()
+            return null
         }
+        return audio
     }
 }
@@ -0,0 +1,98 @@
+package com.securevox.app.whisper
+
+import android.content.Context
+import android.util.Log
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+import java.io.File
+
+/**
+ * Native acoustic fingerprint index for near-duplicate recordings.
+ *
+ * Recordings are indexed by spectral peak pairs, which survive re-encoding at
+ * another bitrate and the audio track of a video, so the same meeting imported
+ * twice is recognised even though the files differ byte for byte. A match also
+ * gives the time offset between the two, so an overlapping excerpt is found
+ * too. Persisted as an append-only log in app storage.
+ */
+class AudioFingerprintIndex private constructor(context: Context) {
+
+    companion object {
+        private const val TAG = "AudioFingerprintIndex"
+        private const val INDEX_FILE = "fingerprints.idx"
+
+        init {
+            NativeLibrary.load()
+        }
+
+        @Volatile
+        private var instance: AudioFingerprintIndex? = null
+
+        fun getInstance(context: Context): AudioFingerprintIndex {
+            return instance ?: synchronized(this) {
+                instance ?: AudioFingerprintIndex(context.applicationContext).also {
+                    instance = it
+                }
+            }
+        }
+    }
+
+    private val indexFile = File(context.filesDir, INDEX_FILE)
+
+    // Opened on first use so startup does not wait on the log replay
+    private val indexPtr: Long by lazy {
+        openIndex(indexFile.absolutePath).also {
+            if (it == 0L) Log.e(TAG, "Fingerprint index unavailable")
+        }
+    }
+
+    /**
+     * Fingerprint a recording and index it, replacing what was indexed for it before.
+     * @return The earlier recording sharing the most audio with this one, or null
+     */
+    suspend fun indexRecording(recordingId: String, audio: NativeAudio): FingerprintMatch? =
+        withContext(Dispatchers.Default) {
+            parseMatch(indexRecording(indexPtr, recordingId, audio.handle))
+        }
+
+    suspend fun remove(recordingId: String): Boolean = withContext(Dispatchers.IO) {
+        removeRecording(indexPtr, recordingId)
+    }
+
+    private fun parseMatch(json: String): FingerprintMatch? {
+        if (json.isEmpty()) return null
+        val pattern = """\{"recording":"((?:[^"\\]|\\.)*)","offset":(-?\d+),"begin":(-?\d+),"end":(-?\d+),"duration":(-?\d+),"matches":(\d+)\}""".toRegex()
+        val match = pattern.find(json) ?: return null
+        return FingerprintMatch(
+            recordingId = match.groupValues[1].replace("\\\"", "\"").replace("\\\\", "\\"),
+            offsetMs = match.groupValues[2].toLong(),
+            beginMs = match.groupValues[3].toLong(),
+            endMs = match.groupValues[4].toLong(),
+            matchedDurationMs = match.groupValues[5].toLong(),
+            landmarks = match.groupValues[6].toInt()
+        )
+    }
+
+    // JNI methods
+    private external fun openIndex(path: String): Long
+    private external fun indexRecording(indexPtr: Long, recordingId: String, audioPtr: Long): String
+    private external fun removeRecording(indexPtr: Long, recordingId: String): Boolean
+}
+
+/**
+ * An earlier recording that contains audio of the fingerprinted one.
+ * @param offsetMs Time in the matched recording at time 0 of this one; a time t
+ *        here is `t + offsetMs` there
+ * @param beginMs Start of the shared audio in this recording
+ * @param endMs End of the shared audio in this recording
+ * @param matchedDurationMs Length of the matched recording
+ * @param landmarks Spectral peak pairs agreeing on the offset
+ */
+data class FingerprintMatch(
+    val recordingId: String,
+    val offsetMs: Long,
+    val beginMs: Long,
+    val endMs: Long,
+    val matchedDurationMs: Long,
+    val landmarks: Int
+)
@@ -0,0 +1,102 @@
+package com.securevox.app.whisper
+
+import java.io.Closeable
+
+/**
+ * Mono audio held in native memory.
+ *
+ * Decoding, resampling and silence removal run natively and [WhisperLib.transcribe]
+ * reads the samples in place, so a long recording never becomes an array on the
+ * Java heap. Only this handle is held here; [close] frees the audio.
+ */
+class NativeAudio private constructor(handle: Long) : Closeable {
+
+    companion object {
+        init {
+            NativeLibrary.load()
+        }
+
+        /**
+         * Empty buffer to fill with [appendPcm16] or [appendFloat].
+         */
+        fun create(sampleRate: Int): NativeAudio {
+            val handle = createAudio(sampleRate)
+            require(handle != 0L) { "Invalid sample rate: $sampleRate" }
+            return NativeAudio(handle)
+        }
+
+        /**
+         * Decode a WAV or FLAC file (any rate or channel count, downmixed to mono) at its own rate.
+         * @return The audio, or null if the file could not be decoded
+         */
+        fun fromFile(path: String): NativeAudio? {
+            val handle = loadAudio(path)
+            return if (handle != 0L) NativeAudio(handle) else null
+        }
+
+        @JvmStatic private external fun createAudio(sampleRate: Int): Long
+        @JvmStatic private external fun loadAudio(path: String): Long
+        @JvmStatic private external fun appendPcm16(audioPtr: Long, samples: ShortArray, offset: Int, length: Int)
+        @JvmStatic private external fun appendFloat(audioPtr: Long, samples: FloatArray, offset: Int, length: Int)
+        @JvmStatic private external fun resampleAudio(audioPtr: Long, sampleRate: Int): Boolean
+        @JvmStatic private external fun suppressNoise(audioPtr: Long): Boolean
+        @JvmStatic private external fun removeSilence(audioPtr: Long): Boolean
+        @JvmStatic private external fun sampleRate(audioPtr: Long): Int
+        @JvmStatic private external fun sampleCount(audioPtr: Long): Int
+        @JvmStatic private external fun durationMs(audioPtr: Long): Long
+        @JvmStatic private external fun freeAudio(audioPtr: Long)
+    }
+
+    internal var handle: Long = handle
+        private set
+
+    val sampleRate: Int get() = sampleRate(checkedHandle())
+
+    /** Samples currently held, after any silence removal */
+    val sampleCount: Int get() = sampleCount(checkedHandle())
+
+    /** Duration of the audio before silence removal */
+    val durationMs: Long get() = durationMs(checkedHandle())
+
+    /**
+     * Append 16-bit PCM at the buffer's rate, e.g. a chunk from AudioRecord.
+     */
+    fun appendPcm16(samples: ShortArray, offset: Int = 0, length: Int = samples.size - offset) {
+        require(offset >= 0 && length >= 0 && offset + length <= samples.size) { "Chunk out of range" }
+        appendPcm16(checkedHandle(), samples, offset, length)
+    }
+
+    fun appendFloat(samples: FloatArray, offset: Int = 0, length: Int = samples.size - offset) {
+        require(offset >= 0 && length >= 0 && offset + length <= samples.size) { "Chunk out of range" }
+        appendFloat(checkedHandle(), samples, offset, length)
+    }
+
+    /**
+     * Resample in place. Must happen before [removeSilence].
+     */
+    fun resample(sampleRate: Int): Boolean = resampleAudio(checkedHandle(), sampleRate)
+
+    /**
+     * Spectral noise suppression, with the noise floor taken from the pauses the
+     * VAD finds. Must happen after [resample] and before [removeSilence].
+     */
+    fun suppressNoise(): Boolean = suppressNoise(checkedHandle())
+
+    /**
+     * Drop non-speech with the energy VAD. Transcript times still refer to the
+     * original audio.
+     */
+    fun removeSilence(): Boolean = removeSilence(checkedHandle())
+
+    private fun checkedHandle(): Long {
+        check(handle != 0L) { "NativeAudio is closed" }
+        return handle
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            freeAudio(handle)
+            handle = 0
+        }
+    }
+}
@@ -0,0 +1,44 @@
+package com.securevox.app.whisper
+
+/**
+ * Native transcript writer for TXT, SRT, VTT and JSON.
+ * Streams straight to a file descriptor without building the output in memory.
+ */
+object NativeExporter {
+
+    init {
+        NativeLibrary.load()
+    }
+
+    // Must match securevox::ExportFormat
+    const val FORMAT_TXT = 0
+    const val FORMAT_SRT = 1
+    const val FORMAT_VTT = 2
+    const val FORMAT_JSON = 3
+
+    /**
+     * Write segments to an open descriptor. The descriptor is not closed.
+     * @param speakers Optional speaker label per segment (null entries allowed)
+     * @param maxLineChars Subtitle line wrap width, 0 to disable
+     * @return true if everything was written
+     */
+    fun write(
+        starts: LongArray,
+        ends: LongArray,
+        texts: Array<String>,
+        speakers: Array<String?>?,
+        format: Int,
+        maxLineChars: Int,
+        fd: Int
+    ): Boolean = writeSegments(starts, ends, texts, speakers, format, maxLineChars, fd)
+
+    private external fun writeSegments(
+        starts: LongArray,
+        ends: LongArray,
+        texts: Array<String>,
+        speakers: Array<String?>?,
+        format: Int,
+        maxLineChars: Int,
+        fd: Int
+    ): Boolean
+}
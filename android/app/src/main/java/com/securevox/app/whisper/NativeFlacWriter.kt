@@ -0,0 +1,74 @@
+package com.securevox.app.whisper
+
+import java.io.Closeable
+
+/**
+ * Streaming lossless FLAC encoder for 16-bit mono capture.
+ *
+ * Each chunk from AudioRecord is handed straight to native code, which encodes
+ * completed blocks (linear prediction plus Rice coding) and flushes them to
+ * disk. Speech takes about half the space of WAV, and [NativeAudio.fromFile]
+ * decodes the result directly.
+ */
+class NativeFlacWriter private constructor(handle: Long) : Closeable {
+
+    companion object {
+        init {
+            NativeLibrary.load()
+        }
+
+        /**
+         * Create [path] and write the stream header.
+         * @return The writer, or null if the file could not be created
+         */
+        fun open(path: String, sampleRate: Int): NativeFlacWriter? {
+            val handle = openWriter(path, sampleRate)
+            return if (handle != 0L) NativeFlacWriter(handle) else null
+        }
+
+        /**
+         * Losslessly re-encode a 16-bit mono WAV file as FLAC. [flacPath] is
+         * only replaced once the whole file has been encoded.
+         */
+        fun convertWav(wavPath: String, flacPath: String): Boolean = convertWavFile(wavPath, flacPath)
+
+        @JvmStatic private external fun openWriter(path: String, sampleRate: Int): Long
+        @JvmStatic private external fun writePcm16(writerPtr: Long, samples: ShortArray, offset: Int, length: Int): Boolean
+        @JvmStatic private external fun samplesWritten(writerPtr: Long): Long
+        @JvmStatic private external fun finishWriter(writerPtr: Long): Boolean
+        @JvmStatic private external fun convertWavFile(wavPath: String, flacPath: String): Boolean
+    }
+
+    private var handle: Long = handle
+
+    /** Samples encoded so far; the last partial block is counted on [finish] */
+    val samplesWritten: Long get() = samplesWritten(checkedHandle())
+
+    /**
+     * Encode a chunk of PCM at the writer's rate.
+     * @return false after a write error, e.g. a full disk
+     */
+    fun write(samples: ShortArray, offset: Int = 0, length: Int = samples.size - offset): Boolean {
+        require(offset >= 0 && length >= 0 && offset + length <= samples.size) { "Chunk out of range" }
+        return writePcm16(checkedHandle(), samples, offset, length)
+    }
+
+    /**
+     * Encode the buffered tail, complete the header and close the file.
+     * @return true if the whole stream reached the disk
+     */
+    fun finish(): Boolean {
+        val ok = finishWriter(checkedHandle())
+        handle = 0
+        return ok
+    }
+
+    private fun checkedHandle(): Long {
+        check(handle != 0L) { "NativeFlacWriter is closed" }
+        return handle
+    }
+
+    override fun close() {
+        if (handle != 0L) finish()
+    }
+}
@@ -0,0 +1,45 @@
+package com.securevox.app.whisper
+
+import android.util.Log
+
+/**
+ * Loads the whisper_jni build that matches this CPU.
+ *
+ * On arm64 the native library is built three times with different ggml kernels:
+ * baseline NEON, dotprod and i8mm. A small probe library reads the CPU features
+ * (getauxval) and the fastest build the device supports is loaded; the baseline
+ * is the fallback. Every class with native methods calls [load] first.
+ */
+internal object NativeLibrary {
+
+    private const val TAG = "NativeLibrary"
+
+    /** Suffix of the loaded build ("i8mm", "dotprod"), or empty for the baseline */
+    val variant: String by lazy {
+        val best = try {
+            System.loadLibrary("securevox_cpu")
+            cpuVariant()
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "CPU probe unavailable, using baseline kernels", e)
+            ""
+        }
+
+        if (best.isNotEmpty()) {
+            try {
+                System.loadLibrary("whisper_jni_$best")
+                Log.i(TAG, "Loaded whisper_jni_$best")
+                return@lazy best
+            } catch (e: UnsatisfiedLinkError) {
+                Log.w(TAG, "whisper_jni_$best not packaged, using baseline kernels", e)
+            }
+        }
+        System.loadLibrary("whisper_jni")
+        ""
+    }
+
+    fun load() {
+        variant
+    }
+
+    @JvmStatic private external fun cpuVariant(): String
+}
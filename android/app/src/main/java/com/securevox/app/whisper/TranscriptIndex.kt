@@ -0,0 +1,156 @@
+package com.securevox.app.whisper
+
+import android.content.Context
+import android.util.Log
+import com.securevox.app.data.model.TranscriptSegment
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+import java.io.File
+
+/**
+ * Native full-text index over transcript segments.
+ *
+ * Kept up to date from the transcription result path and persisted as an
+ * append-only log in app storage. Queries match segments containing every word;
+ * the word being typed matches as a prefix, `word*` forces a prefix match and
+ * "quoted words" must appear in order.
+ */
+class TranscriptIndex private constructor(context: Context) {
+
+    companion object {
+        private const val TAG = "TranscriptIndex"
+        private const val INDEX_FILE = "transcripts.idx"
+
+        init {
+            NativeLibrary.load()
+        }
+
+        @Volatile
+        private var instance: TranscriptIndex? = null
+
+        fun getInstance(context: Context): TranscriptIndex {
+            return instance ?: synchronized(this) {
+                instance ?: TranscriptIndex(context.applicationContext).also {
+                    instance = it
+                }
+            }
+        }
+    }
+
+    private val indexFile = File(context.filesDir, INDEX_FILE)
+
+    // Opened on first use so startup does not wait on the log replay
+    private val indexPtr: Long by lazy {
+        openIndex(indexFile.absolutePath).also {
+            if (it == 0L) Log.e(TAG, "Transcript index unavailable")
+        }
+    }
+
+    /**
+     * Replace the indexed transcript of a recording.
+     */
+    suspend fun setRecording(recordingId: String, segments: List<TranscriptSegment>): Boolean =
+        withContext(Dispatchers.IO) {
+            setRecordingSegments(
+                indexPtr,
+                recordingId,
+                LongArray(segments.size) { segments[it].startTimeMs },
+                LongArray(segments.size) { segments[it].endTimeMs },
+                Array(segments.size) { segments[it].text }
+            )
+        }
+
+    /**
+     * Index segments of a recording as they are saved, without re-indexing the
+     * ones already there. Pass only segments not indexed yet; [remove] first
+     * when the transcript is replaced.
+     */
+    suspend fun addSegments(recordingId: String, segments: List<TranscriptSegment>): Boolean =
+        withContext(Dispatchers.IO) {
+            // One call per run of consecutive segment indices
+            var ok = true
+            var first = 0
+            val sorted = segments.sortedBy { it.segmentIndex }
+            while (first < sorted.size) {
+                var end = first + 1
+                while (end < sorted.size && sorted[end].segmentIndex == sorted[end - 1].segmentIndex + 1) end++
+                val run = sorted.subList(first, end)
+                ok = addRecordingSegments(
+                    indexPtr,
+                    recordingId,
+                    run[0].segmentIndex,
+                    LongArray(run.size) { run[it].startTimeMs },
+                    LongArray(run.size) { run[it].endTimeMs },
+                    Array(run.size) { run[it].text }
+                ) && ok
+                first = end
+            }
+            ok
+        }
+
+    suspend fun remove(recordingId: String): Boolean = withContext(Dispatchers.IO) {
+        removeRecording(indexPtr, recordingId)
+    }
+
+    /**
+     * Find segments matching the query.
+     * @return Hits in library order, each pointing at a time inside its recording
+     */
+    suspend fun search(query: String, limit: Int = 500): List<TranscriptHit> =
+        withContext(Dispatchers.Default) {
+            if (query.isBlank()) return@withContext emptyList()
+            parseHits(searchIndex(indexPtr, query, limit))
+        }
+
+    /**
+     * Number of recordings with indexed text; 0 means the index needs building.
+     */
+    suspend fun recordingCount(): Int = withContext(Dispatchers.IO) {
+        indexedRecordingCount(indexPtr)
+    }
+
+    private fun parseHits(json: String): List<TranscriptHit> {
+        val pattern = """\{"recording":"((?:[^"\\]|\\.)*)","segment":(\d+),"start":(-?\d+),"time":(-?\d+)\}""".toRegex()
+
+        return pattern.findAll(json).map { match ->
+            TranscriptHit(
+                recordingId = match.groupValues[1].replace("\\\"", "\"").replace("\\\\", "\\"),
+                segmentIndex = match.groupValues[2].toInt(),
+                segmentStartMs = match.groupValues[3].toLong(),
+                timeMs = match.groupValues[4].toLong()
+            )
+        }.toList()
+    }
+
+    // JNI methods
+    private external fun openIndex(path: String): Long
+    private external fun setRecordingSegments(
+        indexPtr: Long,
+        recordingId: String,
+        starts: LongArray,
+        ends: LongArray,
+        texts: Array<String>
+    ): Boolean
+    private external fun addRecordingSegments(
+        indexPtr: Long,
+        recordingId: String,
+        firstIndex: Int,
+        starts: LongArray,
+        ends: LongArray,
+        texts: Array<String>
+    ): Boolean
+    private external fun removeRecording(indexPtr: Long, recordingId: String): Boolean
+    private external fun searchIndex(indexPtr: Long, query: String, limit: Int): String
+    private external fun indexedRecordingCount(indexPtr: Long): Int
+}
+
+/**
+ * A transcript search match.
+ * @param timeMs Estimated position of the matched words, for seeking playback
+ */
+data class TranscriptHit(
+    val recordingId: String,
+    val segmentIndex: Int,
+    val segmentStartMs: Long,
+    val timeMs: Long
+)
@@ -0,0 +1,73 @@
+package com.securevox.app.whisper
+
+import java.io.Closeable
+
+/**
+ * Min/max/RMS peak pyramid of a recording, memory-mapped from a sidecar file.
+ *
+ * The sidecar is built natively in one pass over the PCM. Rendering reads only
+ * the level whose buckets match the requested zoom, so drawing a waveform costs
+ * O(columns) however long the recording is.
+ */
+class WaveformPeaks private constructor(handle: Long) : Closeable {
+
+    companion object {
+        init {
+            NativeLibrary.load()
+        }
+
+        /**
+         * Sidecar that holds the peaks of an audio file.
+         */
+        fun sidecarPath(audioPath: String): String = "$audioPath.peaks"
+
+        /**
+         * Compute the peaks of a WAV or FLAC file and write them to [peaksPath].
+         */
+        fun build(audioPath: String, peaksPath: String): Boolean = buildPeaks(audioPath, peaksPath)
+
+        /**
+         * Map a sidecar written by [build].
+         * @return The peaks, or null if the file is missing or invalid
+         */
+        fun open(peaksPath: String): WaveformPeaks? {
+            val handle = openPeaks(peaksPath)
+            return if (handle != 0L) WaveformPeaks(handle) else null
+        }
+
+        @JvmStatic private external fun buildPeaks(audioPath: String, peaksPath: String): Boolean
+        @JvmStatic private external fun openPeaks(peaksPath: String): Long
+        @JvmStatic private external fun peaksDurationMs(peaksPtr: Long): Long
+        @JvmStatic private external fun renderPeaks(peaksPtr: Long, beginMs: Long, endMs: Long, out: FloatArray)
+        @JvmStatic private external fun closePeaks(peaksPtr: Long)
+    }
+
+    private var handle: Long = handle
+
+    val durationMs: Long get() = peaksDurationMs(checkedHandle())
+
+    /**
+     * Summarise [beginMs, endMs) into equal columns, three values each: min and
+     * max peak in [-1, 1], then RMS. Columns past the end of the audio are zero.
+     * @param out Receives the columns; its size must be a multiple of 3
+     */
+    fun render(beginMs: Long, endMs: Long, out: FloatArray) {
+        require(out.size % 3 == 0) { "Output holds (min, max, rms) triples" }
+        renderPeaks(checkedHandle(), beginMs, endMs, out)
+    }
+
+    fun render(beginMs: Long, endMs: Long, columns: Int): FloatArray =
+        FloatArray(columns * 3).also { render(beginMs, endMs, it) }
+
+    private fun checkedHandle(): Long {
+        check(handle != 0L) { "WaveformPeaks is closed" }
+        return handle
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            closePeaks(handle)
+            handle = 0
+        }
+    }
+}
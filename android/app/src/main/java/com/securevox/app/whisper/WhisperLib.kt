@@ -5,6 +5,8 @@ import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.withContext
 import java.io.File
 import java.io.FileOutputStream
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 
 /**
  * Kotlin wrapper for whisper.cpp native library.
@@ -14,13 +16,118 @@ class WhisperLib(private val context: Context) {
 
     companion object {
         init {
-            System.loadLibrary("whisper_jni")
+            NativeLibrary.load()
         }
 
         private const val TAG = "WhisperLib"
+
+        /** Sample rate the model expects */
+        const val SAMPLE_RATE = 16000
+
+        /**
+         * Allocate a direct buffer for [numSamples] float samples, laid out for
+         * the zero-copy [transcribe] overload.
+         */
+        fun allocateAudioBuffer(numSamples: Int): ByteBuffer =
+            ByteBuffer.allocateDirect(numSamples * Float.SIZE_BYTES).order(ByteOrder.nativeOrder())
+
+        /**
+         * Estimate a job's peak native memory before any model is loaded and
+         * pick the cheapest way to keep it within [budgetBytes]: the preferred
+         * model as is, then decoding in chunks, then the same again with each
+         * following model.
+         * @param modelPaths Candidate models, most preferred first
+         * @param numSamples Length of the 16kHz audio to transcribe
+         * @param threads Inference threads the job will use
+         * @param bestOf Greedy decoders the job would like (whisper's default is 5)
+         * @return The chosen plan, or null if a model file could not be read
+         */
+        fun planJob(
+            modelPaths: List<String>,
+            numSamples: Long,
+            budgetBytes: Long,
+            threads: Int = 4,
+            bestOf: Int = 5
+        ): AdmissionPlan? {
+            val values = planJob(modelPaths.toTypedArray(), numSamples, threads, bestOf, budgetBytes)
+                ?: return null
+            val downgrades = values[6].toInt()
+            return AdmissionPlan(
+                admitted = values[0] != 0L,
+                modelIndex = values[1].toInt(),
+                chunkMs = values[2],
+                threads = values[3].toInt(),
+                bestOf = values[4].toInt(),
+                estimatedBytes = values[5],
+                budgetBytes = budgetBytes,
+                chunked = downgrades and 1 != 0,
+                smallerModel = downgrades and 4 != 0
+            )
+        }
+
+        /**
+         * Keep encoder outputs so that transcribing the same audio again (another
+         * language, prompt or decoding preset) skips the encoder for every window
+         * already seen. Shared by all contexts in the process.
+         * @param memoryBytes Encoder output held in memory; 0 disables the cache
+         * @param spillDir Directory for windows evicted from memory, or null for none.
+         *        Windows written there by earlier runs are reused.
+         * @param spillBytes Disk budget for [spillDir]; the oldest windows go first
+         */
+        fun setEncoderCache(memoryBytes: Long, spillDir: File? = null, spillBytes: Long = 0) =
+            configureEncoderCache(memoryBytes, spillDir?.absolutePath, spillBytes)
+
+        /** Drop every cached encoder output, in memory and on disk. */
+        fun clearEncoderOutputs() = clearEncoderCache()
+
+        @JvmStatic private external fun configureEncoderCache(
+            memoryBytes: Long,
+            spillDir: String?,
+            spillBytes: Long
+        )
+
+        @JvmStatic private external fun clearEncoderCache()
+
+        /**
+         * Keep finished transcripts keyed by the audio content, model and decoding
+         * settings, so transcribing identical audio again (a re-imported file, a
+         * retried job) returns the stored segments without running the model.
+         * @param dir Directory for stored transcripts, or null to disable the cache.
+         *        Transcripts stored there by earlier runs are reused.
+         * @param maxBytes Disk budget; the least recently used transcripts go first
+         */
+        fun setResultCache(dir: File?, maxBytes: Long) =
+            configureResultCache(dir?.absolutePath, maxBytes)
+
+        /** Delete every stored transcript. */
+        fun clearResults() = clearResultCache()
+
+        @JvmStatic private external fun configureResultCache(dir: String?, maxBytes: Long)
+
+        @JvmStatic private external fun clearResultCache()
+
+        /**
+         * Encode clips up to [maxMs] long at their own length instead of a full
+         * 30 s window, and decode them as one segment. A result the native
+         * accuracy guard doubts is decoded again with the full window. Such clips
+         * are not decoded speculatively or checkpointed.
+         * @param maxMs Longest clip that takes the fast path; 0 disables it
+         */
+        fun setShortClipMode(maxMs: Long) = configureShortClips(maxMs)
+
+        @JvmStatic private external fun configureShortClips(maxMs: Long)
+
+        @JvmStatic private external fun planJob(
+            modelPaths: Array<String>,
+            numSamples: Long,
+            threads: Int,
+            bestOf: Int,
+            budgetBytes: Long
+        ): LongArray?
     }
 
     private var contextPtr: Long = 0
+    private var draftPtr: Long = 0
 
     /**
      * Initialize the Whisper context with a model file.
@@ -35,6 +142,36 @@ class WhisperLib(private val context: Context) {
         contextPtr != 0L
     }
 
+    /**
+     * Load a small model of the same vocabulary (e.g. tiny for base and up) to
+     * propose tokens the loaded model then verifies several at a time. Native
+     * audio is then decoded greedily with whisper's seek and timestamp rules,
+     * without its decode guard or prompt; a window that fails falls back to
+     * whisper's temperature fallback. `securevox_bench --draft` checks the
+     * result against whisper and measures the wall-time speedup; see also
+     * [lastSpeculativeTokensPerPass].
+     * @param modelPath Path to the draft model, or null to unload it
+     * @return true if the draft model is loaded (or was unloaded)
+     */
+    suspend fun setDraftModel(modelPath: String?): Boolean = withContext(Dispatchers.IO) {
+        if (draftPtr != 0L) {
+            freeContext(draftPtr)
+            draftPtr = 0
+        }
+        if (modelPath == null) return@withContext true
+        draftPtr = initContext(modelPath)
+        draftPtr != 0L
+    }
+
+    /**
+     * Tokens per decoder pass of the large model in the last transcription with
+     * a draft model, i.e. how many times fewer passes than plain greedy
+     * decoding it needed (not a wall-time speedup: the draft's own passes
+     * are not counted); 0 if no transcription used one.
+     */
+    val lastSpeculativeTokensPerPass: Double
+        get() = getSpeculativeTokensPerPass()
+
     /**
      * Initialize with a model from assets.
      * Copies the model to internal storage if needed.
@@ -63,12 +200,131 @@ class WhisperLib(private val context: Context) {
      * Transcribe audio samples.
      * @param audioData PCM audio samples at 16kHz, mono, float32
      * @param language Language code (e.g., "en", "auto" for detection)
+     * @param checkpointPath Optional sidecar file for resumable progress. If a previous
+     *        run with the same audio and settings was interrupted, decoding continues
+     *        where it stopped; the file is deleted once transcription completes.
      * @param onProgress Progress callback (0-100)
      * @return List of transcription segments
      */
     suspend fun transcribe(
         audioData: FloatArray,
         language: String = "en",
+        checkpointPath: String? = null,
+        onProgress: ((Int) -> Unit)? = null
+    ): List<TranscriptionSegment> = withContext(Dispatchers.Default) {
+        if (contextPtr == 0L) {
+            throw IllegalStateException("Whisper context not initialized")
+        }
+
+        val callback = onProgress?.let { ProgressCallback(it) }
+        val jsonResult = transcribeAudio(contextPtr, audioData, language, checkpointPath, callback)
+
+        parseSegments(jsonResult)
+    }
+
+    /**
+     * Transcribe audio samples held outside the Java heap.
+     * The native side reads the floats in place, so the buffer is neither copied
+     * nor pinned; prefer this for long recordings (see [allocateAudioBuffer]).
+     * @param audioData Direct buffer of float32 PCM at 16kHz, mono, in native byte order,
+     *        from position 0 to its limit
+     * @see transcribe
+     */
+    suspend fun transcribe(
+        audioData: ByteBuffer,
+        language: String = "en",
+        checkpointPath: String? = null,
+        onProgress: ((Int) -> Unit)? = null
+    ): List<TranscriptionSegment> = withContext(Dispatchers.Default) {
+        if (contextPtr == 0L) {
+            throw IllegalStateException("Whisper context not initialized")
+        }
+        require(audioData.isDirect && audioData.order() == ByteOrder.nativeOrder()) {
+            "Audio buffer must be direct and in native byte order"
+        }
+
+        val callback = onProgress?.let { ProgressCallback(it) }
+        val numSamples = audioData.limit() / Float.SIZE_BYTES
+        val jsonResult = transcribeAudioBuffer(contextPtr, audioData, numSamples, language, checkpointPath, callback)
+
+        parseSegments(jsonResult)
+    }
+
+    /**
+     * Transcribe native audio in place; no samples cross into the Java heap.
+     * Segment times refer to the original audio even if silence was removed.
+     * @param audio 16kHz audio (see [NativeAudio.resample])
+     * @param plan Chunking and decoder count chosen by [planJob], or null to
+     *        decode the whole recording at once with whisper's defaults. The
+     *        decoder count does not apply with a draft model ([setDraftModel]).
+     * @see transcribe
+     */
+    suspend fun transcribe(
+        audio: NativeAudio,
+        language: String = "en",
+        checkpointPath: String? = null,
+        plan: AdmissionPlan? = null,
+        onProgress: ((Int) -> Unit)? = null
+    ): List<TranscriptionSegment> = withContext(Dispatchers.Default) {
+        if (contextPtr == 0L) {
+            throw IllegalStateException("Whisper context not initialized")
+        }
+        require(audio.sampleRate == SAMPLE_RATE) { "Audio must be resampled to $SAMPLE_RATE Hz" }
+
+        val callback = onProgress?.let { ProgressCallback(it) }
+        val jsonResult = transcribeNativeAudio(
+            contextPtr,
+            audio.handle,
+            language,
+            checkpointPath,
+            plan?.chunkMs ?: 0L,
+            plan?.bestOf ?: 0,
+            draftPtr,
+            callback
+        )
+
+        parseSegments(jsonResult)
+    }
+
+    /**
+     * Transcript stored by an earlier run for this audio, model file and plan
+     * (see [setResultCache]). Needs no initialized context, so a hit skips
+     * loading the model as well as decoding.
+     * @param speculative Whether the transcript is to be decoded with a draft
+     *        model, which is keyed apart from whisper's own decoding
+     * @return The segments as [transcribe] would return them, or null on a miss
+     */
+    suspend fun cachedTranscript(
+        modelPath: String,
+        audio: NativeAudio,
+        language: String = "en",
+        plan: AdmissionPlan? = null,
+        speculative: Boolean = false
+    ): List<TranscriptionSegment>? = withContext(Dispatchers.Default) {
+        lookupResult(modelPath, audio.handle, language, plan?.chunkMs ?: 0L, plan?.bestOf ?: 0, speculative)
+            ?.let { parseSegments(it) }
+    }
+
+    /**
+     * Update an existing transcript after the recording was edited, re-running
+     * inference only around the changed audio.
+     *
+     * The edit replaced [removedSamples] samples at [editStartSample] of the old
+     * audio with [insertedSamples] new ones; appending is an edit at the old end
+     * with nothing removed, trimming removes samples and inserts none.
+     * @param audioData The edited audio, PCM at 16kHz, mono, float32
+     * @param previous Segments transcribed from the audio before the edit
+     * @param language Language code (e.g., "en", "auto" for detection)
+     * @param onProgress Progress callback (0-100) for the re-transcribed range
+     * @return Full segment list with kept segments shifted to the new timeline
+     */
+    suspend fun transcribeEdited(
+        audioData: FloatArray,
+        previous: List<TranscriptionSegment>,
+        editStartSample: Int,
+        removedSamples: Int,
+        insertedSamples: Int,
+        language: String = "en",
         onProgress: ((Int) -> Unit)? = null
     ): List<TranscriptionSegment> = withContext(Dispatchers.Default) {
         if (contextPtr == 0L) {
@@ -76,7 +332,18 @@ class WhisperLib(private val context: Context) {
         }
 
         val callback = onProgress?.let { ProgressCallback(it) }
-        val jsonResult = transcribeAudio(contextPtr, audioData, language, callback)
+        val jsonResult = transcribeIncremental(
+            contextPtr,
+            audioData,
+            language,
+            LongArray(previous.size) { previous[it].startTimeMs },
+            LongArray(previous.size) { previous[it].endTimeMs },
+            Array(previous.size) { previous[it].text },
+            editStartSample,
+            removedSamples,
+            insertedSamples,
+            callback
+        )
 
         parseSegments(jsonResult)
     }
@@ -88,10 +355,38 @@ class WhisperLib(private val context: Context) {
         return contextPtr != 0L && isMultilingual(contextPtr)
     }
 
+    /**
+     * Cap the CPU threads shared by all native work in the process.
+     * @param maxThreads Thread cap, or 0 for all cores
+     */
+    fun setThreadCap(maxThreads: Int) = setMaxThreads(maxThreads)
+
+    /**
+     * Enable battery/thermal throttling for background jobs.
+     * While enabled, transcription threads, core selection and duty cycle follow
+     * the latest state passed to [updatePowerState].
+     */
+    fun setEnergyAwareMode(enabled: Boolean) = setEnergyAware(enabled)
+
+    /**
+     * Report the current device power state to the native throttling policy.
+     * @param batteryPercent Battery level 0-100, or -1 if unknown
+     * @param charging Whether the device is plugged in
+     * @param thermalStatus PowerManager.THERMAL_STATUS_* value
+     * @param powerSave Whether battery saver is on
+     */
+    fun reportPowerState(
+        batteryPercent: Int,
+        charging: Boolean,
+        thermalStatus: Int,
+        powerSave: Boolean
+    ) = updatePowerState(batteryPercent, charging, thermalStatus, powerSave)
+
     /**
      * Get system info for debugging.
      */
-    fun getSystemInfoString(): String = getSystemInfo()
+    fun getSystemInfoString(): String =
+        "kernels: ${NativeLibrary.variant.ifEmpty { "baseline" }} | ${getSystemInfo()}"
 
     /**
      * Release native resources.
@@ -101,6 +396,10 @@ class WhisperLib(private val context: Context) {
             freeContext(contextPtr)
             contextPtr = 0
         }
+        if (draftPtr != 0L) {
+            freeContext(draftPtr)
+            draftPtr = 0
+        }
     }
 
     private fun parseSegments(json: String): List<TranscriptionSegment> {
@@ -108,27 +407,20 @@ class WhisperLib(private val context: Context) {
 
         val segments = mutableListOf<TranscriptionSegment>()
 
-        // Simple JSON parsing without external library
-        val pattern = """\{"text":"((?:[^"\\]|\\.)*)","start":([0-9.]+),"end":([0-9.]+)\}""".toRegex()
+        // Simple JSON parsing without external library; times are whole milliseconds
+        val pattern = """\{"text":"((?:[^"\\]|\\.)*)","start":(-?\d+),"end":(-?\d+)\}""".toRegex()
 
         pattern.findAll(json).forEach { match ->
-            val text = match.groupValues[1]
-                .replace("\\\"", "\"")
-                .replace("\\\\", "\\")
-                .replace("\\n", "\n")
-                .replace("\\r", "\r")
-                .replace("\\t", "\t")
-                .trim()
-
-            val startMs = match.groupValues[2].toDoubleOrNull() ?: 0.0
-            val endMs = match.groupValues[3].toDoubleOrNull() ?: 0.0
+            val text = unescapeJson(match.groupValues[1]).trim()
+            val startMs = match.groupValues[2].toLongOrNull() ?: 0L
+            val endMs = match.groupValues[3].toLongOrNull() ?: 0L
 
             if (text.isNotEmpty()) {
                 segments.add(
                     TranscriptionSegment(
                         text = text,
-                        startTimeMs = startMs.toLong(),
-                        endTimeMs = endMs.toLong()
+                        startTimeMs = startMs,
+                        endTimeMs = endMs
                     )
                 )
             }
@@ -137,6 +429,44 @@ class WhisperLib(private val context: Context) {
         return segments
     }
 
+    /**
+     * Decode JSON string escapes. Characters outside the BMP arrive as
+     * \uXXXX surrogate pairs, which combine back when appended in order.
+     */
+    private fun unescapeJson(escaped: String): String {
+        if (escaped.indexOf('\\') < 0) return escaped
+
+        val out = StringBuilder(escaped.length)
+        var i = 0
+        while (i < escaped.length) {
+            val c = escaped[i]
+            if (c != '\\' || i + 1 >= escaped.length) {
+                out.append(c)
+                i++
+                continue
+            }
+            when (val e = escaped[i + 1]) {
+                'n' -> out.append('\n')
+                'r' -> out.append('\r')
+                't' -> out.append('\t')
+                'b' -> out.append('\b')
+                'f' -> out.append('\u000C')
+                'u' -> {
+                    val code = escaped.substring(i + 2, minOf(i + 6, escaped.length)).toIntOrNull(16)
+                    if (code != null) {
+                        out.append(code.toChar())
+                        i += 4
+                    } else {
+                        out.append('\uFFFD')
+                    }
+                }
+                else -> out.append(e)
+            }
+            i += 2
+        }
+        return out.toString()
+    }
+
     // JNI methods
     private external fun initContext(modelPath: String): Long
     private external fun freeContext(contextPtr: Long)
@@ -144,10 +474,58 @@ class WhisperLib(private val context: Context) {
         contextPtr: Long,
         audioData: FloatArray,
         language: String,
+        checkpointPath: String?,
+        progressCallback: ProgressCallback?
+    ): String
+    private external fun transcribeAudioBuffer(
+        contextPtr: Long,
+        audioData: ByteBuffer,
+        numSamples: Int,
+        language: String,
+        checkpointPath: String?,
+        progressCallback: ProgressCallback?
+    ): String
+    private external fun transcribeNativeAudio(
+        contextPtr: Long,
+        audioPtr: Long,
+        language: String,
+        checkpointPath: String?,
+        chunkMs: Long,
+        bestOf: Int,
+        draftPtr: Long,
+        progressCallback: ProgressCallback?
+    ): String
+    private external fun lookupResult(
+        modelPath: String,
+        audioPtr: Long,
+        language: String,
+        chunkMs: Long,
+        bestOf: Int,
+        speculative: Boolean
+    ): String?
+    private external fun transcribeIncremental(
+        contextPtr: Long,
+        audioData: FloatArray,
+        language: String,
+        previousStarts: LongArray,
+        previousEnds: LongArray,
+        previousTexts: Array<String>,
+        editStart: Int,
+        removedSamples: Int,
+        insertedSamples: Int,
         progressCallback: ProgressCallback?
     ): String
+    private external fun setMaxThreads(maxThreads: Int)
+    private external fun setEnergyAware(enabled: Boolean)
+    private external fun updatePowerState(
+        batteryPercent: Int,
+        charging: Boolean,
+        thermalStatus: Int,
+        powerSave: Boolean
+    )
     private external fun getSystemInfo(): String
     private external fun isMultilingual(contextPtr: Long): Boolean
+    private external fun getSpeculativeTokensPerPass(): Double
 }
 
 /**
@@ -159,6 +537,30 @@ data class TranscriptionSegment(
     val endTimeMs: Long
 )
 
+/**
+ * How a transcription job fits the memory budget, from [WhisperLib.planJob].
+ */
+data class AdmissionPlan(
+    /** False if even the cheapest option is estimated over budget */
+    val admitted: Boolean,
+    /** Index of the chosen model in the candidates */
+    val modelIndex: Int,
+    /** Audio decoded per pass, or 0 for the whole recording at once */
+    val chunkMs: Long,
+    val threads: Int,
+    val bestOf: Int,
+    val estimatedBytes: Long,
+    val budgetBytes: Long,
+    val chunked: Boolean,
+    val smallerModel: Boolean
+) {
+    /** Downgrades applied, e.g. "smaller model, chunked", or "none" */
+    fun describeDowngrades(): String = listOfNotNull(
+        "smaller model".takeIf { smallerModel },
+        "chunked".takeIf { chunked }
+    ).joinToString().ifEmpty { "none" }
+}
+
 /**
  * Progress callback for JNI.
  */
@@ -0,0 +1,176 @@
+#include "arena.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+namespace securevox {
+
+namespace {
+
+std::atomic<size_t> g_scratch_high_water{0};
+
+void note_high_water(size_t bytes) {
+    size_t seen = g_scratch_high_water.load(std::memory_order_relaxed);
+    while (bytes > seen && !g_scratch_high_water.compare_exchange_weak(seen, bytes, std::memory_order_relaxed)) {
+    }
+}
+
+size_t align_up(size_t value, size_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+} // namespace
+
+Arena::Arena(size_t block_bytes) : block_bytes_(block_bytes > 0 ? block_bytes : 1) {}
+
+Arena::~Arena() {
+    free_blocks();
+}
+
+// Block headers are padded so block data starts max-aligned
+size_t Arena::header_size() {
+    return align_up(sizeof(Block), alignof(std::max_align_t));
+}
+
+Arena::Block* Arena::new_block(size_t data_bytes) {
+    void* memory = std::malloc(header_size() + data_bytes);
+    if (memory == nullptr) throw std::bad_alloc();
+
+    auto* block = static_cast<Block*>(memory);
+    block->next = nullptr;
+    block->size = data_bytes;
+    capacity_ += data_bytes;
+    system_allocations_++;
+    return block;
+}
+
+void Arena::free_blocks() {
+    while (head_ != nullptr) {
+        Block* next = head_->next;
+        std::free(head_);
+        head_ = next;
+    }
+    current_ = nullptr;
+    capacity_ = 0;
+}
+
+void* Arena::allocate(size_t bytes, size_t align) {
+    if (align < 1) align = 1;
+
+    for (;;) {
+        if (current_ != nullptr) {
+            const auto base = reinterpret_cast<uintptr_t>(current_) + header_size();
+            const size_t start = align_up(base + offset_, align) - base;
+            if (start + bytes <= current_->size) {
+                used_ += start + bytes - offset_;
+                if (used_ > high_water_) {
+                    high_water_ = used_;
+                    note_high_water(used_);
+                }
+                offset_ = start + bytes;
+                return reinterpret_cast<void*>(base + start);
+            }
+            // Blocks kept from an earlier job are reused before new ones are made
+            if (current_->next != nullptr) {
+                current_ = current_->next;
+                offset_ = 0;
+                continue;
+            }
+        }
+
+        // Grow geometrically so a long job needs few blocks
+        size_t size = block_bytes_;
+        if (current_ != nullptr && current_->size * 2 > size) size = current_->size * 2;
+        if (bytes + align > size) size = bytes + align;
+
+        Block* block = new_block(size);
+        if (current_ != nullptr) {
+            current_->next = block;
+        } else {
+            head_ = block;
+        }
+        current_ = block;
+        offset_ = 0;
+    }
+}
+
+void Arena::reset() {
+    // Collapse a multi-block chain into one block that fits the largest job seen.
+    // Each block boundary may have saved up to one alignment's worth of padding.
+    if (head_ != nullptr && head_->next != nullptr) {
+        size_t blocks = 0;
+        for (Block* b = head_; b != nullptr; b = b->next) blocks++;
+        free_blocks();
+        head_ = new_block(high_water_ + blocks * alignof(std::max_align_t));
+    }
+    current_ = head_;
+    offset_ = 0;
+    used_ = 0;
+}
+
+ArenaPool::Lease::Lease(Lease&& other) noexcept : pool_(other.pool_), arena_(other.arena_) {
+    other.pool_ = nullptr;
+    other.arena_ = nullptr;
+}
+
+ArenaPool::Lease& ArenaPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        arena_ = other.arena_;
+        other.pool_ = nullptr;
+        other.arena_ = nullptr;
+    }
+    return *this;
+}
+
+ArenaPool::Lease::~Lease() {
+    release();
+}
+
+void ArenaPool::Lease::release() {
+    if (pool_ != nullptr && arena_ != nullptr) {
+        pool_->give_back(arena_);
+    }
+    pool_ = nullptr;
+    arena_ = nullptr;
+}
+
+ArenaPool::ArenaPool(size_t block_bytes) : block_bytes_(block_bytes) {}
+
+ArenaPool::Lease ArenaPool::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty()) {
+        arenas_.push_back(std::make_unique<Arena>(block_bytes_));
+        return Lease(this, arenas_.back().get());
+    }
+    Arena* arena = free_.back();
+    free_.pop_back();
+    return Lease(this, arena);
+}
+
+void ArenaPool::give_back(Arena* arena) {
+    // Arenas out on lease belong to their job, so stats are read as they come back
+    const size_t job_bytes = arena->high_water();
+    arena->reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (job_bytes > high_water_) high_water_ = job_bytes;
+    free_.push_back(arena);
+}
+
+size_t ArenaPool::high_water() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return high_water_;
+}
+
+size_t ArenaPool::arena_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return arenas_.size();
+}
+
+size_t scratch_high_water() {
+    return g_scratch_high_water.load(std::memory_order_relaxed);
+}
+
+} // namespace securevox
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace securevox {
+
+// Bump allocator for the scratch memory of one job.
+//
+// Allocations are carved from a chain of blocks and are never freed
+// individually; reset() releases everything at once. If a job spilled into
+// extra blocks, reset() merges the chain into one block sized to the high-water
+// mark, so after the first few jobs the arena settles on a single block and
+// both allocation and reset are O(1) with no calls into the system allocator.
+//
+// Not thread-safe: one job (one thread at a time) owns an arena.
+class Arena {
+public:
+    explicit Arena(size_t block_bytes = 1 << 20);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+    // Release every allocation made since the last reset
+    void reset();
+
+    // Bytes handed out since the last reset, including alignment padding
+    size_t used() const { return used_; }
+    // Largest used() seen at any point
+    size_t high_water() const { return high_water_; }
+    // Bytes held from the system allocator
+    size_t capacity() const { return capacity_; }
+    // Blocks requested from the system allocator over the arena's lifetime
+    size_t system_allocations() const { return system_allocations_; }
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+    };
+
+    static size_t header_size();
+    Block* new_block(size_t data_bytes);
+    void free_blocks();
+
+    const size_t block_bytes_;
+    Block* head_ = nullptr;
+    Block* current_ = nullptr;
+    size_t offset_ = 0;  // into current_'s data
+    size_t used_ = 0;
+    size_t high_water_ = 0;
+    size_t capacity_ = 0;
+    size_t system_allocations_ = 0;
+};
+
+// Standard allocator over an Arena. Default-constructed it uses the heap, so
+// containers declared with it work unchanged where no arena is in play.
+// deallocate() is a no-op for arena memory; it comes back on Arena::reset().
+template <class T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() noexcept = default;
+    explicit ArenaAllocator(Arena* arena) noexcept : arena_(arena) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    T* allocate(size_t n) {
+        if (arena_ == nullptr) return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t /*n*/) noexcept {
+        if (arena_ == nullptr) ::operator delete(p);
+    }
+
+    Arena* arena() const noexcept { return arena_; }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.arena(); }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena_ != other.arena(); }
+
+private:
+    Arena* arena_ = nullptr;
+};
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Mono float samples, heap-backed unless given an arena
+using SampleVector = ArenaVector<float>;
+
+// Arenas reused across the jobs of a batch. A job leases one, the lease resets
+// it and hands it back when released, and the pool only grows to the number of
+// jobs alive at the same time.
+class ArenaPool {
+public:
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        Arena* get() const { return arena_; }
+        Arena* operator->() const { return arena_; }
+        explicit operator bool() const { return arena_ != nullptr; }
+
+    private:
+        friend class ArenaPool;
+        Lease(ArenaPool* pool, Arena* arena) : pool_(pool), arena_(arena) {}
+        void release();
+
+        ArenaPool* pool_ = nullptr;
+        Arena* arena_ = nullptr;
+    };
+
+    explicit ArenaPool(size_t block_bytes = 1 << 20);
+
+    ArenaPool(const ArenaPool&) = delete;
+    ArenaPool& operator=(const ArenaPool&) = delete;
+
+    Lease acquire();
+
+    // Largest scratch footprint of any finished job
+    size_t high_water() const;
+    // Arenas created, i.e. the most jobs that held one at the same time
+    size_t arena_count() const;
+
+private:
+    void give_back(Arena* arena);
+
+    const size_t block_bytes_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Arena>> arenas_;
+    std::vector<Arena*> free_;
+    size_t high_water_ = 0;
+};
+
+// Largest scratch footprint of any job in the process, across all arenas
+size_t scratch_high_water();
+
+} // namespace securevox
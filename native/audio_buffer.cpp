@@ -0,0 +1,94 @@
+#include "audio_buffer.h"
+
+#include "audio_decoder.h"
+#include "resampler.h"
+
+#include <algorithm>
+
+namespace securevox {
+
+AudioBuffer::AudioBuffer(int sample_rate) : sample_rate_(sample_rate) {}
+
+bool AudioBuffer::load_file(const std::string& path, std::string& error) {
+    AudioData audio;
+    if (!load_audio(path, audio, error)) {
+        return false;
+    }
+
+    samples_.swap(audio.samples);
+    sample_rate_ = audio.sample_rate;
+    original_length_ = samples_.size();
+    silence_removed_ = false;
+    time_map_ = TimeMap();
+    return true;
+}
+
+float* AudioBuffer::extend(size_t n) {
+    const size_t offset = samples_.size();
+    if (silence_removed_ && !time_map_.empty()) {
+        time_map_.add(offset, original_length_, n);
+    }
+    samples_.resize(offset + n);
+    original_length_ += n;
+    return samples_.data() + offset;
+}
+
+void AudioBuffer::append(const float* samples, size_t n) {
+    std::copy(samples, samples + n, extend(n));
+}
+
+void AudioBuffer::append_pcm16(const int16_t* samples, size_t n) {
+    pcm16_to_float(samples, n, extend(n));
+}
+
+bool AudioBuffer::resample(int out_rate, std::string& error) {
+    if (out_rate <= 0) {
+        error = "Invalid sample rate: " + std::to_string(out_rate);
+        return false;
+    }
+    if (out_rate == sample_rate_) return true;
+    if (silence_removed_) {
+        error = "Resample before removing silence";
+        return false;
+    }
+
+    SampleVector out;
+    securevox::resample(samples_.data(), samples_.size(), sample_rate_, out_rate, out);
+    samples_.swap(out);
+    sample_rate_ = out_rate;
+    original_length_ = samples_.size();
+    return true;
+}
+
+bool AudioBuffer::suppress_noise(const DenoiseOptions& options, const VadOptions& vad, std::string& error) {
+    if (silence_removed_) {
+        error = "Suppress noise before removing silence";
+        return false;
+    }
+
+    const auto speech = detect_speech(samples_.data(), samples_.size(), sample_rate_, vad);
+    SampleVector out;
+    securevox::suppress_noise(samples_.data(), samples_.size(), sample_rate_, speech, options, out);
+    samples_.swap(out);
+    return true;
+}
+
+bool AudioBuffer::remove_silence(const VadOptions& options, std::string& error) {
+    if (silence_removed_) {
+        error = "Silence was already removed";
+        return false;
+    }
+
+    const auto speech = detect_speech(samples_.data(), samples_.size(), sample_rate_, options);
+    SampleVector out;
+    securevox::remove_silence(samples_.data(), samples_.size(), speech, out, time_map_);
+    samples_.swap(out);
+    silence_removed_ = true;
+    return true;
+}
+
+int64_t AudioBuffer::duration_ms() const {
+    return sample_rate_ > 0 ? static_cast<int64_t>(original_length_) * 1000 / sample_rate_ : 0;
+}
+
+} // namespace securevox
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "denoise.h"
+#include "vad.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace securevox {
+
+// Mono float audio owned by native code.
+//
+// Backs the opaque audio handles of the app bindings: recordings are decoded,
+// converted, trimmed and transcribed here, and managed code only ever holds a
+// pointer, so long files never become arrays on a garbage-collected heap.
+//
+// Silence removal records a TimeMap so segment times can be reported on the
+// original timeline. Resample before removing silence; audio appended
+// afterwards is kept whole and mapped one-to-one.
+class AudioBuffer {
+public:
+    explicit AudioBuffer(int sample_rate);
+
+    AudioBuffer(const AudioBuffer&) = delete;
+    AudioBuffer& operator=(const AudioBuffer&) = delete;
+
+    // Replace the contents with a decoded WAV or FLAC file at its own sample rate
+    bool load_file(const std::string& path, std::string& error);
+
+    void append(const float* samples, size_t n);
+    void append_pcm16(const int16_t* samples, size_t n);
+    // Grow by n samples and return where to write them
+    float* extend(size_t n);
+
+    // Convert to out_rate in place. Fails once silence has been removed.
+    bool resample(int out_rate, std::string& error);
+
+    // Spectral noise gating with the noise taken from what the VAD finds
+    // silent; the length and timeline are unchanged. Must happen before
+    // remove_silence, which leaves no silence to estimate the noise from.
+    bool suppress_noise(const DenoiseOptions& options, const VadOptions& vad, std::string& error);
+
+    // Drop non-speech regions detected by the energy VAD. Fails if already done.
+    bool remove_silence(const VadOptions& options, std::string& error);
+
+    const float* data() const { return samples_.data(); }
+    size_t size() const { return samples_.size(); }
+    int sample_rate() const { return sample_rate_; }
+    // Duration of the original (untrimmed) audio
+    int64_t duration_ms() const;
+    const TimeMap& time_map() const { return time_map_; }
+
+private:
+    SampleVector samples_;
+    int sample_rate_;
+    size_t original_length_ = 0;
+    bool silence_removed_ = false;
+    TimeMap time_map_;
+};
+
+} // namespace securevox
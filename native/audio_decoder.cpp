@@ -0,0 +1,193 @@
+#include "audio_decoder.h"
+
+#include "flac.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+namespace securevox {
+
+namespace {
+
+constexpr uint16_t WAVE_FORMAT_PCM = 0x0001;
+constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// Bytes read from disk per conversion pass
+constexpr size_t READ_BLOCK_BYTES = 64 * 1024;
+
+struct FileCloser {
+    void operator()(FILE* f) const { if (f) std::fclose(f); }
+};
+
+uint16_t read_u16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t read_u32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+float decode_sample(const uint8_t* p, int bits, bool is_float) {
+    if (is_float) {
+        float v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    switch (bits) {
+        case 8:  return (static_cast<int>(p[0]) - 128) * (1.0f / 128.0f);
+        case 16: return static_cast<int16_t>(read_u16(p)) * (1.0f / 32768.0f);
+        case 24: {
+            int32_t v = static_cast<int32_t>((p[0] << 8) | (p[1] << 16) | (static_cast<uint32_t>(p[2]) << 24)) >> 8;
+            return v * (1.0f / 8388608.0f);
+        }
+        case 32: return static_cast<int32_t>(read_u32(p)) * (1.0f / 2147483648.0f);
+        default: return 0.0f;
+    }
+}
+
+} // namespace
+
+void pcm16_to_float(const int16_t* in, size_t n, float* out) {
+    constexpr float scale = 1.0f / 32768.0f;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = in[i] * scale;
+    }
+}
+
+bool read_wav_header(FILE* f, WavFormat& format, std::string& error) {
+    uint8_t header[12];
+    if (std::fread(header, 1, sizeof(header), f) != sizeof(header) ||
+        std::memcmp(header, "RIFF", 4) != 0 || std::memcmp(header + 8, "WAVE", 4) != 0) {
+        error = "Not a RIFF/WAVE file";
+        return false;
+    }
+
+    uint16_t tag = 0;
+    bool have_fmt = false;
+
+    uint8_t chunk[8];
+    while (std::fread(chunk, 1, sizeof(chunk), f) == sizeof(chunk)) {
+        const uint32_t size = read_u32(chunk + 4);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t fmt[40] = {};
+            const size_t n = size < sizeof(fmt) ? size : sizeof(fmt);
+            if (size < 16 || std::fread(fmt, 1, n, f) != n) {
+                error = "Truncated fmt chunk";
+                return false;
+            }
+            tag = read_u16(fmt);
+            format.channels = read_u16(fmt + 2);
+            format.sample_rate = static_cast<int>(read_u32(fmt + 4));
+            format.bits = read_u16(fmt + 14);
+            if (tag == WAVE_FORMAT_EXTENSIBLE && n >= 26) {
+                tag = read_u16(fmt + 24);  // first two bytes of the subformat GUID
+            }
+            // Skip whatever did not fit, plus the pad byte of odd-sized chunks
+            std::fseek(f, static_cast<long>(size - n + (size & 1)), SEEK_CUR);
+            have_fmt = true;
+            continue;
+        }
+
+        if (std::memcmp(chunk, "data", 4) != 0) {
+            std::fseek(f, static_cast<long>(size + (size & 1)), SEEK_CUR);
+            continue;
+        }
+
+        if (!have_fmt) {
+            error = "data chunk before fmt chunk";
+            return false;
+        }
+
+        const int bits = format.bits;
+        format.is_float = tag == WAVE_FORMAT_IEEE_FLOAT;
+        if ((tag != WAVE_FORMAT_PCM && !format.is_float) || format.channels <= 0 ||
+            (format.is_float && bits != 32) || (!format.is_float && bits != 8 && bits != 16 && bits != 24 && bits != 32)) {
+            error = "Unsupported WAV encoding (format " + std::to_string(tag) +
+                    ", " + std::to_string(bits) + " bits)";
+            return false;
+        }
+
+        const uint64_t frame_bytes = static_cast<uint64_t>(format.channels) * (bits / 8);
+        // Recorders that are killed mid-write leave 0 or 0xFFFFFFFF here; read to EOF then
+        const bool open_ended = size == 0 || size == 0xFFFFFFFFu;
+        format.data_bytes = open_ended ? UINT64_MAX : size / frame_bytes * frame_bytes;
+        return true;
+    }
+
+    error = "No data chunk in WAV file";
+    return false;
+}
+
+bool load_wav(const std::string& path, AudioData& out, std::string& error) {
+    std::unique_ptr<FILE, FileCloser> file(std::fopen(path.c_str(), "rb"));
+    if (!file) {
+        error = "Cannot open audio file: " + path;
+        return false;
+    }
+
+    WavFormat format;
+    if (!read_wav_header(file.get(), format, error)) return false;
+
+    const int channels = format.channels;
+    const int bits = format.bits;
+    const bool is_float = format.is_float;
+    const size_t frame_bytes = static_cast<size_t>(channels) * (bits / 8);
+    const bool open_ended = format.data_bytes == UINT64_MAX;
+    size_t remaining = open_ended ? SIZE_MAX : static_cast<size_t>(format.data_bytes);
+
+    out.sample_rate = format.sample_rate;
+    out.samples.clear();
+    if (!open_ended) out.samples.reserve(remaining / frame_bytes);
+
+    const float inv_channels = 1.0f / channels;
+    ArenaVector<uint8_t> block(READ_BLOCK_BYTES / frame_bytes * frame_bytes, out.samples.get_allocator());
+    while (remaining > 0) {
+        const size_t want = remaining < block.size() ? remaining : block.size();
+        const size_t got = std::fread(block.data(), 1, want, file.get()) / frame_bytes * frame_bytes;
+        if (got == 0) break;
+
+        const size_t frames = got / frame_bytes;
+        const uint8_t* p = block.data();
+        if (channels == 1 && bits == 16 && !is_float) {
+            const size_t base = out.samples.size();
+            out.samples.resize(base + frames);
+            // Data is little-endian; the aligned fast path assumes a little-endian host
+            pcm16_to_float(reinterpret_cast<const int16_t*>(p), frames, out.samples.data() + base);
+        } else {
+            for (size_t f = 0; f < frames; f++) {
+                float sum = 0.0f;
+                for (int c = 0; c < channels; c++) {
+                    sum += decode_sample(p, bits, is_float);
+                    p += bits / 8;
+                }
+                out.samples.push_back(sum * inv_channels);
+            }
+        }
+        remaining -= got;
+    }
+    return true;
+}
+
+bool load_audio(const std::string& path, AudioData& out, std::string& error) {
+    char magic[4] = {};
+    {
+        std::unique_ptr<FILE, FileCloser> file(std::fopen(path.c_str(), "rb"));
+        if (!file) {
+            error = "Cannot open audio file: " + path;
+            return false;
+        }
+        if (std::fread(magic, 1, sizeof(magic), file.get()) != sizeof(magic)) {
+            error = "Audio file too short: " + path;
+            return false;
+        }
+    }
+
+    if (std::memcmp(magic, "fLaC", 4) == 0) return load_flac(path, out, error);
+    return load_wav(path, out, error);
+}
+
+} // namespace securevox
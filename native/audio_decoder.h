@@ -0,0 +1,48 @@
+#pragma once
+
+#include "arena.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace securevox {
+
+// Decoded audio, downmixed to mono and normalized to [-1, 1]
+struct AudioData {
+    AudioData() = default;
+    // Decode into arena memory instead of the heap
+    explicit AudioData(Arena* arena) : samples(ArenaAllocator<float>(arena)) {}
+
+    SampleVector samples;
+    int sample_rate = 0;
+};
+
+// Sample format of the data chunk of a RIFF/WAVE file
+struct WavFormat {
+    bool is_float = false;
+    int channels = 0;
+    int sample_rate = 0;
+    int bits = 0;
+    // Whole frames in the data chunk; UINT64_MAX when the writer never filled it in
+    uint64_t data_bytes = 0;
+};
+
+// Parse the chunks of a RIFF/WAVE file up to its data chunk and leave f at the
+// first sample. Fails on encodings load_wav cannot decode.
+bool read_wav_header(FILE* f, WavFormat& format, std::string& error);
+
+// Decode a RIFF/WAVE file (8/16/24/32-bit PCM or 32-bit float, any channel count).
+// Chunks are parsed properly instead of assuming a 44-byte header.
+// The read buffer comes from the same allocator as out.samples.
+bool load_wav(const std::string& path, AudioData& out, std::string& error);
+
+// Decode a WAV or FLAC file, chosen by its signature rather than its extension
+bool load_audio(const std::string& path, AudioData& out, std::string& error);
+
+// Convert signed 16-bit PCM to float in [-1, 1]
+void pcm16_to_float(const int16_t* in, size_t n, float* out);
+
+} // namespace securevox
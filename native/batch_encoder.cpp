@@ -0,0 +1,124 @@
+#include "batch_encoder.h"
+
+#include "content_hash.h"
+#include "encoder_cache.h"
+#include "thread_pool.h"
+#include "whisper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace securevox {
+
+BatchEncoder::BatchEncoder(whisper_context* ctx, int batch)
+    : ctx_(ctx), batch_(std::max(1, batch)) {}
+
+BatchEncoder::~BatchEncoder() {
+    for (whisper_state* state : states_) whisper_free_state(state);
+}
+
+void BatchEncoder::set_batch(int batch) {
+    batch_ = std::max(1, batch);
+    while (static_cast<int>(states_.size()) > std::max(0, batch)) {
+        whisper_free_state(states_.back());
+        states_.pop_back();
+        outputs_.pop_back();
+    }
+}
+
+bool BatchEncoder::available() {
+#ifdef WHISPER_HAS_ENCODER_OUTPUT
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool BatchEncoder::encode(const std::vector<EncodeWindow>& windows, int n_threads, std::string& error) {
+#ifdef WHISPER_HAS_ENCODER_OUTPUT
+    EncoderCache& cache = EncoderCache::instance();
+    const uint64_t model = cache.model_of(ctx_);
+    if (ctx_ == nullptr || model == 0 || !cache.enabled()) {
+        error = "Encoder cache disabled or model not registered";
+        return false;
+    }
+
+    // Windows already cached are left to whisper_full
+    std::vector<std::pair<const EncodeWindow*, EncoderKey>> pending;
+    for (const EncodeWindow& window : windows) {
+        if (window.samples == nullptr || window.n == 0) continue;
+        EncoderKey key;
+        key.audio = hash_samples(window.samples, window.n);
+        key.model = model;
+        key.mel_offset = window.mel_offset;
+        key.audio_ctx = whisper_n_audio_ctx(ctx_);  // whisper_full's default, the full context
+        if (cache.contains(key)) {
+            stats_.skipped++;
+            continue;
+        }
+        pending.emplace_back(&window, key);
+    }
+
+    const size_t n_embd = static_cast<size_t>(whisper_n_audio_ctx(ctx_)) *
+                          static_cast<size_t>(whisper_model_n_audio_state(ctx_));
+    bool ok = true;
+    for (size_t first = 0; first < pending.size(); first += static_cast<size_t>(batch_)) {
+        const int count = static_cast<int>(std::min(pending.size() - first, static_cast<size_t>(batch_)));
+        while (static_cast<int>(states_.size()) < count) {
+            whisper_state* state = whisper_init_state(ctx_);
+            if (state == nullptr) {
+                error = "Failed to allocate an encoder state";
+                return false;
+            }
+            states_.push_back(state);
+            outputs_.emplace_back(n_embd);
+        }
+
+        // Slot i encodes pending[first + i] as a pool task. Its ggml threads are
+        // leased around the slot it runs in, so they count against the pool cap
+        // and a busy pool shrinks them instead of oversubscribing the cores.
+        const int share = std::max(1, n_threads / count);
+        std::vector<char> encoded(static_cast<size_t>(count), 0);
+        auto run = [&](int slot) {
+            ThreadPool::Lease lease = ThreadPool::instance().lease(share);
+            const int threads = lease.count();
+            const EncodeWindow& window = *pending[first + slot].first;
+            whisper_state* state = states_[slot];
+            std::vector<float>& output = outputs_[slot];
+            if (whisper_pcm_to_mel_with_state(ctx_, state, window.samples, static_cast<int>(window.n), threads) != 0 ||
+                whisper_encode_with_state(ctx_, state, window.mel_offset, threads) != 0) {
+                return;
+            }
+            const size_t n = whisper_get_encoder_output_from_state(state, output.data(), output.size());
+            if (n == 0) return;
+            cache.store(pending[first + slot].second, output.data(), n);
+            encoded[slot] = 1;
+        };
+
+        const auto start = std::chrono::steady_clock::now();
+        ThreadPool::instance().parallel_for(count, run);
+        stats_.encode_ms += std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        stats_.batches++;
+
+        for (char done : encoded) {
+            if (done) {
+                stats_.windows++;
+            } else {
+                ok = false;
+            }
+        }
+    }
+
+    if (!ok) error = "Encoder failed on a window";
+    return ok;
+#else
+    (void)windows;
+    (void)n_threads;
+    error = "whisper.cpp was built without the encoder output export (patches/03-encoder-output.patch)";
+    return false;
+#endif
+}
+
+} // namespace securevox
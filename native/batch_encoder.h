@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct whisper_context;
+struct whisper_state;
+
+namespace securevox {
+
+// One 30 s window to encode ahead of whisper_full
+struct EncodeWindow {
+    const float* samples = nullptr;  // exactly the audio later given to whisper_full
+    size_t n = 0;
+    int mel_offset = 0;              // window start in mel frames (10 ms each)
+};
+
+struct BatchEncodeStats {
+    int windows = 0;        // encoded and put in the encoder cache
+    int skipped = 0;        // already cached, left alone
+    int batches = 0;        // groups encoded side by side
+    int64_t encode_ms = 0;  // wall time of those groups, mel spectrograms included
+
+    double windows_per_second() const { return encode_ms > 0 ? windows * 1000.0 / encode_ms : 0.0; }
+};
+
+// Encodes independent windows several at a time, ahead of whisper_full.
+//
+// whisper_full evaluates the encoder graph for one window at a time on all of
+// its threads, and on many cores the matrix products of a single window leave
+// most of them waiting. BatchEncoder instead runs up to `batch` windows side by
+// side, each on its own whisper_state with an equal share of the threads, and
+// puts the outputs in the EncoderCache under the key whisper_full looks up, so
+// the encoder runs of the following whisper_full calls are cache hits.
+//
+// Windows must be independent of decoding: the first window of each queued
+// recording, or windows of one recording at offsets known in advance. Each
+// window computes the mel spectrogram of its whole audio, as whisper_full does,
+// so its output is exactly what whisper_full would encode.
+//
+// This is not a batched encoder graph: each slot is a whole whisper_state
+// (KV caches and graph buffers), so `batch` should be capped with
+// max_encode_states (memory_budget.h).
+//
+// Needs patches/03-encoder-output.patch, the encoder cache enabled and the
+// model registered with it. Must not run while whisper_full runs on ctx.
+class BatchEncoder {
+public:
+    // batch: windows encoded side by side; 1 encodes them one after another
+    BatchEncoder(whisper_context* ctx, int batch);
+    ~BatchEncoder();
+
+    BatchEncoder(const BatchEncoder&) = delete;
+    BatchEncoder& operator=(const BatchEncoder&) = delete;
+
+    // Whether whisper.cpp was built with the encoder output export
+    static bool available();
+
+    // Encode every window not cached yet, batch at a time, with up to n_threads
+    // ggml threads in all. The windows of a batch run as ThreadPool tasks and
+    // lease their threads from its cap, so the caller must not hold a lease
+    // that saturates it. False if a window could not be encoded; the others
+    // are cached regardless.
+    bool encode(const std::vector<EncodeWindow>& windows, int n_threads, std::string& error);
+
+    int batch() const { return batch_; }
+
+    // Change the windows encoded side by side and free the states beyond that
+    // count. 0 frees them all; a later encode() then runs one window at a time.
+    void set_batch(int batch);
+
+    // Totals since construction
+    const BatchEncodeStats& stats() const { return stats_; }
+
+private:
+    whisper_context* ctx_;
+    int batch_;
+    // One per slot, created on first use and kept for the following batches
+    std::vector<whisper_state*> states_;
+    std::vector<std::vector<float>> outputs_;
+    BatchEncodeStats stats_;
+};
+
+} // namespace securevox
@@ -0,0 +1,114 @@
+#include "batch_pipeline.h"
+
+#include "audio_decoder.h"
+#include "resampler.h"
+
+#include <algorithm>
+
+namespace securevox {
+
+PreparedAudio prepare_audio(const std::string& path, const PreprocessOptions& options, Arena* arena) {
+    PreparedAudio prepared;
+    prepared.path = path;
+    prepared.samples = SampleVector(ArenaAllocator<float>(arena));
+    prepared.time_map = TimeMap(arena);
+
+    AudioData audio(arena);
+    if (!load_audio(path, audio, prepared.error)) {
+        return prepared;
+    }
+
+    SampleVector pcm{ArenaAllocator<float>(arena)};
+    if (audio.sample_rate != MODEL_SAMPLE_RATE) {
+        resample(audio.samples.data(), audio.samples.size(), audio.sample_rate, MODEL_SAMPLE_RATE, pcm);
+    } else {
+        pcm.swap(audio.samples);
+    }
+    // Free the source-rate copy before the VAD pass allocates its own
+    SampleVector(audio.samples.get_allocator()).swap(audio.samples);
+
+    if (options.remove_silence) {
+        const auto speech = detect_speech(pcm.data(), pcm.size(), MODEL_SAMPLE_RATE, options.vad, arena);
+        remove_silence(pcm.data(), pcm.size(), speech, prepared.samples, prepared.time_map);
+    } else {
+        prepared.samples.swap(pcm);
+    }
+
+    if (prepared.samples.empty()) {
+        prepared.error = "No audio samples in " + path;
+        return prepared;
+    }
+
+    prepared.ok = true;
+    return prepared;
+}
+
+BatchPipeline::BatchPipeline(std::vector<std::string> paths, int prefetch,
+                             PreprocessOptions options, ThreadPool& pool)
+    : paths_(std::move(paths)),
+      prefetch_(static_cast<size_t>(std::max(1, prefetch))),
+      options_(std::move(options)),
+      pool_(pool) {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (next_schedule_ < paths_.size() && next_schedule_ < prefetch_) {
+        schedule(next_schedule_++);
+    }
+}
+
+BatchPipeline::~BatchPipeline() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    cv_.wait(lock, [this] { return in_flight_ == 0; });
+}
+
+// Called with mutex_ held
+void BatchPipeline::schedule(size_t index) {
+    in_flight_++;
+    pool_.submit([this, index] {
+        PreparedAudio prepared;
+        bool skip;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            skip = cancelled_;
+        }
+        if (!skip) {
+            ArenaPool::Lease arena = arenas_.acquire();
+            prepared = prepare_audio(paths_[index], options_, arena.get());
+            prepared.arena = std::move(arena);
+        }
+        prepared.index = index;
+
+        // Notify under the lock: the destructor may free *this as soon as in_flight_ hits zero
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!cancelled_) {
+            ready_.emplace(index, std::move(prepared));
+        } else {
+            // Hand the arena back while the pool is guaranteed to be alive
+            prepared = PreparedAudio();
+        }
+        in_flight_--;
+        cv_.notify_all();
+    });
+}
+
+bool BatchPipeline::next(PreparedAudio& out) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (next_index_ >= paths_.size()) return false;
+
+    const size_t index = next_index_;
+    cv_.wait(lock, [this, index] { return ready_.count(index) > 0; });
+
+    auto it = ready_.find(index);
+    out = std::move(it->second);
+    ready_.erase(it);
+    next_index_++;
+
+    // Backpressure: a slot only opens when the consumer takes a recording
+    if (next_schedule_ < paths_.size()) {
+        schedule(next_schedule_++);
+    }
+    return true;
+}
+
+} // namespace securevox
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "arena.h"
+#include "thread_pool.h"
+#include "vad.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace securevox {
+
+struct PreprocessOptions {
+    // Drop silence before inference; segment times are mapped back through time_map
+    bool remove_silence = true;
+    VadOptions vad;
+};
+
+// One recording after decode, resample and VAD, ready for whisper_full
+struct PreparedAudio {
+    // Scratch arena the buffers below live in, when prepared by a BatchPipeline.
+    // Declared first so it goes back to the pool after they are destroyed.
+    ArenaPool::Lease arena;
+    size_t index = 0;
+    std::string path;
+    SampleVector samples;  // 16 kHz mono
+    TimeMap time_map;      // empty when nothing was removed
+    bool ok = false;
+    std::string error;
+};
+
+// Decode, resample and VAD one file on the calling thread. All buffers,
+// including intermediate ones, are allocated from arena when one is given.
+PreparedAudio prepare_audio(const std::string& path, const PreprocessOptions& options,
+                            Arena* arena = nullptr);
+
+// Bounded producer/consumer pipeline for batch transcription.
+//
+// While the consumer runs inference on recording N, the shared thread pool
+// prepares up to `prefetch` of the following recordings. A new file is only
+// scheduled when the consumer takes one, so at most prefetch + 1 decoded
+// recordings are alive at any time regardless of the batch size.
+//
+// Each recording is prepared in an arena leased from the pipeline's pool and
+// returned when the consumer takes the next one, so a long batch reuses the
+// same prefetch + 1 arenas and its RSS stays flat. Items returned by next()
+// must not outlive the pipeline.
+class BatchPipeline {
+public:
+    BatchPipeline(std::vector<std::string> paths, int prefetch,
+                  PreprocessOptions options = PreprocessOptions(),
+                  ThreadPool& pool = ThreadPool::instance());
+
+    // Waits for in-flight preprocessing; queued files that have not started are skipped
+    ~BatchPipeline();
+
+    BatchPipeline(const BatchPipeline&) = delete;
+    BatchPipeline& operator=(const BatchPipeline&) = delete;
+
+    size_t size() const { return paths_.size(); }
+
+    // Take the next recording in input order, blocking until it is prepared.
+    // Returns false once every recording has been handed out.
+    bool next(PreparedAudio& out);
+
+    // Largest scratch footprint of a single recording so far
+    size_t scratch_high_water() const { return arenas_.high_water(); }
+
+private:
+    void schedule(size_t index);
+
+    const std::vector<std::string> paths_;
+    const size_t prefetch_;
+    const PreprocessOptions options_;
+    ThreadPool& pool_;
+    // Before ready_, which holds leases on it
+    ArenaPool arenas_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<size_t, PreparedAudio> ready_;
+    size_t next_index_ = 0;      // next recording handed to the consumer
+    size_t next_schedule_ = 0;   // next recording to start preparing
+    int in_flight_ = 0;
+    bool cancelled_ = false;
+};
+
+} // namespace securevox
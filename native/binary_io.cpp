@@ -0,0 +1,69 @@
+#include "binary_io.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace securevox {
+
+void put_u32(std::string& buf, uint32_t v) {
+    for (int i = 0; i < 4; i++) buf.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+void put_u64(std::string& buf, uint64_t v) {
+    for (int i = 0; i < 8; i++) buf.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+bool get_u32(FILE* f, uint32_t& v) {
+    uint8_t b[4];
+    if (std::fread(b, 1, 4, f) != 4) return false;
+    v = static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+        (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+    return true;
+}
+
+bool get_u64(FILE* f, uint64_t& v) {
+    uint32_t lo, hi;
+    if (!get_u32(f, lo) || !get_u32(f, hi)) return false;
+    v = static_cast<uint64_t>(lo) | (static_cast<uint64_t>(hi) << 32);
+    return true;
+}
+
+void put_varint(std::string& buf, uint64_t v) {
+    while (v >= 0x80) {
+        buf.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    buf.push_back(static_cast<char>(v));
+}
+
+bool get_varint(const std::string& buf, size_t& pos, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && pos < buf.size(); shift += 7) {
+        const uint8_t b = static_cast<uint8_t>(buf[pos++]);
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+uint32_t fnv1a(const char* data, size_t n, uint32_t h) {
+    for (size_t i = 0; i < n; i++) {
+        h ^= static_cast<uint8_t>(data[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool sync_file(FILE* f) {
+    if (std::fflush(f) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+} // namespace securevox
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace securevox {
+
+// Little-endian encoding for the sidecar and index files
+void put_u32(std::string& buf, uint32_t v);
+void put_u64(std::string& buf, uint64_t v);
+bool get_u32(FILE* f, uint32_t& v);
+bool get_u64(FILE* f, uint64_t& v);
+
+// LEB128 varint, used for delta-coded postings
+void put_varint(std::string& buf, uint64_t v);
+
+// Decode a varint at pos, advancing it. Returns false on a truncated value.
+bool get_varint(const std::string& buf, size_t& pos, uint64_t& v);
+
+// FNV-1a record checksum; pass the previous result as h to hash in pieces
+uint32_t fnv1a(const char* data, size_t n, uint32_t h = 2166136261u);
+
+// Flush stdio buffers and force the data to storage
+bool sync_file(FILE* f);
+
+} // namespace securevox
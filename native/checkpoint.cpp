@@ -0,0 +1,152 @@
+#include "checkpoint.h"
+
+#include "binary_io.h"
+
+#include <cstring>
+
+namespace securevox {
+
+namespace {
+
+constexpr char MAGIC[4] = {'S', 'V', 'C', 'K'};
+constexpr uint32_t VERSION = 1;
+
+// Sanity limit for a single segment's text when reading back
+constexpr uint32_t MAX_TEXT_BYTES = 64 * 1024;
+
+void encode_record(std::string& buf, const Segment& segment) {
+    const size_t begin = buf.size();
+    put_u64(buf, static_cast<uint64_t>(segment.start_ms));
+    put_u64(buf, static_cast<uint64_t>(segment.end_ms));
+    put_u32(buf, static_cast<uint32_t>(segment.text.size()));
+    buf.append(segment.text);
+    put_u32(buf, fnv1a(buf.data() + begin, buf.size() - begin));
+}
+
+} // namespace
+
+Checkpoint::~Checkpoint() {
+    if (file_ != nullptr) std::fclose(file_);
+}
+
+bool Checkpoint::open(const std::string& path, uint64_t n_samples, const std::string& job_key, std::string& error) {
+    path_ = path;
+    segments_.clear();
+    if (file_ != nullptr) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+
+    const bool resumed = load(job_key, n_samples);
+    if (!resumed) segments_.clear();
+
+    // Rewrite header plus intact records to a temp file and swap it in, which
+    // also drops a torn tail without ever leaving a half-written checkpoint
+    const std::string tmp = path + ".tmp";
+    FILE* out = std::fopen(tmp.c_str(), "wb");
+    if (out == nullptr) {
+        error = "Cannot write checkpoint: " + tmp;
+        return false;
+    }
+
+    std::string buf(MAGIC, 4);
+    put_u32(buf, VERSION);
+    put_u64(buf, n_samples);
+    put_u32(buf, static_cast<uint32_t>(job_key.size()));
+    buf.append(job_key);
+    for (const Segment& segment : segments_) encode_record(buf, segment);
+
+    const bool written = std::fwrite(buf.data(), 1, buf.size(), out) == buf.size() && sync_file(out);
+    std::fclose(out);
+    if (!written) {
+        std::remove(tmp.c_str());
+        error = "Cannot write checkpoint: " + tmp;
+        return false;
+    }
+
+#ifdef _WIN32
+    std::remove(path.c_str());  // rename does not replace on Windows
+#endif
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        error = "Cannot replace checkpoint: " + path;
+        return false;
+    }
+
+    file_ = std::fopen(path.c_str(), "ab");
+    if (file_ == nullptr) {
+        error = "Cannot open checkpoint: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool Checkpoint::load(const std::string& job_key, uint64_t n_samples) {
+    FILE* f = std::fopen(path_.c_str(), "rb");
+    if (f == nullptr) return false;
+
+    bool ok = false;
+    char magic[4];
+    uint32_t version = 0, key_len = 0;
+    uint64_t stored_samples = 0;
+
+    if (std::fread(magic, 1, 4, f) == 4 && std::memcmp(magic, MAGIC, 4) == 0 &&
+        get_u32(f, version) && version == VERSION &&
+        get_u64(f, stored_samples) && stored_samples == n_samples &&
+        get_u32(f, key_len) && key_len == job_key.size()) {
+
+        std::string key(key_len, '\0');
+        ok = std::fread(&key[0], 1, key_len, f) == key_len && key == job_key;
+    }
+
+    if (ok) {
+        for (;;) {
+            std::string record;
+            uint64_t start, end;
+            uint32_t len, checksum;
+            if (!get_u64(f, start) || !get_u64(f, end) || !get_u32(f, len) || len > MAX_TEXT_BYTES) break;
+
+            Segment segment;
+            segment.start_ms = static_cast<int64_t>(start);
+            segment.end_ms = static_cast<int64_t>(end);
+            segment.text.resize(len);
+            if (len > 0 && std::fread(&segment.text[0], 1, len, f) != len) break;
+            if (!get_u32(f, checksum)) break;
+
+            encode_record(record, segment);
+            if (fnv1a(record.data(), record.size() - 4) != checksum) break;
+
+            segments_.push_back(std::move(segment));
+        }
+    }
+
+    std::fclose(f);
+    return ok;
+}
+
+int64_t Checkpoint::resume_offset_ms() const {
+    return segments_.empty() ? 0 : segments_.back().end_ms;
+}
+
+std::string Checkpoint::prompt_tail(size_t max_chars) const {
+    return tail_text(segments_, max_chars);
+}
+
+bool Checkpoint::append(const std::vector<Segment>& window) {
+    if (file_ == nullptr || window.empty()) return file_ != nullptr;
+
+    std::string buf;
+    for (const Segment& segment : window) encode_record(buf, segment);
+    if (std::fwrite(buf.data(), 1, buf.size(), file_) != buf.size()) return false;
+    return sync_file(file_);
+}
+
+void Checkpoint::remove() {
+    if (file_ != nullptr) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    std::remove(path_.c_str());
+    segments_.clear();
+}
+
+} // namespace securevox
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "segment.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace securevox {
+
+// Append-only sidecar that records transcription progress window by window.
+//
+// Layout: a header (magic, version, sample count, job key) followed by one
+// checksummed record per segment. Every decoded window is appended and synced
+// before decoding continues, so a job killed by the OS loses at most the window
+// in flight; a torn trailing record is detected by its checksum and dropped.
+class Checkpoint {
+public:
+    Checkpoint() = default;
+    ~Checkpoint();
+
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+
+    // Open the checkpoint at path for a job over n_samples of audio. An existing
+    // file is resumed only if it was written for the same audio length and job
+    // key (model + language); otherwise it is discarded and a new one started.
+    bool open(const std::string& path, uint64_t n_samples, const std::string& job_key, std::string& error);
+
+    // Where decoding should continue (end of the last completed segment)
+    int64_t resume_offset_ms() const;
+
+    // Segments recovered from a previous run
+    const std::vector<Segment>& segments() const { return segments_; }
+
+    // Trailing text of the recovered segments, for use as the initial prompt
+    std::string prompt_tail(size_t max_chars) const;
+
+    // Durably append the segments of one completed window
+    bool append(const std::vector<Segment>& window);
+
+    // Delete the sidecar once the job has finished
+    void remove();
+
+private:
+    bool load(const std::string& job_key, uint64_t n_samples);
+
+    std::string path_;
+    FILE* file_ = nullptr;
+    std::vector<Segment> segments_;
+};
+
+} // namespace securevox
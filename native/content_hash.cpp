@@ -0,0 +1,184 @@
+#include "content_hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SECUREVOX_HASH_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SECUREVOX_HASH_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace securevox {
+
+namespace {
+
+// Stripes between scrambles of the accumulators (1 KiB)
+constexpr size_t BLOCK_STRIPES = 16;
+
+constexpr uint64_t PRIME32_1 = 0x9E3779B1ull;
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+
+alignas(16) constexpr uint64_t SECRET[8] = {
+    0xBE4BA423396CFEB8ull, 0x1CAD21F72C81017Cull, 0xDB979083E96DD4DEull, 0x1F67B3B7A4A44072ull,
+    0x78E5C0CC4EE679CBull, 0x2172FFCC7DD05A82ull, 0x8E2443F7744608B8ull, 0x4C263A81E69035E0ull,
+};
+
+constexpr uint64_t INIT[8] = {
+    0x00000000C2B2AE3Dull, 0x9E3779B185EBCA87ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull,
+    0x85EBCA77C2B2AE63ull, 0x0000000085EBCA77ull, 0x27D4EB2F165667C5ull, 0x000000009E3779B1ull,
+};
+
+uint64_t read_u64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;  // both supported targets are little-endian
+}
+
+// Reference form of the bulk loop; the SIMD paths compute exactly this
+void accumulate_scalar(uint64_t acc[8], const unsigned char* p, size_t stripes) {
+    for (size_t s = 0; s < stripes; s++, p += 64) {
+        for (size_t i = 0; i < 8; i++) {
+            const uint64_t data = read_u64(p + i * 8);
+            const uint64_t keyed = data ^ SECRET[i];
+            acc[i ^ 1] += data;
+            acc[i] += (keyed & 0xFFFFFFFFull) * (keyed >> 32);
+        }
+    }
+}
+
+void accumulate(uint64_t acc[8], const unsigned char* p, size_t stripes) {
+#if defined(SECUREVOX_HASH_SSE2)
+    __m128i a[4];
+    __m128i secret[4];
+    for (int j = 0; j < 4; j++) {
+        a[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + j * 2));
+        secret[j] = _mm_load_si128(reinterpret_cast<const __m128i*>(SECRET + j * 2));
+    }
+    for (size_t s = 0; s < stripes; s++, p += 64) {
+        for (int j = 0; j < 4; j++) {
+            const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + j * 16));
+            const __m128i keyed = _mm_xor_si128(data, secret[j]);
+            const __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+            const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+            a[j] = _mm_add_epi64(a[j], _mm_add_epi64(swapped, product));
+        }
+    }
+    for (int j = 0; j < 4; j++) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + j * 2), a[j]);
+    }
+#elif defined(SECUREVOX_HASH_NEON)
+    uint64x2_t a[4];
+    uint64x2_t secret[4];
+    for (int j = 0; j < 4; j++) {
+        a[j] = vld1q_u64(acc + j * 2);
+        secret[j] = vld1q_u64(SECRET + j * 2);
+    }
+    for (size_t s = 0; s < stripes; s++, p += 64) {
+        for (int j = 0; j < 4; j++) {
+            const uint64x2_t data = vreinterpretq_u64_u8(vld1q_u8(p + j * 16));
+            const uint64x2_t keyed = veorq_u64(data, secret[j]);
+            a[j] = vaddq_u64(a[j], vextq_u64(data, data, 1));
+            a[j] = vmlal_u32(a[j], vmovn_u64(keyed), vshrn_n_u64(keyed, 32));
+        }
+    }
+    for (int j = 0; j < 4; j++) {
+        vst1q_u64(acc + j * 2, a[j]);
+    }
+#else
+    accumulate_scalar(acc, p, stripes);
+#endif
+}
+
+// Spreads the high bits back down so products keep mixing across blocks
+void scramble(uint64_t acc[8]) {
+    for (size_t i = 0; i < 8; i++) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= SECRET[i];
+        acc[i] = a * PRIME32_1;
+    }
+}
+
+uint64_t mix64(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBull;
+    h ^= h >> 31;
+    return h;
+}
+
+} // namespace
+
+ContentHasher::ContentHasher() {
+    std::memcpy(acc_, INIT, sizeof(acc_));
+}
+
+void ContentHasher::update(const void* data, size_t n) {
+    auto* p = static_cast<const unsigned char*>(data);
+    total_ += n;
+
+    if (pending_size_ > 0) {
+        const size_t take = std::min(n, STRIPE - pending_size_);
+        std::memcpy(pending_ + pending_size_, p, take);
+        pending_size_ += take;
+        p += take;
+        n -= take;
+        if (pending_size_ < STRIPE) return;
+        consume_stripes(pending_, 1);
+        pending_size_ = 0;
+    }
+
+    const size_t stripes = n / STRIPE;
+    consume_stripes(p, stripes);
+    p += stripes * STRIPE;
+    n -= stripes * STRIPE;
+
+    std::memcpy(pending_, p, n);
+    pending_size_ = n;
+}
+
+void ContentHasher::consume_stripes(const unsigned char* p, size_t stripes) {
+    while (stripes > 0) {
+        const size_t n = std::min(stripes, BLOCK_STRIPES - stripes_);
+        accumulate(acc_, p, n);
+        p += n * STRIPE;
+        stripes -= n;
+        stripes_ += n;
+        if (stripes_ == BLOCK_STRIPES) {
+            scramble(acc_);
+            stripes_ = 0;
+        }
+    }
+}
+
+uint64_t ContentHasher::digest() const {
+    uint64_t acc[LANES];
+    std::memcpy(acc, acc_, sizeof(acc));
+
+    // The tail is zero padded; the length below tells it apart from real zeros
+    if (pending_size_ > 0) {
+        unsigned char last[STRIPE] = {};
+        std::memcpy(last, pending_, pending_size_);
+        accumulate_scalar(acc, last, 1);
+    }
+
+    uint64_t h = total_ * PRIME64_1;
+    for (size_t i = 0; i < LANES; i++) {
+        h ^= mix64(acc[i] + i * PRIME64_4);
+        h = ((h << 27) | (h >> 37)) * PRIME64_1 + PRIME64_4;
+    }
+    return mix64(h);
+}
+
+uint64_t hash_samples(const float* samples, size_t n) {
+    ContentHasher hasher;
+    hasher.update(samples, n * sizeof(float));
+    return hasher.digest();
+}
+
+} // namespace securevox
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace securevox {
+
+// Streaming 64-bit hash of a byte stream, for content-addressed caches.
+//
+// Built for throughput rather than for hostile input: the bulk loop folds 64
+// bytes per step into eight independent 64-bit lanes with one 32x32->64
+// multiply each, which maps onto SSE2 (x86-64) and NEON (arm64), both part of
+// the baseline the core is compiled for. The scalar, SSE2 and NEON paths give
+// the same digest, and so does any split of the input across update() calls.
+class ContentHasher {
+public:
+    ContentHasher();
+
+    void update(const void* data, size_t n);
+
+    // Hash of everything passed to update() so far; the hasher can keep going
+    uint64_t digest() const;
+
+private:
+    static constexpr size_t STRIPE = 64;
+    static constexpr size_t LANES = 8;
+
+    void consume_stripes(const unsigned char* p, size_t stripes);
+
+    uint64_t acc_[LANES];
+    unsigned char pending_[STRIPE];
+    size_t pending_size_ = 0;
+    size_t stripes_ = 0;  // stripes folded since the last scramble
+    uint64_t total_ = 0;
+};
+
+// One-shot hash of n samples (the count is part of the hash)
+uint64_t hash_samples(const float* samples, size_t n);
+
+} // namespace securevox
@@ -0,0 +1,131 @@
+#include "cpu_features.h"
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SECUREVOX_X86_64 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SECUREVOX_ARM64 1
+#if defined(__linux__)
+#include <sys/auxv.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+#endif
+
+namespace securevox {
+
+namespace {
+
+#if defined(SECUREVOX_X86_64)
+
+void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; i++) regs[i] = static_cast<unsigned>(r[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Register state the OS saves on context switch (XCR0)
+uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+bool bit(unsigned value, int n) {
+    return (value >> n) & 1u;
+}
+
+void detect_x86(CpuFeatures& f) {
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    const unsigned max_leaf = regs[0];
+    if (max_leaf < 1) return;
+
+    cpuid(1, 0, regs);
+    const unsigned ecx1 = regs[2];
+    f.sse42 = bit(ecx1, 20);
+
+    // AVX registers are only usable if the OS enabled their state in XCR0
+    if (!bit(ecx1, 27) || !bit(ecx1, 28) || max_leaf < 7) return;
+    const uint64_t xcr0 = xgetbv0();
+    const bool os_avx = (xcr0 & 0x6) == 0x6;                // XMM, YMM
+    const bool os_avx512 = os_avx && (xcr0 & 0xE0) == 0xE0;  // opmask, ZMM
+
+    cpuid(7, 0, regs);
+    const unsigned ebx7 = regs[1];
+    f.avx2 = os_avx && bit(ebx7, 5) && bit(ecx1, 12) && bit(ecx1, 29);
+    f.avx512 = f.avx2 && os_avx512 && bit(ebx7, 16) && bit(ebx7, 17) &&
+               bit(ebx7, 28) && bit(ebx7, 30) && bit(ebx7, 31);
+}
+
+#elif defined(SECUREVOX_ARM64)
+
+void detect_arm64(CpuFeatures& f) {
+#if defined(__linux__)
+    // Kernel hwcap bits; spelled out since older NDK headers lack them
+    constexpr unsigned long HWCAP_DOTPROD = 1ul << 20;
+    constexpr unsigned long HWCAP2_MATMUL_INT8 = 1ul << 13;
+    constexpr unsigned long AUXV_HWCAP2 = 26;
+    f.dotprod = (getauxval(AT_HWCAP) & HWCAP_DOTPROD) != 0;
+    f.i8mm = (getauxval(AUXV_HWCAP2) & HWCAP2_MATMUL_INT8) != 0;
+#elif defined(_WIN32)
+    f.dotprod = IsProcessorFeaturePresent(PF_ARM_V82_DP_INSTRUCTIONS_AVAILABLE) != 0;
+#elif defined(__APPLE__)
+    auto sysctl_flag = [](const char* name) {
+        int value = 0;
+        size_t size = sizeof(value);
+        return sysctlbyname(name, &value, &size, nullptr, 0) == 0 && value != 0;
+    };
+    f.dotprod = sysctl_flag("hw.optional.arm.FEAT_DotProd");
+    f.i8mm = sysctl_flag("hw.optional.arm.FEAT_I8MM");
+#else
+    (void)f;
+#endif
+    // The i8mm build also uses dot product instructions
+    f.i8mm = f.i8mm && f.dotprod;
+}
+
+#endif
+
+} // namespace
+
+CpuFeatures detect_cpu_features() {
+    CpuFeatures features;
+#if defined(SECUREVOX_X86_64)
+    detect_x86(features);
+#elif defined(SECUREVOX_ARM64)
+    detect_arm64(features);
+#endif
+    return features;
+}
+
+const char* best_cpu_variant() {
+    static const char* const variant = [] {
+        const CpuFeatures f = detect_cpu_features();
+        if (f.avx512) return "avx512";
+        if (f.avx2) return "avx2";
+        if (f.i8mm) return "i8mm";
+        if (f.dotprod) return "dotprod";
+        return "";
+    }();
+    return variant;
+}
+
+} // namespace securevox
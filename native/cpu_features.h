@@ -0,0 +1,23 @@
+#pragma once
+
+namespace securevox {
+
+// Instruction-set extensions that select a build of the ggml kernels
+struct CpuFeatures {
+    // x86-64; the AVX flags also require the OS to save the wider registers
+    bool sse42 = false;
+    bool avx2 = false;     // with FMA and F16C, as the AVX2 build assumes
+    bool avx512 = false;   // F, CD, BW, DQ and VL
+    // arm64
+    bool dotprod = false;  // SDOT/UDOT (Armv8.2 DotProd)
+    bool i8mm = false;     // SMMLA/UMMLA int8 matrix multiply
+};
+
+CpuFeatures detect_cpu_features();
+
+// Suffix of the fastest library variant this CPU can run: "avx512" or "avx2"
+// on x86-64, "i8mm" or "dotprod" on arm64, and "" for the baseline build.
+// Detected once; the pointer stays valid for the life of the process.
+const char* best_cpu_variant();
+
+} // namespace securevox
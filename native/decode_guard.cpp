@@ -0,0 +1,156 @@
+#include "decode_guard.h"
+
+#include "whisper.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace securevox {
+
+namespace {
+
+// Most text tokens looked at for a repeating tail
+constexpr int MAX_TAIL = 64;
+
+// Samples per whisper timestamp unit (10 ms)
+constexpr size_t SAMPLES_PER_CS = WHISPER_SAMPLE_RATE / 100;
+
+} // namespace
+
+DecodeGuard::DecodeGuard(const DecodeGuardOptions& options)
+    : options_(options) {}
+
+void DecodeGuard::attach(whisper_full_params& params) {
+    entropy_thold_ = params.entropy_thold;
+    logprob_thold_ = params.logprob_thold;
+    no_speech_thold_ = params.no_speech_thold;
+
+    next_logits_ = params.logits_filter_callback;
+    next_logits_data_ = params.logits_filter_callback_user_data;
+    params.logits_filter_callback = &DecodeGuard::on_logits;
+    params.logits_filter_callback_user_data = this;
+
+    next_segment_ = params.new_segment_callback;
+    next_segment_data_ = params.new_segment_callback_user_data;
+    params.new_segment_callback = &DecodeGuard::on_new_segment;
+    params.new_segment_callback_user_data = this;
+}
+
+void DecodeGuard::set_speech(const SpeechRegions* speech, size_t offset) {
+    speech_ = speech;
+    offset_ = offset;
+}
+
+bool DecodeGuard::dropped(int segment) const {
+    return segment >= 0 && static_cast<size_t>(segment) < dropped_.size() && dropped_[segment] != 0;
+}
+
+bool DecodeGuard::repeating(const whisper_token_data* tokens, int n_tokens, int eot) const {
+    // Newest first, timestamps skipped: a looping phrase gets new timestamps
+    // on every repetition
+    whisper_token tail[MAX_TAIL];
+    int count = 0;
+    for (int i = n_tokens - 1; i >= 0 && count < MAX_TAIL; i--) {
+        if (tokens[i].id < eot) tail[count++] = tokens[i].id;
+    }
+
+    for (int n = 1; n <= options_.max_ngram; n++) {
+        const int repeats = std::max(options_.min_repeats, (options_.min_repeat_tokens + n - 1) / n);
+        const int span = repeats * n;
+        if (span > count) continue;
+
+        int i = n;
+        while (i < span && tail[i] == tail[i - n]) i++;
+        if (i == span) return true;
+    }
+    return false;
+}
+
+bool DecodeGuard::low_entropy(const whisper_token_data* tokens, int n_tokens) const {
+    const int n = options_.entropy_tokens;
+    if (n <= 0 || n_tokens < n) return false;
+
+    const whisper_token_data* last = tokens + (n_tokens - n);
+    double entropy = 0.0;
+    for (int i = 0; i < n; i++) {
+        // Count each distinct token at its first occurrence
+        bool seen = false;
+        for (int j = 0; j < i && !seen; j++) seen = last[j].id == last[i].id;
+        if (seen) continue;
+
+        int occurrences = 1;
+        for (int j = i + 1; j < n; j++) occurrences += last[j].id == last[i].id;
+        const double p = static_cast<double>(occurrences) / n;
+        entropy -= p * std::log(p);
+    }
+    return entropy < entropy_thold_;
+}
+
+bool DecodeGuard::no_speech(whisper_state* state, int segment, int eot) const {
+    const int64_t t0 = whisper_full_get_segment_t0_from_state(state, segment);
+    const int64_t t1 = whisper_full_get_segment_t1_from_state(state, segment);
+    const size_t begin = offset_ + static_cast<size_t>(std::max<int64_t>(t0, 0)) * SAMPLES_PER_CS;
+    const size_t end = std::max(begin + 1, offset_ + static_cast<size_t>(std::max<int64_t>(t1, 0)) * SAMPLES_PER_CS);
+
+    size_t voiced = 0;
+    for (const SampleRange& range : *speech_) {
+        if (range.end <= begin) continue;
+        if (range.begin >= end) break;
+        voiced += std::min(range.end, end) - std::max(range.begin, begin);
+    }
+    const float silent = 1.0f - static_cast<float>(voiced) / static_cast<float>(end - begin);
+    if (silent <= no_speech_thold_) return false;
+
+    float logprob = 0.0f;
+    int text_tokens = 0;
+    const int n_tokens = whisper_full_n_tokens_from_state(state, segment);
+    for (int i = 0; i < n_tokens; i++) {
+        const whisper_token_data token = whisper_full_get_token_data_from_state(state, segment, i);
+        if (token.id >= eot) continue;
+        logprob += token.plog;
+        text_tokens++;
+    }
+    return text_tokens > 0 && logprob / static_cast<float>(text_tokens) < logprob_thold_;
+}
+
+void DecodeGuard::on_logits(whisper_context* ctx, whisper_state* state, const whisper_token_data* tokens,
+                            int n_tokens, float* logits, void* user_data) {
+    auto* guard = static_cast<DecodeGuard*>(user_data);
+    if (guard->next_logits_ != nullptr) {
+        guard->next_logits_(ctx, state, tokens, n_tokens, logits, guard->next_logits_data_);
+    }
+
+    const whisper_token eot = whisper_token_eot(ctx);
+    if (n_tokens == 0 || (!guard->repeating(tokens, n_tokens, eot) && !guard->low_entropy(tokens, n_tokens))) {
+        return;
+    }
+
+    // Leave end-of-text as the only token this decoder can sample
+    const int n_vocab = whisper_n_vocab(ctx);
+    std::fill(logits, logits + n_vocab, -INFINITY);
+    logits[eot] = 0.0f;
+    guard->cut_windows_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DecodeGuard::on_new_segment(whisper_context* ctx, whisper_state* state, int n_new, void* user_data) {
+    auto* guard = static_cast<DecodeGuard*>(user_data);
+
+    // Segments are numbered from 0 in every whisper_full call, and all of them
+    // pass through here, so entries past the count belong to an earlier call
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    guard->dropped_.resize(static_cast<size_t>(n_segments));
+
+    const bool vad = guard->speech_ != nullptr && !guard->speech_->empty();
+    const whisper_token eot = whisper_token_eot(ctx);
+    for (int i = std::max(0, n_segments - n_new); i < n_segments; i++) {
+        const bool drop = vad && guard->no_speech(state, i, eot);
+        guard->dropped_[i] = drop ? 1 : 0;
+        if (drop) guard->dropped_segments_++;
+    }
+
+    if (guard->next_segment_ != nullptr) {
+        guard->next_segment_(ctx, state, n_new, guard->next_segment_data_);
+    }
+}
+
+} // namespace securevox
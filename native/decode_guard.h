@@ -0,0 +1,97 @@
+#pragma once
+
+#include "vad.h"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+struct whisper_context;
+struct whisper_state;
+struct whisper_full_params;
+struct whisper_token_data;
+
+namespace securevox {
+
+struct DecodeGuardOptions {
+    // The window is ended once its text tokens finish in at least min_repeats
+    // copies of an n-gram of up to max_ngram tokens, and the copies cover at
+    // least min_repeat_tokens tokens (a word said twice is not a loop)
+    int max_ngram = 8;
+    int min_repeats = 3;
+    int min_repeat_tokens = 16;
+    // Also ended once the entropy of the last entropy_tokens tokens drops below
+    // params.entropy_thold: whisper's stand-in for the compression ratio, which
+    // it otherwise only checks after the window has run to the context limit
+    int entropy_tokens = 32;
+};
+
+// Stops runaway decoding on silence and music.
+//
+// With no_context and greedy sampling whisper can lock into repeating a phrase
+// until the text context is full, on every window and every temperature
+// fallback. The guard sits in the logits filter and, as soon as a decoder's
+// output is a loop or fails whisper's entropy check, leaves it nothing to
+// sample but end-of-text. A window whisper would reject anyway is rejected
+// after a few dozen tokens instead of a few hundred; fallbacks still happen.
+//
+// Segments are also checked as they are produced: one that lies mostly in what
+// the VAD found to be silence (more than params.no_speech_thold of it) and was
+// decoded with an average log probability below params.logprob_thold is
+// marked dropped. That is whisper's own no-speech rule with the VAD standing in
+// for the no-speech token, which whisper.cpp v1.7.2 suppresses before the
+// logits filter and never scores.
+class DecodeGuard {
+public:
+    explicit DecodeGuard(const DecodeGuardOptions& options = DecodeGuardOptions());
+
+    DecodeGuard(const DecodeGuard&) = delete;
+    DecodeGuard& operator=(const DecodeGuard&) = delete;
+
+    // Install on params, calling whatever logits filter and new segment
+    // callbacks were set before. The guard must outlive whisper_full.
+    void attach(whisper_full_params& params);
+
+    // Speech regions of the audio given to whisper_full, which starts offset
+    // samples into the audio they were detected on. Null (the default) or empty
+    // regions drop nothing.
+    void set_speech(const SpeechRegions* speech, size_t offset = 0);
+
+    // Whether segment i of the last whisper_full result was dropped
+    bool dropped(int segment) const;
+
+    // Decoder passes ended early, and segments dropped, since construction
+    int cut_windows() const { return cut_windows_.load(std::memory_order_relaxed); }
+    int dropped_segments() const { return dropped_segments_; }
+
+private:
+    using LogitsFilter = void (*)(whisper_context*, whisper_state*, const whisper_token_data*, int, float*, void*);
+    using NewSegment = void (*)(whisper_context*, whisper_state*, int, void*);
+
+    static void on_logits(whisper_context* ctx, whisper_state* state, const whisper_token_data* tokens,
+                          int n_tokens, float* logits, void* user_data);
+    static void on_new_segment(whisper_context* ctx, whisper_state* state, int n_new, void* user_data);
+
+    bool repeating(const whisper_token_data* tokens, int n_tokens, int eot) const;
+    bool low_entropy(const whisper_token_data* tokens, int n_tokens) const;
+    bool no_speech(whisper_state* state, int segment, int eot) const;
+
+    DecodeGuardOptions options_;
+    float entropy_thold_ = 0.0f;
+    float logprob_thold_ = 0.0f;
+    float no_speech_thold_ = 1.0f;
+    const SpeechRegions* speech_ = nullptr;
+    size_t offset_ = 0;
+
+    LogitsFilter next_logits_ = nullptr;
+    void* next_logits_data_ = nullptr;
+    NewSegment next_segment_ = nullptr;
+    void* next_segment_data_ = nullptr;
+
+    std::vector<char> dropped_;
+    // Decoders may filter their logits on several threads
+    std::atomic<int> cut_windows_{0};
+    int dropped_segments_ = 0;
+};
+
+} // namespace securevox
@@ -0,0 +1,161 @@
+#include "denoise.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace securevox {
+
+namespace {
+
+// Below this a frame's bins are treated as silent rather than divided by
+constexpr float MIN_POWER = 1e-12f;
+
+size_t frame_samples(int sample_rate, int frame_ms) {
+    const size_t wanted = static_cast<size_t>(sample_rate > 0 ? sample_rate : 0) *
+                          static_cast<size_t>(frame_ms > 0 ? frame_ms : 0) / 1000;
+    size_t frame = 64;
+    while (frame < wanted) frame <<= 1;
+    return frame;
+}
+
+} // namespace
+
+NoiseSuppressor::NoiseSuppressor(int sample_rate, const DenoiseOptions& options)
+    : options_(options),
+      frame_(frame_samples(sample_rate, options.frame_ms)),
+      hop_(frame_ / 2),
+      min_gain_(std::pow(10.0f, -options.max_reduction_db / 20.0f)),
+      fft_(frame_),
+      window_(hann_window(frame_)),
+      input_(frame_, 0.0f),
+      overlap_(frame_, 0.0f),
+      frame_buf_(frame_),
+      spectrum_(fft_.bins()),
+      power_(fft_.bins()),
+      noise_(fft_.bins(), 0.0f),
+      gain_(fft_.bins(), 1.0f),
+      skip_(hop_) {
+    // Square-root Hann on analysis and synthesis: the product is a Hann
+    // window, which sums to one at half-frame overlap
+    for (float& w : window_) w = std::sqrt(w);
+}
+
+bool NoiseSuppressor::estimate_noise(const float* samples, size_t n, const SpeechRegions& speech) {
+    std::vector<float> sum(fft_.bins(), 0.0f);
+    size_t frames = 0;
+    size_t region = 0;
+    for (size_t start = 0; start + frame_ <= n; start += hop_) {
+        const size_t end = start + frame_;
+        while (region < speech.size() && speech[region].end <= start) region++;
+        if (region < speech.size() && speech[region].begin < end) continue;
+
+        for (size_t i = 0; i < frame_; i++) frame_buf_[i] = samples[start + i] * window_[i];
+        fft_.power(frame_buf_.data(), power_.data());
+        for (size_t k = 0; k < sum.size(); k++) sum[k] += power_[k];
+        frames++;
+    }
+    if (frames == 0) return false;
+
+    const float scale = 1.0f / static_cast<float>(frames);
+    for (size_t k = 0; k < noise_.size(); k++) noise_[k] = sum[k] * scale;
+    noise_seeded_ = true;
+    return true;
+}
+
+void NoiseSuppressor::process(const float* in, size_t n, SampleVector& out) {
+    while (n > 0) {
+        const size_t take = std::min(n, hop_ - pending_);
+        std::copy(in, in + take, input_.begin() + static_cast<std::ptrdiff_t>(hop_ + pending_));
+        in += take;
+        n -= take;
+        pending_ += take;
+        consumed_ += take;
+        if (pending_ == hop_) process_frame(out);
+    }
+}
+
+void NoiseSuppressor::flush(SampleVector& out) {
+    // Zero-pad until the frames covering the last input have been added up
+    while (produced_ < consumed_) {
+        std::fill(input_.begin() + static_cast<std::ptrdiff_t>(hop_ + pending_), input_.end(), 0.0f);
+        pending_ = hop_;
+        process_frame(out);
+    }
+
+    // Ready for another stream; the noise estimate carries over
+    std::fill(input_.begin(), input_.end(), 0.0f);
+    std::fill(overlap_.begin(), overlap_.end(), 0.0f);
+    pending_ = 0;
+    consumed_ = 0;
+    produced_ = 0;
+    skip_ = hop_;
+}
+
+void NoiseSuppressor::update_noise(const float* power) {
+    if (!noise_seeded_) {
+        std::copy(power, power + noise_.size(), noise_.begin());
+        noise_seeded_ = true;
+        return;
+    }
+
+    float total = 0.0f;
+    float noise_total = 0.0f;
+    for (size_t k = 0; k < noise_.size(); k++) {
+        total += power[k];
+        noise_total += noise_[k];
+    }
+    if (total > noise_total * std::pow(10.0f, options_.noise_update_db / 10.0f)) return;
+
+    // Quieter than the estimate: it was taken from something louder than the
+    // noise, so move down quickly
+    const float rate = total < noise_total ? std::max(options_.noise_adapt, 0.5f) : options_.noise_adapt;
+    for (size_t k = 0; k < noise_.size(); k++) noise_[k] += rate * (power[k] - noise_[k]);
+}
+
+void NoiseSuppressor::process_frame(SampleVector& out) {
+    const size_t bins = fft_.bins();
+
+    for (size_t i = 0; i < frame_; i++) frame_buf_[i] = input_[i] * window_[i];
+    fft_.forward(frame_buf_.data(), spectrum_.data());
+    for (size_t k = 0; k < bins; k++) power_[k] = std::norm(spectrum_[k]);
+    update_noise(power_.data());
+
+    // Power subtraction, floored, with fast attack and smoothed release
+    const float over = options_.over_subtraction;
+    const float release = options_.release;
+    for (size_t k = 0; k < bins; k++) {
+        const float kept = 1.0f - over * noise_[k] / std::max(power_[k], MIN_POWER);
+        const float g = std::max(std::sqrt(std::max(kept, 0.0f)), min_gain_);
+        gain_[k] = g >= gain_[k] ? g : release * gain_[k] + (1.0f - release) * g;
+        spectrum_[k] *= gain_[k];
+    }
+
+    fft_.inverse(spectrum_.data(), frame_buf_.data());
+    for (size_t i = 0; i < frame_; i++) overlap_[i] += frame_buf_[i] * window_[i];
+
+    // The first hop is now complete; the very first one precedes the input
+    const size_t begin = std::min(skip_, hop_);
+    skip_ -= begin;
+    const size_t count = std::min(hop_ - begin, consumed_ - produced_);
+    out.insert(out.end(), overlap_.begin() + static_cast<std::ptrdiff_t>(begin),
+               overlap_.begin() + static_cast<std::ptrdiff_t>(begin + count));
+    produced_ += count;
+
+    std::copy(overlap_.begin() + static_cast<std::ptrdiff_t>(hop_), overlap_.end(), overlap_.begin());
+    std::fill(overlap_.begin() + static_cast<std::ptrdiff_t>(hop_), overlap_.end(), 0.0f);
+    std::copy(input_.begin() + static_cast<std::ptrdiff_t>(hop_), input_.end(), input_.begin());
+    pending_ = 0;
+}
+
+void suppress_noise(const float* samples, size_t n, int sample_rate, const SpeechRegions& speech,
+                    const DenoiseOptions& options, SampleVector& out) {
+    NoiseSuppressor suppressor(sample_rate, options);
+    suppressor.estimate_noise(samples, n, speech);
+
+    out.clear();
+    out.reserve(n);
+    suppressor.process(samples, n, out);
+    suppressor.flush(out);
+}
+
+} // namespace securevox
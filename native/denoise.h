@@ -0,0 +1,90 @@
+#pragma once
+
+#include "arena.h"
+#include "fft.h"
+#include "vad.h"
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace securevox {
+
+struct DenoiseOptions {
+    // STFT frame, rounded up to a power of two in samples (512 at 16 kHz);
+    // frames overlap by half
+    int frame_ms = 32;
+    // Noise power is scaled by this before it is subtracted; higher removes
+    // more noise and more of the speech under it
+    float over_subtraction = 2.0f;
+    // Largest attenuation of any bin. A floor keeps some background, which
+    // sounds more natural and gives the model less to hallucinate on than
+    // gated-to-zero holes.
+    float max_reduction_db = 15.0f;
+    // How slowly gains may fall from one frame to the next (0 = no
+    // smoothing); rising gains follow at once so onsets are kept
+    float release = 0.6f;
+    // Frames at most this far above the noise estimate count as noise and
+    // refine it, at noise_adapt per frame
+    float noise_update_db = 3.0f;
+    float noise_adapt = 0.05f;
+};
+
+// Streaming spectral gating.
+//
+// Each frame is windowed (square-root Hann, so analysis and synthesis windows
+// overlap-add to one), transformed, and every bin is scaled by a gain derived
+// from its power against a running noise spectrum; the inverse transforms are
+// overlap-added back. Output lags input by half a frame, which process() and
+// flush() hide: after flush() exactly as many samples came out as went in.
+//
+// The noise spectrum is seeded from the frames the VAD found silent, then
+// keeps adapting on noise-like frames, so slowly changing noise (a car
+// accelerating, a room filling up) is tracked.
+class NoiseSuppressor {
+public:
+    explicit NoiseSuppressor(int sample_rate, const DenoiseOptions& options = DenoiseOptions());
+
+    // Average spectrum of the frames of samples that lie outside speech.
+    // False when no frame does; the estimate then starts from the first
+    // frames processed.
+    bool estimate_noise(const float* samples, size_t n, const SpeechRegions& speech);
+
+    // Filter a chunk, appending whatever output is complete to out
+    void process(const float* in, size_t n, SampleVector& out);
+
+    // Append the rest of the output
+    void flush(SampleVector& out);
+
+    size_t frame_size() const { return frame_; }
+
+private:
+    void process_frame(SampleVector& out);
+    void update_noise(const float* power);
+
+    DenoiseOptions options_;
+    size_t frame_;
+    size_t hop_;
+    float min_gain_;
+    RealFft fft_;
+    std::vector<float> window_;
+    std::vector<float> input_;     // last frame_ samples; the newest hop_ are filled up to pending_
+    std::vector<float> overlap_;   // synthesis output still to be completed
+    std::vector<float> frame_buf_;
+    std::vector<std::complex<float>> spectrum_;
+    std::vector<float> power_;
+    std::vector<float> noise_;
+    std::vector<float> gain_;
+    bool noise_seeded_ = false;
+    size_t pending_ = 0;     // samples of the current hop received
+    size_t consumed_ = 0;    // samples given to process()
+    size_t produced_ = 0;    // samples appended to out
+    size_t skip_ = 0;        // leading output that precedes the first input sample
+};
+
+// Suppress noise in a whole recording, taking the noise estimate from the
+// non-speech regions. out keeps its allocator.
+void suppress_noise(const float* samples, size_t n, int sample_rate, const SpeechRegions& speech,
+                    const DenoiseOptions& options, SampleVector& out);
+
+} // namespace securevox
@@ -0,0 +1,372 @@
+#include "encoder_cache.h"
+#include "binary_io.h"
+
+#include "whisper.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <system_error>
+
+namespace securevox {
+
+namespace {
+
+constexpr char MAGIC[4] = {'S', 'V', 'E', 'C'};
+constexpr uint32_t VERSION = 2;
+constexpr const char* SPILL_SUFFIX = ".enc";
+
+// Bytes read from each end of a model file for its fingerprint
+constexpr long FINGERPRINT_BYTES = 64 * 1024;
+
+uint64_t fnv1a64(const char* data, size_t n, uint64_t h = 14695981039346656037ull) {
+    for (size_t i = 0; i < n; i++) {
+        h ^= static_cast<uint8_t>(data[i]);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+struct FileCloser {
+    void operator()(FILE* f) const { std::fclose(f); }
+};
+
+} // namespace
+
+uint64_t model_fingerprint(const std::string& path) {
+    std::unique_ptr<FILE, FileCloser> file(std::fopen(path.c_str(), "rb"));
+    if (!file) return 0;
+
+    std::vector<char> buf(FINGERPRINT_BYTES);
+    const size_t head = std::fread(buf.data(), 1, buf.size(), file.get());
+    uint64_t h = fnv1a64(buf.data(), head);
+
+    if (std::fseek(file.get(), 0, SEEK_END) != 0) return 0;
+    const long size = std::ftell(file.get());
+    h = fnv1a64(reinterpret_cast<const char*>(&size), sizeof(size), h);
+
+    if (size > FINGERPRINT_BYTES && std::fseek(file.get(), -FINGERPRINT_BYTES, SEEK_END) == 0) {
+        const size_t tail = std::fread(buf.data(), 1, buf.size(), file.get());
+        h = fnv1a64(buf.data(), tail, h);
+    }
+    return h != 0 ? h : 1;
+}
+
+EncoderCache& EncoderCache::instance() {
+    static EncoderCache cache;
+    return cache;
+}
+
+void EncoderCache::set_memory_budget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_budget_ = bytes;
+    trim_memory();
+}
+
+void EncoderCache::set_spill(const std::string& dir, uint64_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    spill_dir_ = max_bytes > 0 ? dir : std::string();
+    disk_budget_ = max_bytes;
+    disk_lru_.clear();
+    spilled_.clear();
+    disk_bytes_ = 0;
+    if (spill_dir_.empty()) return;
+
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::create_directories(spill_dir_, ec);
+
+    // Windows spilled by earlier runs, oldest first
+    std::vector<std::pair<fs::file_time_type, std::pair<EncoderKey, uint64_t>>> found;
+    for (fs::directory_iterator it(spill_dir_, ec), end; !ec && it != end; it.increment(ec)) {
+        const std::string name = it->path().filename().string();
+        EncoderKey key;
+        unsigned long long audio = 0, model = 0;
+        int offset = 0, audio_ctx = 0;
+        char suffix[8] = {};
+        if (std::sscanf(name.c_str(), "%16llx%16llx-%d-%d%7s", &audio, &model, &offset, &audio_ctx, suffix) != 5 ||
+            std::strcmp(suffix, SPILL_SUFFIX) != 0) {
+            // Windows spilled by version 1, named without the encoder context
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, SPILL_SUFFIX) == 0) {
+                fs::remove(it->path(), ec);
+                ec.clear();
+            }
+            continue;
+        }
+        key.audio = audio;
+        key.model = model;
+        key.mel_offset = offset;
+        key.audio_ctx = audio_ctx;
+
+        std::error_code size_ec, time_ec;
+        const uint64_t bytes = it->file_size(size_ec);
+        const fs::file_time_type time = it->last_write_time(time_ec);
+        if (!size_ec && !time_ec) found.push_back({time, {key, bytes}});
+    }
+    std::sort(found.begin(), found.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (const auto& file : found) {
+        disk_lru_.push_back(file.second);
+        spilled_[file.second.first] = std::prev(disk_lru_.end());
+        disk_bytes_ += file.second.second;
+    }
+    trim_disk();
+}
+
+bool EncoderCache::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_budget_ > 0;
+}
+
+void EncoderCache::register_model(const whisper_context* ctx, const std::string& path) {
+    const uint64_t fingerprint = model_fingerprint(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fingerprint != 0) {
+        models_[ctx] = fingerprint;
+    } else {
+        models_.erase(ctx);
+    }
+}
+
+void EncoderCache::unregister_model(const whisper_context* ctx) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    models_.erase(ctx);
+}
+
+uint64_t EncoderCache::model_of(const whisper_context* ctx) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = models_.find(ctx);
+    return it != models_.end() ? it->second : 0;
+}
+
+bool EncoderCache::load(const EncoderKey& key, float* dst, size_t n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = entries_.find(key);
+    if (it != entries_.end() && it->second->data.size() == n) {
+        std::memcpy(dst, it->second->data.data(), n * sizeof(float));
+        lru_.splice(lru_.begin(), lru_, it->second);
+        stats_.hits++;
+        return true;
+    }
+
+    auto disk = spilled_.find(key);
+    if (disk != spilled_.end() && memory_budget_ > 0) {
+        Entry entry;
+        entry.key = key;
+        bool size_differs = false;
+        if (read_spilled(key, entry.data, n, size_differs)) {
+            std::memcpy(dst, entry.data.data(), n * sizeof(float));
+            disk_lru_.splice(disk_lru_.end(), disk_lru_, disk->second);
+            insert(std::move(entry));
+            stats_.disk_hits++;
+            return true;
+        }
+        // A valid window of another size is a miss for this caller only
+        if (!size_differs) forget_spilled(key);
+    }
+
+    stats_.misses++;
+    return false;
+}
+
+void EncoderCache::store(const EncoderKey& key, const float* src, size_t n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (memory_budget_ == 0) return;
+
+    Entry entry;
+    entry.key = key;
+    entry.data.assign(src, src + n);
+    insert(std::move(entry));
+}
+
+bool EncoderCache::contains(const EncoderKey& key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.count(key) > 0 || spilled_.count(key) > 0;
+}
+
+void EncoderCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    entries_.clear();
+    memory_bytes_ = 0;
+
+    while (!disk_lru_.empty()) forget_spilled(disk_lru_.front().first);
+}
+
+EncoderCacheStats EncoderCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EncoderCacheStats stats = stats_;
+    stats.memory_bytes = memory_bytes_;
+    stats.disk_bytes = disk_bytes_;
+    return stats;
+}
+
+std::string EncoderCache::spill_path(const EncoderKey& key) const {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016" PRIx64 "%016" PRIx64 "-%d-%d%s",
+                  key.audio, key.model, static_cast<int>(key.mel_offset), static_cast<int>(key.audio_ctx),
+                  SPILL_SUFFIX);
+    return spill_dir_ + "/" + name;
+}
+
+bool EncoderCache::read_spilled(const EncoderKey& key, std::vector<float>& data, size_t n,
+                                bool& size_differs) const {
+    size_differs = false;
+    std::unique_ptr<FILE, FileCloser> file(std::fopen(spill_path(key).c_str(), "rb"));
+    if (!file) return false;
+
+    char magic[4];
+    uint32_t version = 0, offset = 0, audio_ctx = 0, checksum = 0;
+    uint64_t audio = 0, model = 0, count = 0;
+    if (std::fread(magic, 1, 4, file.get()) != 4 || std::memcmp(magic, MAGIC, 4) != 0 ||
+        !get_u32(file.get(), version) || version != VERSION ||
+        !get_u64(file.get(), audio) || audio != key.audio ||
+        !get_u64(file.get(), model) || model != key.model ||
+        !get_u32(file.get(), offset) || static_cast<int32_t>(offset) != key.mel_offset ||
+        !get_u32(file.get(), audio_ctx) || static_cast<int32_t>(audio_ctx) != key.audio_ctx ||
+        !get_u64(file.get(), count)) {
+        return false;
+    }
+    if (count != n) {
+        size_differs = true;
+        return false;
+    }
+
+    data.resize(n);
+    const size_t bytes = n * sizeof(float);
+    return std::fread(data.data(), 1, bytes, file.get()) == bytes &&
+           get_u32(file.get(), checksum) &&
+           fnv1a(reinterpret_cast<const char*>(data.data()), bytes) == checksum;
+}
+
+void EncoderCache::spill(const Entry& entry) {
+    auto known = spilled_.find(entry.key);
+    if (known != spilled_.end()) {
+        disk_lru_.splice(disk_lru_.end(), disk_lru_, known->second);
+        return;
+    }
+
+    const std::string path = spill_path(entry.key);
+    const std::string tmp = path + ".tmp";
+    const size_t bytes = entry.data.size() * sizeof(float);
+
+    std::string header(MAGIC, 4);
+    put_u32(header, VERSION);
+    put_u64(header, entry.key.audio);
+    put_u64(header, entry.key.model);
+    put_u32(header, static_cast<uint32_t>(entry.key.mel_offset));
+    put_u32(header, static_cast<uint32_t>(entry.key.audio_ctx));
+    put_u64(header, entry.data.size());
+
+    std::string trailer;
+    put_u32(trailer, fnv1a(reinterpret_cast<const char*>(entry.data.data()), bytes));
+
+    FILE* out = std::fopen(tmp.c_str(), "wb");
+    if (out == nullptr) return;
+    const bool written = std::fwrite(header.data(), 1, header.size(), out) == header.size() &&
+                         std::fwrite(entry.data.data(), 1, bytes, out) == bytes &&
+                         std::fwrite(trailer.data(), 1, trailer.size(), out) == trailer.size();
+    const bool closed = std::fclose(out) == 0;
+
+#ifdef _WIN32
+    std::remove(path.c_str());  // rename does not replace on Windows
+#endif
+    if (!written || !closed || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return;
+    }
+
+    const uint64_t file_bytes = header.size() + bytes + trailer.size();
+    disk_lru_.push_back({entry.key, file_bytes});
+    spilled_[entry.key] = std::prev(disk_lru_.end());
+    disk_bytes_ += file_bytes;
+    trim_disk();
+}
+
+void EncoderCache::forget_spilled(const EncoderKey& key) {
+    auto it = spilled_.find(key);
+    if (it == spilled_.end()) return;
+    std::remove(spill_path(key).c_str());
+    disk_bytes_ -= it->second->second;
+    disk_lru_.erase(it->second);
+    spilled_.erase(it);
+}
+
+void EncoderCache::insert(Entry entry) {
+    auto existing = entries_.find(entry.key);
+    if (existing != entries_.end()) {
+        memory_bytes_ -= existing->second->data.size() * sizeof(float);
+        lru_.erase(existing->second);
+        entries_.erase(existing);
+    }
+
+    memory_bytes_ += entry.data.size() * sizeof(float);
+    lru_.push_front(std::move(entry));
+    entries_[lru_.front().key] = lru_.begin();
+    trim_memory();
+}
+
+void EncoderCache::trim_memory() {
+    while (memory_bytes_ > memory_budget_ && !lru_.empty()) {
+        const Entry& victim = lru_.back();
+        if (!spill_dir_.empty()) spill(victim);
+        memory_bytes_ -= victim.data.size() * sizeof(float);
+        entries_.erase(victim.key);
+        lru_.pop_back();
+    }
+}
+
+void EncoderCache::trim_disk() {
+    while (disk_bytes_ > disk_budget_ && !disk_lru_.empty()) {
+        forget_spilled(disk_lru_.front().first);
+    }
+}
+
+EncoderCacheScope::EncoderCacheScope(whisper_context* ctx, const float* samples, size_t n) {
+#ifdef WHISPER_HAS_ENCODER_CACHE
+    EncoderCache& cache = EncoderCache::instance();
+    if (ctx == nullptr || samples == nullptr || n == 0 || !cache.enabled()) return;
+
+    key_.model = cache.model_of(ctx);
+    if (key_.model == 0) return;
+    key_.audio = hash_samples(samples, n);
+    n_audio_state_ = static_cast<size_t>(std::max(1, whisper_model_n_audio_state(ctx)));
+
+    ctx_ = ctx;
+    whisper_set_encoder_cache(ctx_, on_load, on_store, this);
+#else
+    (void)ctx;
+    (void)samples;
+    (void)n;
+#endif
+}
+
+EncoderCacheScope::~EncoderCacheScope() {
+#ifdef WHISPER_HAS_ENCODER_CACHE
+    if (ctx_ != nullptr) whisper_set_encoder_cache(ctx_, nullptr, nullptr, nullptr);
+#endif
+}
+
+bool EncoderCacheScope::on_load(int mel_offset, float* embd, size_t n, void* user_data) {
+    const auto* scope = static_cast<EncoderCacheScope*>(user_data);
+    EncoderKey key = scope->key_;
+    key.mel_offset = mel_offset;
+    key.audio_ctx = static_cast<int32_t>(n / scope->n_audio_state_);
+    return EncoderCache::instance().load(key, embd, n);
+}
+
+void EncoderCacheScope::on_store(int mel_offset, const float* embd, size_t n, void* user_data) {
+    const auto* scope = static_cast<EncoderCacheScope*>(user_data);
+    EncoderKey key = scope->key_;
+    key.mel_offset = mel_offset;
+    key.audio_ctx = static_cast<int32_t>(n / scope->n_audio_state_);
+    EncoderCache::instance().store(key, embd, n);
+}
+
+} // namespace securevox
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "content_hash.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct whisper_context;
+
+namespace securevox {
+
+// Identifies a model file by content (its first and last 64 KiB plus its
+// size), so a renamed copy still matches and a replaced file does not.
+// Returns 0 if the file cannot be read.
+uint64_t model_fingerprint(const std::string& path);
+
+struct EncoderKey {
+    uint64_t audio = 0;       // hash_samples of the audio passed to whisper_full
+    uint64_t model = 0;       // model_fingerprint
+    int32_t mel_offset = 0;   // window start in mel frames (10 ms each)
+    int32_t audio_ctx = 0;    // encoder frames the window was encoded with
+
+    bool operator==(const EncoderKey& other) const {
+        return audio == other.audio && model == other.model && mel_offset == other.mel_offset &&
+               audio_ctx == other.audio_ctx;
+    }
+};
+
+struct EncoderKeyHash {
+    size_t operator()(const EncoderKey& key) const {
+        return static_cast<size_t>(key.audio ^ (key.model * 31) ^
+                                   (static_cast<uint64_t>(key.mel_offset) * 0x9E3779B97F4A7C15ull) ^
+                                   (static_cast<uint64_t>(key.audio_ctx) << 40));
+    }
+};
+
+struct EncoderCacheStats {
+    uint64_t hits = 0;        // served from memory
+    uint64_t disk_hits = 0;   // read back from the spill directory
+    uint64_t misses = 0;      // encoder ran
+    size_t memory_bytes = 0;
+    uint64_t disk_bytes = 0;
+};
+
+// Encoder outputs per window, keyed by audio content, model, window offset and
+// the encoder context it was computed with (short clips use a reduced one).
+//
+// The encoder dominates the cost of whisper_full, and its output depends only
+// on the audio and the model: re-transcribing a recording with another
+// language, prompt or decoding preset can reuse it and only pay for the
+// decoder. Windows live in an in-memory LRU bounded by a byte budget. With a
+// spill directory set, windows evicted from memory are written there (oldest
+// files removed beyond the disk budget) and read back on a later miss, also
+// by later processes.
+//
+// Needs the whisper.cpp encoder cache hooks (native/patches); without them
+// EncoderCacheScope does nothing and every window is encoded.
+class EncoderCache {
+public:
+    static EncoderCache& instance();
+
+    // Bytes of encoder output kept in memory; 0 (the default) disables the cache
+    void set_memory_budget(size_t bytes);
+
+    // Directory for windows evicted from memory, bounded by max_bytes. Windows
+    // spilled by earlier runs are picked up. An empty dir disables spilling.
+    void set_spill(const std::string& dir, uint64_t max_bytes);
+
+    bool enabled() const;
+
+    // Model identity of a context, from the file it was loaded from
+    void register_model(const whisper_context* ctx, const std::string& path);
+    void unregister_model(const whisper_context* ctx);
+    uint64_t model_of(const whisper_context* ctx) const;
+
+    // Copy a cached window of n floats into dst. False on a miss.
+    bool load(const EncoderKey& key, float* dst, size_t n);
+
+    void store(const EncoderKey& key, const float* src, size_t n);
+
+    // Whether a window is held, in memory or spilled; not counted as a hit
+    bool contains(const EncoderKey& key) const;
+
+    // Drop every window, in memory and spilled
+    void clear();
+
+    EncoderCacheStats stats() const;
+
+private:
+    EncoderCache() = default;
+
+    struct Entry {
+        EncoderKey key;
+        std::vector<float> data;
+    };
+
+    std::string spill_path(const EncoderKey& key) const;
+    // False on a miss; size_differs is set when the file is intact but holds
+    // another number of floats than n, so it is kept
+    bool read_spilled(const EncoderKey& key, std::vector<float>& data, size_t n, bool& size_differs) const;
+    void spill(const Entry& entry);
+    void forget_spilled(const EncoderKey& key);
+    void insert(Entry entry);
+    void trim_memory();
+    void trim_disk();
+
+    mutable std::mutex mutex_;
+    size_t memory_budget_ = 0;
+    std::string spill_dir_;
+    uint64_t disk_budget_ = 0;
+
+    // Most recently used first
+    std::list<Entry> lru_;
+    std::unordered_map<EncoderKey, std::list<Entry>::iterator, EncoderKeyHash> entries_;
+    size_t memory_bytes_ = 0;
+
+    // Spilled windows, oldest first, with their file sizes
+    std::list<std::pair<EncoderKey, uint64_t>> disk_lru_;
+    std::unordered_map<EncoderKey, std::list<std::pair<EncoderKey, uint64_t>>::iterator, EncoderKeyHash> spilled_;
+    uint64_t disk_bytes_ = 0;
+
+    std::unordered_map<const whisper_context*, uint64_t> models_;
+    EncoderCacheStats stats_;
+};
+
+// Routes the encoder of whisper_full calls on ctx through the cache for the
+// scope's lifetime. samples/n must be exactly the audio given to whisper_full.
+// Does nothing when the cache is disabled or the model is not registered.
+class EncoderCacheScope {
+public:
+    EncoderCacheScope(whisper_context* ctx, const float* samples, size_t n);
+    ~EncoderCacheScope();
+
+    EncoderCacheScope(const EncoderCacheScope&) = delete;
+    EncoderCacheScope& operator=(const EncoderCacheScope&) = delete;
+
+    bool active() const { return ctx_ != nullptr; }
+
+private:
+    static bool on_load(int mel_offset, float* embd, size_t n, void* user_data);
+    static void on_store(int mel_offset, const float* embd, size_t n, void* user_data);
+
+    whisper_context* ctx_ = nullptr;
+    EncoderKey key_;
+    size_t n_audio_state_ = 0;  // floats per encoder frame
+};
+
+} // namespace securevox
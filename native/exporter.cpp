@@ -0,0 +1,290 @@
+#include "exporter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace securevox {
+
+namespace {
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Number of code points in a UTF-8 run
+size_t utf8_width(const char* s, size_t n) {
+    size_t width = 0;
+    for (size_t i = 0; i < n; i++) {
+        if ((static_cast<uint8_t>(s[i]) & 0xC0) != 0x80) width++;
+    }
+    return width;
+}
+
+bool write_all(int fd, const char* data, size_t n, int& error_code) {
+    while (n > 0) {
+#ifdef _WIN32
+        const int chunk = n > 0x40000000 ? 0x40000000 : static_cast<int>(n);
+        const int written = _write(fd, data, static_cast<unsigned int>(chunk));
+#else
+        const ssize_t written = ::write(fd, data, n);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            error_code = errno;
+            return false;
+        }
+        data += written;
+        n -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+TranscriptExporter::TranscriptExporter(int fd, ExportFormat format, const ExportOptions& options)
+    : fd_(fd), format_(format), options_(options) {
+    if (format_ == ExportFormat::Vtt) {
+        put_literal("WEBVTT\n");
+    } else if (format_ == ExportFormat::Json) {
+        put_literal("{\"segments\":[");
+    }
+}
+
+void TranscriptExporter::put(const char* s, size_t n) {
+    while (n > 0) {
+        if (used_ == sizeof(buffer_)) flush();
+        const size_t chunk = n < sizeof(buffer_) - used_ ? n : sizeof(buffer_) - used_;
+        std::memcpy(buffer_ + used_, s, chunk);
+        used_ += chunk;
+        s += chunk;
+        n -= chunk;
+    }
+}
+
+void TranscriptExporter::put_literal(const char* s) {
+    put(s, std::strlen(s));
+}
+
+void TranscriptExporter::put_number(uint64_t value, int min_digits) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (n < min_digits) digits[n++] = '0';
+    while (n > 0) put(digits[--n]);
+}
+
+// HH:MM:SS,mmm (SRT) or HH:MM:SS.mmm (VTT)
+void TranscriptExporter::put_timestamp(int64_t ms, char fraction_separator) {
+    const uint64_t t = ms > 0 ? static_cast<uint64_t>(ms) : 0;
+    put_number(t / 3600000, 2);
+    put(':');
+    put_number(t / 60000 % 60, 2);
+    put(':');
+    put_number(t / 1000 % 60, 2);
+    put(fraction_separator);
+    put_number(t % 1000, 3);
+}
+
+// Words separated by single spaces, wrapped to max_line_chars for subtitles.
+// first_line_used accounts for a speaker prefix already on the first line.
+void TranscriptExporter::put_cue_text(const char* text, size_t len, size_t first_line_used) {
+    const bool subtitles = format_ == ExportFormat::Srt || format_ == ExportFormat::Vtt;
+    const size_t max_line = subtitles && options_.max_line_chars > 0
+        ? static_cast<size_t>(options_.max_line_chars) : 0;
+
+    size_t line = first_line_used;
+    bool line_has_words = false;
+    size_t i = 0;
+    while (i < len) {
+        while (i < len && is_space(text[i])) i++;
+        const size_t begin = i;
+        while (i < len && !is_space(text[i])) i++;
+        if (i == begin) break;
+
+        const size_t width = utf8_width(text + begin, i - begin);
+        if (line_has_words || line > 0) {
+            if (max_line > 0 && line > 0 && line + 1 + width > max_line) {
+                put('\n');
+                line = 0;
+            } else if (line_has_words) {
+                put(' ');
+                line++;
+            }
+        }
+        if (format_ == ExportFormat::Vtt) {
+            put_escaped(text + begin, i - begin);
+        } else {
+            put(text + begin, i - begin);
+        }
+        line += width;
+        line_has_words = true;
+    }
+}
+
+// Escaping for VTT cue text and JSON strings
+void TranscriptExporter::put_escaped(const char* text, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        const char c = text[i];
+        if (format_ == ExportFormat::Vtt) {
+            switch (c) {
+                case '&': put_literal("&amp;"); break;
+                case '<': put_literal("&lt;"); break;
+                case '>': put_literal("&gt;"); break;
+                default: put(c);
+            }
+            continue;
+        }
+        switch (c) {
+            case '"': put_literal("\\\""); break;
+            case '\\': put_literal("\\\\"); break;
+            case '\n': put_literal("\\n"); break;
+            case '\r': put_literal("\\r"); break;
+            case '\t': put_literal("\\t"); break;
+            default:
+                if (static_cast<uint8_t>(c) < 0x20) {
+                    put_literal("\\u00");
+                    put(hex[(c >> 4) & 0xF]);
+                    put(hex[c & 0xF]);
+                } else {
+                    put(c);
+                }
+        }
+    }
+}
+
+void TranscriptExporter::add(int64_t start_ms, int64_t end_ms, const char* text, size_t text_len,
+                             const char* speaker, size_t speaker_len) {
+    // Trim; blank segments produce no cue
+    while (text_len > 0 && is_space(text[0])) {
+        text++;
+        text_len--;
+    }
+    while (text_len > 0 && is_space(text[text_len - 1])) text_len--;
+    if (text_len == 0) return;
+
+    const bool labelled = options_.speaker_labels && speaker != nullptr && speaker_len > 0;
+
+    switch (format_) {
+        case ExportFormat::Txt:
+            if (count_ > 0) put('\n');
+            if (labelled) {
+                put(speaker, speaker_len);
+                put_literal(": ");
+            }
+            put_cue_text(text, text_len, 0);
+            put('\n');
+            break;
+
+        case ExportFormat::Srt:
+            if (count_ > 0) put('\n');
+            put_number(count_ + 1, 1);
+            put('\n');
+            put_timestamp(start_ms, ',');
+            put_literal(" --> ");
+            put_timestamp(end_ms, ',');
+            put('\n');
+            if (labelled) {
+                put(speaker, speaker_len);
+                put_literal(": ");
+            }
+            put_cue_text(text, text_len, labelled ? utf8_width(speaker, speaker_len) + 2 : 0);
+            put('\n');
+            break;
+
+        case ExportFormat::Vtt:
+            put('\n');
+            put_timestamp(start_ms, '.');
+            put_literal(" --> ");
+            put_timestamp(end_ms, '.');
+            put('\n');
+            if (labelled) {
+                // Voice span; the tag itself is not displayed
+                put_literal("<v ");
+                put_escaped(speaker, speaker_len);
+                put('>');
+            }
+            put_cue_text(text, text_len, 0);
+            put('\n');
+            break;
+
+        case ExportFormat::Json:
+            if (count_ > 0) put(',');
+            put_literal("{\"start\":");
+            put_number(start_ms > 0 ? static_cast<uint64_t>(start_ms) : 0, 1);
+            put_literal(",\"end\":");
+            put_number(end_ms > 0 ? static_cast<uint64_t>(end_ms) : 0, 1);
+            put_literal(",\"text\":\"");
+            put_escaped(text, text_len);
+            put('"');
+            if (labelled) {
+                put_literal(",\"speaker\":\"");
+                put_escaped(speaker, speaker_len);
+                put('"');
+            }
+            put('}');
+            break;
+    }
+    count_++;
+}
+
+bool TranscriptExporter::finish(std::string& error) {
+    if (format_ == ExportFormat::Json) put_literal("]}\n");
+    flush();
+    if (failed_) {
+        error = std::string("Export write failed: ") + std::strerror(error_code_);
+        return false;
+    }
+    return true;
+}
+
+void TranscriptExporter::flush() {
+    if (used_ > 0 && !failed_) {
+        failed_ = !write_all(fd_, buffer_, used_, error_code_);
+    }
+    used_ = 0;
+}
+
+bool export_segments(const std::vector<Segment>& segments, ExportFormat format,
+                     const ExportOptions& options, int fd, std::string& error) {
+    TranscriptExporter exporter(fd, format, options);
+    for (const Segment& segment : segments) {
+        exporter.add(segment.start_ms, segment.end_ms, segment.text.data(), segment.text.size());
+    }
+    return exporter.finish(error);
+}
+
+int open_export_file(const std::string& path) {
+#ifdef _WIN32
+    // Paths are UTF-8; the narrow CRT calls would use the ANSI code page
+    const int wide_len = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    if (wide_len <= 0) return -1;
+    std::wstring wide(static_cast<size_t>(wide_len), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide[0], wide_len);
+    return _wopen(wide.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+}
+
+void close_export_file(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+} // namespace securevox
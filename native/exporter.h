@@ -0,0 +1,80 @@
+#pragma once
+
+#include "segment.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace securevox {
+
+// Values are shared with the Kotlin and C# bindings
+enum class ExportFormat {
+    Txt = 0,
+    Srt = 1,
+    Vtt = 2,
+    Json = 3,
+};
+
+struct ExportOptions {
+    // Wrap subtitle cues (SRT/VTT) at this many characters per line, 0 to disable
+    int max_line_chars = 42;
+    // Label cues with their speaker when one is given
+    bool speaker_labels = true;
+};
+
+// Streams a transcript to a file descriptor.
+//
+// Output goes through a fixed buffer and timestamps are formatted with integer
+// arithmetic, so adding a segment allocates nothing and long archives export
+// in a single pass. Segment text is trimmed; SRT/VTT cues are kept on their
+// own lines and word-wrapped to max_line_chars.
+//
+// The descriptor is borrowed: it is flushed by finish() but not closed.
+class TranscriptExporter {
+public:
+    TranscriptExporter(int fd, ExportFormat format, const ExportOptions& options = ExportOptions());
+
+    TranscriptExporter(const TranscriptExporter&) = delete;
+    TranscriptExporter& operator=(const TranscriptExporter&) = delete;
+
+    // text and speaker are UTF-8; speaker may be null or empty
+    void add(int64_t start_ms, int64_t end_ms, const char* text, size_t text_len,
+             const char* speaker = nullptr, size_t speaker_len = 0);
+
+    // Write the trailer and flush. Returns false if any write failed.
+    bool finish(std::string& error);
+
+private:
+    void put(char c) {
+        if (used_ == sizeof(buffer_)) flush();
+        buffer_[used_++] = c;
+    }
+    void put(const char* s, size_t n);
+    void put_literal(const char* s);
+    void put_number(uint64_t value, int min_digits);
+    void put_timestamp(int64_t ms, char fraction_separator);
+    void put_cue_text(const char* text, size_t len, size_t first_line_used);
+    void put_escaped(const char* text, size_t len);
+    void flush();
+
+    int fd_;
+    ExportFormat format_;
+    ExportOptions options_;
+    size_t count_ = 0;
+    bool failed_ = false;
+    int error_code_ = 0;
+    size_t used_ = 0;
+    char buffer_[16 * 1024];
+};
+
+// Export a whole segment list to an open descriptor
+bool export_segments(const std::vector<Segment>& segments, ExportFormat format,
+                     const ExportOptions& options, int fd, std::string& error);
+
+// Create or truncate path (UTF-8) for writing. Returns -1 on failure.
+int open_export_file(const std::string& path);
+void close_export_file(int fd);
+
+} // namespace securevox
@@ -0,0 +1,176 @@
+#include "fft.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SECUREVOX_FFT_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SECUREVOX_FFT_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace securevox {
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+} // namespace
+
+RealFft::RealFft(size_t n) : n_(n) {
+    const size_t half = n_ / 2;
+
+    // Each stage's twiddles are contiguous (stage len at offset len/2 - 1) so
+    // the butterflies can load them as vectors
+    twiddles_.resize(half - 1);
+    for (size_t len = 2; len <= half; len <<= 1) {
+        for (size_t k = 0; k < len / 2; k++) {
+            const double angle = -2.0 * PI * static_cast<double>(k) / static_cast<double>(len);
+            twiddles_[len / 2 - 1 + k] =
+                std::complex<float>(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+        }
+    }
+
+    split_.resize(half + 1);
+    for (size_t k = 0; k <= half; k++) {
+        const double angle = -2.0 * PI * static_cast<double>(k) / static_cast<double>(n_);
+        split_[k] = std::complex<float>(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+    }
+
+    bit_reverse_.resize(half);
+    size_t bits = 0;
+    while ((size_t(1) << bits) < half) bits++;
+    for (size_t i = 0; i < half; i++) {
+        size_t reversed = 0;
+        for (size_t b = 0; b < bits; b++) {
+            if (i & (size_t(1) << b)) reversed |= size_t(1) << (bits - 1 - b);
+        }
+        bit_reverse_[i] = reversed;
+    }
+
+    work_.resize(half);
+}
+
+void RealFft::transform_half(const float* in) {
+    const size_t half = n_ / 2;
+
+    // Even samples as the real part, odd samples as the imaginary part
+    for (size_t i = 0; i < half; i++) {
+        work_[bit_reverse_[i]] = std::complex<float>(in[2 * i], in[2 * i + 1]);
+    }
+
+    butterflies();
+}
+
+// Iterative radix-2 decimation in time over work_, which is in bit-reversed order
+void RealFft::butterflies() {
+    const size_t half = n_ / 2;
+    for (size_t len = 2; len <= half; len <<= 1) {
+        const size_t m = len / 2;
+        const std::complex<float>* tw = twiddles_.data() + m - 1;
+        for (size_t start = 0; start < half; start += len) {
+            std::complex<float>* a = work_.data() + start;
+            std::complex<float>* b = a + m;
+            size_t k = 0;
+#if defined(SECUREVOX_FFT_SSE2)
+            // Two complex values per register: (re0, im0, re1, im1)
+            const __m128 sign = _mm_set_ps(1.0f, -1.0f, 1.0f, -1.0f);
+            for (; k + 2 <= m; k += 2) {
+                float* pa = reinterpret_cast<float*>(a + k);
+                float* pb = reinterpret_cast<float*>(b + k);
+                const __m128 u = _mm_loadu_ps(pa);
+                const __m128 v = _mm_loadu_ps(pb);
+                const __m128 w = _mm_loadu_ps(reinterpret_cast<const float*>(tw + k));
+                const __m128 w_re = _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0));
+                const __m128 w_im = _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1));
+                const __m128 v_swap = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+                const __m128 t = _mm_add_ps(_mm_mul_ps(v, w_re), _mm_mul_ps(_mm_mul_ps(v_swap, w_im), sign));
+                _mm_storeu_ps(pa, _mm_add_ps(u, t));
+                _mm_storeu_ps(pb, _mm_sub_ps(u, t));
+            }
+#elif defined(SECUREVOX_FFT_NEON)
+            // Four complex values, deinterleaved into real and imaginary lanes
+            for (; k + 4 <= m; k += 4) {
+                float* pa = reinterpret_cast<float*>(a + k);
+                float* pb = reinterpret_cast<float*>(b + k);
+                const float32x4x2_t u = vld2q_f32(pa);
+                const float32x4x2_t v = vld2q_f32(pb);
+                const float32x4x2_t w = vld2q_f32(reinterpret_cast<const float*>(tw + k));
+                const float32x4_t t_re = vmlsq_f32(vmulq_f32(v.val[0], w.val[0]), v.val[1], w.val[1]);
+                const float32x4_t t_im = vmlaq_f32(vmulq_f32(v.val[0], w.val[1]), v.val[1], w.val[0]);
+                float32x4x2_t sum, diff;
+                sum.val[0] = vaddq_f32(u.val[0], t_re);
+                sum.val[1] = vaddq_f32(u.val[1], t_im);
+                diff.val[0] = vsubq_f32(u.val[0], t_re);
+                diff.val[1] = vsubq_f32(u.val[1], t_im);
+                vst2q_f32(pa, sum);
+                vst2q_f32(pb, diff);
+            }
+#endif
+            for (; k < m; k++) {
+                const std::complex<float> t = tw[k] * b[k];
+                const std::complex<float> u = a[k];
+                a[k] = u + t;
+                b[k] = u - t;
+            }
+        }
+    }
+}
+
+void RealFft::forward(const float* in, std::complex<float>* out) {
+    const size_t half = n_ / 2;
+    transform_half(in);
+
+    // Split the packed transform into the spectra of the even and odd samples
+    for (size_t k = 0; k <= half; k++) {
+        const std::complex<float> z = work_[k < half ? k : 0];
+        const std::complex<float> mirror = std::conj(work_[k > 0 ? half - k : 0]);
+        const std::complex<float> even = 0.5f * (z + mirror);
+        const std::complex<float> odd = std::complex<float>(0.0f, -0.5f) * (z - mirror);
+        out[k] = even + split_[k] * odd;
+    }
+}
+
+void RealFft::power(const float* in, float* out) {
+    const size_t half = n_ / 2;
+    transform_half(in);
+
+    for (size_t k = 0; k <= half; k++) {
+        const std::complex<float> z = work_[k < half ? k : 0];
+        const std::complex<float> mirror = std::conj(work_[k > 0 ? half - k : 0]);
+        const std::complex<float> even = 0.5f * (z + mirror);
+        const std::complex<float> odd = std::complex<float>(0.0f, -0.5f) * (z - mirror);
+        out[k] = std::norm(even + split_[k] * odd);
+    }
+}
+
+void RealFft::inverse(const std::complex<float>* in, float* out) {
+    const size_t half = n_ / 2;
+
+    // Rebuild the packed spectrum from the even and odd halves, conjugated so
+    // the forward butterflies compute the inverse transform
+    for (size_t k = 0; k < half; k++) {
+        const std::complex<float> mirror = std::conj(in[half - k]);
+        const std::complex<float> even = 0.5f * (in[k] + mirror);
+        const std::complex<float> odd = 0.5f * (in[k] - mirror) * std::conj(split_[k]);
+        work_[bit_reverse_[k]] = std::conj(even + std::complex<float>(0.0f, 1.0f) * odd);
+    }
+    butterflies();
+
+    const float scale = 1.0f / static_cast<float>(half);
+    for (size_t i = 0; i < half; i++) {
+        out[2 * i] = work_[i].real() * scale;
+        out[2 * i + 1] = -work_[i].imag() * scale;
+    }
+}
+
+std::vector<float> hann_window(size_t n) {
+    std::vector<float> window(n);
+    for (size_t i = 0; i < n; i++) {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * PI * static_cast<double>(i) / static_cast<double>(n)));
+    }
+    return window;
+}
+
+} // namespace securevox
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace securevox {
+
+// FFT of real input, for a fixed power-of-two size.
+//
+// The n real samples are packed into an n/2-point complex transform and split
+// afterwards, so a frame costs half a complex FFT of the same length. Twiddles
+// and the bit-reversal table are computed once in the constructor, and the
+// butterflies run two (SSE2) or four (NEON) at a time. An instance keeps
+// scratch space and must not be shared between threads.
+class RealFft {
+public:
+    // n is a power of two, at least 4
+    explicit RealFft(size_t n);
+
+    size_t size() const { return n_; }
+
+    // Number of output bins, n/2 + 1 (DC to Nyquist)
+    size_t bins() const { return n_ / 2 + 1; }
+
+    // Spectrum of n samples into bins() values
+    void forward(const float* in, std::complex<float>* out);
+
+    // Squared magnitudes of the spectrum into bins() values
+    void power(const float* in, float* out);
+
+    // n samples from bins() values of a real signal's spectrum; the inverse of
+    // forward(), including the 1/n scaling
+    void inverse(const std::complex<float>* in, float* out);
+
+private:
+    void transform_half(const float* in);
+    void butterflies();
+
+    size_t n_;
+    std::vector<std::complex<float>> twiddles_;  // per stage of length len: e^{-2 pi i k / len}, k < len/2
+    std::vector<std::complex<float>> split_;     // e^{-2 pi i k / n}, k <= n/2
+    std::vector<size_t> bit_reverse_;
+    std::vector<std::complex<float>> work_;
+};
+
+// Periodic Hann window of length n
+std::vector<float> hann_window(size_t n);
+
+} // namespace securevox
@@ -0,0 +1,512 @@
+#include "fingerprint.h"
+
+#include "binary_io.h"
+#include "fft.h"
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace securevox {
+
+namespace {
+
+constexpr char MAGIC[4] = {'S', 'V', 'F', 'P'};
+constexpr uint32_t VERSION = 1;
+
+constexpr char RECORD_ADD = 'A';
+constexpr char RECORD_REMOVE = 'R';
+
+// Sanity limits when reading back the log
+constexpr uint32_t MAX_ID_BYTES = 256;
+constexpr uint32_t MAX_LANDMARK_BYTES = 64 * 1024 * 1024;
+
+// Compact on open once superseded records make up this share of the log
+constexpr double COMPACT_DEAD_RATIO = 0.25;
+
+// Analysis: 64 ms frames every 32 ms, 15.6 Hz bins. Rates that are a multiple
+// of 8 kHz are analysed as they are with the frame scaled to match; others
+// are resampled to 16 kHz first.
+constexpr int BASE_RATE = 8000;
+constexpr size_t BASE_FRAME = 512;
+constexpr size_t BASE_HOP = 256;
+constexpr int FALLBACK_RATE = 16000;
+static_assert(BASE_HOP * 1000 / BASE_RATE == FINGERPRINT_FRAME_MS, "hop must match FINGERPRINT_FRAME_MS");
+
+// Peaks are searched between ~94 Hz and 4 kHz in log-spaced bands
+constexpr int BANDS = 8;
+constexpr double LOWEST_BIN = 6.0;
+constexpr double HIGHEST_BIN = 256.0;
+
+// A peak is the loudest bin of its band over this many frames on either side
+constexpr int PEAK_RADIUS_FRAMES = 2;
+// ...and this far above the frame's mean level
+constexpr float PROMINENCE_DB = 6.0f;
+// Frames quieter than this (digital silence) have no peaks
+constexpr float MIN_LEVEL_DB = -40.0f;
+// Strongest peaks kept per ~1 s block
+constexpr size_t BLOCK_FRAMES = 31;
+constexpr size_t PEAKS_PER_BLOCK = 8;
+
+// Each peak pairs with the next peaks up to ~2 s later
+constexpr size_t FANOUT = 4;
+constexpr uint32_t MAX_PAIR_FRAMES = 63;
+
+// Offsets agreed on by fewer landmarks are chance collisions
+constexpr uint32_t MIN_MATCHES = 25;
+// Hashes this common (hum, tones) are skipped when matching
+constexpr size_t MAX_POSTINGS_PER_HASH = 20000;
+
+struct Peak {
+    uint32_t frame;
+    uint32_t bin;
+    float prominence;
+};
+
+void put_string(std::string& buf, const std::string& s) {
+    put_u32(buf, static_cast<uint32_t>(s.size()));
+    buf.append(s);
+}
+
+bool get_string(FILE* f, uint32_t max_len, std::string& s) {
+    uint32_t len;
+    if (!get_u32(f, len) || len > max_len) return false;
+    s.resize(len);
+    return len == 0 || std::fread(&s[0], 1, len, f) == len;
+}
+
+// Landmarks as varint (frame delta, hash) pairs, ordered by frame
+std::string encode_landmarks(const std::vector<Landmark>& landmarks) {
+    std::string bytes;
+    put_varint(bytes, landmarks.size());
+    uint32_t previous = 0;
+    for (const Landmark& landmark : landmarks) {
+        put_varint(bytes, landmark.frame - previous);
+        put_varint(bytes, landmark.hash);
+        previous = landmark.frame;
+    }
+    return bytes;
+}
+
+bool decode_landmarks(const std::string& bytes, std::vector<Landmark>& landmarks) {
+    size_t pos = 0;
+    uint64_t count, delta, hash;
+    if (!get_varint(bytes, pos, count) || count > bytes.size()) return false;
+    landmarks.resize(static_cast<size_t>(count));
+    uint64_t frame = 0;
+    for (Landmark& landmark : landmarks) {
+        if (!get_varint(bytes, pos, delta) || !get_varint(bytes, pos, hash)) return false;
+        frame += delta;
+        landmark.frame = static_cast<uint32_t>(frame);
+        landmark.hash = static_cast<uint32_t>(hash);
+    }
+    return pos == bytes.size();
+}
+
+void encode_add(std::string& buf, const std::string& recording_id, int64_t duration_ms,
+                const std::string& landmark_bytes) {
+    const size_t begin = buf.size();
+    buf.push_back(RECORD_ADD);
+    put_string(buf, recording_id);
+    put_u64(buf, static_cast<uint64_t>(duration_ms));
+    put_string(buf, landmark_bytes);
+    put_u32(buf, fnv1a(buf.data() + begin, buf.size() - begin));
+}
+
+void encode_remove(std::string& buf, const std::string& recording_id) {
+    const size_t begin = buf.size();
+    buf.push_back(RECORD_REMOVE);
+    put_string(buf, recording_id);
+    put_u32(buf, fnv1a(buf.data() + begin, buf.size() - begin));
+}
+
+// A decoded log record
+struct LogRecord {
+    char type = 0;
+    std::string recording_id;
+    int64_t duration_ms = 0;
+    std::string landmark_bytes;
+    bool live = true;
+};
+
+bool read_record(FILE* f, LogRecord& record) {
+    char type;
+    if (std::fread(&type, 1, 1, f) != 1) return false;
+    if (type != RECORD_ADD && type != RECORD_REMOVE) return false;
+
+    record.type = type;
+    if (!get_string(f, MAX_ID_BYTES, record.recording_id)) return false;
+
+    std::string encoded;
+    if (type == RECORD_ADD) {
+        uint64_t duration;
+        if (!get_u64(f, duration) || !get_string(f, MAX_LANDMARK_BYTES, record.landmark_bytes)) return false;
+        record.duration_ms = static_cast<int64_t>(duration);
+        encode_add(encoded, record.recording_id, record.duration_ms, record.landmark_bytes);
+    } else {
+        encode_remove(encoded, record.recording_id);
+    }
+
+    uint32_t checksum;
+    return get_u32(f, checksum) && fnv1a(encoded.data(), encoded.size() - 4) == checksum;
+}
+
+uint64_t vote_key(uint32_t recording, int64_t offset) {
+    return (static_cast<uint64_t>(recording) << 32) | static_cast<uint32_t>(offset + (int64_t(1) << 31));
+}
+
+} // namespace
+
+std::vector<Landmark> compute_landmarks(const float* samples, size_t n, int sample_rate) {
+    std::vector<Landmark> landmarks;
+    if (samples == nullptr || sample_rate <= 0) return landmarks;
+
+    SampleVector resampled;
+    const float* audio = samples;
+    if (sample_rate % BASE_RATE != 0) {
+        resample(samples, n, sample_rate, FALLBACK_RATE, resampled);
+        audio = resampled.data();
+        n = resampled.size();
+        sample_rate = FALLBACK_RATE;
+    }
+    const size_t scale = static_cast<size_t>(sample_rate / BASE_RATE);
+    const size_t frame_size = BASE_FRAME * scale;
+    const size_t hop = BASE_HOP * scale;
+    if (n < frame_size) return landmarks;
+    const size_t frames = 1 + (n - frame_size) / hop;
+    // Longer frames sum more samples; keep levels comparable across rates
+    const double level_offset = -20.0 * std::log10(static_cast<double>(scale));
+
+    int band_edges[BANDS + 1];
+    for (int b = 0; b <= BANDS; b++) {
+        band_edges[b] = static_cast<int>(LOWEST_BIN * std::pow(HIGHEST_BIN / LOWEST_BIN, static_cast<double>(b) / BANDS));
+    }
+
+    // Loudest bin and its level per frame and band, plus each frame's mean level
+    RealFft fft(frame_size);
+    const std::vector<float> window = hann_window(frame_size);
+    std::vector<float> frame(frame_size);
+    std::vector<float> power(fft.bins());
+    std::vector<float> levels(frames * BANDS);
+    std::vector<uint16_t> bins(frames * BANDS);
+    std::vector<float> means(frames);
+
+    for (size_t t = 0; t < frames; t++) {
+        const float* in = audio + t * hop;
+        for (size_t i = 0; i < frame_size; i++) frame[i] = in[i] * window[i];
+        fft.power(frame.data(), power.data());
+
+        double sum = 0.0;
+        for (int b = 0; b < BANDS; b++) {
+            float best = -1.0f;
+            int best_bin = band_edges[b];
+            for (int k = band_edges[b]; k < band_edges[b + 1]; k++) {
+                sum += 10.0 * std::log10(power[k] + 1e-10f);
+                if (power[k] > best) {
+                    best = power[k];
+                    best_bin = k;
+                }
+            }
+            levels[t * BANDS + b] = static_cast<float>(10.0 * std::log10(best + 1e-10f) + level_offset);
+            bins[t * BANDS + b] = static_cast<uint16_t>(best_bin);
+        }
+        means[t] = static_cast<float>(sum / (band_edges[BANDS] - band_edges[0]) + level_offset);
+    }
+
+    // Peaks: local maxima in time that stand out from their frame
+    std::vector<Peak> peaks;
+    std::vector<Peak> block;
+    for (size_t start = 0; start < frames; start += BLOCK_FRAMES) {
+        block.clear();
+        const size_t end = std::min(frames, start + BLOCK_FRAMES);
+        for (size_t t = start; t < end; t++) {
+            for (int b = 0; b < BANDS; b++) {
+                const float level = levels[t * BANDS + b];
+                if (level < MIN_LEVEL_DB || level < means[t] + PROMINENCE_DB) continue;
+
+                bool is_peak = true;
+                const size_t first = t >= PEAK_RADIUS_FRAMES ? t - PEAK_RADIUS_FRAMES : 0;
+                const size_t last = std::min(frames - 1, t + PEAK_RADIUS_FRAMES);
+                for (size_t u = first; u <= last && is_peak; u++) {
+                    const float other = levels[u * BANDS + b];
+                    // Ties go to the earliest frame
+                    if (other > level || (other == level && u < t)) is_peak = false;
+                }
+                if (is_peak) {
+                    block.push_back({static_cast<uint32_t>(t), bins[t * BANDS + b], level - means[t]});
+                }
+            }
+        }
+
+        if (block.size() > PEAKS_PER_BLOCK) {
+            std::partial_sort(block.begin(), block.begin() + PEAKS_PER_BLOCK, block.end(),
+                              [](const Peak& a, const Peak& c) { return a.prominence > c.prominence; });
+            block.resize(PEAKS_PER_BLOCK);
+        }
+        peaks.insert(peaks.end(), block.begin(), block.end());
+    }
+    std::sort(peaks.begin(), peaks.end(), [](const Peak& a, const Peak& c) {
+        return a.frame != c.frame ? a.frame < c.frame : a.bin < c.bin;
+    });
+
+    // Pair each peak with the next few; frequencies in 31 Hz steps so a peak
+    // moved by one bin through re-encoding still hashes the same
+    for (size_t i = 0; i < peaks.size(); i++) {
+        size_t paired = 0;
+        for (size_t j = i + 1; j < peaks.size() && paired < FANOUT; j++) {
+            const uint32_t dt = peaks[j].frame - peaks[i].frame;
+            if (dt == 0) continue;
+            if (dt > MAX_PAIR_FRAMES) break;
+
+            Landmark landmark;
+            landmark.hash = ((peaks[i].bin >> 1) << 13) | ((peaks[j].bin >> 1) << 6) | dt;
+            landmark.frame = peaks[i].frame;
+            landmarks.push_back(landmark);
+            paired++;
+        }
+    }
+    return landmarks;
+}
+
+FingerprintIndex::~FingerprintIndex() {
+    if (log_ != nullptr) std::fclose(log_);
+}
+
+bool FingerprintIndex::open(const std::string& path, std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    path_ = path;
+    if (log_ != nullptr) {
+        std::fclose(log_);
+        log_ = nullptr;
+    }
+    postings_.clear();
+    recording_ids_.clear();
+    recording_durations_.clear();
+    recording_live_.clear();
+    recording_slots_.clear();
+    live_recordings_ = 0;
+
+    // Replay the log; a later record for the same recording supersedes earlier ones
+    std::vector<LogRecord> records;
+    bool intact = true;
+    bool exists = false;
+    if (FILE* f = std::fopen(path.c_str(), "rb")) {
+        exists = true;
+        char magic[4];
+        uint32_t version = 0;
+        if (std::fread(magic, 1, 4, f) == 4 && std::memcmp(magic, MAGIC, 4) == 0 &&
+            get_u32(f, version) && version == VERSION) {
+
+            std::unordered_map<std::string, size_t> latest;
+            LogRecord record;
+            long good_end = std::ftell(f);
+            while (read_record(f, record)) {
+                good_end = std::ftell(f);
+                auto it = latest.find(record.recording_id);
+                if (it != latest.end()) records[it->second].live = false;
+                if (record.type == RECORD_REMOVE) {
+                    record.live = false;
+                    latest.erase(record.recording_id);
+                } else {
+                    latest[record.recording_id] = records.size();
+                }
+                records.push_back(std::move(record));
+                record = LogRecord();
+            }
+            // Anything after the last valid record is a torn write
+            intact = std::fseek(f, 0, SEEK_END) == 0 && std::ftell(f) == good_end;
+        } else {
+            intact = false;
+        }
+        std::fclose(f);
+    }
+
+    size_t dead = 0;
+    std::vector<Landmark> landmarks;
+    for (LogRecord& record : records) {
+        if (!record.live) {
+            dead++;
+            continue;
+        }
+        if (!decode_landmarks(record.landmark_bytes, landmarks)) {
+            record.live = false;
+            dead++;
+            continue;
+        }
+        const uint32_t slot = recording_slot(record.recording_id);
+        recording_durations_[slot] = record.duration_ms;
+        index_landmarks(slot, landmarks);
+    }
+
+    // A new or torn log is rewritten, as is one where removed recordings left a
+    // quarter or more of the records dead
+    const bool rewrite = !exists || !intact ||
+        (dead > 0 && static_cast<double>(dead) >= COMPACT_DEAD_RATIO * static_cast<double>(records.size()));
+
+    if (rewrite) {
+        std::string buf(MAGIC, 4);
+        put_u32(buf, VERSION);
+        for (const LogRecord& record : records) {
+            if (record.live) encode_add(buf, record.recording_id, record.duration_ms, record.landmark_bytes);
+        }
+
+        const std::string tmp = path + ".tmp";
+        FILE* out = std::fopen(tmp.c_str(), "wb");
+        if (out == nullptr) {
+            error = "Cannot write fingerprint index: " + tmp;
+            return false;
+        }
+        const bool written = std::fwrite(buf.data(), 1, buf.size(), out) == buf.size() && sync_file(out);
+        std::fclose(out);
+        if (!written) {
+            std::remove(tmp.c_str());
+            error = "Cannot write fingerprint index: " + tmp;
+            return false;
+        }
+#ifdef _WIN32
+        std::remove(path.c_str());  // rename does not replace on Windows
+#endif
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            error = "Cannot replace fingerprint index: " + path;
+            return false;
+        }
+    }
+
+    log_ = std::fopen(path.c_str(), "ab");
+    if (log_ == nullptr) {
+        error = "Cannot open fingerprint index: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool FingerprintIndex::set_recording(const std::string& recording_id, const std::vector<Landmark>& landmarks,
+                                     int64_t duration_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = recording_slots_.find(recording_id);
+    if (it != recording_slots_.end()) drop_recording(it->second);
+
+    const uint32_t slot = recording_slot(recording_id);
+    recording_durations_[slot] = duration_ms;
+    index_landmarks(slot, landmarks);
+
+    std::string records;
+    encode_add(records, recording_id, duration_ms, encode_landmarks(landmarks));
+    return append_log(records);
+}
+
+bool FingerprintIndex::remove_recording(const std::string& recording_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = recording_slots_.find(recording_id);
+    if (it == recording_slots_.end()) return true;
+    drop_recording(it->second);
+
+    std::string records;
+    encode_remove(records, recording_id);
+    return append_log(records);
+}
+
+bool FingerprintIndex::find(const std::vector<Landmark>& query, const std::string& exclude_id,
+                            FingerprintMatch& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto excluded = recording_slots_.find(exclude_id);
+    const uint32_t exclude = excluded != recording_slots_.end() ? excluded->second : UINT32_MAX;
+
+    // Votes per (recording, indexed frame - query frame)
+    std::unordered_map<uint64_t, uint32_t> votes;
+    for (const Landmark& landmark : query) {
+        auto it = postings_.find(landmark.hash);
+        if (it == postings_.end() || it->second.size() > MAX_POSTINGS_PER_HASH) continue;
+        for (const Posting& posting : it->second) {
+            if (posting.recording == exclude || !recording_live_[posting.recording]) continue;
+            votes[vote_key(posting.recording, static_cast<int64_t>(posting.frame) - landmark.frame)]++;
+        }
+    }
+
+    // Offsets one frame apart are the same alignment split by frame rounding
+    uint64_t best_key = 0;
+    uint32_t best_score = 0;
+    for (const auto& entry : votes) {
+        uint32_t score = entry.second;
+        auto before = votes.find(entry.first - 1);
+        auto after = votes.find(entry.first + 1);
+        if (before != votes.end()) score += before->second;
+        if (after != votes.end()) score += after->second;
+        if (score > best_score || (score == best_score && entry.first < best_key)) {
+            best_score = score;
+            best_key = entry.first;
+        }
+    }
+    if (best_score < MIN_MATCHES) return false;
+
+    const uint32_t recording = static_cast<uint32_t>(best_key >> 32);
+    const int64_t offset = static_cast<int64_t>(best_key & 0xFFFFFFFFull) - (int64_t(1) << 31);
+
+    // Span of the query covered by the agreeing landmarks
+    uint32_t first = UINT32_MAX, last = 0;
+    for (const Landmark& landmark : query) {
+        auto it = postings_.find(landmark.hash);
+        if (it == postings_.end() || it->second.size() > MAX_POSTINGS_PER_HASH) continue;
+        for (const Posting& posting : it->second) {
+            if (posting.recording != recording) continue;
+            const int64_t d = static_cast<int64_t>(posting.frame) - landmark.frame - offset;
+            if (d >= -1 && d <= 1) {
+                first = std::min(first, landmark.frame);
+                last = std::max(last, landmark.frame);
+                break;
+            }
+        }
+    }
+
+    out.recording_id = recording_ids_[recording];
+    out.offset_ms = offset * FINGERPRINT_FRAME_MS;
+    out.query_begin_ms = static_cast<int64_t>(first) * FINGERPRINT_FRAME_MS;
+    out.query_end_ms = (static_cast<int64_t>(last) + 1) * FINGERPRINT_FRAME_MS;
+    out.recording_duration_ms = recording_durations_[recording];
+    out.matches = best_score;
+    return true;
+}
+
+size_t FingerprintIndex::recording_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return live_recordings_;
+}
+
+uint32_t FingerprintIndex::recording_slot(const std::string& recording_id) {
+    auto it = recording_slots_.find(recording_id);
+    if (it != recording_slots_.end()) return it->second;
+
+    // A replaced recording gets a fresh slot; postings of the old one stay
+    // behind the dead slot until the log is compacted
+    const uint32_t slot = static_cast<uint32_t>(recording_ids_.size());
+    recording_ids_.push_back(recording_id);
+    recording_durations_.push_back(0);
+    recording_live_.push_back(true);
+    recording_slots_.emplace(recording_id, slot);
+    live_recordings_++;
+    return slot;
+}
+
+void FingerprintIndex::drop_recording(uint32_t recording) {
+    recording_live_[recording] = false;
+    recording_slots_.erase(recording_ids_[recording]);
+    live_recordings_--;
+}
+
+void FingerprintIndex::index_landmarks(uint32_t recording, const std::vector<Landmark>& landmarks) {
+    for (const Landmark& landmark : landmarks) {
+        postings_[landmark.hash].push_back({recording, landmark.frame});
+    }
+}
+
+bool FingerprintIndex::append_log(const std::string& records) {
+    if (log_ == nullptr || records.empty()) return log_ != nullptr;
+    if (std::fwrite(records.data(), 1, records.size(), log_) != records.size()) return false;
+    return sync_file(log_);
+}
+
+} // namespace securevox
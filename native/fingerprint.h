@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace securevox {
+
+// Duration of one fingerprint frame; landmark times and match offsets have
+// this resolution
+constexpr int FINGERPRINT_FRAME_MS = 32;
+
+// A pair of spectral peaks: both frequencies and their distance in frames
+// hashed together, anchored at the first peak's frame
+struct Landmark {
+    uint32_t hash = 0;
+    uint32_t frame = 0;
+};
+
+// Landmarks of mono audio at any sample rate, ordered by frame.
+//
+// The audio is cut into 64 ms Hann frames every 32 ms (resampled to 16 kHz
+// first unless the rate is a multiple of 8 kHz) and analysed up to 4 kHz.
+// Each frame contributes at most one peak per log-spaced band, kept when it is
+// a local maximum over neighbouring frames and stands out from the rest of the
+// frame; the strongest few per second survive. Each peak is paired with the
+// next peaks within two seconds. Peaks and their spacing survive re-encoding,
+// bitrate changes, gain changes and the audio track of a video, which change
+// the bytes completely.
+std::vector<Landmark> compute_landmarks(const float* samples, size_t n, int sample_rate);
+
+// The indexed recording that shares the most landmarks at one time offset
+struct FingerprintMatch {
+    std::string recording_id;
+    int64_t offset_ms = 0;        // time in the indexed recording at time 0 of the query
+    int64_t query_begin_ms = 0;   // matched span of the query
+    int64_t query_end_ms = 0;
+    int64_t recording_duration_ms = 0;
+    uint32_t matches = 0;         // landmarks agreeing on the offset
+};
+
+// Persistent landmark index for near-duplicate detection.
+//
+// Landmark hashes map to postings of (recording, frame). A query votes for
+// every (recording, frame offset) its landmarks hit; a copy of the same audio,
+// even re-encoded or shifted, piles its votes on one offset while unrelated
+// audio scatters. Updates are appended to a checksummed log, replayed on open
+// and compacted once superseded records make up a quarter of it, like
+// TranscriptIndex.
+//
+// All methods are thread safe.
+class FingerprintIndex {
+public:
+    FingerprintIndex() = default;
+    ~FingerprintIndex();
+
+    FingerprintIndex(const FingerprintIndex&) = delete;
+    FingerprintIndex& operator=(const FingerprintIndex&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+
+    // Replace the landmarks of a recording
+    bool set_recording(const std::string& recording_id, const std::vector<Landmark>& landmarks,
+                       int64_t duration_ms);
+
+    bool remove_recording(const std::string& recording_id);
+
+    // Best match for the query landmarks among recordings other than
+    // exclude_id. False when no recording shares enough landmarks.
+    bool find(const std::vector<Landmark>& query, const std::string& exclude_id, FingerprintMatch& out) const;
+
+    size_t recording_count() const;
+
+private:
+    struct Posting {
+        uint32_t recording;
+        uint32_t frame;
+    };
+
+    uint32_t recording_slot(const std::string& recording_id);
+    void index_landmarks(uint32_t recording, const std::vector<Landmark>& landmarks);
+    void drop_recording(uint32_t recording);
+    bool append_log(const std::string& records);
+
+    mutable std::mutex mutex_;
+    std::string path_;
+    FILE* log_ = nullptr;
+
+    std::unordered_map<uint32_t, std::vector<Posting>> postings_;
+    std::vector<std::string> recording_ids_;
+    std::vector<int64_t> recording_durations_;
+    std::vector<bool> recording_live_;
+    std::unordered_map<std::string, uint32_t> recording_slots_;
+    size_t live_recordings_ = 0;
+};
+
+} // namespace securevox
@@ -0,0 +1,925 @@
+#include "flac.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SECUREVOX_FLAC_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SECUREVOX_FLAC_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace securevox {
+
+namespace {
+
+constexpr int BITS_PER_SAMPLE = 16;
+constexpr int MAX_FIXED_ORDER = 4;
+constexpr int LPC_ORDER = 8;
+// Coefficient precision. With 12-bit coefficients, 16-bit samples and order 8
+// the prediction sum stays below 2^29, so the residual fits 16x16->32 SIMD
+// multiplies.
+constexpr int QLP_PRECISION = 12;
+constexpr int MAX_PARTITION_ORDER = 6;
+constexpr uint32_t MAX_RICE_PARAM = 14;  // 15 escapes to raw samples
+// Blocks shorter than this are stored verbatim; prediction would not pay off
+constexpr uint32_t MIN_PREDICTED_BLOCK = 32;
+
+// "fLaC", then the STREAMINFO block header (last block, type 0, 34 bytes)
+constexpr uint8_t STREAM_HEADER[8] = {'f', 'L', 'a', 'C', 0x80, 0x00, 0x00, 34};
+constexpr size_t STREAM_INFO_BYTES = 34;
+
+constexpr size_t READ_BLOCK_BYTES = 64 * 1024;
+
+struct FileCloser {
+    void operator()(FILE* f) const { if (f) std::fclose(f); }
+};
+
+struct CrcTables {
+    uint8_t crc8[256];
+    uint16_t crc16[256];
+
+    CrcTables() {
+        for (int i = 0; i < 256; i++) {
+            uint8_t c8 = static_cast<uint8_t>(i);
+            for (int b = 0; b < 8; b++) c8 = static_cast<uint8_t>((c8 & 0x80) ? (c8 << 1) ^ 0x07 : c8 << 1);
+            crc8[i] = c8;
+
+            uint16_t c16 = static_cast<uint16_t>(i << 8);
+            for (int b = 0; b < 8; b++) c16 = static_cast<uint16_t>((c16 & 0x8000) ? (c16 << 1) ^ 0x8005 : c16 << 1);
+            crc16[i] = c16;
+        }
+    }
+};
+
+const CrcTables& crc_tables() {
+    static const CrcTables tables;
+    return tables;
+}
+
+uint8_t crc8(const uint8_t* p, size_t n) {
+    const CrcTables& t = crc_tables();
+    uint8_t crc = 0;
+    for (size_t i = 0; i < n; i++) crc = t.crc8[crc ^ p[i]];
+    return crc;
+}
+
+uint16_t crc16(const uint8_t* p, size_t n) {
+    const CrcTables& t = crc_tables();
+    uint16_t crc = 0;
+    for (size_t i = 0; i < n; i++) crc = static_cast<uint16_t>((crc << 8) ^ t.crc16[(crc >> 8) ^ p[i]]);
+    return crc;
+}
+
+uint32_t low_bits(int bits) {
+    return bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+}
+
+uint32_t zigzag(int32_t v) {
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+// MSB-first bit packer appending to a byte vector
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    // Write the low `bits` bits of value, bits <= 32
+    void put(uint32_t value, int bits) {
+        if (bits == 0) return;
+        acc_ = (acc_ << bits) | (value & low_bits(bits));
+        count_ += bits;
+        while (count_ >= 8) {
+            count_ -= 8;
+            out_.push_back(static_cast<uint8_t>(acc_ >> count_));
+        }
+    }
+
+    void put_signed(int32_t value, int bits) { put(static_cast<uint32_t>(value), bits); }
+
+    void put_zeros(uint32_t n) {
+        for (; n >= 32; n -= 32) put(0, 32);
+        put(0, static_cast<int>(n));
+    }
+
+    // Quotient in unary (zeros closed by a one), then k low bits
+    void put_rice(uint32_t u, uint32_t k) {
+        const uint32_t q = u >> k;
+        if (q + 1 + k <= 32) {
+            put((1u << k) | (u & low_bits(static_cast<int>(k))), static_cast<int>(q + 1 + k));
+        } else {
+            put_zeros(q);
+            put(1, 1);
+            put(u, static_cast<int>(k));
+        }
+    }
+
+    void align() {
+        if (count_ > 0) put(0, 8 - count_);
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+    uint64_t acc_ = 0;
+    int count_ = 0;
+};
+
+// Frame and sample numbers use UTF-8 style coding extended to 36 bits
+void put_utf8(BitWriter& w, uint64_t v) {
+    if (v < 0x80) {
+        w.put(static_cast<uint32_t>(v), 8);
+        return;
+    }
+    int bytes = 2;
+    while (bytes < 7 && v >= (1ull << (5 * bytes + 1))) bytes++;
+    const uint32_t lead = (0xFFu << (8 - bytes)) & 0xFFu;
+    w.put(lead | static_cast<uint32_t>(v >> (6 * (bytes - 1))), 8);
+    for (int i = bytes - 2; i >= 0; i--) {
+        w.put(0x80u | static_cast<uint32_t>((v >> (6 * i)) & 0x3F), 8);
+    }
+}
+
+uint32_t block_size_code(uint32_t n) {
+    switch (n) {
+        case 192: return 1;
+        case 576: return 2;
+        case 1152: return 3;
+        case 2304: return 4;
+        case 4608: return 5;
+        case 256: return 8;
+        case 512: return 9;
+        case 1024: return 10;
+        case 2048: return 11;
+        case 4096: return 12;
+        case 8192: return 13;
+        case 16384: return 14;
+        case 32768: return 15;
+        default: return n <= 256 ? 6 : 7;  // explicit 8- or 16-bit size follows
+    }
+}
+
+// Residual of the fixed polynomial predictor of the given order, for i in [order, n)
+void fixed_residual(const int16_t* x, uint32_t n, int order, int32_t* r) {
+    switch (order) {
+        case 0:
+            for (uint32_t i = 0; i < n; i++) r[i] = x[i];
+            break;
+        case 1:
+            for (uint32_t i = 1; i < n; i++) r[i] = x[i] - x[i - 1];
+            break;
+        case 2:
+            for (uint32_t i = 2; i < n; i++) r[i] = x[i] - 2 * x[i - 1] + x[i - 2];
+            break;
+        case 3:
+            for (uint32_t i = 3; i < n; i++) r[i] = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3];
+            break;
+        default:
+            for (uint32_t i = 4; i < n; i++) r[i] = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4];
+            break;
+    }
+}
+
+// Quantized LPC predictor of LPC_ORDER from the windowed autocorrelation.
+// False when the block has no energy to predict.
+bool compute_lpc(const int16_t* x, uint32_t n, int16_t* coeffs, int& shift) {
+    // Welch window
+    std::vector<float> windowed(n);
+    const double half = (n - 1) / 2.0;
+    for (uint32_t i = 0; i < n; i++) {
+        const double d = (i - half) / (half + 1.0);
+        windowed[i] = static_cast<float>(x[i] * (1.0 - d * d));
+    }
+
+    double autoc[LPC_ORDER + 1];
+    for (int lag = 0; lag <= LPC_ORDER; lag++) {
+        double sum = 0.0;
+        for (uint32_t i = static_cast<uint32_t>(lag); i < n; i++) sum += static_cast<double>(windowed[i]) * windowed[i - lag];
+        autoc[lag] = sum;
+    }
+    if (autoc[0] <= 0.0) return false;
+
+    // Levinson-Durbin: x[i] ~ sum_j a[j] x[i-1-j]
+    double a[LPC_ORDER] = {};
+    double err = autoc[0];
+    for (int i = 0; i < LPC_ORDER; i++) {
+        double acc = autoc[i + 1];
+        for (int j = 0; j < i; j++) acc -= a[j] * autoc[i - j];
+        const double k = acc / err;
+        double prev[LPC_ORDER];
+        std::copy(a, a + i, prev);
+        a[i] = k;
+        for (int j = 0; j < i; j++) a[j] = prev[j] - k * prev[i - 1 - j];
+        err *= 1.0 - k * k;
+        if (err <= 0.0) break;
+    }
+
+    double cmax = 0.0;
+    for (double c : a) cmax = std::max(cmax, std::fabs(c));
+    if (cmax <= 0.0) return false;
+
+    int exponent;
+    std::frexp(cmax, &exponent);
+    shift = std::clamp(QLP_PRECISION - 1 - exponent, 0, 15);
+
+    // Round with error feedback so the quantization error does not accumulate
+    const int qmax = (1 << (QLP_PRECISION - 1)) - 1;
+    const int qmin = -(1 << (QLP_PRECISION - 1));
+    double carry = 0.0;
+    for (int j = 0; j < LPC_ORDER; j++) {
+        carry += a[j] * (1 << shift);
+        const long q = std::clamp<long>(std::lround(carry), qmin, qmax);
+        coeffs[j] = static_cast<int16_t>(q);
+        carry -= static_cast<double>(q);
+    }
+    return true;
+}
+
+// Residual of the order-8 LPC predictor for i in [LPC_ORDER, n)
+void lpc_residual(const int16_t* x, uint32_t n, const int16_t* coeffs, int shift, int32_t* r) {
+    uint32_t i = LPC_ORDER;
+#if defined(SECUREVOX_FLAC_SSE2)
+    // Eight outputs per step: samples at lags j and j+1 are interleaved and
+    // multiplied against a coefficient pair with one pmaddwd
+    __m128i pairs[LPC_ORDER / 2];
+    for (int p = 0; p < LPC_ORDER / 2; p++) {
+        const uint32_t packed = static_cast<uint16_t>(coeffs[2 * p]) |
+                                (static_cast<uint32_t>(static_cast<uint16_t>(coeffs[2 * p + 1])) << 16);
+        pairs[p] = _mm_set1_epi32(static_cast<int>(packed));
+    }
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    for (; i + 8 <= n; i += 8) {
+        __m128i lo = _mm_setzero_si128();
+        __m128i hi = _mm_setzero_si128();
+        for (int p = 0; p < LPC_ORDER / 2; p++) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i - 1 - 2 * p));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i - 2 - 2 * p));
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), pairs[p]));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), pairs[p]));
+        }
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+        const __m128i v_lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i v_hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(r + i), _mm_sub_epi32(v_lo, _mm_sra_epi32(lo, count)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(r + i + 4), _mm_sub_epi32(v_hi, _mm_sra_epi32(hi, count)));
+    }
+#elif defined(SECUREVOX_FLAC_NEON)
+    const int32x4_t neg_shift = vdupq_n_s32(-shift);
+    for (; i + 4 <= n; i += 4) {
+        int32x4_t acc = vdupq_n_s32(0);
+        for (int j = 0; j < LPC_ORDER; j++) {
+            acc = vmlal_n_s16(acc, vld1_s16(x + i - 1 - j), coeffs[j]);
+        }
+        const int32x4_t v = vmovl_s16(vld1_s16(x + i));
+        vst1q_s32(r + i, vsubq_s32(v, vshlq_s32(acc, neg_shift)));
+    }
+#endif
+    for (; i < n; i++) {
+        int32_t sum = 0;
+        for (int j = 0; j < LPC_ORDER; j++) sum += coeffs[j] * x[i - 1 - j];
+        r[i] = x[i] - (sum >> shift);
+    }
+}
+
+struct RicePlan {
+    int partition_order = 0;
+    uint8_t params[1 << MAX_PARTITION_ORDER] = {};
+    uint64_t bits = 0;
+};
+
+// Cheapest partitioning and Rice parameters for r[order, n), with its size in bits
+void plan_rice(const int32_t* r, uint32_t n, int order, RicePlan& plan) {
+    int max_order = 0;
+    while (max_order < MAX_PARTITION_ORDER && (n % (2u << max_order)) == 0 &&
+           (n >> (max_order + 1)) > static_cast<uint32_t>(order)) {
+        max_order++;
+    }
+
+    // Sums of the zigzagged residual per partition at the finest order, merged
+    // pairwise for the coarser ones
+    uint64_t sums[1 << MAX_PARTITION_ORDER] = {};
+    const uint32_t finest = n >> max_order;
+    for (uint32_t i = static_cast<uint32_t>(order); i < n; i++) sums[i / finest] += zigzag(r[i]);
+
+    plan.bits = UINT64_MAX;
+    for (int p = max_order; p >= 0; p--) {
+        const uint32_t partitions = 1u << p;
+        const uint32_t per = n >> p;
+        uint64_t bits = 2 + 4;  // coding method, partition order
+        uint8_t params[1 << MAX_PARTITION_ORDER];
+        for (uint32_t q = 0; q < partitions; q++) {
+            const uint64_t count = q == 0 ? per - order : per;
+            uint64_t best = UINT64_MAX;
+            for (uint32_t k = 0; k <= MAX_RICE_PARAM; k++) {
+                const uint64_t cost = count * (k + 1) + (sums[q] >> k);
+                if (cost < best) {
+                    best = cost;
+                    params[q] = static_cast<uint8_t>(k);
+                }
+            }
+            bits += 4 + best;
+        }
+        if (bits < plan.bits) {
+            plan.bits = bits;
+            plan.partition_order = p;
+            std::copy(params, params + partitions, plan.params);
+        }
+        for (uint32_t q = 0; q < partitions / 2; q++) sums[q] = sums[2 * q] + sums[2 * q + 1];
+    }
+}
+
+void write_residual(BitWriter& w, const int32_t* r, uint32_t n, int order, const RicePlan& plan) {
+    w.put(0, 2);  // 4-bit Rice parameters
+    w.put(static_cast<uint32_t>(plan.partition_order), 4);
+    const uint32_t per = n >> plan.partition_order;
+    for (uint32_t q = 0; q < (1u << plan.partition_order); q++) {
+        const uint32_t k = plan.params[q];
+        w.put(k, 4);
+        const uint32_t begin = q == 0 ? static_cast<uint32_t>(order) : q * per;
+        const uint32_t end = (q + 1) * per;
+        for (uint32_t i = begin; i < end; i++) w.put_rice(zigzag(r[i]), k);
+    }
+}
+
+// Byte-at-a-time bit reader over a file. Bytes are only pulled when a read
+// needs them, so the CRCs over pulled bytes cover exactly what was consumed
+// once the reader is byte-aligned.
+class BitReader {
+public:
+    explicit BitReader(FILE* f) : file_(f), buffer_(READ_BLOCK_BYTES) {}
+
+    bool eof() const { return eof_; }
+
+    void reset_crc() {
+        crc8_ = 0;
+        crc16_ = 0;
+    }
+    uint8_t crc8() const { return crc8_; }
+    uint16_t crc16() const { return crc16_; }
+
+    // True when the next read would hit the end of the file
+    bool at_end() {
+        if (pos_ < end_) return false;
+        refill();
+        return end_ == 0;
+    }
+
+    uint32_t read(int bits) {
+        while (bits_ < bits) {
+            cache_ = (cache_ << 8) | next_byte();
+            bits_ += 8;
+        }
+        bits_ -= bits;
+        return static_cast<uint32_t>(cache_ >> bits_) & low_bits(bits);
+    }
+
+    int32_t read_signed(int bits) {
+        if (bits == 0) return 0;
+        const uint32_t v = read(bits);
+        const uint32_t sign = 1u << (bits - 1);
+        return static_cast<int32_t>((v ^ sign) - sign);
+    }
+
+    uint64_t read_u64(int bits) {
+        if (bits <= 32) return read(bits);
+        const uint64_t high = read(bits - 32);
+        return (high << 32) | read(32);
+    }
+
+    // Zeros before the next one bit
+    uint32_t read_unary() {
+        uint32_t zeros = 0;
+        for (;;) {
+            if (bits_ == 0) {
+                cache_ = (cache_ << 8) | next_byte();
+                bits_ = 8;
+                if (eof_) return zeros;
+            }
+            const uint32_t window = static_cast<uint32_t>(cache_) & low_bits(bits_);
+            if (window == 0) {
+                zeros += static_cast<uint32_t>(bits_);
+                bits_ = 0;
+                continue;
+            }
+            int top = bits_ - 1;
+            while (((window >> top) & 1) == 0) top--;
+            zeros += static_cast<uint32_t>(bits_ - 1 - top);
+            bits_ = top;
+            return zeros;
+        }
+    }
+
+    void align() { bits_ -= bits_ % 8; }
+
+    // Skip whole bytes; the reader must be aligned
+    void skip(uint64_t bytes) {
+        bits_ = 0;
+        const uint64_t buffered = std::min<uint64_t>(bytes, end_ - pos_);
+        pos_ += static_cast<size_t>(buffered);
+        bytes -= buffered;
+        if (bytes > 0 && std::fseek(file_, static_cast<long>(bytes), SEEK_CUR) != 0) eof_ = true;
+    }
+
+private:
+    void refill() {
+        pos_ = 0;
+        end_ = std::fread(buffer_.data(), 1, buffer_.size(), file_);
+    }
+
+    uint8_t next_byte() {
+        if (pos_ == end_) {
+            refill();
+            if (end_ == 0) {
+                eof_ = true;
+                return 0;
+            }
+        }
+        const uint8_t byte = buffer_[pos_++];
+        const CrcTables& t = crc_tables();
+        crc8_ = t.crc8[crc8_ ^ byte];
+        crc16_ = static_cast<uint16_t>((crc16_ << 8) ^ t.crc16[(crc16_ >> 8) ^ byte]);
+        return byte;
+    }
+
+    FILE* file_;
+    std::vector<uint8_t> buffer_;
+    size_t pos_ = 0;
+    size_t end_ = 0;
+    uint64_t cache_ = 0;
+    int bits_ = 0;
+    bool eof_ = false;
+    uint8_t crc8_ = 0;
+    uint16_t crc16_ = 0;
+};
+
+bool decode_residual(BitReader& in, uint32_t n, int order, int32_t* out) {
+    const uint32_t method = in.read(2);
+    if (method > 1) return false;
+    const int param_bits = method == 0 ? 4 : 5;
+    const uint32_t escape = method == 0 ? 15 : 31;
+
+    const int partition_order = static_cast<int>(in.read(4));
+    const uint32_t per = n >> partition_order;
+    if ((per << partition_order) != n || per < static_cast<uint32_t>(order)) return false;
+
+    uint32_t i = static_cast<uint32_t>(order);
+    for (uint32_t q = 0; q < (1u << partition_order); q++) {
+        const uint32_t end = (q + 1) * per;
+        const uint32_t k = in.read(param_bits);
+        if (k == escape) {
+            const int bits = static_cast<int>(in.read(5));
+            for (; i < end; i++) out[i] = in.read_signed(bits);
+        } else {
+            for (; i < end; i++) {
+                const uint32_t u = (in.read_unary() << k) | in.read(static_cast<int>(k));
+                out[i] = static_cast<int32_t>(u >> 1) ^ -static_cast<int32_t>(u & 1);
+            }
+        }
+        if (in.eof()) return false;
+    }
+    return true;
+}
+
+bool decode_subframe(BitReader& in, int bps, uint32_t n, int32_t* out) {
+    if (in.read(1) != 0) return false;
+    const uint32_t type = in.read(6);
+    int wasted = 0;
+    if (in.read(1) != 0) {
+        wasted = static_cast<int>(in.read_unary()) + 1;
+        bps -= wasted;
+        if (bps <= 0) return false;
+    }
+
+    if (type == 0) {
+        std::fill(out, out + n, in.read_signed(bps));
+    } else if (type == 1) {
+        for (uint32_t i = 0; i < n; i++) out[i] = in.read_signed(bps);
+    } else if (type >= 8 && type <= 12) {
+        const int order = static_cast<int>(type - 8);
+        if (static_cast<uint32_t>(order) > n) return false;
+        for (int i = 0; i < order; i++) out[i] = in.read_signed(bps);
+        if (!decode_residual(in, n, order, out)) return false;
+        // 64-bit so damaged input (checked by CRC only afterwards) cannot overflow
+        for (uint32_t i = static_cast<uint32_t>(order); i < n; i++) {
+            int64_t prediction = 0;
+            switch (order) {
+                case 1: prediction = out[i - 1]; break;
+                case 2: prediction = 2LL * out[i - 1] - out[i - 2]; break;
+                case 3: prediction = 3LL * out[i - 1] - 3LL * out[i - 2] + out[i - 3]; break;
+                case 4: prediction = 4LL * out[i - 1] - 6LL * out[i - 2] + 4LL * out[i - 3] - out[i - 4]; break;
+                default: break;
+            }
+            out[i] = static_cast<int32_t>(out[i] + prediction);
+        }
+    } else if (type >= 32) {
+        const int order = static_cast<int>(type - 31);
+        if (static_cast<uint32_t>(order) > n) return false;
+        for (int i = 0; i < order; i++) out[i] = in.read_signed(bps);
+        const int precision = static_cast<int>(in.read(4)) + 1;
+        const int shift = in.read_signed(5);
+        if (precision == 16 || shift < 0) return false;
+        int32_t coeffs[32];
+        for (int j = 0; j < order; j++) coeffs[j] = in.read_signed(precision);
+        if (!decode_residual(in, n, order, out)) return false;
+        for (uint32_t i = static_cast<uint32_t>(order); i < n; i++) {
+            int64_t sum = 0;
+            for (int j = 0; j < order; j++) sum += static_cast<int64_t>(coeffs[j]) * out[i - 1 - j];
+            out[i] = static_cast<int32_t>(out[i] + (sum >> shift));
+        }
+    } else {
+        return false;  // reserved
+    }
+
+    if (wasted > 0) {
+        for (uint32_t i = 0; i < n; i++) out[i] = static_cast<int32_t>(static_cast<uint32_t>(out[i]) << wasted);
+    }
+    return !in.eof();
+}
+
+} // namespace
+
+FlacEncoder::~FlacEncoder() {
+    if (file_ != nullptr) {
+        std::string error;
+        finish(error);
+    }
+}
+
+bool FlacEncoder::open(const std::string& path, int sample_rate, std::string& error) {
+    if (file_ != nullptr) {
+        error = "FLAC encoder already open";
+        return false;
+    }
+    if (sample_rate <= 0 || sample_rate > 655350) {
+        error = "Invalid sample rate: " + std::to_string(sample_rate);
+        return false;
+    }
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+        error = "Cannot create FLAC file: " + path;
+        return false;
+    }
+    path_ = path;
+    sample_rate_ = sample_rate;
+    total_samples_ = 0;
+    frame_number_ = 0;
+    min_frame_bytes_ = 0;
+    max_frame_bytes_ = 0;
+    failed_ = false;
+    pending_.clear();
+    pending_.reserve(FLAC_BLOCK_SIZE);
+
+    // Length and frame sizes unknown until finish(); zero means "unknown"
+    if (std::fwrite(STREAM_HEADER, 1, sizeof(STREAM_HEADER), file_) != sizeof(STREAM_HEADER) ||
+        !write_stream_info()) {
+        std::fclose(file_);
+        file_ = nullptr;
+        error = "Cannot write FLAC header: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool FlacEncoder::append(const int16_t* samples, size_t n) {
+    if (file_ == nullptr || failed_) return false;
+
+    while (n > 0) {
+        // Whole blocks straight from the caller's buffer
+        if (pending_.empty() && n >= FLAC_BLOCK_SIZE) {
+            if (!write_frame(samples, FLAC_BLOCK_SIZE)) return false;
+            samples += FLAC_BLOCK_SIZE;
+            n -= FLAC_BLOCK_SIZE;
+            continue;
+        }
+        const size_t take = std::min<size_t>(n, FLAC_BLOCK_SIZE - pending_.size());
+        pending_.insert(pending_.end(), samples, samples + take);
+        samples += take;
+        n -= take;
+        if (pending_.size() == FLAC_BLOCK_SIZE) {
+            if (!write_frame(pending_.data(), FLAC_BLOCK_SIZE)) return false;
+            pending_.clear();
+        }
+    }
+    return true;
+}
+
+bool FlacEncoder::finish(std::string& error) {
+    if (file_ == nullptr) {
+        error = "FLAC encoder not open";
+        return false;
+    }
+    if (!pending_.empty() && !failed_) {
+        write_frame(pending_.data(), static_cast<uint32_t>(pending_.size()));
+        pending_.clear();
+    }
+
+    bool ok = !failed_ && std::fseek(file_, sizeof(STREAM_HEADER), SEEK_SET) == 0 && write_stream_info();
+    ok = std::fclose(file_) == 0 && ok;
+    file_ = nullptr;
+    if (!ok) error = "Cannot write FLAC file: " + path_;
+    return ok;
+}
+
+bool FlacEncoder::write_stream_info() {
+    std::vector<uint8_t> info;
+    info.reserve(STREAM_INFO_BYTES);
+    BitWriter w(info);
+    w.put(FLAC_BLOCK_SIZE, 16);  // min block size (the last block may be shorter)
+    w.put(FLAC_BLOCK_SIZE, 16);  // max block size
+    w.put(min_frame_bytes_, 24);
+    w.put(max_frame_bytes_, 24);
+    w.put(static_cast<uint32_t>(sample_rate_), 20);
+    w.put(0, 3);  // channels - 1
+    w.put(BITS_PER_SAMPLE - 1, 5);
+    w.put(static_cast<uint32_t>(total_samples_ >> 32), 4);
+    w.put(static_cast<uint32_t>(total_samples_), 32);
+    for (int i = 0; i < 4; i++) w.put(0, 32);  // MD5 not computed
+    return std::fwrite(info.data(), 1, info.size(), file_) == info.size();
+}
+
+bool FlacEncoder::write_frame(const int16_t* block, uint32_t n) {
+    residual_.resize(n);
+    best_residual_.resize(n);
+
+    // Pick the subframe coding with the fewest bits; verbatim is the fallback
+    enum class Coding { Constant, Verbatim, Fixed, Lpc };
+    Coding coding = Coding::Verbatim;
+    uint64_t best_bits = 8 + static_cast<uint64_t>(BITS_PER_SAMPLE) * n;
+    int order = 0;
+    RicePlan best_plan;
+    int16_t coeffs[LPC_ORDER] = {};
+    int shift = 0;
+
+    if (std::all_of(block, block + n, [&](int16_t v) { return v == block[0]; })) {
+        coding = Coding::Constant;
+    } else if (n >= MIN_PREDICTED_BLOCK) {
+        RicePlan plan;
+        for (int o = 0; o <= MAX_FIXED_ORDER; o++) {
+            fixed_residual(block, n, o, residual_.data());
+            plan_rice(residual_.data(), n, o, plan);
+            const uint64_t bits = 8 + static_cast<uint64_t>(BITS_PER_SAMPLE) * o + plan.bits;
+            if (bits < best_bits) {
+                best_bits = bits;
+                coding = Coding::Fixed;
+                order = o;
+                best_plan = plan;
+                residual_.swap(best_residual_);
+            }
+        }
+
+        int16_t lpc[LPC_ORDER];
+        int lpc_shift = 0;
+        if (compute_lpc(block, n, lpc, lpc_shift)) {
+            lpc_residual(block, n, lpc, lpc_shift, residual_.data());
+            plan_rice(residual_.data(), n, LPC_ORDER, plan);
+            const uint64_t bits = 8 + static_cast<uint64_t>(BITS_PER_SAMPLE) * LPC_ORDER + 4 + 5 +
+                                  static_cast<uint64_t>(QLP_PRECISION) * LPC_ORDER + plan.bits;
+            if (bits < best_bits) {
+                best_bits = bits;
+                coding = Coding::Lpc;
+                order = LPC_ORDER;
+                best_plan = plan;
+                std::copy(lpc, lpc + LPC_ORDER, coeffs);
+                shift = lpc_shift;
+                residual_.swap(best_residual_);
+            }
+        }
+    }
+
+    frame_.clear();
+    BitWriter w(frame_);
+
+    // Frame header: fixed block size, rate and bit depth from STREAMINFO, mono
+    const uint32_t size_code = block_size_code(n);
+    w.put(0x3FFE, 14);
+    w.put(0, 1);
+    w.put(0, 1);
+    w.put(size_code, 4);
+    w.put(0, 4);
+    w.put(0, 4);
+    w.put(4, 3);  // 16 bits per sample
+    w.put(0, 1);
+    put_utf8(w, frame_number_);
+    if (size_code == 6) w.put(n - 1, 8);
+    if (size_code == 7) w.put(n - 1, 16);
+    w.put(crc8(frame_.data(), frame_.size()), 8);
+
+    // Subframe header: zero pad, type, no wasted bits
+    switch (coding) {
+        case Coding::Constant:
+            w.put(0, 8);
+            w.put_signed(block[0], BITS_PER_SAMPLE);
+            break;
+        case Coding::Verbatim:
+            w.put(1 << 1, 8);
+            for (uint32_t i = 0; i < n; i++) w.put_signed(block[i], BITS_PER_SAMPLE);
+            break;
+        case Coding::Fixed:
+            w.put(static_cast<uint32_t>(8 | order) << 1, 8);
+            for (int i = 0; i < order; i++) w.put_signed(block[i], BITS_PER_SAMPLE);
+            write_residual(w, best_residual_.data(), n, order, best_plan);
+            break;
+        case Coding::Lpc:
+            w.put(static_cast<uint32_t>(32 | (order - 1)) << 1, 8);
+            for (int i = 0; i < order; i++) w.put_signed(block[i], BITS_PER_SAMPLE);
+            w.put(QLP_PRECISION - 1, 4);
+            w.put_signed(shift, 5);
+            for (int j = 0; j < order; j++) w.put_signed(coeffs[j], QLP_PRECISION);
+            write_residual(w, best_residual_.data(), n, order, best_plan);
+            break;
+    }
+
+    w.align();
+    const uint16_t crc = crc16(frame_.data(), frame_.size());
+    w.put(crc, 16);
+
+    // Flushed per frame so a killed recorder loses at most the block in flight
+    if (std::fwrite(frame_.data(), 1, frame_.size(), file_) != frame_.size() || std::fflush(file_) != 0) {
+        failed_ = true;
+        return false;
+    }
+
+    const uint32_t bytes = static_cast<uint32_t>(frame_.size());
+    min_frame_bytes_ = min_frame_bytes_ == 0 ? bytes : std::min(min_frame_bytes_, bytes);
+    max_frame_bytes_ = std::max(max_frame_bytes_, bytes);
+    total_samples_ += n;
+    frame_number_++;
+    return true;
+}
+
+bool load_flac(const std::string& path, AudioData& out, std::string& error) {
+    std::unique_ptr<FILE, FileCloser> file(std::fopen(path.c_str(), "rb"));
+    if (!file) {
+        error = "Cannot open audio file: " + path;
+        return false;
+    }
+
+    std::fseek(file.get(), 0, SEEK_END);
+    const long file_bytes = std::ftell(file.get());
+    std::fseek(file.get(), 0, SEEK_SET);
+
+    BitReader in(file.get());
+    if (in.read(32) != 0x664C6143u) {  // "fLaC"
+        error = "Not a FLAC file: " + path;
+        return false;
+    }
+
+    int sample_rate = 0;
+    int stream_bps = 0;
+    uint64_t total_samples = 0;
+    bool last = false;
+    while (!last) {
+        last = in.read(1) != 0;
+        const uint32_t type = in.read(7);
+        const uint32_t length = in.read(24);
+        if (in.eof() || type == 127) {
+            error = "Invalid FLAC metadata";
+            return false;
+        }
+        if (type == 0 && length >= STREAM_INFO_BYTES) {
+            in.read(16);  // min block size
+            in.read(16);  // max block size
+            in.read(24);  // min frame size
+            in.read(24);  // max frame size
+            sample_rate = static_cast<int>(in.read(20));
+            in.read(3);   // channels, taken per frame
+            stream_bps = static_cast<int>(in.read(5)) + 1;
+            total_samples = in.read_u64(36);
+            in.skip(16 + length - STREAM_INFO_BYTES);  // MD5 and anything newer
+        } else {
+            in.skip(length);
+        }
+    }
+    if (sample_rate <= 0) {
+        error = "FLAC file without STREAMINFO";
+        return false;
+    }
+
+    out.sample_rate = sample_rate;
+    out.samples.clear();
+    // The header length is only a hint; a damaged one must not allocate gigabytes
+    const uint64_t plausible = static_cast<uint64_t>(std::max(file_bytes, 0L)) * 8;
+    if (total_samples > 0) out.samples.reserve(static_cast<size_t>(std::min(total_samples, plausible)));
+
+    static constexpr int SAMPLE_BITS[8] = {0, 8, 12, 0, 16, 20, 24, 32};
+    std::vector<int32_t> channels[8];
+    while (!in.at_end()) {
+        in.reset_crc();
+        const uint32_t sync = in.read(15);
+        in.read(1);  // blocking strategy; frame and sample numbers are not needed
+        if (sync != 0x7FFC) break;  // lost sync: keep what was decoded
+
+        const uint32_t size_code = in.read(4);
+        const uint32_t rate_code = in.read(4);
+        const uint32_t assignment = in.read(4);
+        const uint32_t bits_code = in.read(3);
+        in.read(1);
+
+        // Frame or sample number, UTF-8 style
+        uint32_t lead = in.read(8);
+        for (uint32_t mask = 0x40; (lead & 0x80) != 0 && (lead & mask) != 0; mask >>= 1) in.read(8);
+
+        uint32_t n = 0;
+        if (size_code == 1) n = 192;
+        else if (size_code >= 2 && size_code <= 5) n = 576u << (size_code - 2);
+        else if (size_code == 6) n = in.read(8) + 1;
+        else if (size_code == 7) n = in.read(16) + 1;
+        else if (size_code >= 8) n = 256u << (size_code - 8);
+
+        if (rate_code == 12) in.read(8);
+        else if (rate_code == 13 || rate_code == 14) in.read(16);
+
+        const uint8_t header_crc = in.crc8();
+        const int bps = bits_code == 0 ? stream_bps : SAMPLE_BITS[bits_code];
+        const uint32_t count = assignment < 8 ? assignment + 1 : 2;
+        if (in.read(8) != header_crc || n == 0 || rate_code == 15 || assignment > 10 || bps <= 0 || bps > 24) break;
+
+        bool ok = true;
+        for (uint32_t c = 0; c < count && ok; c++) {
+            const bool side = (assignment == 8 && c == 1) || (assignment == 9 && c == 0) || (assignment == 10 && c == 1);
+            channels[c].resize(n);
+            ok = decode_subframe(in, bps + (side ? 1 : 0), n, channels[c].data());
+        }
+        in.align();
+        const uint16_t frame_crc = in.crc16();
+        if (!ok || in.read(16) != frame_crc || in.eof()) break;
+
+        int32_t* a = channels[0].data();
+        int32_t* b = channels[1].data();
+        for (uint32_t i = 0; assignment >= 8 && i < n; i++) {
+            if (assignment == 8) {
+                b[i] = static_cast<int32_t>(static_cast<int64_t>(a[i]) - b[i]);
+            } else if (assignment == 9) {
+                a[i] = static_cast<int32_t>(static_cast<int64_t>(a[i]) + b[i]);
+            } else {
+                const int64_t mid = static_cast<int64_t>(a[i]) * 2 + (b[i] & 1);
+                const int64_t side = b[i];
+                a[i] = static_cast<int32_t>((mid + side) >> 1);
+                b[i] = static_cast<int32_t>((mid - side) >> 1);
+            }
+        }
+
+        const float scale = 1.0f / static_cast<float>(1u << (bps - 1)) / static_cast<float>(count);
+        const size_t base = out.samples.size();
+        out.samples.resize(base + n);
+        float* dst = out.samples.data() + base;
+        for (uint32_t i = 0; i < n; i++) {
+            int64_t sum = 0;
+            for (uint32_t c = 0; c < count; c++) sum += channels[c][i];
+            dst[i] = static_cast<float>(sum) * scale;
+        }
+    }
+    return true;
+}
+
+bool convert_wav_to_flac(const std::string& wav_path, const std::string& flac_path, std::string& error) {
+    std::unique_ptr<FILE, FileCloser> wav(std::fopen(wav_path.c_str(), "rb"));
+    if (!wav) {
+        error = "Cannot open audio file: " + wav_path;
+        return false;
+    }
+
+    WavFormat format;
+    if (!read_wav_header(wav.get(), format, error)) return false;
+    if (format.is_float || format.bits != 16 || format.channels != 1) {
+        error = "Only 16-bit mono WAV converts losslessly";
+        return false;
+    }
+
+    const std::string tmp = flac_path + ".tmp";
+    FlacEncoder encoder;
+    if (!encoder.open(tmp, format.sample_rate, error)) return false;
+
+    // WAV data is little-endian, like both supported hosts
+    std::vector<int16_t> block(READ_BLOCK_BYTES / sizeof(int16_t));
+    uint64_t remaining = format.data_bytes / sizeof(int16_t);
+    bool ok = true;
+    while (remaining > 0 && ok) {
+        const size_t want = static_cast<size_t>(std::min<uint64_t>(remaining, block.size()));
+        const size_t got = std::fread(block.data(), sizeof(int16_t), want, wav.get());
+        if (got == 0) break;
+        ok = encoder.append(block.data(), got);
+        remaining -= got;
+    }
+    if (!encoder.finish(error) || !ok) {
+        std::remove(tmp.c_str());
+        if (error.empty()) error = "Cannot write FLAC file: " + tmp;
+        return false;
+    }
+
+#ifdef _WIN32
+    std::remove(flac_path.c_str());  // rename does not replace on Windows
+#endif
+    if (std::rename(tmp.c_str(), flac_path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        error = "Cannot replace FLAC file: " + flac_path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace securevox
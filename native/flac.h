@@ -0,0 +1,75 @@
+#pragma once
+
+#include "audio_decoder.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace securevox {
+
+// Samples per FLAC frame written by FlacEncoder (256 ms at 16 kHz)
+constexpr uint32_t FLAC_BLOCK_SIZE = 4096;
+
+// Streaming lossless encoder for mono 16-bit PCM, e.g. microphone capture.
+//
+// Writes fixed-size blocks: each is coded with the cheapest of a constant,
+// fixed polynomial predictors and an order-8 LPC predictor (residual computed
+// with SSE2/NEON), followed by partitioned Rice coding of the residual. Speech
+// comes out at roughly half the size of the WAV.
+//
+// Frames are flushed as they complete, so a recorder killed mid-write leaves a
+// file that decodes up to its last whole frame; finish() fills in the stream
+// length. The STREAMINFO MD5 is left zero ("not computed").
+class FlacEncoder {
+public:
+    FlacEncoder() = default;
+    ~FlacEncoder();
+
+    FlacEncoder(const FlacEncoder&) = delete;
+    FlacEncoder& operator=(const FlacEncoder&) = delete;
+
+    bool open(const std::string& path, int sample_rate, std::string& error);
+
+    // Buffer samples and encode every block they complete. False after a
+    // write error.
+    bool append(const int16_t* samples, size_t n);
+
+    // Encode the last partial block and rewrite the stream header
+    bool finish(std::string& error);
+
+    uint64_t samples_written() const { return total_samples_; }
+
+private:
+    bool write_frame(const int16_t* block, uint32_t n);
+    bool write_stream_info();
+
+    FILE* file_ = nullptr;
+    std::string path_;
+    int sample_rate_ = 0;
+    uint64_t total_samples_ = 0;
+    uint64_t frame_number_ = 0;
+    uint32_t min_frame_bytes_ = 0;
+    uint32_t max_frame_bytes_ = 0;
+    bool failed_ = false;
+
+    std::vector<int16_t> pending_;
+    std::vector<int32_t> residual_;
+    std::vector<int32_t> best_residual_;
+    std::vector<uint8_t> frame_;
+};
+
+// Decode a FLAC file (any channel count, 8-24 bits, fixed or variable block
+// size) downmixed to mono. Frames are decoded one at a time straight into
+// out.samples; a truncated or damaged tail ends the stream like a killed
+// recording ends a WAV.
+bool load_flac(const std::string& path, AudioData& out, std::string& error);
+
+// Losslessly re-encode a 16-bit mono PCM WAV file as FLAC, streaming the
+// samples through. Other WAV encodings are refused, as they would not
+// round-trip.
+bool convert_wav_to_flac(const std::string& wav_path, const std::string& flac_path, std::string& error);
+
+} // namespace securevox
@@ -0,0 +1,71 @@
+#include "incremental.h"
+
+#include "resampler.h"
+
+#include <algorithm>
+
+namespace securevox {
+
+namespace {
+
+int64_t samples_to_ms(int64_t samples) {
+    return samples * 1000 / MODEL_SAMPLE_RATE;
+}
+
+} // namespace
+
+IncrementalPlan plan_incremental(const std::vector<Segment>& previous, const AudioEdit& edit,
+                                 int64_t new_n_samples, int64_t margin_ms) {
+    IncrementalPlan plan;
+
+    const int64_t edit_start_ms = samples_to_ms(edit.start_sample);
+    const int64_t old_edit_end_ms = samples_to_ms(edit.start_sample + edit.removed_samples);
+    const int64_t new_edit_end_ms = samples_to_ms(edit.start_sample + edit.inserted_samples);
+    const int64_t shift_ms = new_edit_end_ms - old_edit_end_ms;
+    const int64_t new_total_ms = samples_to_ms(new_n_samples);
+
+    // Keep leading segments up to the first one near the edit
+    size_t first_redo = 0;
+    while (first_redo < previous.size() && previous[first_redo].end_ms <= edit_start_ms - margin_ms) {
+        first_redo++;
+    }
+
+    // Keep trailing segments back to the last one near the edit
+    size_t last_redo = previous.size();
+    while (last_redo > first_redo && previous[last_redo - 1].start_ms >= old_edit_end_ms + margin_ms) {
+        last_redo--;
+    }
+
+    plan.before.assign(previous.begin(), previous.begin() + first_redo);
+    for (size_t i = last_redo; i < previous.size(); i++) {
+        Segment segment = previous[i];
+        segment.start_ms += shift_ms;
+        segment.end_ms += shift_ms;
+        // A kept segment can only fall off the end if the caller's edit was inconsistent
+        if (segment.end_ms > new_total_ms) break;
+        plan.after.push_back(std::move(segment));
+    }
+
+    plan.redo_start_ms = plan.before.empty() ? 0 : plan.before.back().end_ms;
+    plan.redo_end_ms = plan.after.empty() ? new_total_ms : plan.after.front().start_ms;
+    plan.redo_end_ms = std::max(plan.redo_start_ms, std::min(plan.redo_end_ms, new_total_ms));
+    return plan;
+}
+
+std::vector<Segment> splice_segments(const IncrementalPlan& plan, std::vector<Segment> redone) {
+    std::vector<Segment> result;
+    result.reserve(plan.before.size() + redone.size() + plan.after.size());
+    result.insert(result.end(), plan.before.begin(), plan.before.end());
+
+    for (Segment& segment : redone) {
+        if (segment.start_ms >= plan.redo_end_ms) break;
+        segment.start_ms = std::max(segment.start_ms, plan.redo_start_ms);
+        segment.end_ms = std::min(segment.end_ms, plan.redo_end_ms);
+        result.push_back(std::move(segment));
+    }
+
+    result.insert(result.end(), plan.after.begin(), plan.after.end());
+    return result;
+}
+
+} // namespace securevox
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "segment.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace securevox {
+
+// An edit to a recording's 16kHz samples: the old range
+// [start_sample, start_sample + removed_samples) was replaced by
+// inserted_samples new ones. Appending is an edit at the old end with nothing
+// removed; trimming removes samples and inserts none.
+struct AudioEdit {
+    int64_t start_sample = 0;
+    int64_t removed_samples = 0;
+    int64_t inserted_samples = 0;
+};
+
+// Which part of the previous transcript survives an edit and what to redo
+struct IncrementalPlan {
+    std::vector<Segment> before;  // untouched segments ahead of the edit
+    std::vector<Segment> after;   // untouched segments past the edit, shifted to the new timeline
+    int64_t redo_start_ms = 0;    // range to transcribe again, in the new timeline
+    int64_t redo_end_ms = 0;
+
+    bool needs_inference() const { return redo_end_ms > redo_start_ms; }
+};
+
+// Work out the smallest range of the edited audio that must be transcribed
+// again. Segments within margin_ms of the edit are redone as well, since
+// whisper may place a boundary differently once the surrounding audio changes.
+// The redo range starts and ends on kept segment boundaries so the spliced
+// timeline has no gaps or overlaps.
+IncrementalPlan plan_incremental(const std::vector<Segment>& previous, const AudioEdit& edit,
+                                 int64_t new_n_samples, int64_t margin_ms = 1000);
+
+// Merge redone segments (already in the new timeline) between the kept ones.
+// Anything whisper emitted past the redo range is clipped so it cannot
+// overlap the kept tail.
+std::vector<Segment> splice_segments(const IncrementalPlan& plan, std::vector<Segment> redone);
+
+} // namespace securevox
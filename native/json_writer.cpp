@@ -0,0 +1,186 @@
+#include "json_writer.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace securevox {
+
+namespace {
+
+const char HEX[] = "0123456789abcdef";
+
+// Length of the valid UTF-8 sequence at s (1-4), or 0 if it is malformed
+size_t utf8_sequence(const uint8_t* s, size_t n, uint32_t& cp) {
+    const uint8_t b0 = s[0];
+    size_t len;
+    uint32_t min;
+    if (b0 < 0x80) {
+        cp = b0;
+        return 1;
+    } else if ((b0 & 0xE0) == 0xC0) {
+        len = 2; cp = b0 & 0x1F; min = 0x80;
+    } else if ((b0 & 0xF0) == 0xE0) {
+        len = 3; cp = b0 & 0x0F; min = 0x800;
+    } else if ((b0 & 0xF8) == 0xF0) {
+        len = 4; cp = b0 & 0x07; min = 0x10000;
+    } else {
+        return 0;
+    }
+    if (len > n) return 0;
+    for (size_t i = 1; i < len; i++) {
+        if ((s[i] & 0xC0) != 0x80) return 0;
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return 0;
+    return len;
+}
+
+} // namespace
+
+JsonWriter::JsonWriter(size_t reserve, bool escape_supplementary, Arena* arena)
+    : arena_(arena), escape_supplementary_(escape_supplementary) {
+    capacity_ = reserve > 16 ? reserve : 16;
+    data_ = arena_ != nullptr
+        ? static_cast<char*>(arena_->allocate(capacity_, 1))
+        : static_cast<char*>(std::malloc(capacity_));
+    if (data_ == nullptr) {
+        capacity_ = 0;
+        ok_ = false;
+        return;
+    }
+    data_[0] = '\0';
+}
+
+JsonWriter::~JsonWriter() {
+    if (arena_ == nullptr) std::free(data_);
+}
+
+bool JsonWriter::grow(size_t extra) {
+    if (!ok_) return false;
+    size_t capacity = capacity_ * 2;
+    if (capacity < size_ + extra + 1) capacity = size_ + extra + 1;
+    char* data;
+    if (arena_ != nullptr) {
+        // The old buffer stays in the arena until reset; a good reserve avoids this
+        data = static_cast<char*>(arena_->allocate(capacity, 1));
+        std::memcpy(data, data_, size_ + 1);
+    } else {
+        data = static_cast<char*>(std::realloc(data_, capacity));
+        if (data == nullptr) {
+            ok_ = false;
+            return false;
+        }
+    }
+    data_ = data;
+    capacity_ = capacity;
+    return true;
+}
+
+void JsonWriter::put(const char* s, size_t n) {
+    if (size_ + n >= capacity_ && !grow(n)) return;
+    std::memcpy(data_ + size_, s, n);
+    size_ += n;
+    data_[size_] = '\0';
+}
+
+void JsonWriter::put_literal(const char* s) {
+    put(s, std::strlen(s));
+}
+
+void JsonWriter::put_int(int64_t value) {
+    char digits[21];
+    int n = 0;
+    // Negate as unsigned so INT64_MIN does not overflow
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    do {
+        digits[n++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) digits[n++] = '-';
+
+    char ordered[21];
+    for (int i = 0; i < n; i++) ordered[i] = digits[n - 1 - i];
+    put(ordered, static_cast<size_t>(n));
+}
+
+void JsonWriter::put_string(const char* text, size_t len) {
+    // Worst case is six output bytes per input byte plus the quotes
+    if (size_ + len * 6 + 2 >= capacity_ && !grow(len * 6 + 2)) return;
+
+    char* out = data_ + size_;
+    *out++ = '"';
+    const auto* s = reinterpret_cast<const uint8_t*>(text);
+    size_t i = 0;
+    while (i < len) {
+        const uint8_t c = s[i];
+        if (c >= 0x20 && c < 0x80) {
+            if (c == '"' || c == '\\') *out++ = '\\';
+            *out++ = static_cast<char>(c);
+            i++;
+            continue;
+        }
+        if (c < 0x20) {
+            *out++ = '\\';
+            switch (c) {
+                case '\n': *out++ = 'n'; break;
+                case '\r': *out++ = 'r'; break;
+                case '\t': *out++ = 't'; break;
+                case '\b': *out++ = 'b'; break;
+                case '\f': *out++ = 'f'; break;
+                default:
+                    *out++ = 'u'; *out++ = '0'; *out++ = '0';
+                    *out++ = HEX[c >> 4];
+                    *out++ = HEX[c & 0xF];
+            }
+            i++;
+            continue;
+        }
+
+        uint32_t cp;
+        const size_t n = utf8_sequence(s + i, len - i, cp);
+        if (n == 0) {
+            // U+FFFD, one per malformed byte
+            *out++ = '\xEF'; *out++ = '\xBF'; *out++ = '\xBD';
+            i++;
+        } else if (cp > 0xFFFF && escape_supplementary_) {
+            const uint32_t v = cp - 0x10000;
+            const uint32_t units[2] = { 0xD800 + (v >> 10), 0xDC00 + (v & 0x3FF) };
+            for (uint32_t unit : units) {
+                *out++ = '\\'; *out++ = 'u';
+                *out++ = HEX[(unit >> 12) & 0xF];
+                *out++ = HEX[(unit >> 8) & 0xF];
+                *out++ = HEX[(unit >> 4) & 0xF];
+                *out++ = HEX[unit & 0xF];
+            }
+            i += n;
+        } else {
+            std::memcpy(out, s + i, n);
+            out += n;
+            i += n;
+        }
+    }
+    *out++ = '"';
+    size_ = static_cast<size_t>(out - data_);
+    data_[size_] = '\0';
+}
+
+char* JsonWriter::release() {
+    char* data = data_;
+    data_ = nullptr;
+    size_ = 0;
+    capacity_ = 0;
+    ok_ = false;
+    return data;
+}
+
+void write_segment_json(JsonWriter& out, const char* text, size_t text_len, int64_t start_ms, int64_t end_ms) {
+    out.put_literal("{\"text\":");
+    out.put_string(text, text_len);
+    out.put_literal(",\"start\":");
+    out.put_int(start_ms);
+    out.put_literal(",\"end\":");
+    out.put_int(end_ms);
+    out.put('}');
+}
+
+} // namespace securevox
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "arena.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace securevox {
+
+// Appends JSON into one growing heap buffer.
+//
+// Strings are escaped in a single pass: quotes, backslashes and every control
+// character below 0x20 are escaped, and invalid UTF-8 (stray continuation
+// bytes, overlong forms, surrogates, truncated sequences) becomes U+FFFD, so
+// the output always parses. Integers are written with digit arithmetic.
+//
+// The buffer is kept NUL-terminated. It is malloc'd, and release() hands it to
+// the caller without copying, unless an arena is given; the JSON then lives in
+// the arena until its next reset.
+class JsonWriter {
+public:
+    // escape_supplementary writes code points above U+FFFF as \uXXXX surrogate
+    // pairs, which JNI's NewStringUTF (modified UTF-8) requires.
+    explicit JsonWriter(size_t reserve = 256, bool escape_supplementary = false, Arena* arena = nullptr);
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    void put(char c) {
+        if (size_ + 1 >= capacity_ && !grow(1)) return;
+        data_[size_++] = c;
+        data_[size_] = '\0';
+    }
+    void put(const char* s, size_t n);
+    void put_literal(const char* s);
+    void put_int(int64_t value);
+    // Quoted, escaped string from UTF-8 text
+    void put_string(const char* text, size_t len);
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    // False if an allocation failed; later writes are dropped
+    bool ok() const { return ok_; }
+
+    // Transfer the buffer to the caller, who frees it with std::free (or resets the arena)
+    char* release();
+
+private:
+    bool grow(size_t extra);
+
+    Arena* arena_;
+    char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+    bool escape_supplementary_;
+    bool ok_ = true;
+};
+
+// {"text":"...","start":<ms>,"end":<ms>}, the segment shape read by the app bindings
+void write_segment_json(JsonWriter& out, const char* text, size_t text_len, int64_t start_ms, int64_t end_ms);
+
+} // namespace securevox
@@ -0,0 +1,183 @@
+#include "memory_budget.h"
+
+#include "binary_io.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+namespace securevox {
+
+namespace {
+
+constexpr uint32_t GGML_MAGIC = 0x67676d6c;  // "ggml"
+
+constexpr uint64_t SAMPLE_RATE = 16000;
+constexpr uint64_t HOP_LENGTH = 160;
+// whisper_full pads the input with 30 s of silence before computing the mel
+constexpr uint64_t PAD_SAMPLES = 30 * SAMPLE_RATE;
+// BatchEncoder only takes audio that fits one window
+constexpr uint64_t WINDOW_SAMPLES = 30 * SAMPLE_RATE;
+
+constexpr uint64_t F16_BYTES = 2;  // KV cache element
+constexpr uint64_t F32_BYTES = 4;  // activations, PCM and mel
+
+// whisper_init_state pads the KV caches to a multiple of 256 positions and,
+// not knowing how many decoders will run, gives kv_self 3x the text context
+constexpr uint64_t KV_PAD = 256;
+constexpr uint64_t KV_SELF_FACTOR = 3;
+
+// Thread stack plus ggml's per-thread work rows
+constexpr uint64_t PER_THREAD_BYTES = 2ull << 20;
+
+// Allocator slack and graph bookkeeping the formula below does not itemise
+constexpr uint64_t OVERHEAD_PERCENT = 10;
+
+struct FileCloser {
+    void operator()(FILE* f) const { if (f) std::fclose(f); }
+};
+
+} // namespace
+
+bool read_model_dims(const std::string& path, ModelDims& dims, std::string& error) {
+    std::unique_ptr<FILE, FileCloser> file(std::fopen(path.c_str(), "rb"));
+    if (!file) {
+        error = "Cannot open model: " + path;
+        return false;
+    }
+
+    uint32_t magic = 0;
+    if (!get_u32(file.get(), magic) || magic != GGML_MAGIC) {
+        error = "Not a ggml model: " + path;
+        return false;
+    }
+
+    int32_t* fields[] = {
+        &dims.n_vocab, &dims.n_audio_ctx, &dims.n_audio_state, &dims.n_audio_head,
+        &dims.n_audio_layer, &dims.n_text_ctx, &dims.n_text_state, &dims.n_text_head,
+        &dims.n_text_layer, &dims.n_mels, &dims.ftype,
+    };
+    for (int32_t* field : fields) {
+        uint32_t v = 0;
+        if (!get_u32(file.get(), v)) {
+            error = "Truncated model header: " + path;
+            return false;
+        }
+        *field = static_cast<int32_t>(v);
+    }
+
+    if (std::fseek(file.get(), 0, SEEK_END) != 0) {
+        error = "Cannot size model: " + path;
+        return false;
+    }
+    const long size = std::ftell(file.get());
+    if (size < 0) {
+        error = "Cannot size model: " + path;
+        return false;
+    }
+    dims.file_bytes = static_cast<uint64_t>(size);
+    return true;
+}
+
+// Follows the buffers whisper.cpp allocates per state (one kv_self shared by
+// all decoders, kv_cross, the conv/encode/cross/decode graph allocators) and
+// the mel it computes for all samples passed to one whisper_full call. Every
+// BatchEncoder state allocates the same buffers again, plus the mel of its
+// window and a copy of the encoder output. Attention scores are counted in f32
+// since the CPU build runs without flash attention.
+MemoryEstimate estimate_memory(const ModelDims& model, const JobShape& job) {
+    const uint64_t audio_ctx = static_cast<uint64_t>(std::max(model.n_audio_ctx, 0));
+    const uint64_t audio_state = static_cast<uint64_t>(std::max(model.n_audio_state, 0));
+    const uint64_t audio_head = static_cast<uint64_t>(std::max(model.n_audio_head, 0));
+    const uint64_t text_ctx = static_cast<uint64_t>(std::max(model.n_text_ctx, 0));
+    const uint64_t text_state = static_cast<uint64_t>(std::max(model.n_text_state, 0));
+    const uint64_t text_layer = static_cast<uint64_t>(std::max(model.n_text_layer, 0));
+    const uint64_t vocab = static_cast<uint64_t>(std::max(model.n_vocab, 0));
+    const uint64_t mels = static_cast<uint64_t>(std::max(model.n_mels, 0));
+    const uint64_t decoders = static_cast<uint64_t>(std::max(job.decoders, 1));
+    const uint64_t threads = static_cast<uint64_t>(std::max(job.threads, 1));
+    const uint64_t encode_states = static_cast<uint64_t>(std::max(job.encode_states, 0));
+
+    MemoryEstimate estimate;
+    estimate.weights = model.file_bytes;
+
+    // K and V per layer, whatever the number of decoders: the padded text
+    // context three times over for self-attention, the audio context for cross
+    const auto pad = [](uint64_t n) { return (n + KV_PAD - 1) / KV_PAD * KV_PAD; };
+    const uint64_t kv_self = 2 * text_layer * pad(text_ctx) * KV_SELF_FACTOR * text_state * F16_BYTES;
+    const uint64_t kv_cross = 2 * text_layer * pad(audio_ctx) * text_state * F16_BYTES;
+    estimate.kv = (kv_self + kv_cross) * (1 + encode_states);
+
+    // Encoder: one layer's attention scores plus the residual and 4x-wide MLP
+    // activations. Decoder: logits for a prompt of up to half the text context,
+    // and each decoder's own logits, probabilities and log probabilities.
+    const uint64_t encode = audio_head * audio_ctx * audio_ctx * F32_BYTES +
+                            16 * audio_ctx * audio_state * F32_BYTES;
+    const uint64_t decode = vocab * (text_ctx / 2) * F32_BYTES;
+    const uint64_t per_decoder = 3 * vocab * F32_BYTES;
+    const uint64_t encoder_output = audio_ctx * audio_state * F32_BYTES;
+    estimate.compute = (encode + decode) * (1 + encode_states) + decoders * per_decoder +
+                       encode_states * encoder_output + threads * PER_THREAD_BYTES;
+
+    // The caller's PCM stays resident; per call whisper holds a padded copy and the mel
+    uint64_t call_samples = job.n_samples;
+    if (job.chunk_ms > 0) {
+        call_samples = std::min(call_samples, static_cast<uint64_t>(job.chunk_ms) * SAMPLE_RATE / 1000);
+    }
+    const uint64_t padded = call_samples + PAD_SAMPLES;
+    estimate.audio = job.n_samples * F32_BYTES + padded * F32_BYTES +
+                     (padded / HOP_LENGTH) * mels * F32_BYTES;
+    const uint64_t window_mel = ((WINDOW_SAMPLES + PAD_SAMPLES) / HOP_LENGTH) * mels * F32_BYTES;
+    estimate.audio += encode_states * window_mel;
+
+    const uint64_t itemised = estimate.total();
+    estimate.compute += itemised * OVERHEAD_PERCENT / 100;
+    return estimate;
+}
+
+int max_encode_states(const ModelDims& model, const JobShape& job, int wanted, uint64_t budget_bytes) {
+    JobShape shape = job;
+    for (int states = std::max(wanted, 0); states > 0; states--) {
+        shape.encode_states = states;
+        if (estimate_memory(model, shape).total() <= budget_bytes) return states;
+    }
+    return 0;
+}
+
+AdmissionPlan plan_admission(const std::vector<ModelDims>& candidates, const JobShape& wanted,
+                             uint64_t budget_bytes) {
+    AdmissionPlan plan;
+    plan.budget_bytes = budget_bytes;
+    plan.job = wanted;
+    if (candidates.empty()) return plan;
+
+    const int64_t audio_ms = static_cast<int64_t>(wanted.n_samples * 1000 / SAMPLE_RATE);
+    const bool can_chunk = (wanted.chunk_ms <= 0 || wanted.chunk_ms > ADMISSION_CHUNK_MS) &&
+                           audio_ms > ADMISSION_CHUNK_MS;
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+        // Cheapest last, so a failed search reports the smallest footprint available
+        JobShape shape = wanted;
+        uint32_t downgrades = i > 0 ? DOWNGRADE_SMALLER_MODEL : DOWNGRADE_NONE;
+
+        for (int step = 0; step < 2; step++) {
+            if (step == 1) {
+                if (!can_chunk) continue;
+                shape.chunk_ms = ADMISSION_CHUNK_MS;
+                downgrades |= DOWNGRADE_CHUNKED;
+            }
+
+            plan.model_index = i;
+            plan.job = shape;
+            plan.downgrades = downgrades;
+            plan.estimated_bytes = estimate_memory(candidates[i], shape).total();
+            if (plan.estimated_bytes <= budget_bytes) {
+                plan.admitted = true;
+                return plan;
+            }
+        }
+    }
+    return plan;
+}
+
+} // namespace securevox
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace securevox {
+
+// Hyperparameters from a ggml model file header, plus the file size
+struct ModelDims {
+    int32_t n_vocab = 0;
+    int32_t n_audio_ctx = 0;
+    int32_t n_audio_state = 0;
+    int32_t n_audio_head = 0;
+    int32_t n_audio_layer = 0;
+    int32_t n_text_ctx = 0;
+    int32_t n_text_state = 0;
+    int32_t n_text_head = 0;
+    int32_t n_text_layer = 0;
+    int32_t n_mels = 0;
+    int32_t ftype = 0;
+    uint64_t file_bytes = 0;
+};
+
+// Read the header only; the weights are not loaded
+bool read_model_dims(const std::string& path, ModelDims& dims, std::string& error);
+
+// The shape of one transcription job
+struct JobShape {
+    uint64_t n_samples = 0;  // 16 kHz mono
+    int threads = 4;
+    int decoders = 5;        // greedy best_of (whisper's default) or beam size; they share one kv_self
+    int64_t chunk_ms = 0;    // audio per whisper_full call, 0 for the whole file
+    int encode_states = 0;   // whisper_states BatchEncoder keeps next to whisper_full's own
+};
+
+// Estimated peak resident memory of a job, by where it goes
+struct MemoryEstimate {
+    uint64_t weights = 0;  // model tensors
+    uint64_t kv = 0;       // self-attention cache (shared by all decoders) plus cross-attention cache
+    uint64_t compute = 0;  // encoder and decoder graph buffers, per-thread work
+    uint64_t audio = 0;    // PCM held by the caller, whisper's padded copy and the mel
+
+    uint64_t total() const { return weights + kv + compute + audio; }
+};
+
+MemoryEstimate estimate_memory(const ModelDims& model, const JobShape& job);
+
+// Most BatchEncoder states, up to wanted, that keep job within budget_bytes;
+// 0 if not even one fits and encoding is best left to whisper_full
+int max_encode_states(const ModelDims& model, const JobShape& job, int wanted, uint64_t budget_bytes);
+
+// Downgrades applied by plan_admission, as a bit set
+enum Downgrade : uint32_t {
+    DOWNGRADE_NONE = 0,
+    DOWNGRADE_CHUNKED = 1u << 0,         // audio fed in chunks of ADMISSION_CHUNK_MS
+    // 1u << 1 was a single-decoder step; whisper's kv_self does not shrink with best_of
+    DOWNGRADE_SMALLER_MODEL = 1u << 2,   // a later candidate than the first was chosen
+};
+
+// Chunk length used when a job has to be chunked to fit
+constexpr int64_t ADMISSION_CHUNK_MS = 5 * 60 * 1000;
+
+struct AdmissionPlan {
+    bool admitted = false;    // false if even the cheapest option is over budget
+    size_t model_index = 0;   // into the candidates passed to plan_admission
+    JobShape job;             // the shape to run with
+    uint64_t estimated_bytes = 0;
+    uint64_t budget_bytes = 0;
+    uint32_t downgrades = DOWNGRADE_NONE;
+};
+
+// Pick the cheapest change that keeps a job within budget_bytes.
+//
+// candidates are ordered by preference (normally largest model first). For each
+// one in turn the wanted shape is tried, then chunked; the first that fits is
+// returned. If none does, the plan is not admitted and describes the cheapest
+// option of the last candidate.
+AdmissionPlan plan_admission(const std::vector<ModelDims>& candidates, const JobShape& wanted,
+                             uint64_t budget_bytes);
+
+} // namespace securevox
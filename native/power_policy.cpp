@@ -0,0 +1,223 @@
+#include "power_policy.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace securevox {
+
+namespace {
+
+// Thermal status thresholds (PowerManager.THERMAL_STATUS_*)
+constexpr int THERMAL_MODERATE = 2;
+constexpr int THERMAL_SEVERE = 3;
+constexpr int THERMAL_CRITICAL = 4;
+
+constexpr int BATTERY_LOW_PERCENT = 15;
+constexpr int BATTERY_MEDIUM_PERCENT = 30;
+
+// Upper bound for a single pause so a stale long window cannot stall a job
+constexpr long long MAX_PAUSE_MS = 5000;
+
+std::string trim(const std::string& s) {
+    size_t b = 0, e = s.size();
+    while (b < e && (s[b] == ' ' || s[b] == '\t')) b++;
+    while (e > b && (s[e - 1] == ' ' || s[e - 1] == '\t' || s[e - 1] == '\r' || s[e - 1] == '\n')) e--;
+    return s.substr(b, e - b);
+}
+
+#if defined(__linux__)
+bool read_line(const std::string& path, std::string& out) {
+    std::ifstream in(path);
+    if (!in || !std::getline(in, out)) return false;
+    out = trim(out);
+    return true;
+}
+
+// Highest cpuinfo_max_freq per CPU, or empty when cpufreq is unavailable
+std::vector<long> cpu_max_frequencies() {
+    std::vector<long> freqs;
+    const int n_cpus = static_cast<int>(std::thread::hardware_concurrency());
+    for (int cpu = 0; cpu < n_cpus; cpu++) {
+        std::string line;
+        if (!read_line("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/cpuinfo_max_freq", line)) {
+            return {};
+        }
+        freqs.push_back(std::atol(line.c_str()));
+    }
+    return freqs;
+}
+#endif
+
+} // namespace
+
+StubPowerSource::StubPowerSource(std::string path) : path_(std::move(path)) {}
+
+bool StubPowerSource::read(PowerSignals& out) {
+    std::ifstream in(path_);
+    if (!in) return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        const size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        const std::string key = trim(line.substr(0, eq));
+        const int value = std::atoi(trim(line.substr(eq + 1)).c_str());
+        if (key == "battery") out.battery_percent = value;
+        else if (key == "charging") out.charging = value != 0;
+        else if (key == "thermal") out.thermal_status = value;
+        else if (key == "power_save") out.power_save = value != 0;
+    }
+    return true;
+}
+
+PowerPolicy& PowerPolicy::instance() {
+    static PowerPolicy policy;
+    return policy;
+}
+
+PowerPolicy::PowerPolicy() {
+    if (const char* stub = std::getenv("SECUREVOX_POWER_STUB")) {
+        source_ = std::make_unique<StubPowerSource>(stub);
+        enabled_ = true;
+    }
+}
+
+void PowerPolicy::set_enabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = enabled;
+}
+
+bool PowerPolicy::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return enabled_;
+}
+
+void PowerPolicy::update(const PowerSignals& signals) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    signals_ = signals;
+}
+
+void PowerPolicy::set_source(std::unique_ptr<PowerSignalSource> source) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    source_ = std::move(source);
+}
+
+PowerSignals PowerPolicy::signals() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (source_) source_->read(signals_);
+    return signals_;
+}
+
+ThrottlePlan PowerPolicy::plan(int wanted_threads) {
+    if (!enabled()) {
+        ThrottlePlan full;
+        full.max_threads = std::max(1, wanted_threads);
+        return full;
+    }
+    return plan_for(signals(), wanted_threads);
+}
+
+ThrottlePlan PowerPolicy::plan_for(const PowerSignals& s, int wanted_threads) {
+    const int wanted = std::max(1, wanted_threads);
+    const int half = std::max(1, wanted / 2);
+
+    ThrottlePlan plan;
+    plan.max_threads = wanted;
+
+    // Heat applies even on the charger
+    if (s.thermal_status >= THERMAL_CRITICAL) {
+        plan.max_threads = 1;
+        plan.efficiency_cores = true;
+        plan.duty_cycle = 0.25f;
+    } else if (s.thermal_status == THERMAL_SEVERE) {
+        plan.max_threads = half;
+        plan.efficiency_cores = true;
+        plan.duty_cycle = 0.5f;
+    } else if (s.thermal_status == THERMAL_MODERATE) {
+        plan.max_threads = half;
+        plan.duty_cycle = 0.75f;
+    }
+
+    if (s.charging) return plan;
+
+    const bool battery_known = s.battery_percent >= 0;
+    if (s.power_save || (battery_known && s.battery_percent <= BATTERY_LOW_PERCENT)) {
+        plan.max_threads = std::min(plan.max_threads, half);
+        plan.efficiency_cores = true;
+        plan.duty_cycle = std::min(plan.duty_cycle, 0.5f);
+    } else if (battery_known && s.battery_percent <= BATTERY_MEDIUM_PERCENT) {
+        plan.max_threads = std::min(plan.max_threads, std::max(1, wanted - 1));
+        plan.efficiency_cores = true;
+        plan.duty_cycle = std::min(plan.duty_cycle, 0.8f);
+    }
+    return plan;
+}
+
+void DutyCycle::on_window() {
+    const Clock::time_point now = Clock::now();
+    if (!started_) {
+        started_ = true;
+        window_start_ = now;
+        return;
+    }
+
+    // Signals are re-read every window so a charger or cool-down changes the pauses
+    // mid-job; the thread count of the running call stays as planned
+    const ThrottlePlan plan = PowerPolicy::instance().plan(wanted_threads_);
+    if (plan.duty_cycle < 1.0f && plan.duty_cycle > 0.0f) {
+        const long long active_ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - window_start_).count();
+        const long long pause_ms = std::min(
+            MAX_PAUSE_MS,
+            static_cast<long long>(active_ms * (1.0f - plan.duty_cycle) / plan.duty_cycle));
+        if (pause_ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(pause_ms));
+            paused_ms_ += pause_ms;
+        }
+    }
+    window_start_ = Clock::now();
+}
+
+EfficiencyCoreScope::EfficiencyCoreScope(bool enable) {
+#if defined(__linux__)
+    static_assert(sizeof(cpu_set_t) <= sizeof(saved_mask_), "cpu_set_t does not fit");
+    if (!enable) return;
+
+    const std::vector<long> freqs = cpu_max_frequencies();
+    if (freqs.empty()) return;
+    const long slowest = *std::min_element(freqs.begin(), freqs.end());
+    const long fastest = *std::max_element(freqs.begin(), freqs.end());
+    if (slowest == fastest) return;  // homogeneous CPU, nothing to prefer
+
+    cpu_set_t* saved = reinterpret_cast<cpu_set_t*>(saved_mask_);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), saved) != 0) return;
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (size_t cpu = 0; cpu < freqs.size(); cpu++) {
+        if (freqs[cpu] == slowest && CPU_ISSET(cpu, saved)) CPU_SET(cpu, &mask);
+    }
+    if (CPU_COUNT(&mask) == 0) return;
+
+    active_ = sched_setaffinity(0, sizeof(cpu_set_t), &mask) == 0;
+#else
+    (void)enable;
+#endif
+}
+
+EfficiencyCoreScope::~EfficiencyCoreScope() {
+#if defined(__linux__)
+    if (active_) {
+        sched_setaffinity(0, sizeof(cpu_set_t), reinterpret_cast<cpu_set_t*>(saved_mask_));
+    }
+#endif
+}
+
+} // namespace securevox
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace securevox {
+
+// Device power and thermal state as reported by the platform
+struct PowerSignals {
+    int battery_percent = 100;  // -1 when unknown
+    bool charging = true;
+    // Android PowerManager.THERMAL_STATUS_* scale: 0 none, 1 light, 2 moderate,
+    // 3 severe, 4 critical, 5 emergency, 6 shutdown
+    int thermal_status = 0;
+    bool power_save = false;
+};
+
+// Where the policy reads signals from when nothing is pushed by the app
+class PowerSignalSource {
+public:
+    virtual ~PowerSignalSource() = default;
+    virtual bool read(PowerSignals& out) = 0;
+};
+
+// Simulated signals for exercising the policy on a Linux desktop, through the
+// wrapper (whisper_wrapper_set_power_stub, securevox_bench --power-stub).
+// The file holds key=value lines (battery, charging, thermal, power_save) and is
+// re-read on every window. Editing it mid-run changes the pauses from the next
+// window on; threads and core selection follow at the next plan():
+//
+//   battery=12
+//   charging=0
+//   thermal=3
+class StubPowerSource : public PowerSignalSource {
+public:
+    explicit StubPowerSource(std::string path);
+    bool read(PowerSignals& out) override;
+
+private:
+    std::string path_;
+};
+
+// How hard a job may run under the current signals
+struct ThrottlePlan {
+    int max_threads = 0;          // inference threads
+    bool efficiency_cores = false; // restrict to the lowest-frequency CPU cluster
+    float duty_cycle = 1.0f;       // fraction of wall time spent computing
+};
+
+// Battery/thermal throttling policy for background transcription.
+//
+// Disabled by default; when enabled, plan() derives thread count, core
+// selection and duty cycle from the latest signals. Thread count and cores are
+// fixed for a whisper_full call once planned; DutyCycle re-plans on every
+// window, so plugging in a charger stops the pauses right away and restores
+// the threads at the next plan (next job, or next file of a batch), as long
+// as the device is not thermally throttled.
+class PowerPolicy {
+public:
+    static PowerPolicy& instance();
+
+    void set_enabled(bool enabled);
+    bool enabled() const;
+
+    // Push signals from the platform (battery broadcast, thermal listener, ...)
+    void update(const PowerSignals& signals);
+
+    // Poll a source instead of relying on pushed updates. SECUREVOX_POWER_STUB
+    // selects a StubPowerSource at startup.
+    void set_source(std::unique_ptr<PowerSignalSource> source);
+
+    // Latest signals, refreshed from the source if one is set
+    PowerSignals signals();
+
+    ThrottlePlan plan(int wanted_threads);
+
+    static ThrottlePlan plan_for(const PowerSignals& signals, int wanted_threads);
+
+private:
+    PowerPolicy();
+
+    mutable std::mutex mutex_;
+    bool enabled_ = false;
+    PowerSignals signals_;
+    std::unique_ptr<PowerSignalSource> source_;
+};
+
+// Sleeps between encoder windows so that compute time stays at the policy's
+// duty cycle. Call on_window() from whisper's encoder_begin_callback.
+class DutyCycle {
+public:
+    explicit DutyCycle(int wanted_threads) : wanted_threads_(wanted_threads) {}
+
+    void on_window();
+
+    // Total time spent paused, for logging
+    long long paused_ms() const { return paused_ms_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    int wanted_threads_;
+    bool started_ = false;
+    Clock::time_point window_start_;
+    long long paused_ms_ = 0;
+};
+
+// Pins the calling thread (and the ggml threads it spawns, which inherit the
+// mask) to the efficiency cores for the lifetime of the scope. No-op when the
+// CPU has a single cluster or the platform has no affinity API.
+class EfficiencyCoreScope {
+public:
+    explicit EfficiencyCoreScope(bool enable);
+    ~EfficiencyCoreScope();
+
+    EfficiencyCoreScope(const EfficiencyCoreScope&) = delete;
+    EfficiencyCoreScope& operator=(const EfficiencyCoreScope&) = delete;
+
+    bool active() const { return active_; }
+
+private:
+    bool active_ = false;
+    unsigned char saved_mask_[128] = {};  // cpu_set_t-sized storage
+};
+
+} // namespace securevox
@@ -0,0 +1,86 @@
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace securevox {
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+// Kernel samples per zero crossing
+constexpr int TABLE_RESOLUTION = 512;
+
+// Keep the transition band just below the output Nyquist frequency
+constexpr double CUTOFF_MARGIN = 0.97;
+
+} // namespace
+
+Resampler::Resampler(int in_rate, int out_rate, int zero_crossings, Arena* arena)
+    : in_rate_(in_rate),
+      out_rate_(out_rate),
+      zero_crossings_(std::max(1, zero_crossings)),
+      cutoff_(std::min(1.0, static_cast<double>(out_rate) / in_rate) * CUTOFF_MARGIN),
+      table_resolution_(TABLE_RESOLUTION),
+      table_(ArenaAllocator<float>(arena)) {
+
+    table_.resize(static_cast<size_t>(zero_crossings_) * table_resolution_ + 2);
+    for (size_t i = 0; i < table_.size(); i++) {
+        const double x = static_cast<double>(i) / table_resolution_;
+        const double sinc = x == 0.0 ? 1.0 : std::sin(PI * x) / (PI * x);
+        const double window = x >= zero_crossings_
+            ? 0.0
+            : 0.5 + 0.5 * std::cos(PI * x / zero_crossings_);
+        table_[i] = static_cast<float>(sinc * window);
+    }
+}
+
+float Resampler::kernel(double x) const {
+    // x is measured in zero crossings of the cutoff-scaled sinc
+    const double pos = std::fabs(x) * table_resolution_;
+    const size_t i = static_cast<size_t>(pos);
+    if (i + 1 >= table_.size()) return 0.0f;
+    const float frac = static_cast<float>(pos - i);
+    return table_[i] + (table_[i + 1] - table_[i]) * frac;
+}
+
+size_t Resampler::output_length(size_t n) const {
+    return static_cast<size_t>((static_cast<unsigned long long>(n) * out_rate_) / in_rate_);
+}
+
+void Resampler::process(const float* in, size_t n, SampleVector& out) const {
+    const size_t n_out = output_length(n);
+    out.resize(n_out);
+    if (n == 0) return;
+
+    const double step = static_cast<double>(in_rate_) / out_rate_;
+    // Kernel half-width in input samples
+    const double half_width = zero_crossings_ / cutoff_;
+
+    for (size_t j = 0; j < n_out; j++) {
+        const double t = j * step;
+        const long first = std::max(0L, static_cast<long>(std::ceil(t - half_width)));
+        const long last = std::min(static_cast<long>(n) - 1, static_cast<long>(std::floor(t + half_width)));
+
+        float acc = 0.0f;
+        float norm = 0.0f;
+        for (long i = first; i <= last; i++) {
+            const float w = kernel((t - i) * cutoff_);
+            acc += in[i] * w;
+            norm += w;
+        }
+        // Normalizing by the tap sum keeps unity gain at the signal edges too
+        out[j] = norm != 0.0f ? acc / norm : 0.0f;
+    }
+}
+
+void resample(const float* in, size_t n, int in_rate, int out_rate, SampleVector& out) {
+    if (in_rate == out_rate || in_rate <= 0 || out_rate <= 0) {
+        out.assign(in, in + n);
+        return;
+    }
+    Resampler(in_rate, out_rate, 8, out.get_allocator().arena()).process(in, n, out);
+}
+
+} // namespace securevox
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "arena.h"
+
+#include <cstddef>
+
+namespace securevox {
+
+// Sample rate whisper expects (WHISPER_SAMPLE_RATE, without needing whisper.h)
+constexpr int MODEL_SAMPLE_RATE = 16000;
+
+// Band-limited resampler using a Hann-windowed sinc kernel.
+//
+// The kernel is tabulated once per rate pair and the cutoff follows the lower
+// of the two rates, so downsampling 44.1/48 kHz recordings does not alias
+// into the speech band.
+class Resampler {
+public:
+    // The kernel table is allocated from arena when one is given
+    Resampler(int in_rate, int out_rate, int zero_crossings = 8, Arena* arena = nullptr);
+
+    int in_rate() const { return in_rate_; }
+    int out_rate() const { return out_rate_; }
+
+    // Number of output samples produced for n input samples
+    size_t output_length(size_t n) const;
+
+    // Resample a complete signal into out (resized to output_length(n))
+    void process(const float* in, size_t n, SampleVector& out) const;
+
+private:
+    float kernel(double x) const;
+
+    int in_rate_;
+    int out_rate_;
+    int zero_crossings_;
+    double cutoff_;
+    int table_resolution_;
+    SampleVector table_;  // kernel sampled over [0, zero_crossings]
+};
+
+// Resample in into out; copies when the rates already match.
+// Scratch memory comes from out's allocator.
+void resample(const float* in, size_t n, int in_rate, int out_rate, SampleVector& out);
+
+} // namespace securevox
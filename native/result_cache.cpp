@@ -0,0 +1,259 @@
+#include "result_cache.h"
+#include "binary_io.h"
+#include "content_hash.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <system_error>
+
+namespace securevox {
+
+namespace {
+
+constexpr char MAGIC[4] = {'S', 'V', 'R', 'C'};
+constexpr uint32_t VERSION = 1;
+constexpr const char* ENTRY_SUFFIX = ".res";
+
+// Entries larger than this are treated as corrupt rather than read
+constexpr uint64_t MAX_PAYLOAD_BYTES = 64ull * 1024 * 1024;
+
+struct FileCloser {
+    void operator()(FILE* f) const { std::fclose(f); }
+};
+
+} // namespace
+
+ResultKey make_result_key(const float* samples, size_t n, uint64_t model, const std::string& settings) {
+    ResultKey key;
+    key.audio = hash_samples(samples, n);
+    key.model = model;
+
+    ContentHasher hasher;
+    hasher.update(settings.data(), settings.size());
+    key.settings = hasher.digest();
+    return key;
+}
+
+ResultCache& ResultCache::instance() {
+    static ResultCache cache;
+    return cache;
+}
+
+void ResultCache::set_storage(const std::string& dir, uint64_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    dir_ = max_bytes > 0 ? dir : std::string();
+    budget_ = max_bytes;
+    lru_.clear();
+    entries_.clear();
+    disk_bytes_ = 0;
+    if (dir_.empty()) return;
+
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+
+    // Results stored by earlier runs, least recently used first (hits touch the file)
+    std::vector<std::pair<fs::file_time_type, std::pair<ResultKey, uint64_t>>> found;
+    for (fs::directory_iterator it(dir_, ec), end; !ec && it != end; it.increment(ec)) {
+        const std::string name = it->path().filename().string();
+        unsigned long long audio = 0, model = 0, settings = 0;
+        char suffix[8] = {};
+        if (std::sscanf(name.c_str(), "%16llx%16llx%16llx%7s", &audio, &model, &settings, suffix) != 4 ||
+            std::strcmp(suffix, ENTRY_SUFFIX) != 0) {
+            continue;
+        }
+        ResultKey key;
+        key.audio = audio;
+        key.model = model;
+        key.settings = settings;
+
+        std::error_code size_ec, time_ec;
+        const uint64_t bytes = it->file_size(size_ec);
+        const fs::file_time_type time = it->last_write_time(time_ec);
+        if (!size_ec && !time_ec) found.push_back({time, {key, bytes}});
+    }
+    std::sort(found.begin(), found.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (const auto& file : found) {
+        lru_.push_back(file.second);
+        entries_[file.second.first] = std::prev(lru_.end());
+        disk_bytes_ += file.second.second;
+    }
+    trim();
+}
+
+bool ResultCache::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !dir_.empty();
+}
+
+bool ResultCache::load(const ResultKey& key, std::vector<Segment>& segments) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        if (read_entry(key, segments)) {
+            lru_.splice(lru_.end(), lru_, it->second);
+
+            // Keep the order for the next process, which sorts by write time
+            std::error_code ec;
+            std::filesystem::last_write_time(entry_path(key), std::filesystem::file_time_type::clock::now(), ec);
+            stats_.hits++;
+            return true;
+        }
+        forget(key);
+    }
+
+    stats_.misses++;
+    return false;
+}
+
+bool ResultCache::contains(const ResultKey& key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.count(key) > 0;
+}
+
+void ResultCache::store(const ResultKey& key, const std::vector<Segment>& segments) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dir_.empty()) return;
+
+    std::string payload;
+    put_varint(payload, segments.size());
+    for (const auto& segment : segments) {
+        put_varint(payload, static_cast<uint64_t>(std::max<int64_t>(segment.start_ms, 0)));
+        put_varint(payload, static_cast<uint64_t>(std::max<int64_t>(segment.end_ms, 0)));
+        put_varint(payload, segment.text.size());
+        payload.append(segment.text);
+    }
+
+    std::string header(MAGIC, 4);
+    put_u32(header, VERSION);
+    put_u64(header, key.audio);
+    put_u64(header, key.model);
+    put_u64(header, key.settings);
+    put_u64(header, payload.size());
+
+    std::string trailer;
+    put_u32(trailer, fnv1a(payload.data(), payload.size()));
+
+    const uint64_t file_bytes = header.size() + payload.size() + trailer.size();
+    if (file_bytes > budget_) return;
+
+    const std::string path = entry_path(key);
+    const std::string tmp = path + ".tmp";
+
+    FILE* out = std::fopen(tmp.c_str(), "wb");
+    if (out == nullptr) return;
+    const bool written = std::fwrite(header.data(), 1, header.size(), out) == header.size() &&
+                         std::fwrite(payload.data(), 1, payload.size(), out) == payload.size() &&
+                         std::fwrite(trailer.data(), 1, trailer.size(), out) == trailer.size();
+    const bool closed = std::fclose(out) == 0;
+
+#ifdef _WIN32
+    std::remove(path.c_str());  // rename does not replace on Windows
+#endif
+    if (!written || !closed || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return;
+    }
+
+    auto existing = entries_.find(key);
+    if (existing != entries_.end()) {
+        disk_bytes_ -= existing->second->second;
+        lru_.erase(existing->second);
+        entries_.erase(existing);
+    }
+    lru_.push_back({key, file_bytes});
+    entries_[key] = std::prev(lru_.end());
+    disk_bytes_ += file_bytes;
+    trim();
+}
+
+void ResultCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!lru_.empty()) forget(lru_.front().first);
+}
+
+ResultCacheStats ResultCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ResultCacheStats stats = stats_;
+    stats.entries = entries_.size();
+    stats.disk_bytes = disk_bytes_;
+    return stats;
+}
+
+std::string ResultCache::entry_path(const ResultKey& key) const {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016" PRIx64 "%016" PRIx64 "%016" PRIx64 "%s",
+                  key.audio, key.model, key.settings, ENTRY_SUFFIX);
+    return dir_ + "/" + name;
+}
+
+bool ResultCache::read_entry(const ResultKey& key, std::vector<Segment>& segments) const {
+    std::unique_ptr<FILE, FileCloser> file(std::fopen(entry_path(key).c_str(), "rb"));
+    if (!file) return false;
+
+    char magic[4];
+    uint32_t version = 0, checksum = 0;
+    uint64_t audio = 0, model = 0, settings = 0, size = 0;
+    if (std::fread(magic, 1, 4, file.get()) != 4 || std::memcmp(magic, MAGIC, 4) != 0 ||
+        !get_u32(file.get(), version) || version != VERSION ||
+        !get_u64(file.get(), audio) || audio != key.audio ||
+        !get_u64(file.get(), model) || model != key.model ||
+        !get_u64(file.get(), settings) || settings != key.settings ||
+        !get_u64(file.get(), size) || size > MAX_PAYLOAD_BYTES) {
+        return false;
+    }
+
+    std::string payload(static_cast<size_t>(size), '\0');
+    if (std::fread(&payload[0], 1, payload.size(), file.get()) != payload.size() ||
+        !get_u32(file.get(), checksum) || fnv1a(payload.data(), payload.size()) != checksum) {
+        return false;
+    }
+
+    size_t pos = 0;
+    uint64_t count = 0;
+    if (!get_varint(payload, pos, count)) return false;
+
+    std::vector<Segment> decoded;
+    decoded.reserve(static_cast<size_t>(std::min<uint64_t>(count, payload.size())));
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t start = 0, end = 0, length = 0;
+        if (!get_varint(payload, pos, start) || !get_varint(payload, pos, end) ||
+            !get_varint(payload, pos, length) || length > payload.size() - pos) {
+            return false;
+        }
+        Segment segment;
+        segment.start_ms = static_cast<int64_t>(start);
+        segment.end_ms = static_cast<int64_t>(end);
+        segment.text.assign(payload, pos, static_cast<size_t>(length));
+        pos += static_cast<size_t>(length);
+        decoded.push_back(std::move(segment));
+    }
+
+    segments = std::move(decoded);
+    return true;
+}
+
+void ResultCache::forget(const ResultKey& key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return;
+    std::remove(entry_path(key).c_str());
+    disk_bytes_ -= it->second->second;
+    lru_.erase(it->second);
+    entries_.erase(it);
+}
+
+void ResultCache::trim() {
+    while (disk_bytes_ > budget_ && !lru_.empty()) {
+        forget(lru_.front().first);
+    }
+}
+
+} // namespace securevox
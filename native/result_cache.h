@@ -0,0 +1,94 @@
+#pragma once
+
+#include "segment.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace securevox {
+
+struct ResultKey {
+    uint64_t audio = 0;     // hash_samples of the audio given to the model
+    uint64_t model = 0;     // model_fingerprint
+    uint64_t settings = 0;  // hash of the decoding settings that change the text
+
+    bool operator==(const ResultKey& other) const {
+        return audio == other.audio && model == other.model && settings == other.settings;
+    }
+};
+
+struct ResultKeyHash {
+    size_t operator()(const ResultKey& key) const {
+        return static_cast<size_t>(key.audio ^ (key.model * 31) ^ (key.settings * 0x9E3779B97F4A7C15ull));
+    }
+};
+
+// Key for a transcription of samples with the given model and decoding
+// settings. settings should name every parameter that changes the output
+// (language, sampling, chunking, ...).
+ResultKey make_result_key(const float* samples, size_t n, uint64_t model, const std::string& settings);
+
+struct ResultCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t entries = 0;
+    uint64_t disk_bytes = 0;
+};
+
+// Finished transcripts, content addressed by audio, model and settings.
+//
+// Importing the same file again, or retrying a job, decodes identical audio;
+// a hit returns the stored segments without running the model. Entries are
+// files in one directory, bounded by a byte budget with least recently used
+// entries removed first, and are picked up again by later processes. The audio
+// hash reads the samples at memory speed, so a lookup is cheap next to even
+// the smallest model.
+class ResultCache {
+public:
+    static ResultCache& instance();
+
+    // Directory for stored results bounded by max_bytes; an empty dir or a
+    // zero budget (the default) disables the cache. Existing entries are kept.
+    void set_storage(const std::string& dir, uint64_t max_bytes);
+
+    bool enabled() const;
+
+    // Segments stored for key, in the timeline of the hashed audio. False on a miss.
+    bool load(const ResultKey& key, std::vector<Segment>& segments);
+
+    void store(const ResultKey& key, const std::vector<Segment>& segments);
+
+    // Whether a result is stored for key; not counted as a hit or a miss
+    bool contains(const ResultKey& key) const;
+
+    // Delete every stored result
+    void clear();
+
+    ResultCacheStats stats() const;
+
+private:
+    ResultCache() = default;
+
+    std::string entry_path(const ResultKey& key) const;
+    bool read_entry(const ResultKey& key, std::vector<Segment>& segments) const;
+    void forget(const ResultKey& key);
+    void trim();
+
+    mutable std::mutex mutex_;
+    std::string dir_;
+    uint64_t budget_ = 0;
+
+    // Stored results, least recently used first, with their file sizes
+    std::list<std::pair<ResultKey, uint64_t>> lru_;
+    std::unordered_map<ResultKey, std::list<std::pair<ResultKey, uint64_t>>::iterator, ResultKeyHash> entries_;
+    uint64_t disk_bytes_ = 0;
+
+    ResultCacheStats stats_;
+};
+
+} // namespace securevox
@@ -0,0 +1,51 @@
+#include "segment.h"
+
+#include "decode_guard.h"
+#include "whisper.h"
+
+namespace securevox {
+
+void read_segments(whisper_context* ctx, whisper_state* state, int first, std::vector<Segment>& out,
+                   const DecodeGuard* guard) {
+    const int n = state != nullptr
+        ? whisper_full_n_segments_from_state(state)
+        : whisper_full_n_segments(ctx);
+
+    for (int i = first < 0 ? 0 : first; i < n; i++) {
+        if (guard != nullptr && guard->dropped(i)) continue;
+
+        const char* text = state != nullptr
+            ? whisper_full_get_segment_text_from_state(state, i)
+            : whisper_full_get_segment_text(ctx, i);
+        const int64_t t0 = state != nullptr
+            ? whisper_full_get_segment_t0_from_state(state, i)
+            : whisper_full_get_segment_t0(ctx, i);
+        const int64_t t1 = state != nullptr
+            ? whisper_full_get_segment_t1_from_state(state, i)
+            : whisper_full_get_segment_t1(ctx, i);
+
+        // whisper timestamps are in centiseconds
+        Segment segment;
+        segment.start_ms = t0 * 10;
+        segment.end_ms = t1 * 10;
+        segment.text = text ? text : "";
+        out.push_back(std::move(segment));
+    }
+}
+
+std::string tail_text(const std::vector<Segment>& segments, size_t max_chars) {
+    std::string text;
+    for (auto it = segments.rbegin(); it != segments.rend() && text.size() < max_chars; ++it) {
+        text.insert(0, it->text);
+    }
+    if (text.size() <= max_chars) return text;
+
+    // Cut at a word boundary, and never inside a UTF-8 sequence
+    size_t cut = text.size() - max_chars;
+    while (cut < text.size() && (static_cast<uint8_t>(text[cut]) & 0xC0) == 0x80) cut++;
+    const size_t space = text.find(' ', cut);
+    if (space != std::string::npos) cut = space + 1;
+    return text.substr(cut);
+}
+
+} // namespace securevox
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct whisper_context;
+struct whisper_state;
+
+namespace securevox {
+
+class DecodeGuard;
+
+// One transcript segment with times in milliseconds
+struct Segment {
+    int64_t start_ms = 0;
+    int64_t end_ms = 0;
+    std::string text;
+};
+
+// Append segments [first, n_segments) of the last whisper_full result,
+// leaving out those guard dropped. state may be null to read the context's
+// default state, guard to keep every segment.
+void read_segments(whisper_context* ctx, whisper_state* state, int first, std::vector<Segment>& out,
+                   const DecodeGuard* guard = nullptr);
+
+// Up to max_chars of trailing transcript text, cut at a word boundary.
+// Used as the initial prompt when decoding continues after these segments.
+std::string tail_text(const std::vector<Segment>& segments, size_t max_chars);
+
+} // namespace securevox
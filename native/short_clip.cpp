@@ -0,0 +1,72 @@
+#include "short_clip.h"
+
+#include "decode_guard.h"
+#include "whisper.h"
+
+#include <algorithm>
+
+namespace securevox {
+
+namespace {
+
+// Samples per encoder frame (20 ms)
+constexpr int64_t SAMPLES_PER_FRAME = WHISPER_SAMPLE_RATE / 50;
+
+// audio_ctx is rounded up to a multiple of this many frames, so clips of
+// about the same length share one context size
+constexpr int CTX_ALIGN = 64;
+
+} // namespace
+
+int short_clip_audio_ctx(size_t n, const ShortClipOptions& options) {
+    const int64_t samples = static_cast<int64_t>(n);
+    if (options.max_ms <= 0 || samples == 0 || samples * 1000 > options.max_ms * WHISPER_SAMPLE_RATE) return 0;
+
+    const int64_t margin = std::max<int64_t>(options.margin_ms, 0) * WHISPER_SAMPLE_RATE / 1000;
+    int64_t frames = (samples + margin + SAMPLES_PER_FRAME - 1) / SAMPLES_PER_FRAME;
+    frames = (frames + CTX_ALIGN - 1) / CTX_ALIGN * CTX_ALIGN;
+    frames = std::max<int64_t>(frames, options.min_audio_ctx);
+    return frames < FULL_AUDIO_CTX ? static_cast<int>(frames) : 0;
+}
+
+bool apply_short_clip(whisper_full_params& params, size_t n, const ShortClipOptions& options) {
+    const int audio_ctx = short_clip_audio_ctx(n, options);
+    if (audio_ctx == 0) return false;
+    params.audio_ctx = audio_ctx;
+    params.single_segment = true;
+    return true;
+}
+
+void clear_short_clip(whisper_full_params& params) {
+    params.audio_ctx = 0;
+    params.single_segment = false;
+}
+
+bool short_clip_accepted(whisper_context* ctx, const DecodeGuard* guard, int cut_before,
+                         const ShortClipOptions& options) {
+    if (guard != nullptr && guard->cut_windows() > cut_before) return false;
+
+    const whisper_token eot = whisper_token_eot(ctx);
+    const int n_segments = whisper_full_n_segments(ctx);
+    int text_tokens = 0;
+    int dropped = 0;
+    double sum_logprob = 0.0;
+    for (int i = 0; i < n_segments; i++) {
+        if (guard != nullptr && guard->dropped(i)) {
+            dropped++;
+            continue;
+        }
+        const int n_tokens = whisper_full_n_tokens(ctx, i);
+        for (int j = 0; j < n_tokens; j++) {
+            const whisper_token_data token = whisper_full_get_token_data(ctx, i, j);
+            if (token.id >= eot) continue;
+            sum_logprob += token.plog;
+            text_tokens++;
+        }
+    }
+
+    if (text_tokens == 0) return dropped > 0;
+    return sum_logprob / text_tokens >= options.min_avg_logprob;
+}
+
+} // namespace securevox
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct whisper_context;
+struct whisper_full_params;
+
+namespace securevox {
+
+class DecodeGuard;
+
+// Encoder frames of every Whisper model: 30 s at 20 ms each
+static constexpr int FULL_AUDIO_CTX = 1500;
+
+struct ShortClipOptions {
+    // Clips up to this long take the fast path; 0 disables it
+    int64_t max_ms = 15000;
+    // Context left past the end of the clip, so the last word is not encoded
+    // against the edge of the window
+    int64_t margin_ms = 2000;
+    // The context never gets smaller than this many frames: the model was
+    // trained on full windows and degrades quickly on very short ones
+    int min_audio_ctx = 384;
+    // Accuracy guard: a result whose text tokens average a lower log
+    // probability is decoded again with the full context. Stricter than
+    // whisper's own fallback threshold (-1.0), which the shortened context
+    // tends to approach before the text visibly breaks.
+    float min_avg_logprob = -0.7f;
+};
+
+// Short-clip fast path.
+//
+// whisper_full pads every window to 30 s and, with audio_ctx left at 0, runs
+// the encoder over all 1500 frames, so a 5 s memo costs as much as a 30 s one.
+// For a clip of at most options.max_ms, audio_ctx is cut to the clip plus the
+// margin (rounded up to a multiple of 64 frames), and single_segment decodes
+// it as one segment: the encoder cost falls with the clip length and there is
+// no timestamp-driven seeking. The encoder cache keys windows by the context
+// they were encoded with, so the short and the full-context encoding of a clip
+// are cached side by side.
+//
+// The decoder sees fewer frames than it was trained on, which can cost
+// accuracy. short_clip_accepted checks the result, and a result it rejects is
+// decoded again with clear_short_clip params, the full-context transcript.
+
+// audio_ctx for n 16 kHz samples, or 0 (the full context) when n is longer
+// than options.max_ms or the clip would need most of the window anyway
+int short_clip_audio_ctx(size_t n, const ShortClipOptions& options = ShortClipOptions());
+
+// Set audio_ctx and single_segment for n samples. False, leaving params as
+// they were, when n does not take the fast path.
+bool apply_short_clip(whisper_full_params& params, size_t n,
+                      const ShortClipOptions& options = ShortClipOptions());
+
+// Back to the full context and ordinary segmentation
+void clear_short_clip(whisper_full_params& params);
+
+// Accuracy guard on the last whisper_full result of ctx (its default state):
+// false if it has no text (unless guard dropped all of it as silence), if
+// guard cut a decoder pass short since it had cut_before passes, or if its
+// text tokens average less than options.min_avg_logprob. guard may be null.
+bool short_clip_accepted(whisper_context* ctx, const DecodeGuard* guard, int cut_before,
+                         const ShortClipOptions& options = ShortClipOptions());
+
+} // namespace securevox
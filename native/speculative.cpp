@@ -0,0 +1,510 @@
+#include "speculative.h"
+
+#include "whisper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace securevox {
+
+namespace {
+
+// Mel frames (10 ms) per window, and per timestamp token step (20 ms)
+constexpr int WINDOW_FRAMES = WHISPER_CHUNK_SIZE * 100;
+constexpr int TIMESTAMP_FRAMES = 2;
+
+// A tail shorter than this is not decoded, as in whisper_full
+constexpr int MIN_WINDOW_FRAMES = 100;
+
+// The first timestamp of a window is at most 1 s in (whisper's max_initial_ts)
+constexpr int MAX_INITIAL_TIMESTAMP = 50;
+
+void suppress_range(float* logits, int begin, int end) {
+    if (begin < end) std::fill(logits + begin, logits + end, -INFINITY);
+}
+
+} // namespace
+
+SpeculativeDecoder::SpeculativeDecoder(whisper_context* target, whisper_context* draft,
+                                       const SpeculativeOptions& options)
+    : options_(options) {
+    target_.ctx = target;
+    target_.state = whisper_init_state(target);
+
+    std::string ignored;
+    if (options.draft_tokens > 0 && compatible(target, draft, ignored)) {
+        draft_.ctx = draft;
+        draft_.state = whisper_init_state(draft);
+    }
+
+    n_vocab_ = whisper_n_vocab(target);
+    scratch_.resize(static_cast<size_t>(n_vocab_));
+    max_tokens_ = whisper_n_text_ctx(target) / 2 - 4;
+
+    vocab_.eot = whisper_token_eot(target);
+    vocab_.sot = whisper_token_sot(target);
+    vocab_.beg = whisper_token_beg(target);
+    vocab_.no_timestamps = whisper_token_not(target);
+    vocab_.no_speech = whisper_token_nosp(target);
+    vocab_.solm = whisper_token_solm(target);
+    vocab_.prev = whisper_token_prev(target);
+    vocab_.translate = whisper_token_translate(target);
+    vocab_.transcribe = whisper_token_transcribe(target);
+    vocab_.lang_first = whisper_token_lang(target, 0);
+    vocab_.lang_last = whisper_token_lang(target, whisper_lang_max_id());
+    whisper_token space;
+    if (whisper_tokenize(target, " ", &space, 1) == 1) vocab_.space = space;
+}
+
+SpeculativeDecoder::~SpeculativeDecoder() {
+    if (draft_.state != nullptr) whisper_free_state(draft_.state);
+    if (target_.state != nullptr) whisper_free_state(target_.state);
+}
+
+bool SpeculativeDecoder::compatible(whisper_context* target, whisper_context* draft, std::string& error) {
+#ifdef WHISPER_HAS_BATCH_LOGITS
+    if (target == nullptr || draft == nullptr) {
+        error = "No draft model";
+        return false;
+    }
+    if (whisper_n_vocab(target) != whisper_n_vocab(draft) ||
+        whisper_is_multilingual(target) != whisper_is_multilingual(draft)) {
+        error = "Draft model has a different vocabulary";
+        return false;
+    }
+    return true;
+#else
+    (void)target;
+    (void)draft;
+    error = "whisper.cpp was built without batched logits (patches/02-batch-logits.patch)";
+    return false;
+#endif
+}
+
+const float* SpeculativeDecoder::decode_last(Model& model, const Token* tokens, int n, std::string& error) {
+#ifdef WHISPER_HAS_BATCH_LOGITS
+    const float* rows = decode_all(model, tokens, n, error);
+    return rows != nullptr ? rows + static_cast<size_t>(n - 1) * n_vocab_ : nullptr;
+#else
+    // Only the last token's logits are kept, in row 0 when it is decoded alone
+    if (n > 1) {
+        if (whisper_decode_with_state(model.ctx, model.state, tokens, n - 1, model.n_past, options_.n_threads) != 0) {
+            error = "Decoder failed";
+            return nullptr;
+        }
+        model.n_past += n - 1;
+        tokens += n - 1;
+    }
+    if (whisper_decode_with_state(model.ctx, model.state, tokens, 1, model.n_past, options_.n_threads) != 0) {
+        error = "Decoder failed";
+        return nullptr;
+    }
+    model.n_past += 1;
+    return whisper_get_logits_from_state(model.state);
+#endif
+}
+
+const float* SpeculativeDecoder::decode_all(Model& model, const Token* tokens, int n, std::string& error) {
+#ifdef WHISPER_HAS_BATCH_LOGITS
+    if (whisper_decode_all_logits_with_state(model.ctx, model.state, tokens, n, model.n_past, options_.n_threads) != 0) {
+        error = "Decoder failed";
+        return nullptr;
+    }
+    model.n_past += n;
+    return whisper_get_logits_from_state(model.state);
+#else
+    (void)model;
+    (void)tokens;
+    (void)n;
+    error = "whisper.cpp was built without batched logits (patches/02-batch-logits.patch)";
+    return nullptr;
+#endif
+}
+
+void SpeculativeDecoder::filter_logits(float* logits, const Sequence& seq) const {
+    const Vocab& v = vocab_;
+    const Token* generated = seq.tokens.data();
+    const int n_generated = static_cast<int>(seq.tokens.size());
+    auto suppress = [&](Token token) {
+        if (token >= 0 && token < n_vocab_) logits[token] = -INFINITY;
+    };
+
+    // No blank start (suppress_blank), and none of the special tokens
+    if (n_generated == 0) {
+        suppress(v.eot);
+        suppress(v.space);
+    }
+    suppress(v.no_timestamps);
+    suppress(v.sot);
+    suppress(v.no_speech);
+    suppress(v.solm);
+    suppress(v.prev);
+    suppress(v.translate);
+    suppress(v.transcribe);
+    suppress_range(logits, v.lang_first, std::min(v.lang_last + 1, n_vocab_));
+
+    // Timestamps come in pairs, except right before end-of-text
+    const bool last_was_timestamp = n_generated > 0 && generated[n_generated - 1] >= v.beg;
+    const bool penultimate_was_timestamp = n_generated < 2 || generated[n_generated - 2] >= v.beg;
+    if (last_was_timestamp) {
+        if (penultimate_was_timestamp) {
+            suppress_range(logits, v.beg, n_vocab_);
+        } else {
+            suppress_range(logits, 0, v.eot);
+        }
+    }
+
+    // The first timestamp is at most max_initial_ts in, and once one counted
+    // in seek_delta none may come before it
+    if (n_generated == 0) {
+        suppress_range(logits, std::min(v.beg + MAX_INITIAL_TIMESTAMP + 1, n_vocab_), n_vocab_);
+    }
+    if (seq.has_ts) {
+        suppress_range(logits, v.beg, std::min(v.beg + seq.seek_delta / TIMESTAMP_FRAMES, n_vocab_));
+    }
+
+    // A timestamp when their total probability beats every text token
+    float max_text = -INFINITY;
+    for (int i = 0; i < v.beg; i++) max_text = std::max(max_text, logits[i]);
+    float max_timestamp = -INFINITY;
+    for (int i = v.beg; i < n_vocab_; i++) max_timestamp = std::max(max_timestamp, logits[i]);
+    if (max_timestamp == -INFINITY) return;
+
+    double sum = 0.0;
+    for (int i = v.beg; i < n_vocab_; i++) sum += std::exp(static_cast<double>(logits[i] - max_timestamp));
+    if (max_timestamp + std::log(sum) > max_text) suppress_range(logits, 0, v.beg);
+}
+
+SpeculativeDecoder::Token SpeculativeDecoder::greedy(const float* logits, const Sequence& seq, Token& tid) {
+    std::memcpy(scratch_.data(), logits, scratch_.size() * sizeof(float));
+    filter_logits(scratch_.data(), seq);
+
+    // The likeliest timestamp is only used for the first token: whisper_full
+    // starts the first segment there even if a text token was picked
+    tid = vocab_.beg;
+    if (seq.tokens.empty()) {
+        float best = -INFINITY;
+        for (int i = vocab_.beg; i < n_vocab_; i++) {
+            if (scratch_[i] > best) {
+                best = scratch_[i];
+                tid = i;
+            }
+        }
+    }
+    return static_cast<Token>(std::max_element(scratch_.begin(), scratch_.end()) - scratch_.begin());
+}
+
+void SpeculativeDecoder::advance(Sequence& seq, Token token, Token tid, int seek, int seek_end) const {
+    const int i = static_cast<int>(seq.tokens.size());
+    if (i == 0) seq.first_tid = tid;
+    seq.tokens.push_back(token);
+
+    // A timestamp past <|0.00|> moves the end of the result and the next seek,
+    // unless it goes back in time, which fails the decoder
+    if (token > vocab_.beg) {
+        const int seek_delta = (token - vocab_.beg) * TIMESTAMP_FRAMES;
+        if (seq.has_ts && seq.seek_delta > seek_delta && seq.result_len < i) {
+            seq.failed = true;
+            return;
+        }
+        seq.seek_delta = seek_delta;
+        seq.result_len = i + 1;
+        seq.has_ts = true;
+    }
+
+    // End of text, or a timestamp reaching the end of the audio
+    const bool at_end = seek + seq.seek_delta + MIN_WINDOW_FRAMES >= seek_end;
+    if (token == vocab_.eot || (seq.has_ts && at_end)) {
+        if (seq.result_len == 0) {
+            if (!at_end) {
+                seq.failed = true;
+                return;
+            }
+            seq.result_len = i + 1;
+        }
+        seq.completed = true;
+        return;
+    }
+
+    // Out of tokens without having moved past half the window: a repetition loop
+    if (i == max_tokens_ - 1 && (seq.result_len == 0 || seq.seek_delta < WINDOW_FRAMES / 2)) {
+        seq.failed = true;
+    }
+}
+
+bool SpeculativeDecoder::finished(const Sequence& seq) const {
+    return seq.completed || seq.failed || static_cast<int>(seq.tokens.size()) >= max_tokens_;
+}
+
+bool SpeculativeDecoder::decode_window(int seek, int seek_end, Sequence& seq, std::string& error) {
+    if (whisper_encode_with_state(target_.ctx, target_.state, seek, options_.n_threads) != 0 ||
+        (draft_.ctx != nullptr && whisper_encode_with_state(draft_.ctx, draft_.state, seek, options_.n_threads) != 0)) {
+        error = "Encoder failed";
+        return false;
+    }
+    target_.n_past = 0;
+    draft_.n_past = 0;
+
+    seq = Sequence();
+    seq.seek_delta = WINDOW_FRAMES;
+
+    // Prompt and generated tokens, as fed to the decoders
+    std::vector<Token> fed = prompt_;
+    Token tid = 0;
+
+    // Keep the large model's pick
+    auto commit = [&](Token token) {
+        advance(seq, token, tid, seek, seek_end);
+        fed.push_back(token);
+        stats_.tokens++;
+    };
+
+    if (draft_.ctx == nullptr) {
+        while (!finished(seq)) {
+            const float* logits = decode_last(target_, fed.data() + target_.n_past,
+                                              static_cast<int>(fed.size()) - target_.n_past, error);
+            if (logits == nullptr) return false;
+            stats_.target_passes++;
+            commit(greedy(logits, seq, tid));
+        }
+        return true;
+    }
+
+    std::vector<Token> proposals;
+    while (!finished(seq)) {
+        // The draft extends the sequence greedily under the same rules,
+        // feeding whatever its cache lacks
+        const size_t committed = fed.size();
+        Sequence drafted = seq;
+        const int budget = std::min(options_.draft_tokens, max_tokens_ - static_cast<int>(seq.tokens.size()));
+        proposals.clear();
+        for (int i = 0; i < budget && !finished(drafted); i++) {
+            const float* logits = decode_last(draft_, fed.data() + draft_.n_past,
+                                              static_cast<int>(fed.size()) - draft_.n_past, error);
+            if (logits == nullptr) return false;
+            Token draft_tid = 0;
+            const Token token = greedy(logits, drafted, draft_tid);
+            advance(drafted, token, draft_tid, seek, seek_end);
+            fed.push_back(token);
+            proposals.push_back(token);
+        }
+        stats_.drafted += static_cast<int>(proposals.size());
+
+        // One pass of the large model over the pending token and the proposals.
+        // Row r scores what follows fed[first + r]; the first proposal follows
+        // the last committed token.
+        const int first = target_.n_past;
+        const float* rows = decode_all(target_, fed.data() + first, static_cast<int>(fed.size()) - first, error);
+        if (rows == nullptr) return false;
+        stats_.target_passes++;
+        fed.resize(committed);
+
+        // Keep proposals while they are what the large model picks, then its pick
+        int accepted = 0;
+        for (size_t j = 0; j <= proposals.size() && !finished(seq); j++) {
+            const float* row = rows + (committed - 1 - static_cast<size_t>(first) + j) * static_cast<size_t>(n_vocab_);
+            const Token token = greedy(row, seq, tid);
+            const bool agreed = j < proposals.size() && token == proposals[j];
+            commit(token);
+            if (!agreed) break;
+            accepted++;
+        }
+        stats_.accepted += accepted;
+
+        // Both caches stay valid up to the last proposal kept
+        const int valid = static_cast<int>(committed) + accepted;
+        target_.n_past = std::min(target_.n_past, valid);
+        draft_.n_past = std::min(draft_.n_past, valid);
+    }
+    return true;
+}
+
+int SpeculativeDecoder::window_segments(const Sequence& seq, int seek, std::vector<Segment>& out) const {
+    // whisper_full keeps the tokens up to the last timestamp, or all of them
+    // when the decoder failed and there was no temperature left to fall back to
+    const size_t n = seq.failed ? seq.tokens.size() : std::min(seq.tokens.size(), static_cast<size_t>(seq.result_len));
+    if (n == 0) return seq.seek_delta;
+
+    auto add = [&](int t0, int t1, std::string& text) {
+        Segment segment;
+        segment.start_ms = static_cast<int64_t>(t0) * 10;
+        segment.end_ms = static_cast<int64_t>(t1) * 10;
+        segment.text = std::move(text);
+        out.push_back(std::move(segment));
+        text.clear();
+    };
+
+    // A timestamp past <|0.00|> closes the text before it; a run of them
+    // starts the next segment at the first one
+    int t0 = seek + (seq.first_tid - vocab_.beg) * TIMESTAMP_FRAMES;
+    std::string text;
+    for (size_t i = 0; i < n; i++) {
+        const Token token = seq.tokens[i];
+        if (token < vocab_.eot) {
+            const char* piece = whisper_token_to_str(target_.ctx, token);
+            if (piece != nullptr) text += piece;
+        }
+        if (token > vocab_.beg) {
+            const int t1 = seek + (token - vocab_.beg) * TIMESTAMP_FRAMES;
+            if (!text.empty()) add(t0, t1, text);
+            while (i + 1 < n && seq.tokens[i + 1] > vocab_.beg) i++;
+            t0 = t1;
+        }
+    }
+    if (!text.empty()) add(t0, seek + seq.seek_delta, text);
+    return seq.seek_delta;
+}
+
+bool SpeculativeDecoder::fallback_window(int seek, int seek_end, std::vector<Segment>& out, std::string& error) {
+    const size_t first = std::min(n_samples_, static_cast<size_t>(seek) * WHISPER_HOP_LENGTH);
+    const size_t count = std::min(n_samples_ - first, static_cast<size_t>(std::min(WINDOW_FRAMES, seek_end - seek)) * WHISPER_HOP_LENGTH);
+
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.print_realtime = false;
+    params.print_progress = false;
+    params.print_timestamps = false;
+    params.print_special = false;
+    params.language = language_.c_str();
+    params.n_threads = options_.n_threads;
+    params.no_context = true;
+    params.n_max_text_ctx = 0;
+    params.temperature = options_.temperature_inc;
+    params.temperature_inc = options_.temperature_inc;
+    if (whisper_full(target_.ctx, params, samples_ + first, static_cast<int>(count)) != 0) {
+        error = "Fallback decoding failed";
+        return false;
+    }
+
+    const size_t begin = out.size();
+    read_segments(target_.ctx, nullptr, 0, out);
+    for (size_t i = begin; i < out.size(); i++) {
+        out[i].start_ms += static_cast<int64_t>(seek) * 10;
+        out[i].end_ms += static_cast<int64_t>(seek) * 10;
+    }
+    return true;
+}
+
+bool SpeculativeDecoder::transcribe(const float* samples, size_t n, const char* language, std::vector<Segment>& out,
+                                    std::string& error, const WindowCallback& on_window) {
+    const auto started = std::chrono::steady_clock::now();
+
+    if (whisper_pcm_to_mel_with_state(target_.ctx, target_.state, samples, static_cast<int>(n), options_.n_threads) != 0 ||
+        (draft_.ctx != nullptr &&
+         whisper_pcm_to_mel_with_state(draft_.ctx, draft_.state, samples, static_cast<int>(n), options_.n_threads) != 0)) {
+        error = "Failed to compute the mel spectrogram";
+        return false;
+    }
+    samples_ = samples;
+    n_samples_ = n;
+
+    // <|startoftranscript|> [<|lang|> <|transcribe|>]
+    prompt_.assign(1, vocab_.sot);
+    language_ = "en";
+    if (whisper_is_multilingual(target_.ctx)) {
+        const bool detect = language == nullptr || std::strcmp(language, "auto") == 0;
+        const int lang_id = detect
+            ? whisper_lang_auto_detect_with_state(target_.ctx, target_.state, 0, options_.n_threads, nullptr)
+            : whisper_lang_id(language);
+        if (lang_id < 0) {
+            error = detect ? "Language detection failed" : "Unknown language: " + std::string(language);
+            return false;
+        }
+        prompt_.push_back(whisper_token_lang(target_.ctx, lang_id));
+        prompt_.push_back(vocab_.transcribe);
+        language_ = whisper_lang_str(lang_id);
+    }
+
+    // Windows follow whisper_full: each starts at the last timestamp decoded
+    // in the one before, and a tail under a second is left out
+    const int n_len = whisper_n_len_from_state(target_.state);
+    Sequence seq;
+    std::vector<Segment> window;
+    int seek = 0;
+    bool ok = true;
+    while (seek + MIN_WINDOW_FRAMES < n_len) {
+        if (!decode_window(seek, n_len, seq, error)) {
+            ok = false;
+            break;
+        }
+        stats_.windows++;
+
+        window.clear();
+        int advance = 0;
+        if (seq.failed) stats_.failed++;
+        if (seq.failed && options_.temperature_inc > 0.0f) {
+            stats_.fallbacks++;
+            if (!fallback_window(seek, n_len, window, error)) {
+                ok = false;
+                break;
+            }
+            advance = std::min(WINDOW_FRAMES, n_len - seek);
+        } else {
+            advance = window_segments(seq, seek, window);
+        }
+        seek += advance;
+
+        out.insert(out.end(), window.begin(), window.end());
+        if (on_window) on_window(window, std::min(n, static_cast<size_t>(seek) * WHISPER_HOP_LENGTH));
+    }
+
+    samples_ = nullptr;
+    n_samples_ = 0;
+    stats_.decode_ms += std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    return ok;
+}
+
+bool check_speculative(whisper_context* target, whisper_context* draft, const float* samples, size_t n,
+                       const char* language, int n_threads, SpeculativeCheck& check, std::string& error) {
+    if (!SpeculativeDecoder::compatible(target, draft, error)) return false;
+
+    // whisper_full with nothing SpeculativeDecoder does not do: no fallback
+    // temperatures and no earlier windows' text as prompt
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.print_realtime = false;
+    params.print_progress = false;
+    params.print_timestamps = false;
+    params.print_special = false;
+    params.language = language != nullptr ? language : "auto";
+    params.n_threads = n_threads;
+    params.no_context = true;
+    params.n_max_text_ctx = 0;
+    params.temperature = 0.0f;
+    params.temperature_inc = 0.0f;
+
+    auto started = std::chrono::steady_clock::now();
+    if (whisper_full(target, params, samples, static_cast<int>(n)) != 0) {
+        error = "whisper_full failed";
+        return false;
+    }
+    check.reference_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    std::vector<Segment> reference;
+    read_segments(target, nullptr, 0, reference);
+
+    SpeculativeOptions options;
+    options.n_threads = n_threads;
+    options.temperature_inc = 0.0f;
+    SpeculativeDecoder decoder(target, draft, options);
+    std::vector<Segment> decoded;
+    started = std::chrono::steady_clock::now();
+    if (!decoder.transcribe(samples, n, language, decoded, error)) return false;
+    check.speculative_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    check.stats = decoder.stats();
+
+    size_t i = 0;
+    while (i < reference.size() && i < decoded.size() &&
+           reference[i].start_ms == decoded[i].start_ms && reference[i].end_ms == decoded[i].end_ms &&
+           reference[i].text == decoded[i].text) {
+        i++;
+    }
+    check.segments = reference.size();
+    check.first_difference = i;
+    check.identical = i == reference.size() && i == decoded.size();
+    return true;
+}
+
+} // namespace securevox
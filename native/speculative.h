@@ -0,0 +1,170 @@
+#pragma once
+
+#include "segment.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct whisper_context;
+struct whisper_state;
+
+namespace securevox {
+
+struct SpeculativeOptions {
+    // Tokens the draft model proposes per pass of the large model; 0 decodes
+    // with the large model alone
+    int draft_tokens = 4;
+    int n_threads = 4;
+    // A window that fails whisper_full's checks is decoded again by whisper_full
+    // from this temperature up, in steps of it, as whisper_full falls back. 0
+    // keeps the failed result, as whisper_full does at its last temperature.
+    float temperature_inc = 0.2f;
+};
+
+struct SpeculativeStats {
+    int windows = 0;
+    int tokens = 0;          // tokens kept, timestamps and end-of-text included
+    int target_passes = 0;   // decoder passes of the large model
+    int drafted = 0;         // tokens the draft proposed
+    int accepted = 0;        // of which the large model agreed with
+    int failed = 0;          // windows that failed whisper_full's checks
+    int fallbacks = 0;       // of which whisper_full decoded again at a higher temperature
+    int64_t decode_ms = 0;   // encoders and decoders of both models
+
+    // Tokens per pass of the large model. Plain greedy makes one pass per
+    // token, so this is how many times fewer large-model decoder passes were
+    // run; it is not a wall-time speedup, which the draft's own passes reduce
+    // (check_speculative measures that).
+    double tokens_per_pass() const { return target_passes > 0 ? static_cast<double>(tokens) / target_passes : 1.0; }
+    double acceptance() const { return drafted > 0 ? static_cast<double>(accepted) / drafted : 0.0; }
+};
+
+// Greedy (temperature 0) transcription with a small draft model.
+//
+// Both models encode the same 30 s window. The draft then proposes
+// draft_tokens tokens one at a time, and the large model scores all of them in
+// one batched decoder pass; the proposals are kept up to the first one that
+// differs from the large model's own choice, which is kept instead. Draft
+// proposals cost a pass of the small decoder each.
+//
+// Tokens are picked with whisper_full's logit rules and windows end, fail and
+// advance by its seek rules (the window moves to the last timestamp decoded),
+// so the transcript is meant to be whisper_full's at temperature 0 with
+// temperature_inc 0 and no previous-text prompt (n_max_text_ctx 0).
+// check_speculative compares the two on given audio.
+//
+// This is its own decoding loop over whisper's low-level API. The only part
+// of whisper_full it runs is the temperature fallback of a failed window, on
+// the target context's default state, so whisper_full must not run on target
+// at the same time. Needs patches/02-batch-logits.patch; without it only
+// draft_tokens = 0 is available.
+class SpeculativeDecoder {
+public:
+    // draft may be null for plain greedy decoding. Contexts are not owned.
+    SpeculativeDecoder(whisper_context* target, whisper_context* draft,
+                       const SpeculativeOptions& options = SpeculativeOptions());
+    ~SpeculativeDecoder();
+
+    SpeculativeDecoder(const SpeculativeDecoder&) = delete;
+    SpeculativeDecoder& operator=(const SpeculativeDecoder&) = delete;
+
+    // Whether draft can propose tokens for target: the same vocabulary, and
+    // whisper.cpp built with batched logits
+    static bool compatible(whisper_context* target, whisper_context* draft, std::string& error);
+
+    // Called after each window with its segments and the samples decoded so far
+    using WindowCallback = std::function<void(const std::vector<Segment>& window, size_t done)>;
+
+    // Transcribe 16 kHz samples, appending segments with times relative to
+    // samples. language may be "auto" or null to detect it once from the start.
+    bool transcribe(const float* samples, size_t n, const char* language, std::vector<Segment>& out,
+                    std::string& error, const WindowCallback& on_window = nullptr);
+
+    // Totals since construction
+    const SpeculativeStats& stats() const { return stats_; }
+
+private:
+    using Token = int32_t;  // whisper_token
+
+    // Special token ids of the (shared) vocabulary
+    struct Vocab {
+        Token eot = 0, sot = 0, beg = 0, no_timestamps = 0, no_speech = 0;
+        Token solm = 0, prev = 0, translate = 0, transcribe = 0, space = -1;
+        Token lang_first = 0, lang_last = -1;
+    };
+
+    struct Model {
+        whisper_context* ctx = nullptr;
+        whisper_state* state = nullptr;
+        int n_past = 0;   // tokens of the current window in the KV cache
+    };
+
+    // A window's decoder, kept as whisper_full keeps it
+    struct Sequence {
+        std::vector<Token> tokens;   // generated after the prompt
+        Token first_tid = 0;         // likeliest timestamp when the first token was picked
+        int seek_delta = 0;          // frames to advance: the last timestamp, or the whole window
+        int result_len = 0;          // tokens up to the last timestamp
+        bool has_ts = false;         // a timestamp past <|0.00|> was picked
+        bool completed = false;
+        bool failed = false;
+    };
+
+    // Feed tokens at model.n_past; logits of the last one, or of all of them
+    // (row i at i * n_vocab) with batched logits
+    const float* decode_last(Model& model, const Token* tokens, int n, std::string& error);
+    const float* decode_all(Model& model, const Token* tokens, int n, std::string& error);
+    // whisper_full's logit rules for greedy sampling: suppressed tokens and
+    // timestamp constraints
+    void filter_logits(float* logits, const Sequence& seq) const;
+    Token greedy(const float* logits, const Sequence& seq, Token& tid);
+    // Append token as whisper_full does, ending or failing the sequence
+    void advance(Sequence& seq, Token token, Token tid, int seek, int seek_end) const;
+    bool finished(const Sequence& seq) const;
+    bool decode_window(int seek, int seek_end, Sequence& seq, std::string& error);
+    // Segments of a decoded window; returns the frames to advance by
+    int window_segments(const Sequence& seq, int seek, std::vector<Segment>& out) const;
+    bool fallback_window(int seek, int seek_end, std::vector<Segment>& out, std::string& error);
+
+    Model target_;
+    Model draft_;
+    SpeculativeOptions options_;
+    SpeculativeStats stats_;
+
+    Vocab vocab_;
+    std::vector<Token> prompt_;
+    std::vector<float> scratch_;
+    int n_vocab_ = 0;
+    int max_tokens_ = 0;
+
+    // The audio and language of the running transcribe(), for fallbacks
+    const float* samples_ = nullptr;
+    size_t n_samples_ = 0;
+    std::string language_;
+};
+
+// Plain whisper_full against SpeculativeDecoder on the same audio
+struct SpeculativeCheck {
+    bool identical = false;       // the same segments, times and text
+    size_t segments = 0;          // whisper_full's
+    size_t first_difference = 0;  // index of the first segment that differs
+    int64_t reference_ms = 0;     // whisper_full's wall time
+    int64_t speculative_ms = 0;   // SpeculativeDecoder's wall time, both models
+    SpeculativeStats stats;       // of the speculative run
+
+    // Wall-time speedup of speculative decoding over whisper_full
+    double speedup() const { return speculative_ms > 0 ? static_cast<double>(reference_ms) / speculative_ms : 0.0; }
+};
+
+// Transcribe 16 kHz samples with whisper_full on target (greedy, temperature
+// 0, temperature_inc 0, n_max_text_ctx 0) and again with a SpeculativeDecoder
+// of target and draft with temperature_inc 0, then compare the segments and
+// time both. False if either run fails. No EncoderCacheScope may be open on
+// target, or the second run reuses the first one's encoder outputs.
+bool check_speculative(whisper_context* target, whisper_context* draft, const float* samples, size_t n,
+                       const char* language, int n_threads, SpeculativeCheck& check, std::string& error);
+
+} // namespace securevox
@@ -0,0 +1,261 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace securevox {
+
+namespace {
+
+thread_local int tls_worker_index = -1;
+thread_local ThreadPool* tls_worker_pool = nullptr;
+// Pool whose cap counts the calling thread: its workers, and any other thread
+// while it runs a task it helped with
+thread_local ThreadPool* tls_slot_pool = nullptr;
+
+int hardware_threads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n > 0 ? static_cast<int>(n) : 1;
+}
+
+} // namespace
+
+ThreadPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), count_(other.count_), reserved_(other.reserved_) {
+    other.pool_ = nullptr;
+    other.count_ = 0;
+    other.reserved_ = 0;
+}
+
+ThreadPool::Lease& ThreadPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        if (pool_ != nullptr) pool_->release(reserved_);
+        pool_ = other.pool_;
+        count_ = other.count_;
+        reserved_ = other.reserved_;
+        other.pool_ = nullptr;
+        other.count_ = 0;
+        other.reserved_ = 0;
+    }
+    return *this;
+}
+
+ThreadPool::Lease::~Lease() {
+    if (pool_ != nullptr) pool_->release(reserved_);
+}
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool(hardware_threads());
+    return pool;
+}
+
+ThreadPool::ThreadPool(int max_threads)
+    : max_threads_(max_threads > 0 ? max_threads : hardware_threads()) {
+    const int n_workers = std::max(hardware_threads(), max_threads_);
+    workers_.reserve(n_workers);
+    for (int i = 0; i < n_workers; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < n_workers; i++) {
+        workers_[i]->thread = std::thread(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+void ThreadPool::set_max_threads(int max_threads) {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        // Workers are spawned once; a cap above the pool size only widens leases
+        max_threads_ = max_threads > 0 ? max_threads : hardware_threads();
+    }
+    cv_.notify_all();
+}
+
+int ThreadPool::max_threads() const {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return max_threads_;
+}
+
+int ThreadPool::current_worker() {
+    return tls_worker_index;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    int index = tls_worker_pool == this ? tls_worker_index : -1;
+    if (index < 0) {
+        index = static_cast<int>(next_queue_.fetch_add(1, std::memory_order_relaxed) % workers_.size());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // Counted under the state mutex so a sleeping worker cannot miss the wakeup
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        pending_++;
+    }
+    cv_.notify_one();
+}
+
+bool ThreadPool::pop_task(int index, std::function<void()>& task) {
+    const int n = static_cast<int>(workers_.size());
+
+    // Own deque first, newest task first
+    if (index >= 0) {
+        Worker& own = *workers_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest task from the other deques
+    const int start = index >= 0 ? index + 1 : 0;
+    for (int k = 0; k < n; k++) {
+        const int victim = (start + k) % n;
+        if (victim == index) continue;
+        Worker& other = *workers_[victim];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::worker_loop(int index) {
+    tls_worker_index = index;
+    tls_worker_pool = this;
+    tls_slot_pool = this;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(state_mutex_);
+            cv_.wait(lock, [this] {
+                return stopping_ ||
+                       (pending_ > 0 && in_use_ < max_threads_);
+            });
+            if (stopping_ && pending_ == 0) return;
+            // Claim a task and a slot together so a wakeup never over-counts in_use_
+            pending_--;
+            in_use_++;
+        }
+
+        // A claimed task is always in some deque: tasks are queued before being counted
+        std::function<void()> task;
+        while (!pop_task(index, task)) {
+            std::this_thread::yield();
+        }
+        task();
+
+        release(1);
+    }
+}
+
+bool ThreadPool::try_run_one() {
+    // A thread that holds a slot helps in it; any other thread must claim a
+    // free one, or helping would run more CPU-bound threads than the cap allows
+    const int index = tls_worker_pool == this ? tls_worker_index : -1;
+    const bool holds_slot = tls_slot_pool == this;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        if (pending_ == 0 || (!holds_slot && in_use_ >= max_threads_)) return false;
+        pending_--;
+        if (!holds_slot) in_use_++;
+    }
+
+    std::function<void()> task;
+    while (!pop_task(index, task)) {
+        std::this_thread::yield();
+    }
+    if (holds_slot) {
+        task();
+        return true;
+    }
+
+    // The task runs in the claimed slot, so leases it takes borrow around it
+    ThreadPool* const outer = tls_slot_pool;
+    tls_slot_pool = this;
+    task();
+    tls_slot_pool = outer;
+    release(1);
+    return true;
+}
+
+void ThreadPool::parallel_for(int n, const std::function<void(int)>& fn) {
+    if (n <= 0) return;
+    if (n == 1) {
+        fn(0);
+        return;
+    }
+
+    std::atomic<int> remaining{n};
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+
+    for (int i = 0; i < n; i++) {
+        submit([&, i] {
+            fn(i);
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(done_mutex);
+                done_cv.notify_all();
+            }
+        });
+    }
+
+    // Help drain the queues instead of blocking a thread that could do work
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (try_run_one()) continue;
+
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done_cv.wait_for(lock, std::chrono::milliseconds(1), [&] {
+            return remaining.load(std::memory_order_acquire) == 0;
+        });
+    }
+}
+
+ThreadPool::Lease ThreadPool::lease(int wanted) {
+    wanted = std::max(1, wanted);
+    const bool holds_slot = tls_slot_pool == this;
+
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    if (holds_slot) {
+        // The caller already holds a slot; only borrow what is free right now so
+        // nested leases can never deadlock against their own pool.
+        const int extra = std::max(0, std::min(wanted - 1, max_threads_ - in_use_));
+        in_use_ += extra;
+        return Lease(this, 1 + extra, extra);
+    }
+
+    cv_.wait(lock, [this] { return in_use_ < max_threads_; });
+    const int granted = std::min(wanted, max_threads_ - in_use_);
+    in_use_ += granted;
+    return Lease(this, granted, granted);
+}
+
+void ThreadPool::release(int reserved) {
+    if (reserved <= 0) return;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        in_use_ -= reserved;
+    }
+    cv_.notify_all();
+}
+
+} // namespace securevox
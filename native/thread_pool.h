@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace securevox {
+
+// Process-wide work-stealing thread pool shared by preprocessing and inference.
+//
+// Every worker owns a deque: tasks submitted from a worker are pushed to its own
+// deque and popped LIFO, tasks submitted from other threads are spread round-robin,
+// and idle workers steal from the front of the other deques.
+//
+// The cap limits how many CPU-bound threads run at once. ggml spawns its own
+// threads inside whisper_full, so inference takes a Lease for its n_threads and
+// those threads count against the same cap as the pool workers. Running several
+// jobs at once then divides the cores instead of oversubscribing them.
+class ThreadPool {
+public:
+    // Threads reserved for work that runs outside the pool (e.g. ggml threads).
+    // The reservation is returned to the pool when the lease is destroyed.
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        // Number of threads the holder may run
+        int count() const { return count_; }
+
+    private:
+        friend class ThreadPool;
+        Lease(ThreadPool* pool, int count, int reserved)
+            : pool_(pool), count_(count), reserved_(reserved) {}
+
+        ThreadPool* pool_ = nullptr;
+        int count_ = 0;
+        int reserved_ = 0;  // slots taken from the cap (excludes the caller's own worker slot)
+    };
+
+    static ThreadPool& instance();
+
+    explicit ThreadPool(int max_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Cap on concurrently running CPU-bound threads (busy workers + leased threads).
+    // Values <= 0 reset the cap to the number of hardware threads.
+    void set_max_threads(int max_threads);
+    int max_threads() const;
+
+    // Number of worker threads owned by the pool
+    int size() const { return static_cast<int>(workers_.size()); }
+
+    void submit(std::function<void()> task);
+
+    template <class F>
+    auto async(F&& fn) -> std::future<decltype(fn())> {
+        using R = decltype(fn());
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+        std::future<R> result = task->get_future();
+        submit([task]() { (*task)(); });
+        return result;
+    }
+
+    // Run fn(i) for every i in [0, n) and wait for all of them. The calling thread
+    // runs queued tasks while it waits, so nesting inside a pool task is safe. A
+    // pool worker runs them in the slot it already holds; any other thread only
+    // takes a free slot of the cap while it runs one, so helping never exceeds it,
+    // and a lease taken inside that task counts the slot as the caller's own.
+    void parallel_for(int n, const std::function<void(int)>& fn);
+
+    // Reserve up to `wanted` threads for work outside the pool. Blocks until at
+    // least one thread is free; the lease may hold fewer threads than requested.
+    // When called from a pool task, the slot it runs in is part of the lease and
+    // only threads free right now are added, without blocking.
+    // Pool tasks only run in the slots left over, so a holder must not block on
+    // pool work while its lease saturates the cap.
+    Lease lease(int wanted);
+
+    // Index of the calling worker, or -1 when called from outside the pool
+    static int current_worker();
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+        std::thread thread;
+    };
+
+    void worker_loop(int index);
+    bool pop_task(int index, std::function<void()>& task);
+    bool try_run_one();
+    void release(int reserved);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    mutable std::mutex state_mutex_;
+    std::condition_variable cv_;
+    int max_threads_;
+    int in_use_ = 0;
+    int pending_ = 0;  // queued tasks not yet claimed by a thread
+    bool stopping_ = false;
+
+    std::atomic<unsigned> next_queue_{0};
+};
+
+} // namespace securevox
@@ -0,0 +1,464 @@
+#include "transcript_index.h"
+
+#include "binary_io.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace securevox {
+
+namespace {
+
+constexpr char MAGIC[4] = {'S', 'V', 'I', 'X'};
+constexpr uint32_t VERSION = 1;
+
+constexpr char RECORD_ADD = 'A';
+constexpr char RECORD_REMOVE = 'R';
+
+// Sanity limits when reading back the log
+constexpr uint32_t MAX_ID_BYTES = 256;
+constexpr uint32_t MAX_TEXT_BYTES = 64 * 1024;
+
+// Compact on open once superseded records make up this share of the log
+constexpr double COMPACT_DEAD_RATIO = 0.25;
+
+void put_string(std::string& buf, const std::string& s) {
+    put_u32(buf, static_cast<uint32_t>(s.size()));
+    buf.append(s);
+}
+
+bool get_string(FILE* f, uint32_t max_len, std::string& s) {
+    uint32_t len;
+    if (!get_u32(f, len) || len > max_len) return false;
+    s.resize(len);
+    return len == 0 || std::fread(&s[0], 1, len, f) == len;
+}
+
+void encode_add(std::string& buf, const std::string& recording_id, uint32_t segment_index, const Segment& segment) {
+    const size_t begin = buf.size();
+    buf.push_back(RECORD_ADD);
+    put_string(buf, recording_id);
+    put_u32(buf, segment_index);
+    put_u64(buf, static_cast<uint64_t>(segment.start_ms));
+    put_u64(buf, static_cast<uint64_t>(segment.end_ms));
+    put_string(buf, segment.text);
+    put_u32(buf, fnv1a(buf.data() + begin, buf.size() - begin));
+}
+
+void encode_remove(std::string& buf, const std::string& recording_id) {
+    const size_t begin = buf.size();
+    buf.push_back(RECORD_REMOVE);
+    put_string(buf, recording_id);
+    put_u32(buf, fnv1a(buf.data() + begin, buf.size() - begin));
+}
+
+// A decoded log record
+struct LogRecord {
+    char type = 0;
+    std::string recording_id;
+    uint32_t segment_index = 0;
+    Segment segment;
+    bool live = true;
+};
+
+bool read_record(FILE* f, LogRecord& record) {
+    char type;
+    if (std::fread(&type, 1, 1, f) != 1) return false;
+    if (type != RECORD_ADD && type != RECORD_REMOVE) return false;
+
+    record.type = type;
+    if (!get_string(f, MAX_ID_BYTES, record.recording_id)) return false;
+
+    std::string encoded;
+    if (type == RECORD_ADD) {
+        uint64_t start, end;
+        if (!get_u32(f, record.segment_index) || !get_u64(f, start) || !get_u64(f, end) ||
+            !get_string(f, MAX_TEXT_BYTES, record.segment.text)) {
+            return false;
+        }
+        record.segment.start_ms = static_cast<int64_t>(start);
+        record.segment.end_ms = static_cast<int64_t>(end);
+        encode_add(encoded, record.recording_id, record.segment_index, record.segment);
+    } else {
+        encode_remove(encoded, record.recording_id);
+    }
+
+    uint32_t checksum;
+    return get_u32(f, checksum) && fnv1a(encoded.data(), encoded.size() - 4) == checksum;
+}
+
+bool is_word_byte(unsigned char c) {
+    // Bytes >= 0x80 keep UTF-8 words intact; only ASCII is case-folded
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+bool starts_with(const std::string& s, const std::string& prefix) {
+    return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+}
+
+} // namespace
+
+TranscriptIndex::~TranscriptIndex() {
+    if (log_ != nullptr) std::fclose(log_);
+}
+
+std::vector<std::string> TranscriptIndex::tokenize(const std::string& text) {
+    std::vector<std::string> terms;
+    std::string current;
+    for (unsigned char c : text) {
+        if (is_word_byte(c)) {
+            current.push_back(static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c));
+        } else if (c == '\'' && !current.empty()) {
+            // "don't" indexes as "dont"
+        } else if (!current.empty()) {
+            terms.push_back(std::move(current));
+            current.clear();
+        }
+    }
+    if (!current.empty()) terms.push_back(std::move(current));
+    return terms;
+}
+
+bool TranscriptIndex::open(const std::string& path, std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    path_ = path;
+    if (log_ != nullptr) {
+        std::fclose(log_);
+        log_ = nullptr;
+    }
+    terms_.clear();
+    segments_.clear();
+    recording_ids_.clear();
+    recording_live_.clear();
+    recording_slots_.clear();
+    live_recordings_ = 0;
+
+    // Replay the log, tracking which records a later remove supersedes
+    std::vector<LogRecord> records;
+    bool intact = true;
+    bool exists = false;
+    if (FILE* f = std::fopen(path.c_str(), "rb")) {
+        exists = true;
+        char magic[4];
+        uint32_t version = 0;
+        if (std::fread(magic, 1, 4, f) == 4 && std::memcmp(magic, MAGIC, 4) == 0 &&
+            get_u32(f, version) && version == VERSION) {
+
+            std::unordered_map<std::string, std::vector<size_t>> by_recording;
+            LogRecord record;
+            long good_end = std::ftell(f);
+            while (read_record(f, record)) {
+                good_end = std::ftell(f);
+                std::vector<size_t>& live = by_recording[record.recording_id];
+                if (record.type == RECORD_REMOVE) {
+                    for (size_t i : live) records[i].live = false;
+                    live.clear();
+                    record.live = false;
+                } else {
+                    live.push_back(records.size());
+                }
+                records.push_back(std::move(record));
+                record = LogRecord();
+            }
+            // Anything after the last valid record is a torn write
+            intact = std::fseek(f, 0, SEEK_END) == 0 && std::ftell(f) == good_end;
+        } else {
+            intact = false;
+        }
+        std::fclose(f);
+    }
+
+    size_t dead = 0;
+    for (const LogRecord& record : records) {
+        if (!record.live) {
+            dead++;
+            continue;
+        }
+        index_segment(recording_slot(record.recording_id), record.segment_index, record.segment);
+    }
+
+    // Rewrite when the log is new, has a torn tail, or superseded records make up at least a quarter of it
+    const bool rewrite = !exists || !intact ||
+        (dead > 0 && static_cast<double>(dead) >= COMPACT_DEAD_RATIO * static_cast<double>(records.size()));
+
+    if (rewrite) {
+        std::string buf(MAGIC, 4);
+        put_u32(buf, VERSION);
+        for (const LogRecord& record : records) {
+            if (record.live) encode_add(buf, record.recording_id, record.segment_index, record.segment);
+        }
+
+        const std::string tmp = path + ".tmp";
+        FILE* out = std::fopen(tmp.c_str(), "wb");
+        if (out == nullptr) {
+            error = "Cannot write index: " + tmp;
+            return false;
+        }
+        const bool written = std::fwrite(buf.data(), 1, buf.size(), out) == buf.size() && sync_file(out);
+        std::fclose(out);
+        if (!written) {
+            std::remove(tmp.c_str());
+            error = "Cannot write index: " + tmp;
+            return false;
+        }
+#ifdef _WIN32
+        std::remove(path.c_str());  // rename does not replace on Windows
+#endif
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            error = "Cannot replace index: " + path;
+            return false;
+        }
+    }
+
+    log_ = std::fopen(path.c_str(), "ab");
+    if (log_ == nullptr) {
+        error = "Cannot open index: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool TranscriptIndex::set_recording(const std::string& recording_id, const std::vector<Segment>& segments) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::string records;
+    auto it = recording_slots_.find(recording_id);
+    if (it != recording_slots_.end()) {
+        drop_recording(it->second);
+        encode_remove(records, recording_id);
+    }
+
+    if (!segments.empty()) {
+        const uint32_t recording = recording_slot(recording_id);
+        for (size_t i = 0; i < segments.size(); i++) {
+            index_segment(recording, static_cast<uint32_t>(i), segments[i]);
+            encode_add(records, recording_id, static_cast<uint32_t>(i), segments[i]);
+        }
+    }
+    return append_log(records);
+}
+
+bool TranscriptIndex::add_segments(const std::string& recording_id, uint32_t first_index,
+                                   const std::vector<Segment>& segments) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (segments.empty()) return true;
+
+    std::string records;
+    const uint32_t recording = recording_slot(recording_id);
+    for (size_t i = 0; i < segments.size(); i++) {
+        const uint32_t segment_index = first_index + static_cast<uint32_t>(i);
+        index_segment(recording, segment_index, segments[i]);
+        encode_add(records, recording_id, segment_index, segments[i]);
+    }
+    return append_log(records);
+}
+
+bool TranscriptIndex::remove_recording(const std::string& recording_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = recording_slots_.find(recording_id);
+    if (it == recording_slots_.end()) return true;
+    drop_recording(it->second);
+
+    std::string records;
+    encode_remove(records, recording_id);
+    return append_log(records);
+}
+
+size_t TranscriptIndex::recording_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return live_recordings_;
+}
+
+uint32_t TranscriptIndex::recording_slot(const std::string& recording_id) {
+    auto it = recording_slots_.find(recording_id);
+    if (it != recording_slots_.end()) return it->second;
+
+    // A replaced or re-added recording gets a fresh slot; segments of the old
+    // one stay behind the dead slot until the log is compacted
+    const uint32_t slot = static_cast<uint32_t>(recording_ids_.size());
+    recording_ids_.push_back(recording_id);
+    recording_live_.push_back(true);
+    recording_slots_.emplace(recording_id, slot);
+    live_recordings_++;
+    return slot;
+}
+
+void TranscriptIndex::drop_recording(uint32_t recording) {
+    recording_live_[recording] = false;
+    recording_slots_.erase(recording_ids_[recording]);
+    live_recordings_--;
+}
+
+void TranscriptIndex::index_segment(uint32_t recording, uint32_t segment_index, const Segment& segment) {
+    const std::vector<std::string> words = tokenize(segment.text);
+    const uint32_t id = static_cast<uint32_t>(segments_.size());
+    segments_.push_back({recording, segment_index, segment.start_ms, segment.end_ms,
+                         static_cast<uint32_t>(words.size())});
+
+    // Group positions per term so each posting is written once per segment
+    std::map<std::string, std::vector<uint32_t>> positions;
+    for (size_t i = 0; i < words.size(); i++) {
+        positions[words[i]].push_back(static_cast<uint32_t>(i));
+    }
+
+    for (const auto& entry : positions) {
+        Postings& postings = terms_[entry.first];
+        put_varint(postings.bytes, id - postings.last_segment);
+        put_varint(postings.bytes, entry.second.size());
+        uint32_t previous = 0;
+        for (uint32_t position : entry.second) {
+            put_varint(postings.bytes, position - previous);
+            previous = position;
+        }
+        postings.last_segment = id;
+        postings.n_segments++;
+    }
+}
+
+bool TranscriptIndex::append_log(const std::string& records) {
+    if (log_ == nullptr || records.empty()) return log_ != nullptr;
+    if (std::fwrite(records.data(), 1, records.size(), log_) != records.size()) return false;
+    return sync_file(log_);
+}
+
+void TranscriptIndex::collect(const Postings& postings, Matches& out) const {
+    size_t pos = 0;
+    uint64_t segment = 0;
+    uint64_t delta, count, gap;
+    while (pos < postings.bytes.size()) {
+        if (!get_varint(postings.bytes, pos, delta) || !get_varint(postings.bytes, pos, count)) return;
+        segment += delta;
+
+        const bool live = recording_live_[segments_[segment].recording];
+        std::vector<uint32_t>* positions = live ? &out[static_cast<uint32_t>(segment)] : nullptr;
+        uint64_t position = 0;
+        for (uint64_t i = 0; i < count; i++) {
+            if (!get_varint(postings.bytes, pos, gap)) return;
+            position += gap;
+            if (positions != nullptr) positions->push_back(static_cast<uint32_t>(position));
+        }
+    }
+}
+
+TranscriptIndex::Matches TranscriptIndex::lookup(const QueryTerm& term) const {
+    Matches matches;
+    if (!term.prefix) {
+        auto it = terms_.find(term.text);
+        if (it != terms_.end()) collect(it->second, matches);
+        return matches;
+    }
+
+    for (auto it = terms_.lower_bound(term.text); it != terms_.end() && starts_with(it->first, term.text); ++it) {
+        collect(it->second, matches);
+    }
+    // Several expansions can hit the same segment
+    for (auto& entry : matches) {
+        std::sort(entry.second.begin(), entry.second.end());
+    }
+    return matches;
+}
+
+std::vector<TranscriptIndex::QueryTerm> TranscriptIndex::parse_query(const std::string& query) {
+    std::vector<QueryTerm> terms;
+    bool in_quote = false;
+    bool quote_started = false;  // a term has been emitted inside the current quote
+    std::string word;
+
+    auto flush = [&]() {
+        const bool star = !word.empty() && word.back() == '*';
+        const std::vector<std::string> tokens = tokenize(word);
+        for (size_t i = 0; i < tokens.size(); i++) {
+            QueryTerm term;
+            term.text = tokens[i];
+            term.prefix = star && i + 1 == tokens.size();
+            // Hyphenated and quoted words must be adjacent
+            term.follows_previous = i > 0 || (in_quote && quote_started);
+            terms.push_back(std::move(term));
+            if (in_quote) quote_started = true;
+        }
+        word.clear();
+    };
+
+    for (char c : query) {
+        if (c == '"') {
+            flush();
+            in_quote = !in_quote;
+            quote_started = false;
+        } else if (c == ' ' || c == '\t' || c == '\n') {
+            flush();
+        } else {
+            word.push_back(c);
+        }
+    }
+    flush();
+
+    // Search as you type: the word being typed matches as a prefix
+    const char last = query.empty() ? ' ' : query.back();
+    if (!terms.empty() && last != ' ' && last != '\t' && last != '\n' && last != '"') {
+        terms.back().prefix = true;
+    }
+    return terms;
+}
+
+std::vector<SearchHit> TranscriptIndex::search(const std::string& query, size_t limit) const {
+    const std::vector<QueryTerm> terms = parse_query(query);
+    std::vector<SearchHit> hits;
+    if (terms.empty() || limit == 0) return hits;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Candidate segments with the positions where the current phrase chain ends
+    Matches state = lookup(terms[0]);
+    size_t chain = 0;  // words in the phrase ending at the current term, minus one
+
+    for (size_t t = 1; t < terms.size() && !state.empty(); t++) {
+        const Matches next = lookup(terms[t]);
+        Matches merged;
+        for (auto& entry : state) {
+            auto it = next.find(entry.first);
+            if (it == next.end()) continue;
+
+            if (!terms[t].follows_previous) {
+                merged.emplace(entry.first, it->second);
+                continue;
+            }
+            std::vector<uint32_t> adjacent;
+            for (uint32_t position : it->second) {
+                if (position > 0 && std::binary_search(entry.second.begin(), entry.second.end(), position - 1)) {
+                    adjacent.push_back(position);
+                }
+            }
+            if (!adjacent.empty()) merged.emplace(entry.first, std::move(adjacent));
+        }
+        state.swap(merged);
+        chain = terms[t].follows_previous ? chain + 1 : 0;
+    }
+
+    std::vector<uint32_t> matched;
+    matched.reserve(state.size());
+    for (const auto& entry : state) matched.push_back(entry.first);
+    std::sort(matched.begin(), matched.end());
+    if (matched.size() > limit) matched.resize(limit);
+
+    hits.reserve(matched.size());
+    for (uint32_t id : matched) {
+        const SegmentRef& ref = segments_[id];
+        const std::vector<uint32_t>& positions = state[id];
+        const uint32_t anchor = positions.front() >= chain ? positions.front() - static_cast<uint32_t>(chain) : 0;
+
+        // whisper gives segment-level times; place the word proportionally inside
+        SearchHit hit;
+        hit.recording_id = recording_ids_[ref.recording];
+        hit.segment_index = ref.segment_index;
+        hit.segment_start_ms = ref.start_ms;
+        hit.time_ms = ref.start_ms;
+        if (ref.n_terms > 0 && ref.end_ms > ref.start_ms) {
+            hit.time_ms += (ref.end_ms - ref.start_ms) * anchor / ref.n_terms;
+        }
+        hits.push_back(std::move(hit));
+    }
+    return hits;
+}
+
+} // namespace securevox
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "segment.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace securevox {
+
+// A query match, resolved to a position inside a recording
+struct SearchHit {
+    std::string recording_id;
+    uint32_t segment_index = 0;
+    int64_t segment_start_ms = 0;
+    int64_t time_ms = 0;  // estimated time of the matched word
+};
+
+// Persistent inverted index over transcript segments.
+//
+// Terms map to delta/varint-compressed postings of (segment, word positions);
+// each indexed segment resolves to its recording, segment index and time
+// range, so a hit points straight into the audio. Updates are appended to a
+// checksummed log next to the in-memory index, which is replayed on open and
+// compacted once superseded records (those of removed recordings, and the
+// removals themselves) make up a quarter of it.
+//
+// Queries match segments containing every term. The last term is a prefix
+// unless the query ends in whitespace, and a trailing '*' makes any term a
+// prefix. "Quoted words" must appear consecutively.
+//
+// All methods are thread safe.
+class TranscriptIndex {
+public:
+    TranscriptIndex() = default;
+    ~TranscriptIndex();
+
+    TranscriptIndex(const TranscriptIndex&) = delete;
+    TranscriptIndex& operator=(const TranscriptIndex&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+
+    // Replace everything indexed for a recording
+    bool set_recording(const std::string& recording_id, const std::vector<Segment>& segments);
+
+    // Index more segments of a recording as they are transcribed.
+    // first_index is the segment index of segments[0].
+    bool add_segments(const std::string& recording_id, uint32_t first_index,
+                      const std::vector<Segment>& segments);
+
+    bool remove_recording(const std::string& recording_id);
+
+    std::vector<SearchHit> search(const std::string& query, size_t limit) const;
+
+    // Number of recordings with indexed text
+    size_t recording_count() const;
+
+    // Split text into lowercase index terms
+    static std::vector<std::string> tokenize(const std::string& text);
+
+private:
+    struct Postings {
+        std::string bytes;          // [segment delta][n positions][position deltas...]*
+        uint32_t last_segment = 0;
+        uint32_t n_segments = 0;
+    };
+
+    struct SegmentRef {
+        uint32_t recording;
+        uint32_t segment_index;
+        int64_t start_ms;
+        int64_t end_ms;
+        uint32_t n_terms;
+    };
+
+    struct QueryTerm {
+        std::string text;
+        bool prefix = false;
+        bool follows_previous = false;  // next word of a quoted phrase
+    };
+
+    // Matching segment -> word positions
+    using Matches = std::unordered_map<uint32_t, std::vector<uint32_t>>;
+
+    uint32_t recording_slot(const std::string& recording_id);
+    void index_segment(uint32_t recording, uint32_t segment_index, const Segment& segment);
+    void drop_recording(uint32_t recording);
+    bool append_log(const std::string& records);
+
+    void collect(const Postings& postings, Matches& out) const;
+    Matches lookup(const QueryTerm& term) const;
+    static std::vector<QueryTerm> parse_query(const std::string& query);
+
+    mutable std::mutex mutex_;
+    std::string path_;
+    FILE* log_ = nullptr;
+
+    std::map<std::string, Postings> terms_;  // ordered for prefix scans
+    std::vector<SegmentRef> segments_;
+    std::vector<std::string> recording_ids_;
+    std::vector<bool> recording_live_;
+    std::unordered_map<std::string, uint32_t> recording_slots_;
+    size_t live_recordings_ = 0;
+};
+
+} // namespace securevox
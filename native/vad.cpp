@@ -0,0 +1,116 @@
+#include "vad.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace securevox {
+
+namespace {
+
+// Percentile of frame energies taken as the noise floor
+constexpr float NOISE_FLOOR_PERCENTILE = 0.10f;
+
+size_t ms_to_samples(int ms, int sample_rate) {
+    return static_cast<size_t>(ms > 0 ? ms : 0) * sample_rate / 1000;
+}
+
+} // namespace
+
+SpeechRegions detect_speech(const float* samples, size_t n, int sample_rate,
+                            const VadOptions& options, Arena* arena) {
+    SpeechRegions regions{ArenaAllocator<SampleRange>(arena)};
+    const size_t frame = std::max<size_t>(1, ms_to_samples(options.frame_ms, sample_rate));
+    const size_t n_frames = n / frame;
+    if (n_frames == 0) return regions;
+
+    SampleVector energy(n_frames, ArenaAllocator<float>(arena));
+    for (size_t f = 0; f < n_frames; f++) {
+        const float* p = samples + f * frame;
+        float sum = 0.0f;
+        for (size_t i = 0; i < frame; i++) sum += p[i] * p[i];
+        energy[f] = 10.0f * std::log10(sum / frame + 1e-10f);
+    }
+
+    // The whole recording is available, so take the floor from its quiet frames
+    // rather than tracking it adaptively.
+    SampleVector sorted(energy);
+    const size_t k = static_cast<size_t>(NOISE_FLOOR_PERCENTILE * (n_frames - 1));
+    std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+    const float threshold = std::max(sorted[k] + options.threshold_db, options.min_energy_db);
+
+    const size_t min_speech = ms_to_samples(options.min_speech_ms, sample_rate);
+    const size_t min_silence = ms_to_samples(options.min_silence_ms, sample_rate);
+    const size_t pad = ms_to_samples(options.pad_ms, sample_rate);
+
+    // Runs of speech frames, bridging short pauses
+    SpeechRegions runs{ArenaAllocator<SampleRange>(arena)};
+    for (size_t f = 0; f < n_frames; f++) {
+        if (energy[f] < threshold) continue;
+        const size_t begin = f * frame;
+        const size_t end = std::min(n, begin + frame);
+        if (!runs.empty() && begin - runs.back().end < min_silence) {
+            runs.back().end = end;
+        } else {
+            runs.push_back({begin, end});
+        }
+    }
+
+    for (const SampleRange& run : runs) {
+        if (run.end - run.begin < min_speech) continue;
+        const size_t begin = run.begin > pad ? run.begin - pad : 0;
+        const size_t end = std::min(n, run.end + pad);
+        if (!regions.empty() && begin <= regions.back().end) {
+            regions.back().end = std::max(regions.back().end, end);
+        } else {
+            regions.push_back({begin, end});
+        }
+    }
+
+    return regions;
+}
+
+void TimeMap::add(size_t compact_begin, size_t original_begin, size_t length) {
+    spans_.push_back({compact_begin, original_begin, length});
+}
+
+size_t TimeMap::to_original(size_t compact) const {
+    if (spans_.empty()) return compact;
+
+    // Last span starting at or before the position
+    auto it = std::upper_bound(spans_.begin(), spans_.end(), compact,
+        [](size_t pos, const Span& span) { return pos < span.compact_begin; });
+    if (it == spans_.begin()) return spans_.front().original_begin;
+    --it;
+
+    const size_t offset = std::min(compact - it->compact_begin, it->length);
+    return it->original_begin + offset;
+}
+
+int64_t TimeMap::to_original_ms(int64_t compact_ms, int sample_rate) const {
+    if (spans_.empty()) return compact_ms;
+    // Position 0 still maps past any leading silence that was removed
+    const size_t compact = static_cast<size_t>(std::max<int64_t>(compact_ms, 0)) * sample_rate / 1000;
+    return static_cast<int64_t>(to_original(compact) * 1000 / sample_rate);
+}
+
+void remove_silence(const float* samples, size_t n, const SpeechRegions& speech,
+                    SampleVector& out, TimeMap& map) {
+    out.clear();
+    map.clear();
+
+    if (speech.empty()) {
+        out.assign(samples, samples + n);
+        return;
+    }
+
+    size_t total = 0;
+    for (const SampleRange& r : speech) total += r.end - r.begin;
+    out.reserve(total);
+
+    for (const SampleRange& r : speech) {
+        map.add(out.size(), r.begin, r.end - r.begin);
+        out.insert(out.end(), samples + r.begin, samples + r.end);
+    }
+}
+
+} // namespace securevox
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "arena.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace securevox {
+
+// Half-open sample range [begin, end)
+struct SampleRange {
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+struct VadOptions {
+    int frame_ms = 30;
+    // Frames this far above the noise floor count as speech
+    float threshold_db = 9.0f;
+    // Absolute floor below which a frame is never speech
+    float min_energy_db = -60.0f;
+    // Speech shorter than this is dropped
+    int min_speech_ms = 120;
+    // Silence shorter than this does not split speech
+    int min_silence_ms = 600;
+    // Padding kept around every speech region
+    int pad_ms = 200;
+};
+
+using SpeechRegions = ArenaVector<SampleRange>;
+
+// Energy-based voice activity detector. The noise floor is the 10th
+// percentile of the frame energies over the whole recording, one fixed value
+// rather than one tracked over time.
+// Returns padded, merged speech regions in samples. The result and the
+// per-frame scratch are allocated from arena when one is given.
+SpeechRegions detect_speech(const float* samples, size_t n, int sample_rate,
+                            const VadOptions& options = VadOptions(), Arena* arena = nullptr);
+
+// Maps positions in audio with silence removed back to the original timeline
+class TimeMap {
+public:
+    explicit TimeMap(Arena* arena = nullptr) : spans_(ArenaAllocator<Span>(arena)) {}
+
+    void add(size_t compact_begin, size_t original_begin, size_t length);
+    void clear() { spans_.clear(); }
+
+    // Original sample position for a position in the compacted audio
+    size_t to_original(size_t compact) const;
+
+    // Same as to_original, in milliseconds
+    int64_t to_original_ms(int64_t compact_ms, int sample_rate) const;
+
+    bool empty() const { return spans_.empty(); }
+
+private:
+    struct Span {
+        size_t compact_begin;
+        size_t original_begin;
+        size_t length;
+    };
+    ArenaVector<Span> spans_;
+};
+
+// Keep only the speech regions of samples. When nothing is detected as speech
+// the audio is kept as-is so quiet recordings still reach the model.
+// out and map keep their allocators.
+void remove_silence(const float* samples, size_t n, const SpeechRegions& speech,
+                    SampleVector& out, TimeMap& map);
+
+} // namespace securevox
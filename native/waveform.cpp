@@ -0,0 +1,411 @@
+#include "waveform.h"
+
+#include "audio_decoder.h"
+#include "binary_io.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SECUREVOX_WAVEFORM_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SECUREVOX_WAVEFORM_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX  // std::min/std::max below
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace securevox {
+
+namespace {
+
+// Layout: magic, version, sample rate, base samples, fanout, level count,
+// total samples, then the bucket count of every level, then the buckets of
+// each level in order, finest first. Buckets are stored as they sit in memory
+// (both supported targets are little-endian) so a mapped file is read in place.
+constexpr char MAGIC[4] = {'S', 'V', 'W', 'F'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t FIXED_HEADER_BYTES = 32;
+
+static_assert(sizeof(WaveformBucket) == 6, "buckets are stored packed");
+
+// Min, max and sum of squares of n samples
+void reduce(const float* p, size_t n, float& lo, float& hi, double& sum_squares) {
+    size_t i = 0;
+    float min_value = p[0];
+    float max_value = p[0];
+    float squares = 0.0f;
+#if defined(SECUREVOX_WAVEFORM_SSE2)
+    if (n >= 4) {
+        __m128 vmin = _mm_loadu_ps(p);
+        __m128 vmax = vmin;
+        __m128 vsum = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4) {
+            const __m128 x = _mm_loadu_ps(p + i);
+            vmin = _mm_min_ps(vmin, x);
+            vmax = _mm_max_ps(vmax, x);
+            vsum = _mm_add_ps(vsum, _mm_mul_ps(x, x));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, vmin);
+        min_value = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+        _mm_store_ps(lanes, vmax);
+        max_value = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+        _mm_store_ps(lanes, vsum);
+        squares = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+#elif defined(SECUREVOX_WAVEFORM_NEON)
+    if (n >= 4) {
+        float32x4_t vmin = vld1q_f32(p);
+        float32x4_t vmax = vmin;
+        float32x4_t vsum = vdupq_n_f32(0.0f);
+        for (; i + 4 <= n; i += 4) {
+            const float32x4_t x = vld1q_f32(p + i);
+            vmin = vminq_f32(vmin, x);
+            vmax = vmaxq_f32(vmax, x);
+            vsum = vmlaq_f32(vsum, x, x);
+        }
+        float lanes[4];
+        vst1q_f32(lanes, vmin);
+        min_value = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+        vst1q_f32(lanes, vmax);
+        max_value = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+        vst1q_f32(lanes, vsum);
+        squares = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+#endif
+    for (; i < n; i++) {
+        min_value = std::min(min_value, p[i]);
+        max_value = std::max(max_value, p[i]);
+        squares += p[i] * p[i];
+    }
+    lo = min_value;
+    hi = max_value;
+    sum_squares = squares;
+}
+
+int16_t to_peak(float v) {
+    return static_cast<int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
+
+uint32_t read_u32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t read_u64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+} // namespace
+
+void WaveformBuilder::Accumulator::merge(const Accumulator& other) {
+    if (other.count == 0) return;
+    if (count == 0) {
+        min = other.min;
+        max = other.max;
+    } else {
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+    sum_squares += other.sum_squares;
+    count += other.count;
+}
+
+WaveformBuilder::WaveformBuilder(int sample_rate)
+    : sample_rate_(sample_rate), levels_(1), pending_(1) {}
+
+void WaveformBuilder::append(const float* samples, size_t n) {
+    total_samples_ += n;
+    while (n > 0) {
+        const size_t take = std::min<size_t>(n, WAVEFORM_BASE_SAMPLES - partial_.count);
+        Accumulator chunk;
+        reduce(samples, take, chunk.min, chunk.max, chunk.sum_squares);
+        chunk.count = take;
+        partial_.merge(chunk);
+        samples += take;
+        n -= take;
+
+        if (partial_.count == WAVEFORM_BASE_SAMPLES) {
+            push(0, partial_);
+            partial_ = Accumulator();
+        }
+    }
+}
+
+void WaveformBuilder::push(size_t level, const Accumulator& bucket) {
+    if (levels_.size() <= level) {
+        levels_.resize(level + 1);
+        pending_.resize(level + 1);
+    }
+
+    const float rms = bucket.count > 0 ? static_cast<float>(std::sqrt(bucket.sum_squares / bucket.count)) : 0.0f;
+    WaveformBucket stored;
+    stored.min = to_peak(bucket.min);
+    stored.max = to_peak(bucket.max);
+    stored.rms = static_cast<uint16_t>(std::lround(std::min(rms, 1.0f) * 65535.0f));
+    levels_[level].push_back(stored);
+
+    pending_[level].merge(bucket);
+    if (++pending_[level].children == WAVEFORM_FANOUT) {
+        const Accumulator merged = pending_[level];
+        pending_[level] = Accumulator();
+        push(level + 1, merged);
+    }
+}
+
+void WaveformBuilder::finish() {
+    if (finished_) return;
+    finished_ = true;
+
+    if (partial_.count > 0) push(0, partial_);
+    partial_ = Accumulator();
+
+    // Carry the leftover buckets of each level up until one covers everything
+    for (size_t level = 0; level < levels_.size(); level++) {
+        if (levels_[level].size() <= 1) {
+            levels_.resize(level + 1);
+            break;
+        }
+        if (pending_[level].children > 0) {
+            const Accumulator rest = pending_[level];
+            pending_[level] = Accumulator();
+            push(level + 1, rest);
+        }
+    }
+}
+
+bool WaveformBuilder::write(const std::string& path, std::string& error) {
+    finish();
+
+    std::string header(MAGIC, 4);
+    put_u32(header, VERSION);
+    put_u32(header, static_cast<uint32_t>(sample_rate_));
+    put_u32(header, WAVEFORM_BASE_SAMPLES);
+    put_u32(header, WAVEFORM_FANOUT);
+    put_u32(header, static_cast<uint32_t>(levels_.size()));
+    put_u64(header, total_samples_);
+    for (const auto& level : levels_) put_u64(header, level.size());
+
+    const std::string tmp = path + ".tmp";
+    FILE* out = std::fopen(tmp.c_str(), "wb");
+    if (out == nullptr) {
+        error = "Cannot write waveform: " + tmp;
+        return false;
+    }
+
+    bool written = std::fwrite(header.data(), 1, header.size(), out) == header.size();
+    for (const auto& level : levels_) {
+        if (!written || level.empty()) continue;
+        written = std::fwrite(level.data(), sizeof(WaveformBucket), level.size(), out) == level.size();
+    }
+    written = std::fclose(out) == 0 && written;
+    if (!written) {
+        std::remove(tmp.c_str());
+        error = "Cannot write waveform: " + tmp;
+        return false;
+    }
+
+#ifdef _WIN32
+    std::remove(path.c_str());  // rename does not replace on Windows
+#endif
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        error = "Cannot replace waveform: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool build_waveform(const std::string& audio_path, const std::string& peaks_path, std::string& error) {
+    AudioData audio;
+    if (!load_audio(audio_path, audio, error)) return false;
+
+    WaveformBuilder builder(audio.sample_rate);
+    builder.append(audio.samples.data(), audio.samples.size());
+    return builder.write(peaks_path, error);
+}
+
+WaveformPeaks::~WaveformPeaks() {
+    close();
+}
+
+bool WaveformPeaks::open(const std::string& path, std::string& error) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "Cannot open waveform: " + path;
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart >= static_cast<LONGLONG>(FIXED_HEADER_BYTES)) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (view == nullptr) {
+        if (mapping != nullptr) CloseHandle(mapping);
+        CloseHandle(file);
+        error = "Cannot map waveform: " + path;
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+    data_ = static_cast<const unsigned char*>(view);
+    size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "Cannot open waveform: " + path;
+        return false;
+    }
+    struct stat st;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(FIXED_HEADER_BYTES)) {
+        view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);  // the mapping keeps the file alive
+    if (view == MAP_FAILED) {
+        error = "Cannot map waveform: " + path;
+        return false;
+    }
+    data_ = static_cast<const unsigned char*>(view);
+    size_ = static_cast<size_t>(st.st_size);
+#endif
+
+    const uint32_t version = read_u32(data_ + 4);
+    const uint32_t rate = read_u32(data_ + 8);
+    const uint32_t base = read_u32(data_ + 12);
+    const uint32_t fanout = read_u32(data_ + 16);
+    const uint32_t level_count = read_u32(data_ + 20);
+    const uint64_t total = read_u64(data_ + 24);
+
+    bool valid = std::memcmp(data_, MAGIC, 4) == 0 && version == VERSION && rate > 0 && base > 0 &&
+                 fanout >= 2 && level_count > 0 && level_count <= 64 &&
+                 size_ >= FIXED_HEADER_BYTES + level_count * sizeof(uint64_t);
+
+    // Every level must cover the whole recording and fit in the file
+    size_t offset = FIXED_HEADER_BYTES + level_count * sizeof(uint64_t);
+    uint64_t span = base;
+    for (uint32_t l = 0; valid && l < level_count; l++) {
+        const uint64_t count = read_u64(data_ + FIXED_HEADER_BYTES + l * sizeof(uint64_t));
+        const uint64_t expected = (total + span - 1) / span;
+        if (count != expected || count > (size_ - offset) / sizeof(WaveformBucket)) {
+            valid = false;
+            break;
+        }
+        Level level;
+        level.buckets = reinterpret_cast<const WaveformBucket*>(data_ + offset);
+        level.count = count;
+        level.span = span;
+        levels_.push_back(level);
+        offset += static_cast<size_t>(count) * sizeof(WaveformBucket);
+        span *= fanout;
+    }
+    if (!valid) {
+        close();
+        error = "Invalid waveform file: " + path;
+        return false;
+    }
+
+    sample_rate_ = static_cast<int>(rate);
+    total_samples_ = total;
+    return true;
+}
+
+void WaveformPeaks::close() {
+    levels_.clear();
+    sample_rate_ = 0;
+    total_samples_ = 0;
+    if (data_ == nullptr) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle(static_cast<HANDLE>(mapping_));
+    CloseHandle(static_cast<HANDLE>(file_));
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+int64_t WaveformPeaks::duration_ms() const {
+    if (sample_rate_ <= 0) return 0;
+    return static_cast<int64_t>(total_samples_ * 1000 / static_cast<uint64_t>(sample_rate_));
+}
+
+void WaveformPeaks::summarise(const Level& level, uint64_t begin, uint64_t end, WaveformColumn& out) const {
+    const uint64_t first = begin / level.span;
+    const uint64_t last = std::min((end - 1) / level.span, level.count - 1);
+
+    int min_peak = 32767;
+    int max_peak = -32767;
+    double energy = 0.0;
+    uint64_t covered = 0;
+    for (uint64_t i = first; i <= last; i++) {
+        const WaveformBucket& bucket = level.buckets[i];
+        const uint64_t samples = std::min(level.span, total_samples_ - i * level.span);
+        const double rms = bucket.rms / 65535.0;
+        min_peak = std::min<int>(min_peak, bucket.min);
+        max_peak = std::max<int>(max_peak, bucket.max);
+        energy += rms * rms * static_cast<double>(samples);
+        covered += samples;
+    }
+
+    out.min = min_peak / 32767.0f;
+    out.max = max_peak / 32767.0f;
+    out.rms = covered > 0 ? static_cast<float>(std::sqrt(energy / static_cast<double>(covered))) : 0.0f;
+}
+
+void WaveformPeaks::render(int64_t begin_ms, int64_t end_ms, size_t columns, WaveformColumn* out) const {
+    if (columns == 0) return;
+    std::fill(out, out + columns, WaveformColumn());
+    if (levels_.empty() || total_samples_ == 0 || end_ms <= begin_ms) return;
+
+    const int64_t begin = begin_ms * sample_rate_ / 1000;
+    const int64_t length = (end_ms - begin_ms) * sample_rate_ / 1000;
+    const int64_t total = static_cast<int64_t>(total_samples_);
+
+    // Coarsest level with a bucket no wider than a column; every column then
+    // merges fewer than WAVEFORM_FANOUT + 2 buckets
+    const double per_column = static_cast<double>(length) / static_cast<double>(columns);
+    size_t chosen = 0;
+    while (chosen + 1 < levels_.size() && static_cast<double>(levels_[chosen + 1].span) <= per_column) {
+        chosen++;
+    }
+    const Level& level = levels_[chosen];
+
+    for (size_t c = 0; c < columns; c++) {
+        int64_t from = begin + length * static_cast<int64_t>(c) / static_cast<int64_t>(columns);
+        int64_t to = begin + length * static_cast<int64_t>(c + 1) / static_cast<int64_t>(columns);
+        if (to <= from) to = from + 1;
+        from = std::max<int64_t>(from, 0);
+        to = std::min(to, total);
+        if (from >= to) continue;  // outside the recording
+        summarise(level, static_cast<uint64_t>(from), static_cast<uint64_t>(to), out[c]);
+    }
+}
+
+} // namespace securevox
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace securevox {
+
+// Samples summarised by one bucket of the finest level
+constexpr uint32_t WAVEFORM_BASE_SAMPLES = 256;
+
+// Buckets of a level merged into one bucket of the next
+constexpr uint32_t WAVEFORM_FANOUT = 2;
+
+// One bucket as stored in the sidecar: peaks scaled to int16, RMS to uint16
+struct WaveformBucket {
+    int16_t min;
+    int16_t max;
+    uint16_t rms;
+};
+
+// One rendered column, in sample units ([-1, 1] for peaks, [0, 1] for RMS)
+struct WaveformColumn {
+    float min = 0.0f;
+    float max = 0.0f;
+    float rms = 0.0f;
+};
+
+// Streaming generator of a min/max/RMS peak pyramid.
+//
+// Level 0 summarises every WAVEFORM_BASE_SAMPLES samples and each level above
+// merges WAVEFORM_FANOUT buckets of the one below, up to a single bucket for
+// the whole recording. Samples are read once: each base bucket is reduced with
+// SSE2/NEON and the upper levels are built from the buckets as they complete,
+// so the cost is one pass over the PCM however many levels there are.
+class WaveformBuilder {
+public:
+    explicit WaveformBuilder(int sample_rate);
+
+    void append(const float* samples, size_t n);
+
+    // Flush partial buckets and write the sidecar to path (via a temp file)
+    bool write(const std::string& path, std::string& error);
+
+private:
+    struct Accumulator {
+        float min = 0.0f;
+        float max = 0.0f;
+        double sum_squares = 0.0;
+        uint64_t count = 0;
+        uint32_t children = 0;
+
+        void merge(const Accumulator& other);
+    };
+
+    void push(size_t level, const Accumulator& bucket);
+    void finish();
+
+    int sample_rate_;
+    uint64_t total_samples_ = 0;
+    Accumulator partial_;  // base bucket being filled
+    std::vector<std::vector<WaveformBucket>> levels_;
+    std::vector<Accumulator> pending_;  // per level, buckets not yet merged upwards
+    bool finished_ = false;
+};
+
+// Build the peak sidecar of a WAV or FLAC file at the file's own sample rate
+bool build_waveform(const std::string& audio_path, const std::string& peaks_path, std::string& error);
+
+// Read-only view of a peak sidecar, memory-mapped rather than loaded.
+//
+// Rendering picks the coarsest level that still has at least one bucket per
+// column, so a view of any length and zoom touches O(columns) buckets and only
+// those pages of the file are read in.
+class WaveformPeaks {
+public:
+    WaveformPeaks() = default;
+    ~WaveformPeaks();
+
+    WaveformPeaks(const WaveformPeaks&) = delete;
+    WaveformPeaks& operator=(const WaveformPeaks&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    int sample_rate() const { return sample_rate_; }
+    uint64_t total_samples() const { return total_samples_; }
+    int64_t duration_ms() const;
+
+    // Summarise [begin_ms, end_ms) into columns equal slices. Columns narrower
+    // than a base bucket repeat the bucket they fall in.
+    void render(int64_t begin_ms, int64_t end_ms, size_t columns, WaveformColumn* out) const;
+
+private:
+    struct Level {
+        const WaveformBucket* buckets = nullptr;
+        uint64_t count = 0;
+        uint64_t span = 0;  // samples per bucket
+    };
+
+    void summarise(const Level& level, uint64_t begin, uint64_t end, WaveformColumn& out) const;
+
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+    int sample_rate_ = 0;
+    uint64_t total_samples_ = 0;
+    std::vector<Level> levels_;
+};
+
+} // namespace securevox
@@ -0,0 +1,61 @@
+# Local patches on top of the pinned whisper.cpp (native/patches/*.patch)
+#
+# Applied at configure time, in file name order: a patch may build on the
+# ones numbered before it. They are applied in place, so configuring modifies
+# the whisper.cpp submodule checkout itself and `git status` in it shows the
+# patched files; `git -C <whisper.cpp> checkout .` undoes them. A checkout
+# that already has a patch applied is left alone, so reconfiguring is safe.
+#
+# Each patch defines a WHISPER_HAS_* macro in whisper.h that the core checks.
+# A patch that does not apply stops the configure: a silently missing patch
+# would compile the encoder cache, speculative decoding or batched encoding
+# out without anyone noticing. Configure with -DSECUREVOX_WHISPER_PATCHES=OFF
+# to build against an unpatched whisper.cpp with those features compiled out.
+
+option(SECUREVOX_WHISPER_PATCHES "Apply native/patches to the whisper.cpp checkout" ON)
+
+set(SECUREVOX_WHISPER_PATCH_DIR ${CMAKE_CURRENT_LIST_DIR}/patches)
+
+function(securevox_apply_whisper_patches whisper_dir)
+    if(NOT SECUREVOX_WHISPER_PATCHES)
+        message(STATUS "whisper.cpp patches disabled (SECUREVOX_WHISPER_PATCHES=OFF)")
+        return()
+    endif()
+
+    find_package(Git QUIET)
+    if(NOT GIT_FOUND)
+        message(FATAL_ERROR "git is needed to apply the whisper.cpp patches; "
+            "install it or configure with -DSECUREVOX_WHISPER_PATCHES=OFF")
+    endif()
+
+    file(GLOB patches ${SECUREVOX_WHISPER_PATCH_DIR}/*.patch)
+    list(SORT patches)
+    foreach(patch ${patches})
+        get_filename_component(name ${patch} NAME)
+
+        # Already applied by an earlier configure
+        execute_process(
+            COMMAND ${GIT_EXECUTABLE} apply -C1 --reverse --check ${patch}
+            WORKING_DIRECTORY ${whisper_dir}
+            RESULT_VARIABLE not_applied
+            OUTPUT_QUIET ERROR_QUIET
+        )
+        if(NOT not_applied)
+            continue()
+        endif()
+
+        execute_process(
+            COMMAND ${GIT_EXECUTABLE} apply -C1 ${patch}
+            WORKING_DIRECTORY ${whisper_dir}
+            RESULT_VARIABLE failed
+            ERROR_VARIABLE output
+        )
+        if(failed)
+            message(FATAL_ERROR "whisper.cpp patch ${name} does not apply to ${whisper_dir}:\n${output}"
+                "Check that the submodule is at the pinned version and has no local "
+                "changes, or configure with -DSECUREVOX_WHISPER_PATCHES=OFF to build "
+                "without the features the patches add.")
+        endif()
+        message(STATUS "Applied whisper.cpp patch ${name}")
+    endforeach()
+endfunction()
@@ -1,5 +1,6 @@
 using Microsoft.Extensions.DependencyInjection;
 using Microsoft.UI.Xaml;
+using SecureVox.Core.Configuration;
 using SecureVox.Core.Data;
 using SecureVox.Whisper;
 
@@ -45,6 +46,21 @@ public partial class App : Application
             dbContext.Database.EnsureCreated();
         }
 
+        // Re-running a recording with another language or preset reuses its encoder output
+        var localFolder = Environment.GetFolderPath(Environment.SpecialFolder.LocalApplicationData);
+        WhisperProcessor.ConfigureEncoderCache(
+            AppConstants.Storage.EncoderCacheMemoryBytes,
+            Path.Combine(localFolder, "SecureVox", AppConstants.Storage.EncoderCacheDirectory),
+            AppConstants.Storage.EncoderCacheDiskBytes);
+
+        // Importing the same file again returns its stored transcript
+        WhisperProcessor.ConfigureResultCache(
+            Path.Combine(localFolder, "SecureVox", AppConstants.Storage.ResultCacheDirectory),
+            AppConstants.Storage.ResultCacheBytes);
+
+        // Short memos skip most of the 30 s encoder window
+        WhisperProcessor.SetShortClipMode(AppConstants.Audio.ShortClipMaxMs);
+
         _window = new MainWindow();
         _window.Activate();
     }
@@ -48,6 +48,11 @@ public static class AppConstants
         /// Maximum file size for import in bytes (2GB)
         /// </summary>
         public const long MaxImportFileSize = 2L * 1024 * 1024 * 1024;
+
+        /// <summary>
+        /// Recordings up to this long are encoded at their own length (15 s)
+        /// </summary>
+        public const long ShortClipMaxMs = 15_000;
     }
 
     public static class Storage
@@ -55,6 +60,24 @@ public static class AppConstants
         public const string RecordingsDirectory = "Recordings";
         public const string ModelsDirectory = "Models";
         public const string TempDirectory = "Temp";
+        public const string EncoderCacheDirectory = "EncoderCache";
+
+        /// <summary>
+        /// Encoder output kept in memory for re-transcriptions (256 MB)
+        /// </summary>
+        public const long EncoderCacheMemoryBytes = 256L * 1024 * 1024;
+
+        /// <summary>
+        /// Encoder output spilled to disk for re-transcriptions (2 GB)
+        /// </summary>
+        public const long EncoderCacheDiskBytes = 2L * 1024 * 1024 * 1024;
+
+        public const string ResultCacheDirectory = "Transcripts";
+
+        /// <summary>
+        /// Finished transcripts kept for identical audio (64 MB)
+        /// </summary>
+        public const long ResultCacheBytes = 64L * 1024 * 1024;
         public const string DatabaseFileName = "securevox.db";
 
         /// <summary>
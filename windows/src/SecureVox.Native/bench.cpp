@@ -0,0 +1,317 @@
+// securevox_bench: real-time factor of the wrapper over a set of WAV files.
+//
+// Drives the same C API the app uses (decode, resample, optional noise
+// suppression and VAD, transcribe), so it doubles as the training workload
+// for PGO builds; see pgo_build.sh. Besides wall time it reports the time in
+// whisper_full, the windows decoded, how many were re-decoded at a higher
+// temperature, decoder passes the repetition guard cut short and segments it
+// dropped as no-speech. --denoise runs the corpus twice, without and with noise
+// suppression, and compares those. --encode-batch N runs the files as one batch
+// twice, encoding their windows ahead one at a time and then N side by side,
+// and compares the encoder throughput in windows per second. --short-clip MS
+// runs the corpus with the full encoder window and then with files up to MS
+// encoded at their own length, and compares decode time and retries.
+// --power-stub FILE throttles every run by the simulated battery/thermal
+// signals in FILE (see whisper_wrapper_set_power_stub); edit it mid-run to
+// watch threads, core selection and duty-cycle pauses follow.
+//
+//   securevox_bench -m ggml-base.bin [-l en] [-t 4] [-r 1] [--vad] [--denoise] [--encode-batch 4]
+//                   [--short-clip 15000] [--power-stub power.txt] a.wav b.wav ...
+
+#include "whisper_wrapper.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef SECUREVOX_VARIANT
+#define SECUREVOX_VARIANT ""
+#endif
+
+namespace {
+
+struct Options {
+    std::string model;
+    std::string language = "en";
+    int threads = 0;
+    int repeats = 1;
+    bool vad = false;
+    bool denoise = false;
+    int encode_batch = 0;
+    uint64_t memory_mb = 0;
+    std::string draft;
+    int64_t short_clip_ms = 0;
+    std::string power_stub;
+    std::vector<std::string> files;
+};
+
+struct Totals {
+    double audio_s = 0.0;
+    double wall_s = 0.0;
+    double decode_s = 0.0;
+    double paused_s = 0.0;
+    int windows = 0;
+    int fallbacks = 0;
+    int cut = 0;
+    int dropped = 0;
+    int short_clips = 0;
+    int short_retries = 0;
+    int failures = 0;
+};
+
+void usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "usage: %s -m model.bin [-l lang] [-t threads] [-r repeats] [--vad] [--denoise]\n"
+                 "          [--encode-batch n [--memory-mb n]] [--short-clip ms] [--draft model.bin]\n"
+                 "          [--power-stub file] file.wav...\n"
+                 "  -t              thread cap, 0 for all cores (default)\n"
+                 "  -r              transcribe each file this many times (default 1)\n"
+                 "  --denoise       compare runs without and with noise suppression\n"
+                 "  --encode-batch  compare batch runs encoding 1 and n windows side by side\n"
+                 "  --memory-mb     fewer windows side by side if the batch would exceed this (default no limit)\n"
+                 "  --short-clip    compare full windows with files up to ms encoded at their length\n"
+                 "  --draft         compare whisper_full with speculative decoding using this draft model\n"
+                 "  --power-stub    throttle by simulated battery/thermal signals (key=value file)\n",
+                 argv0);
+}
+
+bool parse_args(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(arg, "-m") == 0 && has_value) {
+            options.model = argv[++i];
+        } else if (std::strcmp(arg, "-l") == 0 && has_value) {
+            options.language = argv[++i];
+        } else if (std::strcmp(arg, "-t") == 0 && has_value) {
+            options.threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "-r") == 0 && has_value) {
+            options.repeats = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--vad") == 0) {
+            options.vad = true;
+        } else if (std::strcmp(arg, "--denoise") == 0) {
+            options.denoise = true;
+        } else if (std::strcmp(arg, "--encode-batch") == 0 && has_value) {
+            options.encode_batch = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--memory-mb") == 0 && has_value) {
+            options.memory_mb = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(arg, "--short-clip") == 0 && has_value) {
+            options.short_clip_ms = std::atoll(argv[++i]);
+        } else if (std::strcmp(arg, "--draft") == 0 && has_value) {
+            options.draft = argv[++i];
+        } else if (std::strcmp(arg, "--power-stub") == 0 && has_value) {
+            options.power_stub = argv[++i];
+        } else if (arg[0] == '-') {
+            return false;
+        } else {
+            options.files.push_back(arg);
+        }
+    }
+    return !options.model.empty() && !options.files.empty() && options.repeats > 0;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Transcribe every file options.repeats times, one row per run, then the totals
+Totals run_pass(void* ctx, const Options& options, bool denoise) {
+    std::printf("%-40s %10s %10s %8s %10s %8s %9s %5s %7s %9s\n", "file", "audio_s", "wall_s", "rtf",
+                "decode_s", "windows", "fallbacks", "cut", "dropped", "paused_s");
+
+    Totals totals;
+    for (const std::string& path : options.files) {
+        for (int r = 0; r < options.repeats; r++) {
+            const auto start = std::chrono::steady_clock::now();
+
+            void* audio = whisper_wrapper_audio_load(path.c_str());
+            bool ok = audio != nullptr && whisper_wrapper_audio_resample(audio, 16000) != 0;
+            if (ok && denoise) ok = whisper_wrapper_audio_suppress_noise(audio) != 0;
+            if (ok && options.vad) ok = whisper_wrapper_audio_remove_silence(audio) != 0;
+
+            const char* json = nullptr;
+            if (ok) {
+                json = whisper_wrapper_transcribe_audio(ctx, audio, options.language.c_str(), nullptr, nullptr);
+                ok = json != nullptr;
+            }
+
+            const double wall = seconds_since(start);
+            const double audio_s = audio != nullptr ? whisper_wrapper_audio_duration_ms(audio) / 1000.0 : 0.0;
+            whisper_wrapper_free_string(json);
+            whisper_wrapper_audio_free(audio);
+
+            whisper_wrapper_decode_stats stats = {};
+            if (!ok || whisper_wrapper_get_decode_stats(ctx, &stats) == 0) {
+                std::fprintf(stderr, "%s: %s\n", path.c_str(), whisper_wrapper_get_last_error());
+                totals.failures++;
+                continue;
+            }
+
+            totals.audio_s += audio_s;
+            totals.wall_s += wall;
+            totals.decode_s += stats.decode_ms / 1000.0;
+            totals.paused_s += stats.paused_ms / 1000.0;
+            totals.windows += stats.windows;
+            totals.fallbacks += stats.fallbacks;
+            totals.cut += stats.cut_windows;
+            totals.dropped += stats.dropped_segments;
+            totals.short_clips += stats.short_clips;
+            totals.short_retries += stats.short_retries;
+            std::printf("%-40s %10.2f %10.2f %8.4f %10.2f %8d %9d %5d %7d %9.2f\n", path.c_str(), audio_s, wall,
+                        audio_s > 0.0 ? wall / audio_s : 0.0, stats.decode_ms / 1000.0, stats.windows, stats.fallbacks,
+                        stats.cut_windows, stats.dropped_segments, stats.paused_ms / 1000.0);
+        }
+    }
+
+    std::printf("%-40s %10.2f %10.2f %8.4f %10.2f %8d %9d %5d %7d %9.2f\n", "TOTAL", totals.audio_s, totals.wall_s,
+                totals.audio_s > 0.0 ? totals.wall_s / totals.audio_s : 0.0, totals.decode_s,
+                totals.windows, totals.fallbacks, totals.cut, totals.dropped, totals.paused_s);
+    return totals;
+}
+
+// Transcribe all files as one batch with their windows encoded ahead, `batch`
+// at a time; returns encoded windows per second, or a negative value on failure
+double run_encode_pass(void* ctx, const Options& options, int batch) {
+    std::vector<const char*> paths;
+    for (const std::string& path : options.files) paths.push_back(path.c_str());
+
+    whisper_wrapper_clear_encoder_cache();
+    whisper_wrapper_set_encode_batch(batch, options.memory_mb << 20);
+    const auto start = std::chrono::steady_clock::now();
+    const int succeeded = whisper_wrapper_transcribe_batch(ctx, paths.data(), static_cast<int>(paths.size()),
+                                                           options.language.c_str(), 2, nullptr, nullptr);
+    const double wall = seconds_since(start);
+    whisper_wrapper_set_encode_batch(0, 0);
+
+    whisper_wrapper_decode_stats stats = {};
+    if (succeeded < static_cast<int>(paths.size()) || whisper_wrapper_get_decode_stats(ctx, &stats) == 0) {
+        std::fprintf(stderr, "encode batch %d: %s\n", batch, whisper_wrapper_get_last_error());
+        return -1.0;
+    }
+
+    const double per_second = stats.encode_ms > 0 ? stats.encoded_windows * 1000.0 / stats.encode_ms : 0.0;
+    std::printf("# encode batch %d: %d windows in %.2f s (%.2f windows/s), decode %.2f s, wall %.2f s\n",
+                batch, stats.encoded_windows, stats.encode_ms / 1000.0, per_second,
+                stats.decode_ms / 1000.0, wall);
+    return per_second;
+}
+
+// Decode each file with whisper_full and speculatively with draft, one row per
+// file; returns the number of files that failed or came out different
+int run_speculative_check(void* ctx, void* draft, const Options& options) {
+    std::printf("%-40s %9s %10s %10s %8s %9s %8s\n", "file", "identical", "whisper_s", "spec_s", "speedup",
+                "tok/pass", "accepted");
+
+    int64_t reference_ms = 0;
+    int64_t speculative_ms = 0;
+    int failures = 0;
+    for (const std::string& path : options.files) {
+        void* audio = whisper_wrapper_audio_load(path.c_str());
+        whisper_wrapper_speculative_check check = {};
+        const bool ok = audio != nullptr && whisper_wrapper_audio_resample(audio, 16000) != 0 &&
+                        whisper_wrapper_check_speculative(ctx, draft, audio, options.language.c_str(), &check) != 0;
+        if (audio != nullptr) whisper_wrapper_audio_free(audio);
+        if (!ok) {
+            std::fprintf(stderr, "%s: %s\n", path.c_str(), whisper_wrapper_get_last_error());
+            failures++;
+            continue;
+        }
+
+        if (!check.identical) {
+            std::fprintf(stderr, "%s: differs from segment %d of %d\n", path.c_str(), check.first_difference,
+                         check.segments);
+            failures++;
+        }
+        reference_ms += check.reference_ms;
+        speculative_ms += check.speculative_ms;
+        std::printf("%-40s %9s %10.2f %10.2f %7.2fx %9.2f %8.2f\n", path.c_str(), check.identical ? "yes" : "NO",
+                    check.reference_ms / 1000.0, check.speculative_ms / 1000.0,
+                    check.speculative_ms > 0 ? static_cast<double>(check.reference_ms) / check.speculative_ms : 0.0,
+                    check.target_passes > 0 ? static_cast<double>(check.tokens) / check.target_passes : 0.0,
+                    check.drafted > 0 ? static_cast<double>(check.accepted) / check.drafted : 0.0);
+    }
+
+    std::printf("# speculative: whisper_full %.2f s -> %.2f s (%.2fx wall time)\n", reference_ms / 1000.0,
+                speculative_ms / 1000.0,
+                speculative_ms > 0 ? static_cast<double>(reference_ms) / speculative_ms : 0.0);
+    return failures;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_args(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    whisper_wrapper_set_max_threads(options.threads);
+    if (!options.power_stub.empty() && whisper_wrapper_set_power_stub(options.power_stub.c_str()) == 0) {
+        std::fprintf(stderr, "%s\n", whisper_wrapper_get_last_error());
+        return 1;
+    }
+
+    void* ctx = whisper_wrapper_init(options.model.c_str());
+    if (ctx == nullptr) {
+        std::fprintf(stderr, "%s\n", whisper_wrapper_get_last_error());
+        return 2;
+    }
+
+    std::printf("# variant: %s\n", SECUREVOX_VARIANT[0] ? SECUREVOX_VARIANT : "baseline");
+    std::printf("# system: %s\n", whisper_wrapper_get_system_info());
+
+    int failures = 0;
+    if (!options.draft.empty()) {
+        void* draft = whisper_wrapper_init(options.draft.c_str());
+        if (draft == nullptr) {
+            std::fprintf(stderr, "%s\n", whisper_wrapper_get_last_error());
+            whisper_wrapper_free(ctx);
+            return 2;
+        }
+        failures = run_speculative_check(ctx, draft, options);
+        whisper_wrapper_free(draft);
+    } else if (options.encode_batch > 0) {
+        // Windows encoded ahead are handed to whisper_full through the encoder cache
+        whisper_wrapper_set_encoder_cache(256ull * 1024 * 1024, nullptr, 0);
+        const double single = run_encode_pass(ctx, options, 1);
+        const double batched = run_encode_pass(ctx, options, options.encode_batch);
+        if (single < 0.0 || batched < 0.0) {
+            failures = 1;
+        } else {
+            std::printf("# batched encode: %.2f -> %.2f windows/s (%.2fx)\n", single, batched,
+                        single > 0.0 ? batched / single : 0.0);
+        }
+        whisper_wrapper_set_encoder_cache(0, nullptr, 0);
+    } else if (options.short_clip_ms > 0) {
+        std::printf("# pass: full window\n");
+        const Totals full = run_pass(ctx, options, options.denoise);
+        std::printf("# pass: short clips up to %lld ms\n", static_cast<long long>(options.short_clip_ms));
+        whisper_wrapper_set_short_clip_ms(options.short_clip_ms);
+        const Totals fast = run_pass(ctx, options, options.denoise);
+        whisper_wrapper_set_short_clip_ms(0);
+        failures = full.failures + fast.failures;
+
+        std::printf("# short clips: %d, %d decoded again, decode %.2f s -> %.2f s (%+.1f%%)\n",
+                    fast.short_clips, fast.short_retries, full.decode_s, fast.decode_s,
+                    full.decode_s > 0.0 ? (fast.decode_s / full.decode_s - 1.0) * 100.0 : 0.0);
+    } else if (!options.denoise) {
+        failures = run_pass(ctx, options, false).failures;
+    } else {
+        std::printf("# pass: plain\n");
+        const Totals plain = run_pass(ctx, options, false);
+        std::printf("# pass: denoise\n");
+        const Totals denoised = run_pass(ctx, options, true);
+        failures = plain.failures + denoised.failures;
+
+        std::printf("# denoise: fallbacks %d -> %d, decode %.2f s -> %.2f s (%+.1f%%)\n",
+                    plain.fallbacks, denoised.fallbacks, plain.decode_s, denoised.decode_s,
+                    plain.decode_s > 0.0 ? (denoised.decode_s / plain.decode_s - 1.0) * 100.0 : 0.0);
+    }
+
+    whisper_wrapper_free(ctx);
+    return failures == 0 ? 0 : 2;
+}
@@ -0,0 +1,16 @@
+// securevox_cpu.dll: built at the baseline ISA so it can run before we know
+// which whisper_native variant the CPU supports.
+
+#include "cpu_features.h"
+
+#ifdef _WIN32
+    #define CPU_PROBE_API __declspec(dllexport)
+#else
+    #define CPU_PROBE_API __attribute__((visibility("default")))
+#endif
+
+// Suffix of the fastest whisper_native build for this CPU ("avx512", "avx2";
+// "i8mm", "dotprod" on arm64), or "" for the baseline. The string is static.
+extern "C" CPU_PROBE_API const char* securevox_cpu_variant(void) {
+    return securevox::best_cpu_variant();
+}
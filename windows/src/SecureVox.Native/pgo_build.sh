@@ -0,0 +1,108 @@
+#!/bin/bash
+
+# Profile-guided optimized build of whisper_native on Linux (GCC or Clang).
+#
+#   ./pgo_build.sh <model.bin> <corpus_dir> [build_dir]
+#
+# 1. Build instrumented libraries (SECUREVOX_PGO=GENERATE, LTO on)
+# 2. Train: run securevox_bench over every WAV under corpus_dir, once per CPU
+#    variant this machine can execute
+# 3. Rebuild in the same directory with the profile (SECUREVOX_PGO=USE); GCC
+#    finds profiles by object path, so the directory must not change
+# 4. Build the plain -O3 configuration in <build_dir>-ref and benchmark both on
+#    the same corpus, printing the real-time factor of each. The comparison is
+#    also written to <build_dir>/rtf-table.md, ready for the README.
+#
+# Use a corpus that looks like real recordings (speech, typical lengths and
+# sample rates); the profile is only as good as the training run.
+
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+
+if [ $# -lt 2 ]; then
+    echo "usage: $0 <model.bin> <corpus_dir> [build_dir]"
+    exit 1
+fi
+
+MODEL="$(realpath "$1")"
+CORPUS="$(realpath "$2")"
+BUILD_DIR="$(realpath -m "${3:-$SCRIPT_DIR/build-pgo}")"
+REF_DIR="$BUILD_DIR-ref"
+PROFILE_DIR="$BUILD_DIR/pgo-profile"
+JOBS="$(nproc)"
+
+mapfile -t FILES < <(find "$CORPUS" -type f -iname '*.wav' | sort)
+if [ ${#FILES[@]} -eq 0 ]; then
+    echo "No .wav files under $CORPUS"
+    exit 1
+fi
+echo "Corpus: ${#FILES[@]} files"
+
+# Run every bench variant the CPU supports; one killed by SIGILL is skipped
+run_benches() {
+    local bin_dir="$1"
+    for bench in "$bin_dir"/securevox_bench*; do
+        [ -x "$bench" ] || continue
+        echo "== $(basename "$bench")"
+        set +e
+        "$bench" -m "$MODEL" "${FILES[@]}"
+        local status=$?
+        set -e
+        if [ $status -eq 132 ]; then
+            echo "   (instruction set not supported here, skipped)"
+        elif [ $status -ne 0 ]; then
+            echo "   (failed with status $status)"
+        fi
+    done
+}
+
+echo ""
+echo "== Stage 1: instrumented build"
+rm -rf "$PROFILE_DIR"
+cmake -S "$SCRIPT_DIR" -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release \
+    -DSECUREVOX_LTO=ON -DSECUREVOX_PGO=GENERATE -DSECUREVOX_PGO_DIR="$PROFILE_DIR"
+cmake --build "$BUILD_DIR" -j"$JOBS" --clean-first
+
+echo ""
+echo "== Stage 2: training run"
+run_benches "$BUILD_DIR/bin" > "$BUILD_DIR/pgo-training.txt"
+cat "$BUILD_DIR/pgo-training.txt"
+
+# Clang writes raw profiles that have to be merged first
+if compgen -G "$PROFILE_DIR/*.profraw" > /dev/null; then
+    llvm-profdata merge -output="$PROFILE_DIR/default.profdata" "$PROFILE_DIR"/*.profraw
+fi
+
+echo ""
+echo "== Stage 3: optimized rebuild"
+cmake -S "$SCRIPT_DIR" -B "$BUILD_DIR" -DSECUREVOX_PGO=USE
+cmake --build "$BUILD_DIR" -j"$JOBS" --clean-first
+
+echo ""
+echo "== Stage 4: comparison with the plain -O3 build"
+cmake -S "$SCRIPT_DIR" -B "$REF_DIR" -DCMAKE_BUILD_TYPE=Release \
+    -DSECUREVOX_LTO=OFF -DSECUREVOX_PGO=
+cmake --build "$REF_DIR" -j"$JOBS"
+
+run_benches "$REF_DIR/bin" > "$BUILD_DIR/bench-ref.txt"
+run_benches "$BUILD_DIR/bin" > "$BUILD_DIR/bench-pgo.txt"
+
+echo ""
+printf "%-28s %12s %14s %9s\n" "variant" "rtf -O3" "rtf LTO+PGO" "speedup"
+# Fails when the two runs did not bench the same files
+awk -f "$SCRIPT_DIR/rtf_table.awk" "$BUILD_DIR/bench-ref.txt" "$BUILD_DIR/bench-pgo.txt" |
+    tee "$BUILD_DIR/rtf-table.txt"
+
+# Same numbers as a Markdown table with what they were measured on
+{
+    echo "$(basename "$MODEL"), ${#FILES[@]} files, $(grep -m1 '^# system:' "$BUILD_DIR/bench-ref.txt" | cut -c11-)"
+    echo ""
+    echo "| variant | RTF -O3 | RTF LTO+PGO | speedup |"
+    echo "|---|---:|---:|---:|"
+    awk '{ printf "| %s | %s | %s | %s |\n", $1, $2, $3, $4 }' "$BUILD_DIR/rtf-table.txt"
+} > "$BUILD_DIR/rtf-table.md"
+echo "Markdown table: $BUILD_DIR/rtf-table.md"
+
+echo ""
+echo "Optimized libraries: $BUILD_DIR/lib (Linux) or $BUILD_DIR/bin"
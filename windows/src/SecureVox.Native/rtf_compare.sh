@@ -0,0 +1,115 @@
+#!/bin/bash
+
+# Real-time factor of the default ggml build against the OpenMP build
+# (SECUREVOX_GGML_OPENMP, the option the Android build turns on with
+# -Psecurevox.ggmlOpenmp).
+#
+#   ./rtf_compare.sh [--aarch64] <model.bin> <corpus_dir> [build_dir]
+#
+# --aarch64 cross-compiles with aarch64-linux-gnu-gcc and runs the benches
+# under qemu-aarch64 (-cpu max, so the dotprod/i8mm variants run too). That
+# checks the arm64 kernels on an x86 machine; emulated timings are only
+# meaningful relative to each other, not as device numbers.
+#
+# The before/after table is also written to <build_dir>/rtf-table.md, ready
+# for the README.
+#
+# Both builds include ggml-aarch64.c on arm64. Its interleaved kernels run for
+# models quantized to Q4_0_4_4/Q4_0_4_8/Q4_0_8_8; whisper.cpp v1.7.2 loads
+# weights into the default CPU buffer, so plain Q4_0 is not repacked at load.
+
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+
+CROSS=0
+if [ "${1:-}" = "--aarch64" ]; then
+    CROSS=1
+    shift
+fi
+
+if [ $# -lt 2 ]; then
+    echo "usage: $0 [--aarch64] <model.bin> <corpus_dir> [build_dir]"
+    exit 1
+fi
+
+MODEL="$(realpath "$1")"
+CORPUS="$(realpath "$2")"
+BUILD_DIR="$(realpath -m "${3:-$SCRIPT_DIR/build-rtf}")"
+JOBS="$(nproc)"
+THREADS="${THREADS:-4}"
+
+mapfile -t FILES < <(find "$CORPUS" -type f -iname '*.wav' | sort)
+if [ ${#FILES[@]} -eq 0 ]; then
+    echo "No .wav files under $CORPUS"
+    exit 1
+fi
+echo "Corpus: ${#FILES[@]} files, $THREADS threads"
+
+CMAKE_ARGS=(-DCMAKE_BUILD_TYPE=Release)
+RUNNER=()
+if [ $CROSS -eq 1 ]; then
+    CMAKE_ARGS+=(
+        -DCMAKE_SYSTEM_NAME=Linux
+        -DCMAKE_SYSTEM_PROCESSOR=aarch64
+        -DCMAKE_C_COMPILER=aarch64-linux-gnu-gcc
+        -DCMAKE_CXX_COMPILER=aarch64-linux-gnu-g++
+    )
+    RUNNER=(qemu-aarch64 -cpu max -L /usr/aarch64-linux-gnu)
+fi
+
+# Run every bench variant the CPU supports; one killed by SIGILL is skipped
+run_benches() {
+    local bin_dir="$1"
+    for bench in "$bin_dir"/securevox_bench*; do
+        [ -x "$bench" ] || continue
+        echo "== $(basename "$bench")"
+        set +e
+        "${RUNNER[@]}" "$bench" -m "$MODEL" -t "$THREADS" "${FILES[@]}"
+        local status=$?
+        set -e
+        if [ $status -eq 132 ]; then
+            echo "   (instruction set not supported here, skipped)"
+        elif [ $status -ne 0 ]; then
+            echo "   (failed with status $status)"
+        fi
+    done
+}
+
+build() {
+    local dir="$1"
+    local on_off="$2"
+    cmake -S "$SCRIPT_DIR" -B "$dir" "${CMAKE_ARGS[@]}" \
+        -DSECUREVOX_GGML_OPENMP="$on_off"
+    cmake --build "$dir" -j"$JOBS"
+}
+
+echo ""
+echo "== Default ggml build"
+build "$BUILD_DIR/default" OFF
+run_benches "$BUILD_DIR/default/bin" > "$BUILD_DIR/bench-default.txt"
+cat "$BUILD_DIR/bench-default.txt"
+
+echo ""
+echo "== OpenMP build"
+build "$BUILD_DIR/openmp" ON
+run_benches "$BUILD_DIR/openmp/bin" > "$BUILD_DIR/bench-openmp.txt"
+cat "$BUILD_DIR/bench-openmp.txt"
+
+echo ""
+printf "%-28s %12s %14s %9s\n" "variant" "rtf default" "rtf openmp" "speedup"
+# Fails when the two runs did not bench the same files
+awk -f "$SCRIPT_DIR/rtf_table.awk" "$BUILD_DIR/bench-default.txt" "$BUILD_DIR/bench-openmp.txt" |
+    tee "$BUILD_DIR/rtf-table.txt"
+
+# Same numbers as a Markdown table with what they were measured on
+TARGET="$(uname -m)"
+[ $CROSS -eq 1 ] && TARGET="aarch64 under qemu (relative only)"
+{
+    echo "$(basename "$MODEL"), ${#FILES[@]} files, $THREADS threads, $TARGET"
+    echo ""
+    echo "| variant | RTF default | RTF OpenMP | speedup |"
+    echo "|---|---:|---:|---:|"
+    awk '{ printf "| %s | %s | %s | %s |\n", $1, $2, $3, $4 }' "$BUILD_DIR/rtf-table.txt"
+} > "$BUILD_DIR/rtf-table.md"
+echo "Markdown table: $BUILD_DIR/rtf-table.md"
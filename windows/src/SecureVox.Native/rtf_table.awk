@@ -0,0 +1,62 @@
+# Real-time factor of each bench variant in two securevox_bench runs, before
+# and after, one line per variant with the speedup:
+#
+#   awk -f rtf_table.awk bench-before.txt bench-after.txt
+#
+# Rows are matched by variant and file name, not by position: a variant whose
+# files differ between the runs (a bench that died partway, a file that failed
+# in one run only) is an error rather than a silently shifted row. A variant
+# neither run has rows for (its instruction set is missing here) is left out.
+
+FNR == 1 { run++ }
+
+/^== / {
+    variant = $2
+    if (!(variant in seen)) {
+        seen[variant] = 1
+        order[++n] = variant
+    }
+    next
+}
+
+# Per-file and TOTAL rows end in nine numeric columns, rtf the third of them
+NF >= 10 && $1 != "file" && $(NF - 6) ~ /^[0-9.]+$/ {
+    rtf = $(NF - 6)
+    name = $0
+    for (k = 0; k < 9; k++) sub(/[ \t]+[^ \t]+[ \t]*$/, "", name)
+    if (name == "TOTAL") {
+        total[run, variant] = rtf
+    } else {
+        files[run, variant]++
+        has[run, variant, name] = 1
+    }
+}
+
+END {
+    if (run != 2) {
+        print "rtf_table.awk: expected two bench outputs" > "/dev/stderr"
+        exit 1
+    }
+    for (i = 1; i <= n; i++) {
+        v = order[i]
+        if (!((1, v) in files) && !((2, v) in files)) continue
+        if (files[1, v] != files[2, v] || !((1, v) in total) || !((2, v) in total)) {
+            printf "rtf_table.awk: %s has %d files before and %d after, or no TOTAL row\n",
+                v, files[1, v], files[2, v] > "/dev/stderr"
+            failed = 1
+            continue
+        }
+        for (key in has) {
+            split(key, part, SUBSEP)
+            if (part[2] == v && !((3 - part[1], v, part[3]) in has)) {
+                printf "rtf_table.awk: %s ran %s only %s\n", v, part[3],
+                    (part[1] == 1 ? "before" : "after") > "/dev/stderr"
+                failed = 1
+            }
+        }
+        before = total[1, v]
+        after = total[2, v]
+        printf "%-28s %12.4f %14.4f %8.2fx\n", v, before, after, (after > 0 ? before / after : 0)
+    }
+    exit failed
+}
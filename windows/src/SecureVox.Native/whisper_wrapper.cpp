@@ -1,10 +1,34 @@
 #include "whisper_wrapper.h"
 #include "whisper.h"
+#include "thread_pool.h"
+#include "power_policy.h"
+#include "batch_pipeline.h"
+#include "audio_buffer.h"
+#include "resampler.h"
+#include "exporter.h"
+#include "json_writer.h"
+#include "arena.h"
+#include "encoder_cache.h"
+#include "result_cache.h"
+#include "decode_guard.h"
+#include "batch_encoder.h"
+#include "memory_budget.h"
+#include "short_clip.h"
+#include "speculative.h"
+#include "waveform.h"
 
 #include <string>
 #include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
 
 // Thread-safe error message storage
 static std::string g_last_error;
@@ -15,6 +39,221 @@ static void set_error(const std::string& error) {
     g_last_error = error;
 }
 
+// Batch files whose windows are encoded side by side, 0 to leave it to whisper_full
+static std::atomic<int> g_encode_batch{0};
+// Peak memory a batch with encoding ahead may reach, 0 for no limit
+static std::atomic<uint64_t> g_encode_memory_bytes{0};
+
+// Model header of each context, to size the encoder states against that limit
+static std::unordered_map<const void*, securevox::ModelDims> g_model_dims;
+static std::mutex g_dims_mutex;
+
+// Clips up to this long take the short-clip fast path; 0 while it is off
+static std::atomic<int64_t> g_short_clip_ms{0};
+
+// Decoding statistics of the last transcription per context
+static std::unordered_map<const void*, whisper_wrapper_decode_stats> g_decode_stats;
+static std::mutex g_stats_mutex;
+
+// Counts decoding passes through whisper's callbacks. Greedy decoding runs one
+// decoder per window at temperature 0; every temperature fallback reruns the
+// window with best_of decoders, and each decoder filters the logits of its
+// first token exactly once.
+struct DecodeCounter {
+    int windows = 0;
+    int first_tokens = 0;
+    int decoders_per_fallback = 1;
+    int short_clips = 0;
+    int short_retries = 0;
+    std::chrono::steady_clock::duration elapsed{};
+    // Pauses between encoder windows under the power policy, may be null
+    securevox::DutyCycle* duty_cycle = nullptr;
+    // Paused by the duty cycles of files already done in a batch
+    long long paused_ms = 0;
+
+    // guard may be null (nothing decoded), encoded null (nothing encoded ahead)
+    void save(const void* ctx, const securevox::DecodeGuard* guard,
+              const securevox::BatchEncodeStats* encoded = nullptr) const {
+        whisper_wrapper_decode_stats stats;
+        stats.windows = windows;
+        stats.fallbacks = std::max(0, first_tokens - windows) / decoders_per_fallback;
+        stats.cut_windows = guard != nullptr ? guard->cut_windows() : 0;
+        stats.dropped_segments = guard != nullptr ? guard->dropped_segments() : 0;
+        stats.decode_ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+        stats.encoded_windows = encoded != nullptr ? encoded->windows : 0;
+        stats.encode_ms = encoded != nullptr ? encoded->encode_ms : 0;
+        stats.short_clips = short_clips;
+        stats.short_retries = short_retries;
+        stats.paused_ms = paused_ms + (duty_cycle != nullptr ? duty_cycle->paused_ms() : 0);
+        std::lock_guard<std::mutex> lock(g_stats_mutex);
+        g_decode_stats[ctx] = stats;
+    }
+};
+
+static void attach_decode_counter(whisper_full_params& params, DecodeCounter* counter) {
+    counter->decoders_per_fallback = std::max(1, params.greedy.best_of);
+
+    params.encoder_begin_callback_user_data = counter;
+    params.encoder_begin_callback = [](struct whisper_context* /*ctx*/,
+                                       struct whisper_state* /*state*/,
+                                       void* user_data) {
+        auto* counter = static_cast<DecodeCounter*>(user_data);
+        counter->windows++;
+        if (counter->duty_cycle != nullptr) counter->duty_cycle->on_window();
+        return true;
+    };
+
+    params.logits_filter_callback_user_data = counter;
+    params.logits_filter_callback = [](struct whisper_context* /*ctx*/,
+                                       struct whisper_state* /*state*/,
+                                       const whisper_token_data* /*tokens*/,
+                                       int n_tokens,
+                                       float* /*logits*/,
+                                       void* user_data) {
+        if (n_tokens == 0) static_cast<DecodeCounter*>(user_data)->first_tokens++;
+    };
+}
+
+// Build result JSON with the segments guard kept. Whole milliseconds, written in
+// one pass into a buffer sized from the segment text. The buffer is allocated
+// from arena when one is given, otherwise the caller owns it.
+static char* build_segments_json(whisper_context* whisper_ctx, const securevox::TimeMap* time_map,
+                                 const securevox::DecodeGuard& guard, securevox::Arena* arena = nullptr) {
+    const int numSegments = whisper_full_n_segments(whisper_ctx);
+
+    size_t textBytes = 0;
+    for (int i = 0; i < numSegments; i++) {
+        const char* text = whisper_full_get_segment_text(whisper_ctx, i);
+        if (text) textBytes += std::strlen(text);
+    }
+
+    // Text plus keys and two timestamps per segment; escapes are rare
+    securevox::JsonWriter json(textBytes + static_cast<size_t>(numSegments) * 48 + 2, false, arena);
+    json.put('[');
+
+    bool first = true;
+    for (int i = 0; i < numSegments; i++) {
+        if (guard.dropped(i)) continue;
+
+        const char* text = whisper_full_get_segment_text(whisper_ctx, i);
+        const int64_t t0 = whisper_full_get_segment_t0(whisper_ctx, i);
+        const int64_t t1 = whisper_full_get_segment_t1(whisper_ctx, i);
+
+        // Convert to milliseconds (t0/t1 are in centiseconds)
+        int64_t startMs = t0 * 10;
+        int64_t endMs = t1 * 10;
+
+        // Map back to the original timeline when silence was removed
+        if (time_map != nullptr && !time_map->empty()) {
+            startMs = time_map->to_original_ms(startMs, securevox::MODEL_SAMPLE_RATE);
+            endMs = time_map->to_original_ms(endMs, securevox::MODEL_SAMPLE_RATE);
+        }
+
+        if (!first) json.put(',');
+        first = false;
+        securevox::write_segment_json(json, text ? text : "", text ? std::strlen(text) : 0, startMs, endMs);
+    }
+
+    json.put(']');
+
+    if (!json.ok()) {
+        set_error("Out of memory building transcription result");
+        return nullptr;
+    }
+    return json.release();
+}
+
+// Same JSON for segments returned by the result cache (times in the model timeline)
+static char* cached_segments_json(std::vector<securevox::Segment>& segments, const securevox::TimeMap* time_map,
+                                  securevox::Arena* arena = nullptr) {
+    size_t textBytes = 0;
+    for (const auto& segment : segments) textBytes += segment.text.size();
+
+    securevox::JsonWriter json(textBytes + segments.size() * 48 + 2, false, arena);
+    json.put('[');
+    for (size_t i = 0; i < segments.size(); i++) {
+        int64_t startMs = segments[i].start_ms;
+        int64_t endMs = segments[i].end_ms;
+        if (time_map != nullptr && !time_map->empty()) {
+            startMs = time_map->to_original_ms(startMs, securevox::MODEL_SAMPLE_RATE);
+            endMs = time_map->to_original_ms(endMs, securevox::MODEL_SAMPLE_RATE);
+        }
+
+        if (i > 0) json.put(',');
+        securevox::write_segment_json(json, segments[i].text.data(), segments[i].text.size(), startMs, endMs);
+    }
+    json.put(']');
+
+    if (!json.ok()) {
+        set_error("Out of memory building transcription result");
+        return nullptr;
+    }
+    return json.release();
+}
+
+// Short-clip fast path settings (see short_clip.h)
+static securevox::ShortClipOptions short_clip_options() {
+    securevox::ShortClipOptions options;
+    options.max_ms = g_short_clip_ms.load();
+    return options;
+}
+
+// Result cache key for samples decoded with make_params(language) by
+// run_whisper_full. False when the cache is off or the model is unknown.
+static bool result_key_for(whisper_context* whisper_ctx, const float* samples, size_t n, const char* language,
+                           securevox::ResultKey& key) {
+    const uint64_t model = securevox::EncoderCache::instance().model_of(whisper_ctx);
+    if (!securevox::ResultCache::instance().enabled() || model == 0) return false;
+    std::string settings = language ? language : "en";
+    const int audio_ctx = securevox::short_clip_audio_ctx(n, short_clip_options());
+    if (audio_ctx > 0) settings += "/ctx" + std::to_string(audio_ctx);
+    key = securevox::make_result_key(samples, n, model, settings);
+    return true;
+}
+
+// Keep the segments of the last whisper_full call that guard kept under key
+static void store_result(whisper_context* whisper_ctx, const securevox::ResultKey& key,
+                         const securevox::DecodeGuard& guard) {
+    std::vector<securevox::Segment> segments;
+    securevox::read_segments(whisper_ctx, nullptr, 0, segments, &guard);
+    securevox::ResultCache::instance().store(key, segments);
+}
+
+// Default decoding parameters shared by the single and batch entry points
+static whisper_full_params make_params(const char* language, int n_threads) {
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.print_realtime = false;
+    params.print_progress = false;
+    params.print_timestamps = true;
+    params.print_special = false;
+    params.translate = false;
+    params.language = language ? language : "en";
+    params.n_threads = n_threads;
+    params.offset_ms = 0;
+    params.no_context = true;
+    params.single_segment = false;
+    return params;
+}
+
+// whisper_full on n samples. A short clip is encoded at its own length first,
+// and decoded again with the full context if guard's checks reject the result.
+static int run_whisper_full(whisper_context* whisper_ctx, whisper_full_params& params, const float* samples,
+                            size_t n, const securevox::DecodeGuard& guard, DecodeCounter& counter) {
+    const securevox::ShortClipOptions options = short_clip_options();
+    if (!securevox::apply_short_clip(params, n, options)) {
+        return whisper_full(whisper_ctx, params, samples, static_cast<int>(n));
+    }
+
+    counter.short_clips++;
+    const int cut_before = guard.cut_windows();
+    const int result = whisper_full(whisper_ctx, params, samples, static_cast<int>(n));
+    if (result != 0 || securevox::short_clip_accepted(whisper_ctx, &guard, cut_before, options)) return result;
+
+    counter.short_retries++;
+    securevox::clear_short_clip(params);
+    return whisper_full(whisper_ctx, params, samples, static_cast<int>(n));
+}
+
 extern "C" {
 
 WHISPER_API void* whisper_wrapper_init(const char* model_path) {
@@ -33,11 +272,28 @@ WHISPER_API void* whisper_wrapper_init(const char* model_path) {
         return nullptr;
     }
 
+    securevox::EncoderCache::instance().register_model(ctx, model_path);
+
+    securevox::ModelDims dims;
+    std::string error;
+    if (securevox::read_model_dims(model_path, dims, error)) {
+        std::lock_guard<std::mutex> lock(g_dims_mutex);
+        g_model_dims[ctx] = dims;
+    }
     return ctx;
 }
 
 WHISPER_API void whisper_wrapper_free(void* ctx) {
     if (ctx != nullptr) {
+        securevox::EncoderCache::instance().unregister_model(static_cast<whisper_context*>(ctx));
+        {
+            std::lock_guard<std::mutex> lock(g_stats_mutex);
+            g_decode_stats.erase(ctx);
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_dims_mutex);
+            g_model_dims.erase(ctx);
+        }
         whisper_free(static_cast<whisper_context*>(ctx));
     }
 }
@@ -48,38 +304,38 @@ struct CallbackData {
     void* user_data;
 };
 
-WHISPER_API const char* whisper_wrapper_transcribe(
-    void* ctx,
+// Run whisper_full on 16 kHz samples and return the result JSON (caller frees).
+// time_map may be null; otherwise segment times are mapped to the original audio.
+static char* transcribe_samples(
+    whisper_context* whisper_ctx,
     const float* audio_data,
     int n_samples,
     const char* language,
     whisper_progress_callback_t progress_callback,
-    void* user_data
+    void* user_data,
+    const securevox::TimeMap* time_map
 ) {
-    if (ctx == nullptr) {
-        set_error("Context is null");
-        return nullptr;
+    // The same audio, model and language were transcribed before: no decoding at all
+    securevox::ResultKey result_key;
+    const bool cache_result = result_key_for(whisper_ctx, audio_data, static_cast<size_t>(n_samples),
+                                             language, result_key);
+    std::vector<securevox::Segment> cached;
+    DecodeCounter counter;
+    if (cache_result && securevox::ResultCache::instance().load(result_key, cached)) {
+        counter.save(whisper_ctx, nullptr);
+        return cached_segments_json(cached, time_map);
     }
 
-    if (audio_data == nullptr || n_samples <= 0) {
-        set_error("Invalid audio data");
-        return nullptr;
-    }
+    // Follows the battery/thermal policy when a signal source is set (full speed otherwise)
+    const securevox::ThrottlePlan plan = securevox::PowerPolicy::instance().plan(4);
+    securevox::EfficiencyCoreScope core_scope(plan.efficiency_cores);
+    securevox::DutyCycle duty_cycle(4);
 
-    auto* whisper_ctx = static_cast<whisper_context*>(ctx);
+    // ggml threads count against the shared pool so concurrent jobs don't oversubscribe
+    securevox::ThreadPool::Lease threads = securevox::ThreadPool::instance().lease(plan.max_threads);
 
     // Configure whisper parameters
-    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-    params.print_realtime = false;
-    params.print_progress = false;
-    params.print_timestamps = true;
-    params.print_special = false;
-    params.translate = false;
-    params.language = language ? language : "en";
-    params.n_threads = std::min(4, static_cast<int>(std::thread::hardware_concurrency()));
-    params.offset_ms = 0;
-    params.no_context = true;
-    params.single_segment = false;
+    whisper_full_params params = make_params(language, threads.count());
 
     // Set up progress callback
     CallbackData cbData = { progress_callback, user_data };
@@ -97,63 +353,552 @@ WHISPER_API const char* whisper_wrapper_transcribe(
         };
     }
 
-    // Run transcription
-    int result = whisper_full(whisper_ctx, params, audio_data, n_samples);
+    // Runaway loops are cut short. Unless silence was already removed, segments
+    // decoded from what the VAD finds silent are dropped too.
+    attach_decode_counter(params, &counter);
+    counter.duty_cycle = &duty_cycle;
+    securevox::DecodeGuard guard;
+    guard.attach(params);
+    securevox::SpeechRegions speech;
+    if (time_map == nullptr || time_map->empty()) {
+        speech = securevox::detect_speech(audio_data, static_cast<size_t>(n_samples), securevox::MODEL_SAMPLE_RATE);
+        guard.set_speech(&speech);
+    }
+
+    // Run transcription, reusing the encoder output of windows seen before
+    int result;
+    {
+        securevox::EncoderCacheScope encoder_cache(whisper_ctx, audio_data, static_cast<size_t>(n_samples));
+        const auto start = std::chrono::steady_clock::now();
+        result = run_whisper_full(whisper_ctx, params, audio_data, static_cast<size_t>(n_samples), guard, counter);
+        counter.elapsed = std::chrono::steady_clock::now() - start;
+    }
+    counter.save(whisper_ctx, &guard);
 
     if (result != 0) {
         set_error("Transcription failed with code: " + std::to_string(result));
         return nullptr;
     }
 
-    // Build result JSON with segments
-    std::string jsonResult = "[";
-    int numSegments = whisper_full_n_segments(whisper_ctx);
+    if (cache_result) store_result(whisper_ctx, result_key, guard);
 
-    for (int i = 0; i < numSegments; i++) {
-        const char* text = whisper_full_get_segment_text(whisper_ctx, i);
-        int64_t t0 = whisper_full_get_segment_t0(whisper_ctx, i);
-        int64_t t1 = whisper_full_get_segment_t1(whisper_ctx, i);
+    // Returned without copying (caller must free)
+    return build_segments_json(whisper_ctx, time_map, guard);
+}
 
-        // Convert to milliseconds (t0/t1 are in centiseconds)
-        double startMs = t0 * 10.0;
-        double endMs = t1 * 10.0;
-
-        if (i > 0) jsonResult += ",";
-
-        // Escape text for JSON
-        std::string escapedText;
-        if (text) {
-            for (const char* p = text; *p; p++) {
-                switch (*p) {
-                    case '"': escapedText += "\\\""; break;
-                    case '\\': escapedText += "\\\\"; break;
-                    case '\n': escapedText += "\\n"; break;
-                    case '\r': escapedText += "\\r"; break;
-                    case '\t': escapedText += "\\t"; break;
-                    default: escapedText += *p;
+WHISPER_API const char* whisper_wrapper_transcribe(
+    void* ctx,
+    const float* audio_data,
+    int n_samples,
+    const char* language,
+    whisper_progress_callback_t progress_callback,
+    void* user_data
+) {
+    if (ctx == nullptr) {
+        set_error("Context is null");
+        return nullptr;
+    }
+
+    if (audio_data == nullptr || n_samples <= 0) {
+        set_error("Invalid audio data");
+        return nullptr;
+    }
+
+    return transcribe_samples(static_cast<whisper_context*>(ctx), audio_data, n_samples,
+                              language, progress_callback, user_data, nullptr);
+}
+
+WHISPER_API void* whisper_wrapper_audio_create(int sample_rate) {
+    if (sample_rate <= 0) {
+        set_error("Invalid sample rate: " + std::to_string(sample_rate));
+        return nullptr;
+    }
+    return new securevox::AudioBuffer(sample_rate);
+}
+
+WHISPER_API void* whisper_wrapper_audio_load(const char* path) {
+    if (path == nullptr) {
+        set_error("Audio path is null");
+        return nullptr;
+    }
+
+    auto* audio = new securevox::AudioBuffer(securevox::MODEL_SAMPLE_RATE);
+    std::string error;
+    if (!audio->load_file(path, error)) {
+        set_error(error);
+        delete audio;
+        return nullptr;
+    }
+    return audio;
+}
+
+WHISPER_API int whisper_wrapper_audio_append_pcm16(void* audio, const int16_t* samples, int n_samples) {
+    if (audio == nullptr || (samples == nullptr && n_samples > 0) || n_samples < 0) {
+        set_error("Invalid audio append arguments");
+        return 0;
+    }
+    static_cast<securevox::AudioBuffer*>(audio)->append_pcm16(samples, static_cast<size_t>(n_samples));
+    return 1;
+}
+
+WHISPER_API int whisper_wrapper_audio_append_float(void* audio, const float* samples, int n_samples) {
+    if (audio == nullptr || (samples == nullptr && n_samples > 0) || n_samples < 0) {
+        set_error("Invalid audio append arguments");
+        return 0;
+    }
+    static_cast<securevox::AudioBuffer*>(audio)->append(samples, static_cast<size_t>(n_samples));
+    return 1;
+}
+
+WHISPER_API int whisper_wrapper_audio_resample(void* audio, int sample_rate) {
+    if (audio == nullptr) {
+        set_error("Audio handle is null");
+        return 0;
+    }
+    std::string error;
+    if (!static_cast<securevox::AudioBuffer*>(audio)->resample(sample_rate, error)) {
+        set_error(error);
+        return 0;
+    }
+    return 1;
+}
+
+WHISPER_API int whisper_wrapper_audio_suppress_noise(void* audio) {
+    if (audio == nullptr) {
+        set_error("Audio handle is null");
+        return 0;
+    }
+    std::string error;
+    if (!static_cast<securevox::AudioBuffer*>(audio)->suppress_noise(securevox::DenoiseOptions(),
+                                                                     securevox::VadOptions(), error)) {
+        set_error(error);
+        return 0;
+    }
+    return 1;
+}
+
+WHISPER_API int whisper_wrapper_audio_remove_silence(void* audio) {
+    if (audio == nullptr) {
+        set_error("Audio handle is null");
+        return 0;
+    }
+    std::string error;
+    if (!static_cast<securevox::AudioBuffer*>(audio)->remove_silence(securevox::VadOptions(), error)) {
+        set_error(error);
+        return 0;
+    }
+    return 1;
+}
+
+WHISPER_API int64_t whisper_wrapper_audio_duration_ms(void* audio) {
+    return audio != nullptr ? static_cast<securevox::AudioBuffer*>(audio)->duration_ms() : 0;
+}
+
+WHISPER_API const char* whisper_wrapper_transcribe_audio(
+    void* ctx,
+    void* audio,
+    const char* language,
+    whisper_progress_callback_t progress_callback,
+    void* user_data
+) {
+    if (ctx == nullptr) {
+        set_error("Context is null");
+        return nullptr;
+    }
+
+    auto* buffer = static_cast<securevox::AudioBuffer*>(audio);
+    if (buffer == nullptr || buffer->size() == 0) {
+        set_error("Invalid audio data");
+        return nullptr;
+    }
+    if (buffer->sample_rate() != securevox::MODEL_SAMPLE_RATE) {
+        set_error("Audio must be resampled to 16kHz before transcription");
+        return nullptr;
+    }
+
+    return transcribe_samples(static_cast<whisper_context*>(ctx), buffer->data(), static_cast<int>(buffer->size()),
+                              language, progress_callback, user_data, &buffer->time_map());
+}
+
+WHISPER_API void whisper_wrapper_audio_free(void* audio) {
+    delete static_cast<securevox::AudioBuffer*>(audio);
+}
+
+WHISPER_API int whisper_wrapper_transcribe_batch(
+    void* ctx,
+    const char* const* paths,
+    int n_paths,
+    const char* language,
+    int prefetch,
+    whisper_batch_callback_t callback,
+    void* user_data
+) {
+    if (ctx == nullptr) {
+        set_error("Context is null");
+        return -1;
+    }
+
+    if (paths == nullptr || n_paths <= 0) {
+        set_error("No input files");
+        return -1;
+    }
+
+    auto* whisper_ctx = static_cast<whisper_context*>(ctx);
+    auto& pool = securevox::ThreadPool::instance();
+
+    std::vector<std::string> files;
+    files.reserve(n_paths);
+    for (int i = 0; i < n_paths; i++) {
+        files.emplace_back(paths[i] ? paths[i] : "");
+    }
+
+    // Decode/resample/VAD of the next files runs on the pool while this thread infers
+    securevox::BatchPipeline pipeline(std::move(files), prefetch);
+
+    // Optionally take the next files a group at a time and encode their windows
+    // side by side; whisper_full then finds them in the encoder cache
+    const int encode_batch = g_encode_batch.load();
+    const bool encode_ahead = encode_batch > 0 && securevox::BatchEncoder::available() &&
+                              securevox::EncoderCache::instance().enabled();
+    securevox::BatchEncoder encoder(whisper_ctx, encode_batch);
+
+    // Each encoder slot is a whole whisper_state, kept while the group's files
+    // are decoded, so the slots are capped to what fits next to whisper_full
+    // running on the longest file of the group
+    const uint64_t memory_bytes = g_encode_memory_bytes.load();
+    securevox::ModelDims dims;
+    bool has_dims = false;
+    {
+        std::lock_guard<std::mutex> lock(g_dims_mutex);
+        auto it = g_model_dims.find(whisper_ctx);
+        if (it != g_model_dims.end()) {
+            dims = it->second;
+            has_dims = true;
+        }
+    }
+    auto encode_slots = [&](const std::deque<securevox::PreparedAudio>& group) {
+        if (memory_bytes == 0) return encode_batch;
+        if (!has_dims) return 0;
+        securevox::JobShape job;
+        job.threads = pool.max_threads();
+        for (const auto& prepared : group) {
+            job.n_samples = std::max<uint64_t>(job.n_samples, prepared.samples.size());
+        }
+        return securevox::max_encode_states(dims, job, encode_batch, memory_bytes);
+    };
+    std::deque<securevox::PreparedAudio> ahead;
+    auto next_item = [&](securevox::PreparedAudio& out) {
+        if (!encode_ahead) return pipeline.next(out);
+        if (ahead.empty()) {
+            securevox::PreparedAudio taken;
+            while (static_cast<int>(ahead.size()) < encode_batch && pipeline.next(taken)) {
+                ahead.push_back(std::move(taken));
+            }
+
+            // Short clips are encoded at their own length by whisper_full instead,
+            // and files with a stored transcript are not run through the model at all
+            const securevox::ShortClipOptions short_clip = short_clip_options();
+            std::vector<securevox::EncodeWindow> windows;
+            for (const auto& prepared : ahead) {
+                if (!prepared.ok || prepared.samples.size() > WHISPER_N_SAMPLES ||
+                    securevox::short_clip_audio_ctx(prepared.samples.size(), short_clip) > 0) {
+                    continue;
                 }
+                securevox::ResultKey result_key;
+                if (result_key_for(whisper_ctx, prepared.samples.data(), prepared.samples.size(), language, result_key) &&
+                    securevox::ResultCache::instance().contains(result_key)) {
+                    continue;
+                }
+                securevox::EncodeWindow window;
+                window.samples = prepared.samples.data();
+                window.n = prepared.samples.size();
+                windows.push_back(window);
+            }
+            // With no slot to spare, whisper_full encodes the windows itself
+            const int slots = encode_slots(ahead);
+            encoder.set_batch(slots);
+            if (!windows.empty() && slots > 0) {
+                // The windows lease their threads from the pool; asking for one
+                // less than the cap leaves prefetching room to keep running
+                std::string error;
+                if (!encoder.encode(windows, std::max(1, pool.max_threads() - 1), error)) set_error(error);
             }
         }
+        if (ahead.empty()) return false;
+        out = std::move(ahead.front());
+        ahead.pop_front();
+        return true;
+    };
+
+    // Silence is removed while preparing, so the guard only cuts runaway loops
+    int succeeded = 0;
+    DecodeCounter counter;
+    securevox::DecodeGuard guard;
+    securevox::PreparedAudio item;
+    while (next_item(item)) {
+        const int index = static_cast<int>(item.index);
+
+        if (!item.ok) {
+            if (callback != nullptr) callback(index, nullptr, item.error.c_str(), user_data);
+            continue;
+        }
+
+        // A file imported before is answered from the result cache
+        securevox::ResultKey result_key;
+        const bool cache_result = result_key_for(whisper_ctx, item.samples.data(), item.samples.size(),
+                                                 language, result_key);
+        std::vector<securevox::Segment> cached;
+        if (cache_result && securevox::ResultCache::instance().load(result_key, cached)) {
+            const char* json = cached_segments_json(cached, &item.time_map, item.arena.get());
+            if (json == nullptr) {
+                if (callback != nullptr) callback(index, nullptr, "Out of memory building transcription result", user_data);
+                continue;
+            }
+            if (callback != nullptr) callback(index, json, nullptr, user_data);
+            succeeded++;
+            continue;
+        }
 
-        jsonResult += "{";
-        jsonResult += "\"text\":\"" + escapedText + "\",";
-        jsonResult += "\"start\":" + std::to_string(startMs) + ",";
-        jsonResult += "\"end\":" + std::to_string(endMs);
-        jsonResult += "}";
+        int result;
+        {
+            // Leave one slot of the cap free so prefetching keeps running during inference.
+            // The power policy is planned per file so a state change applies to the next
+            // one, and each file gets its own duty cycle: the time spent between files
+            // (cache hits, writing results) is not counted as compute.
+            const securevox::ThrottlePlan plan = securevox::PowerPolicy::instance().plan(4);
+            securevox::EfficiencyCoreScope core_scope(plan.efficiency_cores);
+            securevox::DutyCycle duty_cycle(4);
+            counter.duty_cycle = &duty_cycle;
+            securevox::ThreadPool::Lease threads = pool.lease(std::min(plan.max_threads, std::max(1, pool.max_threads() - 1)));
+            whisper_full_params params = make_params(language, threads.count());
+            attach_decode_counter(params, &counter);
+            guard.attach(params);
+            securevox::EncoderCacheScope encoder_cache(whisper_ctx, item.samples.data(), item.samples.size());
+            const auto start = std::chrono::steady_clock::now();
+            result = run_whisper_full(whisper_ctx, params, item.samples.data(), item.samples.size(), guard, counter);
+            counter.elapsed += std::chrono::steady_clock::now() - start;
+            counter.paused_ms += duty_cycle.paused_ms();
+            counter.duty_cycle = nullptr;
+        }
+
+        if (result != 0) {
+            const std::string error = "Transcription failed with code: " + std::to_string(result);
+            if (callback != nullptr) callback(index, nullptr, error.c_str(), user_data);
+            continue;
+        }
+
+        if (cache_result) store_result(whisper_ctx, result_key, guard);
+
+        // Lives in the item's arena, which is recycled when the next file is taken
+        const char* json = build_segments_json(whisper_ctx, &item.time_map, guard, item.arena.get());
+        if (json == nullptr) {
+            if (callback != nullptr) callback(index, nullptr, "Out of memory building transcription result", user_data);
+            continue;
+        }
+        if (callback != nullptr) callback(index, json, nullptr, user_data);
+        succeeded++;
+    }
+
+    counter.save(whisper_ctx, &guard, encode_ahead ? &encoder.stats() : nullptr);
+    return succeeded;
+}
+
+WHISPER_API int whisper_wrapper_export_segments(
+    const char* path,
+    int format,
+    const int64_t* start_ms,
+    const int64_t* end_ms,
+    const char* const* texts,
+    const char* const* speakers,
+    int n_segments,
+    int max_line_chars) {
+
+    if (path == nullptr || n_segments < 0 || (n_segments > 0 && (start_ms == nullptr || end_ms == nullptr || texts == nullptr))) {
+        set_error("Invalid export arguments");
+        return 0;
+    }
+    if (format < 0 || format > static_cast<int>(securevox::ExportFormat::Json)) {
+        set_error("Unknown export format: " + std::to_string(format));
+        return 0;
+    }
+
+    const int fd = securevox::open_export_file(path);
+    if (fd < 0) {
+        set_error("Cannot create export file: " + std::string(path));
+        return 0;
+    }
+
+    securevox::ExportOptions options;
+    options.max_line_chars = max_line_chars;
+    securevox::TranscriptExporter exporter(fd, static_cast<securevox::ExportFormat>(format), options);
+
+    for (int i = 0; i < n_segments; i++) {
+        const char* text = texts[i] != nullptr ? texts[i] : "";
+        const char* speaker = speakers != nullptr ? speakers[i] : nullptr;
+        exporter.add(start_ms[i], end_ms[i], text, std::strlen(text),
+                     speaker, speaker != nullptr ? std::strlen(speaker) : 0);
+    }
+
+    std::string error;
+    const bool ok = exporter.finish(error);
+    securevox::close_export_file(fd);
+    if (!ok) {
+        set_error(error);
+        return 0;
+    }
+    return 1;
+}
+
+WHISPER_API int whisper_wrapper_waveform_build(const char* audio_path, const char* peaks_path) {
+    if (audio_path == nullptr || peaks_path == nullptr) {
+        set_error("Waveform path is null");
+        return 0;
+    }
+
+    std::string error;
+    if (!securevox::build_waveform(audio_path, peaks_path, error)) {
+        set_error(error);
+        return 0;
+    }
+    return 1;
+}
+
+WHISPER_API void* whisper_wrapper_waveform_open(const char* peaks_path) {
+    if (peaks_path == nullptr) {
+        set_error("Waveform path is null");
+        return nullptr;
+    }
+
+    auto* peaks = new securevox::WaveformPeaks();
+    std::string error;
+    if (!peaks->open(peaks_path, error)) {
+        set_error(error);
+        delete peaks;
+        return nullptr;
+    }
+    return peaks;
+}
+
+WHISPER_API int64_t whisper_wrapper_waveform_duration_ms(void* peaks) {
+    return peaks != nullptr ? static_cast<securevox::WaveformPeaks*>(peaks)->duration_ms() : 0;
+}
+
+WHISPER_API int whisper_wrapper_waveform_render(void* peaks, int64_t begin_ms, int64_t end_ms, float* out, int n_columns) {
+    if (peaks == nullptr || out == nullptr || n_columns <= 0) {
+        set_error("Invalid waveform render arguments");
+        return 0;
+    }
+
+    static_assert(sizeof(securevox::WaveformColumn) == 3 * sizeof(float), "columns are returned as float triples");
+    static_cast<securevox::WaveformPeaks*>(peaks)->render(
+        begin_ms, end_ms, static_cast<size_t>(n_columns), reinterpret_cast<securevox::WaveformColumn*>(out));
+    return 1;
+}
+
+WHISPER_API void whisper_wrapper_waveform_free(void* peaks) {
+    delete static_cast<securevox::WaveformPeaks*>(peaks);
+}
+
+WHISPER_API int whisper_wrapper_get_decode_stats(void* ctx, whisper_wrapper_decode_stats* out) {
+    if (ctx == nullptr || out == nullptr) return 0;
+
+    std::lock_guard<std::mutex> lock(g_stats_mutex);
+    auto it = g_decode_stats.find(ctx);
+    if (it == g_decode_stats.end()) return 0;
+    *out = it->second;
+    return 1;
+}
+
+WHISPER_API int whisper_wrapper_check_speculative(void* ctx, void* draft_ctx, void* audio, const char* language,
+                                                  whisper_wrapper_speculative_check* out) {
+    auto* buffer = static_cast<securevox::AudioBuffer*>(audio);
+    if (ctx == nullptr || draft_ctx == nullptr || buffer == nullptr || out == nullptr) {
+        set_error("Invalid arguments");
+        return 0;
+    }
+    if (buffer->sample_rate() != securevox::MODEL_SAMPLE_RATE) {
+        set_error("Audio must be resampled to 16kHz before transcription");
+        return 0;
     }
 
-    jsonResult += "]";
+    securevox::ThreadPool::Lease threads = securevox::ThreadPool::instance().lease(4);
+    securevox::SpeculativeCheck check;
+    std::string error;
+    if (!securevox::check_speculative(static_cast<whisper_context*>(ctx), static_cast<whisper_context*>(draft_ctx),
+                                      buffer->data(), buffer->size(), language ? language : "en",
+                                      threads.count(), check, error)) {
+        set_error(error);
+        return 0;
+    }
 
-    // Allocate and return a copy (caller must free)
-    char* result_str = new char[jsonResult.size() + 1];
-    std::strcpy(result_str, jsonResult.c_str());
-    return result_str;
+    out->identical = check.identical ? 1 : 0;
+    out->segments = static_cast<int>(check.segments);
+    out->first_difference = static_cast<int>(check.first_difference);
+    out->reference_ms = check.reference_ms;
+    out->speculative_ms = check.speculative_ms;
+    out->tokens = check.stats.tokens;
+    out->target_passes = check.stats.target_passes;
+    out->drafted = check.stats.drafted;
+    out->accepted = check.stats.accepted;
+    return 1;
 }
 
 WHISPER_API void whisper_wrapper_free_string(const char* str) {
-    if (str != nullptr) {
-        delete[] str;
+    // Result buffers come from JsonWriter (malloc)
+    std::free(const_cast<char*>(str));
+}
+
+WHISPER_API uint64_t whisper_wrapper_get_scratch_high_water(void) {
+    return securevox::scratch_high_water();
+}
+
+WHISPER_API void whisper_wrapper_set_max_threads(int max_threads) {
+    securevox::ThreadPool::instance().set_max_threads(max_threads);
+}
+
+WHISPER_API void whisper_wrapper_set_encoder_cache(uint64_t memory_bytes, const char* spill_dir, uint64_t spill_bytes) {
+    auto& cache = securevox::EncoderCache::instance();
+    cache.set_memory_budget(static_cast<size_t>(memory_bytes));
+    cache.set_spill(spill_dir != nullptr ? spill_dir : "", spill_dir != nullptr ? spill_bytes : 0);
+}
+
+WHISPER_API void whisper_wrapper_clear_encoder_cache(void) {
+    securevox::EncoderCache::instance().clear();
+}
+
+WHISPER_API void whisper_wrapper_set_encode_batch(int windows, uint64_t memory_bytes) {
+    g_encode_batch.store(std::max(0, windows));
+    g_encode_memory_bytes.store(memory_bytes);
+}
+
+WHISPER_API int whisper_wrapper_set_power_stub(const char* path) {
+    auto& policy = securevox::PowerPolicy::instance();
+    if (path == nullptr) {
+        policy.set_source(nullptr);
+        policy.set_enabled(false);
+        return 1;
     }
+    securevox::PowerSignals signals;
+    auto source = std::make_unique<securevox::StubPowerSource>(path);
+    if (!source->read(signals)) {
+        set_error("Cannot read power stub file: " + std::string(path));
+        return 0;
+    }
+    policy.set_source(std::move(source));
+    policy.set_enabled(true);
+    return 1;
+}
+
+WHISPER_API void whisper_wrapper_set_short_clip_ms(int64_t max_ms) {
+    g_short_clip_ms.store(std::max<int64_t>(0, max_ms));
+}
+
+WHISPER_API void whisper_wrapper_set_result_cache(const char* dir, uint64_t max_bytes) {
+    securevox::ResultCache::instance().set_storage(dir != nullptr ? dir : "", dir != nullptr ? max_bytes : 0);
+}
+
+WHISPER_API void whisper_wrapper_clear_result_cache(void) {
+    securevox::ResultCache::instance().clear();
 }
 
 WHISPER_API const char* whisper_wrapper_get_system_info(void) {
@@ -42,9 +42,198 @@ WHISPER_API const char* whisper_wrapper_transcribe(
     void* user_data
 );
 
+// Native audio buffers. Decoding, conversion and silence removal happen in
+// native memory and managed code only holds the returned handle.
+
+// Create an empty buffer for mono samples at sample_rate
+WHISPER_API void* whisper_wrapper_audio_create(int sample_rate);
+
+// Decode a WAV or FLAC file (any rate/channel count) into a new buffer at the file's rate
+// Returns: handle, or nullptr on failure (see whisper_wrapper_get_last_error)
+WHISPER_API void* whisper_wrapper_audio_load(const char* path);
+
+// Append mono samples at the buffer's rate. Returns 1 on success, 0 on failure
+WHISPER_API int whisper_wrapper_audio_append_pcm16(void* audio, const int16_t* samples, int n_samples);
+WHISPER_API int whisper_wrapper_audio_append_float(void* audio, const float* samples, int n_samples);
+
+// Resample in place; must happen before silence removal. Returns 1 on success, 0 on failure
+WHISPER_API int whisper_wrapper_audio_resample(void* audio, int sample_rate);
+
+// Suppress background noise by spectral gating, with the noise floor taken from
+// the frames the VAD finds silent. Noisy audio otherwise sends the decoder into
+// temperature fallbacks and repetition loops. Must happen before silence removal.
+// Returns 1 on success, 0 on failure
+WHISPER_API int whisper_wrapper_audio_suppress_noise(void* audio);
+
+// Drop silence with the energy VAD; segment times from whisper_wrapper_transcribe_audio
+// still refer to the original audio. Returns 1 on success, 0 on failure
+WHISPER_API int whisper_wrapper_audio_remove_silence(void* audio);
+
+// Duration of the audio before silence removal
+WHISPER_API int64_t whisper_wrapper_audio_duration_ms(void* audio);
+
+// Transcribe a 16kHz audio buffer without copying it.
+// Returns: JSON string with segments array, caller must free with whisper_wrapper_free_string
+WHISPER_API const char* whisper_wrapper_transcribe_audio(
+    void* ctx,
+    void* audio,
+    const char* language,
+    whisper_progress_callback_t progress_callback,
+    void* user_data
+);
+
+// Free an audio buffer
+WHISPER_API void whisper_wrapper_audio_free(void* audio);
+
+// Batch result callback, invoked once per file in input order.
+// json is null when the file failed and error is null when it succeeded;
+// both are only valid for the duration of the call.
+typedef void (*whisper_batch_callback_t)(int index, const char* json, const char* error, void* user_data);
+
+// Transcribe a batch of WAV or FLAC files (any rate/channel count; resampled to 16kHz mono).
+// Decoding, resampling and silence removal of up to `prefetch` upcoming files run
+// on the shared thread pool while the current file is being transcribed.
+// Segment times refer to the original audio even when silence was removed.
+// Returns: number of files transcribed successfully, or -1 on invalid arguments
+WHISPER_API int whisper_wrapper_transcribe_batch(
+    void* ctx,
+    const char* const* paths,
+    int n_paths,
+    const char* language,
+    int prefetch,
+    whisper_batch_callback_t callback,
+    void* user_data
+);
+
+// Write a transcript to path as TXT (0), SRT (1), VTT (2) or JSON (3).
+// path, texts and speakers are UTF-8; speakers may be null, as may any entry.
+// max_line_chars wraps subtitle lines, 0 to disable.
+// Returns: 1 on success, 0 on failure (see whisper_wrapper_get_last_error)
+WHISPER_API int whisper_wrapper_export_segments(
+    const char* path,
+    int format,
+    const int64_t* start_ms,
+    const int64_t* end_ms,
+    const char* const* texts,
+    const char* const* speakers,
+    int n_segments,
+    int max_line_chars
+);
+
+// Waveform peak pyramids (min/max/RMS per bucket at every zoom level), stored
+// in a sidecar file and memory-mapped for drawing.
+
+// Build the peak sidecar of a WAV or FLAC file. Returns 1 on success, 0 on failure
+WHISPER_API int whisper_wrapper_waveform_build(const char* audio_path, const char* peaks_path);
+
+// Map a peak sidecar. Returns: handle, or nullptr on failure (see whisper_wrapper_get_last_error)
+WHISPER_API void* whisper_wrapper_waveform_open(const char* peaks_path);
+
+// Duration of the audio the peaks were built from
+WHISPER_API int64_t whisper_wrapper_waveform_duration_ms(void* peaks);
+
+// Summarise [begin_ms, end_ms) into n_columns equal columns, written to out as
+// (min, max, rms) float triples (3 * n_columns values). Reads O(n_columns)
+// buckets regardless of the range. Returns 1 on success, 0 on invalid arguments
+WHISPER_API int whisper_wrapper_waveform_render(void* peaks, int64_t begin_ms, int64_t end_ms, float* out, int n_columns);
+
+// Unmap a peak sidecar
+WHISPER_API void whisper_wrapper_waveform_free(void* peaks);
+
+// Decoding work of the last transcription (single file or whole batch) on a context
+typedef struct whisper_wrapper_decode_stats {
+    int windows;          // 30 s windows decoded
+    int fallbacks;        // re-decodes at a higher temperature after a window failed the quality checks
+    int cut_windows;      // decoder passes the repetition guard ended early
+    int dropped_segments; // segments left out as decoded from silence (no-speech)
+    int64_t decode_ms;    // time spent in whisper_full; 0 when answered from the result cache
+    int encoded_windows;  // windows encoded ahead of whisper_full (see whisper_wrapper_set_encode_batch)
+    int64_t encode_ms;    // time spent encoding them
+    int short_clips;      // files encoded at their own length (see whisper_wrapper_set_short_clip_ms)
+    int short_retries;    // of which decoded again with the full window
+    int64_t paused_ms;    // duty-cycle pauses under the power policy (see whisper_wrapper_set_power_stub)
+} whisper_wrapper_decode_stats;
+
+// Returns 1 and fills out, or 0 if nothing was transcribed on ctx yet
+WHISPER_API int whisper_wrapper_get_decode_stats(void* ctx, whisper_wrapper_decode_stats* out);
+
+// Speculative decoding checked against whisper_full (see whisper_wrapper_check_speculative)
+typedef struct whisper_wrapper_speculative_check {
+    int identical;           // 1 if both produced the same segments, times and text
+    int segments;            // whisper_full's segments
+    int first_difference;    // index of the first segment that differs
+    int64_t reference_ms;    // whisper_full wall time
+    int64_t speculative_ms;  // speculative wall time, both models
+    int tokens;              // tokens kept by the speculative run
+    int target_passes;       // of its large-model decoder passes
+    int drafted;             // draft proposals
+    int accepted;            // of which the large model agreed with
+} whisper_wrapper_speculative_check;
+
+// Transcribe audio (resampled to 16 kHz) with whisper_full on ctx, greedy at
+// temperature 0 without fallback or previous-text prompt, and again with
+// draft_ctx proposing tokens that ctx verifies in batches, then compare the
+// two and time them. The models need the same vocabulary and whisper.cpp
+// batched logits. Returns 1 and fills out, 0 on failure.
+WHISPER_API int whisper_wrapper_check_speculative(void* ctx, void* draft_ctx, void* audio, const char* language,
+                                                  whisper_wrapper_speculative_check* out);
+
 // Free string returned by whisper_wrapper_transcribe
 WHISPER_API void whisper_wrapper_free_string(const char* str);
 
+// Cap the number of CPU threads used by all native work in the process
+// (preprocessing plus every concurrent transcription). <= 0 means all cores.
+WHISPER_API void whisper_wrapper_set_max_threads(int max_threads);
+
+// Largest scratch memory (decode, resample, VAD and result buffers) used by a
+// single batch file so far, in bytes. Batch runs reuse this memory between files.
+WHISPER_API uint64_t whisper_wrapper_get_scratch_high_water(void);
+
+// Keep encoder outputs per window so transcribing the same audio again (another
+// language, prompt or decoding preset) only runs the decoder. memory_bytes of
+// output stay in memory, 0 disables the cache. Windows evicted from memory are
+// written to spill_dir (null for none) up to spill_bytes, and reused by later runs.
+WHISPER_API void whisper_wrapper_set_encoder_cache(uint64_t memory_bytes, const char* spill_dir, uint64_t spill_bytes);
+
+// Drop every cached encoder output, in memory and in the spill directory
+WHISPER_API void whisper_wrapper_clear_encoder_cache(void);
+
+// Encode the windows of up to `windows` upcoming batch files side by side
+// before decoding them, each on its share of the threads, instead of one
+// window at a time inside whisper_full. Files of up to 30 s (one window) take
+// part, short clips excepted. 1 encodes them ahead one at a time, the
+// baseline; 0 (the default) leaves encoding to whisper_full. Needs the
+// encoder cache to be enabled.
+// Every window encoded side by side needs a whisper_state of its own, KV
+// caches included. memory_bytes caps the peak of the whole batch (model,
+// whisper_full's state and those extra states); windows is lowered to fit, down
+// to leaving encoding to whisper_full. 0 sets no limit.
+WHISPER_API void whisper_wrapper_set_encode_batch(int windows, uint64_t memory_bytes);
+
+// Throttle transcription by simulated battery/thermal signals read from path,
+// key=value lines (battery, charging, thermal, power_save) re-read on every
+// encoder window. The policy caps threads, prefers efficiency cores and pauses
+// between windows as on Android. Threads and cores are planned once per
+// transcription (per file in a batch); an edit to the file mid-run changes the
+// pauses from the next window and the threads from the next file. Null turns throttling off. Returns 0 if the file cannot be read.
+// SECUREVOX_POWER_STUB=path in the environment does the same at startup.
+WHISPER_API int whisper_wrapper_set_power_stub(const char* path);
+
+// Encode audio of up to max_ms (voice memos) at its own length plus a margin
+// instead of a full 30 s window, and decode it as one segment. A result that
+// fails the accuracy guard (no text, a cut loop or low token confidence) is
+// decoded again with the full window. 0 (the default) disables it.
+WHISPER_API void whisper_wrapper_set_short_clip_ms(int64_t max_ms);
+
+// Keep finished transcripts in dir (null disables), keyed by the audio content,
+// model and language, up to max_bytes with the least recently used dropped
+// first. Transcribing identical audio again returns the stored segments
+// without running the model. Transcripts stored by earlier runs are reused.
+WHISPER_API void whisper_wrapper_set_result_cache(const char* dir, uint64_t max_bytes);
+
+// Delete every stored transcript
+WHISPER_API void whisper_wrapper_clear_result_cache(void);
+
 // Get system info string
 WHISPER_API const char* whisper_wrapper_get_system_info(void);
 
@@ -0,0 +1,136 @@
+using System.Runtime.InteropServices;
+
+namespace SecureVox.Whisper;
+
+/// <summary>
+/// Mono audio held in native memory. Decoding, resampling and silence removal run
+/// natively and <see cref="WhisperProcessor.TranscribeAsync(NativeAudioBuffer, string, IProgress{int}?, CancellationToken)"/>
+/// reads the samples in place, so long recordings never become managed arrays.
+/// </summary>
+public sealed class NativeAudioBuffer : IDisposable
+{
+    /// <summary>
+    /// Sample rate expected by the model
+    /// </summary>
+    public const int ModelSampleRate = 16000;
+
+    private IntPtr _handle;
+
+    private NativeAudioBuffer(IntPtr handle)
+    {
+        _handle = handle;
+    }
+
+    /// <summary>
+    /// Create an empty buffer to fill with <see cref="Append(ReadOnlySpan{short})"/>
+    /// </summary>
+    public static NativeAudioBuffer Create(int sampleRate)
+    {
+        var handle = WhisperInterop.whisper_wrapper_audio_create(sampleRate);
+        if (handle == IntPtr.Zero)
+            throw new ArgumentOutOfRangeException(nameof(sampleRate), LastError("Invalid sample rate"));
+        return new NativeAudioBuffer(handle);
+    }
+
+    /// <summary>
+    /// Decode a WAV or FLAC file (any rate or channel count, downmixed to mono) at its own sample rate
+    /// </summary>
+    public static NativeAudioBuffer FromFile(string path)
+    {
+        if (string.IsNullOrEmpty(path))
+            throw new ArgumentNullException(nameof(path));
+
+        var handle = WhisperInterop.whisper_wrapper_audio_load(path);
+        if (handle == IntPtr.Zero)
+            throw new IOException(LastError("Failed to load audio"));
+        return new NativeAudioBuffer(handle);
+    }
+
+    internal IntPtr Handle
+    {
+        get
+        {
+            ObjectDisposedException.ThrowIf(_handle == IntPtr.Zero, this);
+            return _handle;
+        }
+    }
+
+    /// <summary>
+    /// Duration of the audio before silence removal
+    /// </summary>
+    public TimeSpan Duration => TimeSpan.FromMilliseconds(WhisperInterop.whisper_wrapper_audio_duration_ms(Handle));
+
+    /// <summary>
+    /// Append mono 16-bit PCM at the buffer's sample rate
+    /// </summary>
+    public unsafe void Append(ReadOnlySpan<short> samples)
+    {
+        fixed (short* ptr = samples)
+        {
+            if (WhisperInterop.whisper_wrapper_audio_append_pcm16(Handle, ptr, samples.Length) == 0)
+                throw new InvalidOperationException(LastError("Failed to append audio"));
+        }
+    }
+
+    /// <summary>
+    /// Append mono float samples in [-1, 1] at the buffer's sample rate
+    /// </summary>
+    public unsafe void Append(ReadOnlySpan<float> samples)
+    {
+        fixed (float* ptr = samples)
+        {
+            if (WhisperInterop.whisper_wrapper_audio_append_float(Handle, ptr, samples.Length) == 0)
+                throw new InvalidOperationException(LastError("Failed to append audio"));
+        }
+    }
+
+    /// <summary>
+    /// Resample in place. Must happen before <see cref="RemoveSilence"/>.
+    /// </summary>
+    public void Resample(int sampleRate = ModelSampleRate)
+    {
+        if (WhisperInterop.whisper_wrapper_audio_resample(Handle, sampleRate) == 0)
+            throw new InvalidOperationException(LastError("Failed to resample audio"));
+    }
+
+    /// <summary>
+    /// Spectral noise suppression with the noise floor taken from the pauses the VAD finds.
+    /// Must happen after <see cref="Resample"/> and before <see cref="RemoveSilence"/>.
+    /// </summary>
+    public void SuppressNoise()
+    {
+        if (WhisperInterop.whisper_wrapper_audio_suppress_noise(Handle) == 0)
+            throw new InvalidOperationException(LastError("Failed to suppress noise"));
+    }
+
+    /// <summary>
+    /// Drop non-speech with the energy VAD. Transcript times still refer to the original audio.
+    /// </summary>
+    public void RemoveSilence()
+    {
+        if (WhisperInterop.whisper_wrapper_audio_remove_silence(Handle) == 0)
+            throw new InvalidOperationException(LastError("Failed to remove silence"));
+    }
+
+    private static string LastError(string fallback)
+    {
+        var errorPtr = WhisperInterop.whisper_wrapper_get_last_error();
+        return errorPtr != IntPtr.Zero ? Marshal.PtrToStringAnsi(errorPtr) ?? fallback : fallback;
+    }
+
+    public void Dispose()
+    {
+        if (_handle != IntPtr.Zero)
+        {
+            WhisperInterop.whisper_wrapper_audio_free(_handle);
+            _handle = IntPtr.Zero;
+        }
+        GC.SuppressFinalize(this);
+    }
+
+    ~NativeAudioBuffer()
+    {
+        if (_handle != IntPtr.Zero)
+            WhisperInterop.whisper_wrapper_audio_free(_handle);
+    }
+}
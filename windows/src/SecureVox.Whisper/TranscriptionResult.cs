@@ -1,5 +1,64 @@
+using System.Runtime.InteropServices;
+
 namespace SecureVox.Whisper;
 
+/// <summary>
+/// Decoder counters of one transcription
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public readonly struct DecodeStats
+{
+    /// <summary>
+    /// 30 s windows decoded
+    /// </summary>
+    public readonly int Windows;
+
+    /// <summary>
+    /// Re-decodes at a higher temperature after a window failed the quality checks
+    /// </summary>
+    public readonly int Fallbacks;
+
+    /// <summary>
+    /// Decoder passes the repetition guard ended early instead of letting a loop run
+    /// </summary>
+    public readonly int CutWindows;
+
+    /// <summary>
+    /// Segments left out because they were decoded from silence
+    /// </summary>
+    public readonly int DroppedSegments;
+
+    /// <summary>
+    /// Time spent decoding; 0 when the transcript came from the result cache
+    /// </summary>
+    public readonly long DecodeMs;
+
+    /// <summary>
+    /// Windows encoded ahead of decoding in a batch (see <see cref="WhisperProcessor.SetEncodeBatch"/>)
+    /// </summary>
+    public readonly int EncodedWindows;
+
+    /// <summary>
+    /// Time spent encoding those windows
+    /// </summary>
+    public readonly long EncodeMs;
+
+    /// <summary>
+    /// Files encoded at their own length (see <see cref="WhisperProcessor.SetShortClipMode"/>)
+    /// </summary>
+    public readonly int ShortClips;
+
+    /// <summary>
+    /// Short clips decoded again with the full window after failing the accuracy guard
+    /// </summary>
+    public readonly int ShortRetries;
+
+    /// <summary>
+    /// Time paused between encoder windows by battery/thermal throttling
+    /// </summary>
+    public readonly long PausedMs;
+}
+
 /// <summary>
 /// Result of a transcription segment from whisper
 /// </summary>
@@ -0,0 +1,111 @@
+using System.Runtime.InteropServices;
+
+namespace SecureVox.Whisper;
+
+/// <summary>
+/// One rendered waveform column: peaks in [-1, 1] and RMS in [0, 1]
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public readonly struct WaveformColumn
+{
+    public readonly float Min;
+    public readonly float Max;
+    public readonly float Rms;
+}
+
+/// <summary>
+/// Min/max/RMS peak pyramid of a recording, memory-mapped from a sidecar file.
+/// Rendering reads only the level matching the zoom, so drawing any range costs
+/// O(columns) regardless of the recording length.
+/// </summary>
+public sealed class WaveformPeaks : IDisposable
+{
+    private IntPtr _handle;
+
+    private WaveformPeaks(IntPtr handle)
+    {
+        _handle = handle;
+    }
+
+    /// <summary>
+    /// Sidecar that holds the peaks of an audio file
+    /// </summary>
+    public static string SidecarPath(string audioPath) => audioPath + ".peaks";
+
+    /// <summary>
+    /// Compute the peaks of a WAV or FLAC file in one pass and write them to <paramref name="peaksPath"/>
+    /// </summary>
+    public static void Build(string audioPath, string peaksPath)
+    {
+        ArgumentException.ThrowIfNullOrEmpty(audioPath);
+        ArgumentException.ThrowIfNullOrEmpty(peaksPath);
+
+        if (WhisperInterop.whisper_wrapper_waveform_build(audioPath, peaksPath) == 0)
+            throw new IOException(LastError("Failed to build waveform"));
+    }
+
+    /// <summary>
+    /// Map a sidecar written by <see cref="Build"/>
+    /// </summary>
+    public static WaveformPeaks Open(string peaksPath)
+    {
+        ArgumentException.ThrowIfNullOrEmpty(peaksPath);
+
+        var handle = WhisperInterop.whisper_wrapper_waveform_open(peaksPath);
+        if (handle == IntPtr.Zero)
+            throw new IOException(LastError("Failed to open waveform"));
+        return new WaveformPeaks(handle);
+    }
+
+    private IntPtr Handle
+    {
+        get
+        {
+            ObjectDisposedException.ThrowIf(_handle == IntPtr.Zero, this);
+            return _handle;
+        }
+    }
+
+    /// <summary>
+    /// Duration of the audio the peaks were built from
+    /// </summary>
+    public TimeSpan Duration => TimeSpan.FromMilliseconds(WhisperInterop.whisper_wrapper_waveform_duration_ms(Handle));
+
+    /// <summary>
+    /// Summarise [begin, end) into one column per element of <paramref name="columns"/>.
+    /// Columns past the end of the audio are zero.
+    /// </summary>
+    public unsafe void Render(TimeSpan begin, TimeSpan end, Span<WaveformColumn> columns)
+    {
+        if (columns.IsEmpty)
+            return;
+
+        fixed (WaveformColumn* ptr = columns)
+        {
+            WhisperInterop.whisper_wrapper_waveform_render(
+                Handle, (long)begin.TotalMilliseconds, (long)end.TotalMilliseconds, (float*)ptr, columns.Length);
+        }
+    }
+
+    private static string LastError(string fallback)
+    {
+        var errorPtr = WhisperInterop.whisper_wrapper_get_last_error();
+        return errorPtr != IntPtr.Zero ? Marshal.PtrToStringAnsi(errorPtr) ?? fallback : fallback;
+    }
+
+    public void Dispose()
+    {
+        if (_handle != IntPtr.Zero)
+        {
+            WhisperInterop.whisper_wrapper_waveform_free(_handle);
+            _handle = IntPtr.Zero;
+        }
+        GC.SuppressFinalize(this);
+    }
+
+    ~WaveformPeaks()
+    {
+        if (_handle != IntPtr.Zero)
+            WhisperInterop.whisper_wrapper_waveform_free(_handle);
+    }
+}
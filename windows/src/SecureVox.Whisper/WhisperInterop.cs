@@ -1,3 +1,4 @@
+using System.Reflection;
 using System.Runtime.InteropServices;
 
 namespace SecureVox.Whisper;
@@ -8,6 +9,62 @@ namespace SecureVox.Whisper;
 internal static class WhisperInterop
 {
     private const string DllName = "whisper_native";
+    private const string CpuProbeDllName = "securevox_cpu";
+
+    /// <summary>
+    /// Suffix of the whisper_native build in use ("avx512", "avx2", "i8mm", "dotprod"), or empty for the baseline
+    /// </summary>
+    public static string CpuVariant { get; private set; } = "";
+
+    static WhisperInterop()
+    {
+        NativeLibrary.SetDllImportResolver(typeof(WhisperInterop).Assembly, ResolveLibrary);
+    }
+
+    /// <summary>
+    /// Load whisper_native_{variant}.dll, built with the fastest kernels this CPU
+    /// supports, in place of the baseline whisper_native.dll
+    /// </summary>
+    private static IntPtr ResolveLibrary(string libraryName, Assembly assembly, DllImportSearchPath? searchPath)
+    {
+        if (libraryName != DllName)
+        {
+            return IntPtr.Zero;
+        }
+
+        string variant = DetectCpuVariant();
+        if (variant.Length > 0 &&
+            NativeLibrary.TryLoad($"{DllName}_{variant}", assembly, searchPath, out IntPtr handle))
+        {
+            CpuVariant = variant;
+            return handle;
+        }
+
+        // Default probing loads the baseline build
+        return IntPtr.Zero;
+    }
+
+    private static string DetectCpuVariant()
+    {
+        try
+        {
+            return Marshal.PtrToStringAnsi(securevox_cpu_variant()) ?? "";
+        }
+        catch (DllNotFoundException)
+        {
+            return "";
+        }
+        catch (EntryPointNotFoundException)
+        {
+            return "";
+        }
+    }
+
+    /// <summary>
+    /// Best whisper_native variant for this CPU, from cpuid
+    /// </summary>
+    [DllImport(CpuProbeDllName, CallingConvention = CallingConvention.Cdecl)]
+    private static extern IntPtr securevox_cpu_variant();
 
     /// <summary>
     /// Progress callback delegate matching the native signature
@@ -15,6 +72,12 @@ internal static class WhisperInterop
     [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
     public delegate void ProgressCallback(int progress, IntPtr userData);
 
+    /// <summary>
+    /// Batch result callback delegate matching the native signature
+    /// </summary>
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public delegate void BatchCallback(int index, IntPtr json, IntPtr error, IntPtr userData);
+
     /// <summary>
     /// Initialize whisper context from model file
     /// </summary>
@@ -48,12 +111,233 @@ internal static class WhisperInterop
         ProgressCallback? progressCallback,
         IntPtr userData);
 
+    /// <summary>
+    /// Create an empty native audio buffer
+    /// </summary>
+    /// <param name="sampleRate">Sample rate of the audio to be appended</param>
+    /// <returns>Audio handle, or IntPtr.Zero on failure</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr whisper_wrapper_audio_create(int sampleRate);
+
+    /// <summary>
+    /// Decode a WAV or FLAC file into a native audio buffer at the file's sample rate
+    /// </summary>
+    /// <param name="path">WAV or FLAC file path</param>
+    /// <returns>Audio handle, or IntPtr.Zero on failure</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi)]
+    public static extern IntPtr whisper_wrapper_audio_load(string path);
+
+    /// <summary>
+    /// Append mono 16-bit PCM at the buffer's sample rate
+    /// </summary>
+    /// <returns>1 on success, 0 on failure</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern unsafe int whisper_wrapper_audio_append_pcm16(IntPtr audio, short* samples, int nSamples);
+
+    /// <summary>
+    /// Append mono float samples at the buffer's sample rate
+    /// </summary>
+    /// <returns>1 on success, 0 on failure</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern unsafe int whisper_wrapper_audio_append_float(IntPtr audio, float* samples, int nSamples);
+
+    /// <summary>
+    /// Resample a native audio buffer in place
+    /// </summary>
+    /// <returns>1 on success, 0 on failure</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int whisper_wrapper_audio_resample(IntPtr audio, int sampleRate);
+
+    /// <summary>
+    /// Suppress stationary background noise in a native audio buffer, estimated from its pauses
+    /// </summary>
+    /// <returns>1 on success, 0 on failure</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int whisper_wrapper_audio_suppress_noise(IntPtr audio);
+
+    /// <summary>
+    /// Remove silence from a native audio buffer; transcript times stay on the original timeline
+    /// </summary>
+    /// <returns>1 on success, 0 on failure</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int whisper_wrapper_audio_remove_silence(IntPtr audio);
+
+    /// <summary>
+    /// Duration of a native audio buffer before silence removal
+    /// </summary>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern long whisper_wrapper_audio_duration_ms(IntPtr audio);
+
+    /// <summary>
+    /// Transcribe a 16kHz native audio buffer in place
+    /// </summary>
+    /// <param name="ctx">Whisper context</param>
+    /// <param name="audio">Audio handle</param>
+    /// <param name="language">Language code (e.g., "en", "auto")</param>
+    /// <param name="progressCallback">Optional progress callback</param>
+    /// <param name="userData">User data for callback</param>
+    /// <returns>JSON string with segments, or IntPtr.Zero on failure</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi)]
+    public static extern IntPtr whisper_wrapper_transcribe_audio(
+        IntPtr ctx,
+        IntPtr audio,
+        string language,
+        ProgressCallback? progressCallback,
+        IntPtr userData);
+
+    /// <summary>
+    /// Free a native audio buffer
+    /// </summary>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void whisper_wrapper_audio_free(IntPtr audio);
+
+    /// <summary>
+    /// Transcribe a batch of WAV or FLAC files, preprocessing upcoming files while the current one is inferred
+    /// </summary>
+    /// <param name="ctx">Whisper context</param>
+    /// <param name="paths">WAV or FLAC file paths</param>
+    /// <param name="nPaths">Number of paths</param>
+    /// <param name="language">Language code (e.g., "en", "auto")</param>
+    /// <param name="prefetch">Number of files to prepare ahead of inference</param>
+    /// <param name="callback">Called once per file, in input order</param>
+    /// <param name="userData">User data for callback</param>
+    /// <returns>Number of files transcribed successfully, or -1 on invalid arguments</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi)]
+    public static extern int whisper_wrapper_transcribe_batch(
+        IntPtr ctx,
+        string[] paths,
+        int nPaths,
+        string language,
+        int prefetch,
+        BatchCallback callback,
+        IntPtr userData);
+
+    /// <summary>
+    /// Write a transcript to a file as TXT (0), SRT (1), VTT (2) or JSON (3)
+    /// </summary>
+    /// <param name="path">Output file path</param>
+    /// <param name="format">Export format</param>
+    /// <param name="startMs">Segment start times in milliseconds</param>
+    /// <param name="endMs">Segment end times in milliseconds</param>
+    /// <param name="texts">Segment texts</param>
+    /// <param name="speakers">Optional speaker label per segment</param>
+    /// <param name="nSegments">Number of segments</param>
+    /// <param name="maxLineChars">Subtitle line wrap width, 0 to disable</param>
+    /// <returns>1 on success, 0 on failure</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int whisper_wrapper_export_segments(
+        [MarshalAs(UnmanagedType.LPUTF8Str)] string path,
+        int format,
+        [In] long[] startMs,
+        [In] long[] endMs,
+        [In, MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPUTF8Str)] string[] texts,
+        [In, MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPUTF8Str)] string?[]? speakers,
+        int nSegments,
+        int maxLineChars);
+
+    /// <summary>
+    /// Build the min/max/RMS peak sidecar of a WAV or FLAC file
+    /// </summary>
+    /// <returns>1 on success, 0 on failure</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi)]
+    public static extern int whisper_wrapper_waveform_build(string audioPath, string peaksPath);
+
+    /// <summary>
+    /// Memory-map a peak sidecar
+    /// </summary>
+    /// <returns>Peaks handle, or IntPtr.Zero on failure</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi)]
+    public static extern IntPtr whisper_wrapper_waveform_open(string peaksPath);
+
+    /// <summary>
+    /// Duration of the audio a peak sidecar was built from
+    /// </summary>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern long whisper_wrapper_waveform_duration_ms(IntPtr peaks);
+
+    /// <summary>
+    /// Summarise a time range into columns of (min, max, rms) float triples
+    /// </summary>
+    /// <returns>1 on success, 0 on invalid arguments</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern unsafe int whisper_wrapper_waveform_render(IntPtr peaks, long beginMs, long endMs, float* output, int nColumns);
+
+    /// <summary>
+    /// Unmap a peak sidecar
+    /// </summary>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void whisper_wrapper_waveform_free(IntPtr peaks);
+
+    /// <summary>
+    /// Fallback and timing counters of the last transcription on a context
+    /// </summary>
+    /// <returns>1 if filled, 0 if nothing was transcribed on ctx yet</returns>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int whisper_wrapper_get_decode_stats(IntPtr ctx, out DecodeStats stats);
+
     /// <summary>
     /// Free string returned by whisper_wrapper_transcribe
     /// </summary>
     [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
     public static extern void whisper_wrapper_free_string(IntPtr str);
 
+    /// <summary>
+    /// Cap the number of CPU threads used by all native work in the process
+    /// </summary>
+    /// <param name="maxThreads">Thread cap, or 0 for all cores</param>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void whisper_wrapper_set_max_threads(int maxThreads);
+
+    /// <summary>
+    /// Largest scratch memory used by a single batch file so far, in bytes
+    /// </summary>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern ulong whisper_wrapper_get_scratch_high_water();
+
+    /// <summary>
+    /// Keep encoder outputs so re-transcribing the same audio only runs the decoder
+    /// </summary>
+    /// <param name="memoryBytes">Encoder output kept in memory, 0 to disable</param>
+    /// <param name="spillDir">Directory for windows evicted from memory, or null</param>
+    /// <param name="spillBytes">Disk budget for the spill directory</param>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi)]
+    public static extern void whisper_wrapper_set_encoder_cache(ulong memoryBytes, string? spillDir, ulong spillBytes);
+
+    /// <summary>
+    /// Drop every cached encoder output, in memory and on disk
+    /// </summary>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void whisper_wrapper_clear_encoder_cache();
+
+    /// <summary>
+    /// Encode the windows of upcoming batch files side by side before decoding them
+    /// </summary>
+    /// <param name="windows">Windows encoded together, 1 for one at a time, 0 to leave it to whisper_full</param>
+    /// <param name="memoryBytes">Peak memory of the batch that caps the windows, 0 for no limit</param>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void whisper_wrapper_set_encode_batch(int windows, ulong memoryBytes);
+
+    /// <summary>
+    /// Encode audio up to max_ms long at its own length and decode it as one segment
+    /// </summary>
+    /// <param name="maxMs">Longest clip that takes the fast path, 0 to disable it</param>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void whisper_wrapper_set_short_clip_ms(long maxMs);
+
+    /// <summary>
+    /// Keep finished transcripts so identical audio is not transcribed again
+    /// </summary>
+    /// <param name="dir">Directory for stored transcripts, or null to disable</param>
+    /// <param name="maxBytes">Disk budget; least recently used transcripts go first</param>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi)]
+    public static extern void whisper_wrapper_set_result_cache(string? dir, ulong maxBytes);
+
+    /// <summary>
+    /// Delete every stored transcript
+    /// </summary>
+    [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void whisper_wrapper_clear_result_cache();
+
     /// <summary>
     /// Get system info string
     /// </summary>
@@ -1,5 +1,6 @@
 using System.Runtime.InteropServices;
 using System.Text.Json;
+using SecureVox.Core.Models;
 
 namespace SecureVox.Whisper;
 
@@ -29,6 +30,18 @@ public class WhisperProcessor : IDisposable
         }
     }
 
+    /// <summary>
+    /// Counters of the last transcription, or null before the first one
+    /// </summary>
+    public DecodeStats? LastDecodeStats
+    {
+        get
+        {
+            if (!IsInitialized) return null;
+            return WhisperInterop.whisper_wrapper_get_decode_stats(_context, out var stats) != 0 ? stats : null;
+        }
+    }
+
     /// <summary>
     /// Initialize the processor with a model file
     /// </summary>
@@ -102,33 +115,289 @@ public class WhisperProcessor : IDisposable
                     callback,
                     IntPtr.Zero);
 
-                if (resultPtr == IntPtr.Zero)
+                return TakeResult(resultPtr);
+            }
+        }, cancellationToken);
+    }
+
+    /// <summary>
+    /// Transcribe audio held in native memory without copying it into managed arrays
+    /// </summary>
+    /// <param name="audio">Audio resampled to 16kHz; silence may have been removed</param>
+    /// <param name="language">Language code (e.g., "en", "auto" for auto-detect)</param>
+    /// <param name="progress">Optional progress reporter (0-100)</param>
+    /// <param name="cancellationToken">Cancellation token</param>
+    /// <returns>Transcription result with segments on the original audio timeline</returns>
+    public async Task<TranscriptionResult> TranscribeAsync(
+        NativeAudioBuffer audio,
+        string language = "en",
+        IProgress<int>? progress = null,
+        CancellationToken cancellationToken = default)
+    {
+        ArgumentNullException.ThrowIfNull(audio);
+
+        if (!IsInitialized)
+            return TranscriptionResult.Failure("Whisper processor not initialized");
+
+        return await Task.Run(() =>
+        {
+            lock (_lock)
+            {
+                if (cancellationToken.IsCancellationRequested)
+                    return TranscriptionResult.Failure("Transcription cancelled");
+
+                WhisperInterop.ProgressCallback? callback = null;
+                if (progress != null)
                 {
-                    var errorPtr = WhisperInterop.whisper_wrapper_get_last_error();
-                    var error = errorPtr != IntPtr.Zero
-                        ? Marshal.PtrToStringAnsi(errorPtr) ?? "Unknown error"
-                        : "Transcription failed";
-                    return TranscriptionResult.Failure(error);
+                    callback = (int progressValue, IntPtr userData) =>
+                    {
+                        progress.Report(progressValue);
+                    };
                 }
 
-                try
-                {
-                    // Parse JSON result
-                    var jsonString = Marshal.PtrToStringAnsi(resultPtr);
-                    if (string.IsNullOrEmpty(jsonString))
-                        return TranscriptionResult.Failure("Empty result from transcription");
+                IntPtr resultPtr = WhisperInterop.whisper_wrapper_transcribe_audio(
+                    _context,
+                    audio.Handle,
+                    language,
+                    callback,
+                    IntPtr.Zero);
+                GC.KeepAlive(audio);
 
-                    var segments = ParseSegmentsJson(jsonString);
-                    return TranscriptionResult.Success(segments);
-                }
-                finally
+                return TakeResult(resultPtr);
+            }
+        }, cancellationToken);
+    }
+
+    // Parse and free a result returned by the native transcribe calls
+    private static TranscriptionResult TakeResult(IntPtr resultPtr)
+    {
+        if (resultPtr == IntPtr.Zero)
+        {
+            var errorPtr = WhisperInterop.whisper_wrapper_get_last_error();
+            var error = errorPtr != IntPtr.Zero
+                ? Marshal.PtrToStringAnsi(errorPtr) ?? "Unknown error"
+                : "Transcription failed";
+            return TranscriptionResult.Failure(error);
+        }
+
+        try
+        {
+            // Parse JSON result
+            var jsonString = Marshal.PtrToStringUTF8(resultPtr);
+            if (string.IsNullOrEmpty(jsonString))
+                return TranscriptionResult.Failure("Empty result from transcription");
+
+            var segments = ParseSegmentsJson(jsonString);
+            return TranscriptionResult.Success(segments);
+        }
+        finally
+        {
+            WhisperInterop.whisper_wrapper_free_string(resultPtr);
+        }
+    }
+
+    /// <summary>
+    /// Transcribe a batch of WAV or FLAC files. Decoding, resampling and silence removal of the
+    /// next files overlap with inference of the current one.
+    /// </summary>
+    /// <param name="audioPaths">WAV or FLAC files to transcribe</param>
+    /// <param name="language">Language code (e.g., "en", "auto" for auto-detect)</param>
+    /// <param name="prefetch">Number of files prepared ahead of inference</param>
+    /// <param name="progress">Optional reporter for the number of files completed</param>
+    /// <param name="cancellationToken">Cancellation token</param>
+    /// <returns>One result per input file, in input order</returns>
+    public async Task<IReadOnlyList<TranscriptionResult>> TranscribeBatchAsync(
+        IReadOnlyList<string> audioPaths,
+        string language = "en",
+        int prefetch = 2,
+        IProgress<int>? progress = null,
+        CancellationToken cancellationToken = default)
+    {
+        if (audioPaths == null || audioPaths.Count == 0)
+            return Array.Empty<TranscriptionResult>();
+
+        var results = new TranscriptionResult[audioPaths.Count];
+        for (int i = 0; i < results.Length; i++)
+            results[i] = TranscriptionResult.Failure("Not transcribed");
+
+        if (!IsInitialized)
+        {
+            for (int i = 0; i < results.Length; i++)
+                results[i] = TranscriptionResult.Failure("Whisper processor not initialized");
+            return results;
+        }
+
+        return await Task.Run(() =>
+        {
+            lock (_lock)
+            {
+                if (cancellationToken.IsCancellationRequested)
+                    return (IReadOnlyList<TranscriptionResult>)results;
+
+                int completed = 0;
+                WhisperInterop.BatchCallback callback = (int index, IntPtr json, IntPtr error, IntPtr userData) =>
                 {
-                    WhisperInterop.whisper_wrapper_free_string(resultPtr);
-                }
+                    if (json != IntPtr.Zero)
+                    {
+                        var jsonString = Marshal.PtrToStringUTF8(json) ?? string.Empty;
+                        results[index] = TranscriptionResult.Success(ParseSegmentsJson(jsonString));
+                    }
+                    else
+                    {
+                        var message = error != IntPtr.Zero
+                            ? Marshal.PtrToStringAnsi(error) ?? "Unknown error"
+                            : "Transcription failed";
+                        results[index] = TranscriptionResult.Failure(message);
+                    }
+                    progress?.Report(++completed);
+                };
+
+                var paths = audioPaths.ToArray();
+                WhisperInterop.whisper_wrapper_transcribe_batch(
+                    _context,
+                    paths,
+                    paths.Length,
+                    language,
+                    prefetch,
+                    callback,
+                    IntPtr.Zero);
+
+                GC.KeepAlive(callback);
+                return (IReadOnlyList<TranscriptionResult>)results;
             }
         }, cancellationToken);
     }
 
+    /// <summary>
+    /// Cap the CPU threads shared by all native transcription and preprocessing work
+    /// </summary>
+    /// <param name="maxThreads">Thread cap, or 0 for all cores</param>
+    public static void SetMaxThreads(int maxThreads)
+    {
+        WhisperInterop.whisper_wrapper_set_max_threads(maxThreads);
+    }
+
+    /// <summary>
+    /// Keep encoder outputs so that transcribing the same audio again (another language,
+    /// prompt or decoding preset) skips the encoder for every window already seen.
+    /// Shared by all processors in the process.
+    /// </summary>
+    /// <param name="memoryBytes">Encoder output held in memory, 0 to disable the cache</param>
+    /// <param name="spillDirectory">Directory for windows evicted from memory, or null for none.
+    /// Windows written there by earlier runs are reused.</param>
+    /// <param name="spillBytes">Disk budget for the spill directory; the oldest windows go first</param>
+    public static void ConfigureEncoderCache(long memoryBytes, string? spillDirectory = null, long spillBytes = 0)
+    {
+        WhisperInterop.whisper_wrapper_set_encoder_cache(
+            (ulong)Math.Max(0, memoryBytes), spillDirectory, (ulong)Math.Max(0, spillBytes));
+    }
+
+    /// <summary>
+    /// Drop every cached encoder output, in memory and on disk
+    /// </summary>
+    public static void ClearEncoderCache()
+    {
+        WhisperInterop.whisper_wrapper_clear_encoder_cache();
+    }
+
+    /// <summary>
+    /// Encode the windows of up to <paramref name="windows"/> upcoming files of a batch
+    /// side by side, each on its share of the threads, before decoding them. Files of up
+    /// to 30 s take part. Needs the encoder cache (<see cref="ConfigureEncoderCache"/>).
+    /// Shared by all processors in the process.
+    /// </summary>
+    /// <param name="windows">Windows encoded together; 1 encodes them ahead one at a time,
+    /// 0 leaves encoding to the decoder</param>
+    /// <param name="memoryBytes">Peak memory the batch may use, the model included. Each window
+    /// encoded together holds a full decoder state, so fewer are encoded together (or none)
+    /// when they would not fit; 0 sets no limit.</param>
+    public static void SetEncodeBatch(int windows, long memoryBytes)
+    {
+        WhisperInterop.whisper_wrapper_set_encode_batch(Math.Max(0, windows), (ulong)Math.Max(0, memoryBytes));
+    }
+
+    /// <summary>
+    /// Encode audio up to <paramref name="maxMs"/> long (voice memos) at its own length
+    /// instead of a full 30 s window, and decode it as one segment. A result that fails
+    /// the native accuracy guard is decoded again with the full window. Shared by all
+    /// processors in the process.
+    /// </summary>
+    /// <param name="maxMs">Longest clip that takes the fast path; 0 disables it</param>
+    public static void SetShortClipMode(long maxMs)
+    {
+        WhisperInterop.whisper_wrapper_set_short_clip_ms(Math.Max(0, maxMs));
+    }
+
+    /// <summary>
+    /// Keep finished transcripts keyed by the audio content, model and language, so
+    /// transcribing identical audio again (a re-imported file, a retried batch) returns
+    /// the stored segments without running the model. Shared by all processors in the process.
+    /// </summary>
+    /// <param name="directory">Directory for stored transcripts, or null to disable the cache.
+    /// Transcripts stored there by earlier runs are reused.</param>
+    /// <param name="maxBytes">Disk budget; the least recently used transcripts go first</param>
+    public static void ConfigureResultCache(string? directory, long maxBytes)
+    {
+        WhisperInterop.whisper_wrapper_set_result_cache(directory, (ulong)Math.Max(0, maxBytes));
+    }
+
+    /// <summary>
+    /// Delete every stored transcript
+    /// </summary>
+    public static void ClearResultCache()
+    {
+        WhisperInterop.whisper_wrapper_clear_result_cache();
+    }
+
+    /// <summary>
+    /// Largest native scratch memory (decode, resample, VAD and result buffers) used by a
+    /// single batch file so far. Batch runs reuse this memory from file to file.
+    /// </summary>
+    public static long ScratchHighWaterBytes => (long)WhisperInterop.whisper_wrapper_get_scratch_high_water();
+
+    /// <summary>
+    /// Native kernel build chosen for this CPU once the library has loaded:
+    /// "avx512", "avx2" ("i8mm", "dotprod" on arm64), or empty for the baseline build.
+    /// </summary>
+    public static string CpuVariant => WhisperInterop.CpuVariant;
+
+    /// <summary>
+    /// Write a transcript to a file in the given format using the native exporter
+    /// </summary>
+    /// <param name="segments">Segments in playback order</param>
+    /// <param name="format">Export format</param>
+    /// <param name="path">Output file path</param>
+    /// <param name="maxLineChars">Subtitle line wrap width, 0 to disable</param>
+    public static void ExportSegments(
+        IReadOnlyList<TranscriptSegment> segments,
+        ExportFormat format,
+        string path,
+        int maxLineChars = 42)
+    {
+        var startMs = new long[segments.Count];
+        var endMs = new long[segments.Count];
+        var texts = new string[segments.Count];
+        var speakers = new string?[segments.Count];
+
+        for (var i = 0; i < segments.Count; i++)
+        {
+            startMs[i] = (long)Math.Round(segments[i].StartTime * 1000);
+            endMs[i] = (long)Math.Round(segments[i].EndTime * 1000);
+            texts[i] = segments[i].Text;
+            speakers[i] = segments[i].SpeakerLabel;
+        }
+
+        var result = WhisperInterop.whisper_wrapper_export_segments(
+            path, (int)format, startMs, endMs, texts, speakers, segments.Count, maxLineChars);
+
+        if (result == 0)
+        {
+            var errorPtr = WhisperInterop.whisper_wrapper_get_last_error();
+            var error = errorPtr != IntPtr.Zero ? Marshal.PtrToStringAnsi(errorPtr) : "Unknown error";
+            throw new IOException($"Export failed: {error}");
+        }
+    }
+
     /// <summary>
     /// Get system information string
     /// </summary>